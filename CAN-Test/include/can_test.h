@@ -0,0 +1,93 @@
+/**
+ * @file can_test.h
+ * @brief message table and schedule of the CAN test, shared by main.cpp and the simulation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the node sends TEST_STATUS every 50 ms from a TX scheduler serviced on a 1 ms tick and
+ * listens for the same message. main.cpp runs can_tasks.h's steps in the write, read and
+ * process tasks, the simulation runs them back to back from each node's tick timer, so both
+ * exercise the same code.
+ *
+ * handleTestMessage() is not here: the device logs the message, the simulation counts it per
+ * node. each program defines its own.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include <esp_timer.h>
+#include "driver/can.h"
+#include <spsc_ring.h>
+#include <can_dispatch.h>
+#include <can_tx_scheduler.h>
+#include <can_tasks.h>
+#include "vehicle_dbc.h"                // generated from ../dbc/vehicle.dbc at build time
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_TX_PIN                        23
+#define CAN_RX_PIN                        19
+#define MSG_PERIOD                        50000       // 50 milliseconds in microseconds
+#define MSG_PRIORITY                      1
+
+#define CAN_UPDATE_INTERVAL               1000        // TX scheduler tick, 1 millisecond in microseconds
+#define CAN_RX_RING_SIZE                  64          // frames buffered between the read and process tasks
+
+// received frames waiting to be decoded, written only by the read task and read only by the process task
+typedef SpscRing<can_message_t, CAN_RX_RING_SIZE> CanRxRing;
+
+
+/*
+===============================================================================================
+                                    Messages
+===============================================================================================
+*/
+
+void handleTestMessage(const can_message_t& message);
+
+// every message this node listens to, add a row here to receive a new ID
+constexpr CanMessageEntry canMessageTable[] = {
+  // id             dlc                 handler
+  { TestStatus::ID,   TestStatus::DLC,    handleTestMessage },
+};
+constexpr auto canDispatchTable = makeCanDispatchTable(canMessageTable);
+
+
+/**
+ * @brief refreshes the test message payload right before it is sent
+ *
+ * @param message the frame about to be transmitted
+ */
+inline void fillTestMessage(can_message_t& message)
+{
+  static TestStatus status;
+
+  status.counter++;
+  status.uptime = (uint16_t)(esp_timer_get_time() / 1000000);
+  status.pack(message.data);
+}
+
+/**
+ * @brief adds TEST_STATUS to the TX scheduler
+ *
+ * @param flags CAN_MSG_FLAG_SELF to receive it back on a lone node
+ * @return false if the scheduler is full
+ */
+inline bool scheduleTestMessage(CanTxScheduler& scheduler, uint32_t flags)
+{
+  can_message_t testMessage = {
+    .flags = flags,
+    .identifier = TestStatus::ID,
+    .data_length_code = TestStatus::DLC,
+    .data = {},
+  };
+  return scheduler.addPeriodic(testMessage, MSG_PERIOD, MSG_PRIORITY, fillTestMessage) != CAN_TX_INVALID_HANDLE;
+}
+
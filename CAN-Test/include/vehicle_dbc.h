@@ -0,0 +1,165 @@
+/**
+ * @file vehicle_dbc.h
+ * @brief generated from vehicle.dbc by tools/dbc_codegen/dbc_codegen.py, do not edit by hand
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+// whole frame as one little endian (intel) word
+constexpr uint64_t dbcLoadLittleEndian(const uint8_t* data)
+{
+  uint64_t word = 0;
+  for (int i = 7; i >= 0; i--) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+// whole frame as one big endian (motorola) word
+constexpr uint64_t dbcLoadBigEndian(const uint8_t* data)
+{
+  uint64_t word = 0;
+  for (int i = 0; i < 8; i++) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+constexpr void dbcStore(uint64_t littleEndian, uint64_t bigEndian, uint8_t* data)
+{
+  for (int i = 0; i < 8; i++) {
+    data[i] = (uint8_t)(littleEndian >> (8 * i)) | (uint8_t)(bigEndian >> (56 - 8 * i));
+  }
+}
+
+constexpr int64_t dbcSignExtend(uint64_t raw, int length)
+{
+  return (int64_t)(raw << (64 - length)) >> (64 - length);
+}
+
+// round half away from zero, only used by scaled signals
+constexpr int64_t dbcRound(float value)
+{
+  return (int64_t)(value >= 0.0f ? value + 0.5f : value - 0.5f);
+}
+
+
+/*
+===============================================================================================
+                                    Messages
+===============================================================================================
+*/
+
+/**
+ * @brief TEST_STATUS (0x555), 8 bytes, sent by CAN_TEST
+ */
+struct TestStatus
+{
+  static constexpr uint32_t ID = 0x555;
+  static constexpr uint8_t DLC = 8;
+  static constexpr bool EXTENDED = false;
+
+  uint8_t counter = 0;    // 0|8@1+ (1,0) [0|255] - increments every time the message is sent
+  uint16_t uptime = 0;    // 8|16@1+ (1,0) [0|65535] "s"
+  int16_t coolantTemp = 0;    // 24|12@1- (0.1,-40) [-244.8|164.7] "degC"
+  uint8_t faultActive = 0;    // 36|1@1+ (1,0) [0|1]
+  uint16_t packVoltage = 0;    // 47|16@0+ (0.01,0) [0|655.35] "V" - big endian (motorola) to exercise both byte orders
+  int8_t packCurrent = 0;    // 63|8@0- (2,0) [-256|254] "A"
+
+  constexpr float physicalCoolantTemp() const { return coolantTemp * 0.1f - 40.0f; }
+  constexpr void setPhysicalCoolantTemp(float value) { coolantTemp = (int16_t)dbcRound((value + 40.0f) / 0.1f); }
+  constexpr float physicalPackVoltage() const { return packVoltage * 0.01f; }
+  constexpr void setPhysicalPackVoltage(float value) { packVoltage = (uint16_t)dbcRound((value) / 0.01f); }
+  constexpr int64_t physicalPackCurrent() const { return (int64_t)packCurrent * 2; }
+  constexpr void setPhysicalPackCurrent(int64_t value) { packCurrent = (int8_t)((value) / 2); }
+
+  // write every signal into an 8 byte frame buffer
+  constexpr void pack(uint8_t* data) const
+  {
+    uint64_t littleEndian = 0;
+    uint64_t bigEndian = 0;
+    littleEndian |= ((uint64_t)counter & 0xFFULL) << 0;
+    littleEndian |= ((uint64_t)uptime & 0xFFFFULL) << 8;
+    littleEndian |= ((uint64_t)coolantTemp & 0xFFFULL) << 24;
+    littleEndian |= ((uint64_t)faultActive & 0x1ULL) << 36;
+    bigEndian |= ((uint64_t)packVoltage & 0xFFFFULL) << 8;
+    bigEndian |= ((uint64_t)packCurrent & 0xFFULL) << 0;
+    dbcStore(littleEndian, bigEndian, data);
+  }
+
+  // read every signal out of an 8 byte frame buffer
+  static constexpr TestStatus unpack(const uint8_t* data)
+  {
+    const uint64_t littleEndian = dbcLoadLittleEndian(data);
+    const uint64_t bigEndian = dbcLoadBigEndian(data);
+    TestStatus message;
+    message.counter = (uint8_t)((littleEndian >> 0) & 0xFFULL);
+    message.uptime = (uint16_t)((littleEndian >> 8) & 0xFFFFULL);
+    message.coolantTemp = (int16_t)(dbcSignExtend((littleEndian >> 24) & 0xFFFULL, 12));
+    message.faultActive = (uint8_t)((littleEndian >> 36) & 0x1ULL);
+    message.packVoltage = (uint16_t)((bigEndian >> 8) & 0xFFFFULL);
+    message.packCurrent = (int8_t)(dbcSignExtend((bigEndian >> 0) & 0xFFULL, 8));
+    return message;
+  }
+};
+
+
+/**
+ * @brief NODE_STATUS (0x556), 4 bytes, sent by VEHICLE_NODE
+ */
+struct NodeStatus
+{
+  static constexpr uint32_t ID = 0x556;
+  static constexpr uint8_t DLC = 4;
+  static constexpr bool EXTENDED = false;
+
+  uint8_t counter = 0;    // 0|8@1+ (1,0) [0|255] - increments every time the message is sent
+  uint8_t imdFault = 0;    // 8|1@1+ (1,0) [0|1]
+  uint8_t bmsFault = 0;    // 9|1@1+ (1,0) [0|1]
+  uint8_t fanEnable = 0;    // 10|1@1+ (1,0) [0|1]
+  uint8_t faultLamp = 0;    // 11|1@1+ (1,0) [0|1]
+  uint8_t peersOnline = 0;    // 12|4@1+ (1,0) [0|15] - ESP-NOW peers that acknowledged a frame in the last second
+  uint8_t telemetryDelivery = 0;    // 16|8@1+ (1,0) [0|100] "%" - ESP-NOW delivery ratio to the slowest peer
+  uint8_t uptime = 0;    // 24|8@1+ (1,0) [0|255] "min"
+
+  // write every signal into an 8 byte frame buffer
+  constexpr void pack(uint8_t* data) const
+  {
+    uint64_t littleEndian = 0;
+    uint64_t bigEndian = 0;
+    littleEndian |= ((uint64_t)counter & 0xFFULL) << 0;
+    littleEndian |= ((uint64_t)imdFault & 0x1ULL) << 8;
+    littleEndian |= ((uint64_t)bmsFault & 0x1ULL) << 9;
+    littleEndian |= ((uint64_t)fanEnable & 0x1ULL) << 10;
+    littleEndian |= ((uint64_t)faultLamp & 0x1ULL) << 11;
+    littleEndian |= ((uint64_t)peersOnline & 0xFULL) << 12;
+    littleEndian |= ((uint64_t)telemetryDelivery & 0xFFULL) << 16;
+    littleEndian |= ((uint64_t)uptime & 0xFFULL) << 24;
+    dbcStore(littleEndian, bigEndian, data);
+  }
+
+  // read every signal out of an 8 byte frame buffer
+  static constexpr NodeStatus unpack(const uint8_t* data)
+  {
+    const uint64_t littleEndian = dbcLoadLittleEndian(data);
+    NodeStatus message;
+    message.counter = (uint8_t)((littleEndian >> 0) & 0xFFULL);
+    message.imdFault = (uint8_t)((littleEndian >> 8) & 0x1ULL);
+    message.bmsFault = (uint8_t)((littleEndian >> 9) & 0x1ULL);
+    message.fanEnable = (uint8_t)((littleEndian >> 10) & 0x1ULL);
+    message.faultLamp = (uint8_t)((littleEndian >> 11) & 0x1ULL);
+    message.peersOnline = (uint8_t)((littleEndian >> 12) & 0xFULL);
+    message.telemetryDelivery = (uint8_t)((littleEndian >> 16) & 0xFFULL);
+    message.uptime = (uint8_t)((littleEndian >> 24) & 0xFFULL);
+    return message;
+  }
+};
+
@@ -0,0 +1,223 @@
+/**
+ * @file bench_main.cpp
+ * @brief frames/s the CAN TX scheduler gets onto a timed 500 kbit/s bus, against the bus's
+ * theoretical maximum
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * one node runs can_tasks.h's write task step from its 1 ms tick, like main.cpp, with
+ * CAN_TX_MAX_MESSAGES periodic 8 byte messages whose periods add up to a demand from a quarter
+ * of the bus to twice the bus. the bus (sim_can_bus.h) takes every frame's exact time on the
+ * wire, stuff bits and intermission included, so the theoretical maximum of each run is the
+ * bitrate over the average bits per frame actually sent. below capacity the scheduler has to
+ * send everything on time, well above it it has to keep the bus full: frames/s within 2% of
+ * the maximum. the exit code is 1 if either fails.
+ *
+ * the driver's TX queue holds 5 frames (CAN_GENERAL_CONFIG_DEFAULT), about 1.15 ms of 8 byte
+ * frames at 500 kbit/s, so a tick that refills it just after a frame has started can leave the
+ * bus idle for a few tens of microseconds before the next one: about 1% of the bus.
+ *
+ * for reference, the blocking write task the scheduler replaced sent at most 100 frames/s.
+ *
+ * build and run: pio run -e native_bench -t exec
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include "esp_err.h"
+#include <esp_timer.h>
+#include "driver/can.h"
+#include "can_test.h"
+#include <sim_can_bus.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_BITRATE                     500000
+#define BENCH_FRAME_BITS                  114         // 8 byte standard frame with intermission and a few stuff bits
+#define BENCH_WARM_UP_US                  200000
+#define BENCH_RUN_US                      10000000
+#define BENCH_FULL_LOAD_PERCENT           98          // of the maximum, once demand is past it
+#define BENCH_ON_TIME_PERCENT             90          // demand up to which every frame has to go out on time
+#define BENCH_OVERLOAD_PERCENT            125         // demand from which the bus has to be full
+
+const int benchLoadPercents[] = { 25, 50, 75, 90, 100, 125, 150, 200 };
+const size_t benchLoadCount = sizeof(benchLoadPercents) / sizeof(benchLoadPercents[0]);
+
+TimedCanBus canBus(halSim().clock, BENCH_BITRATE);
+CanTxScheduler canTxSchedulers[benchLoadCount];
+int failures = 0;
+
+
+/*
+===============================================================================================
+                                    Node
+===============================================================================================
+*/
+
+void handleTestMessage(const can_message_t& message)
+{
+  (void)message;
+}
+
+
+/**
+ * @brief a rolling counter, so the stuff bits vary like on a real bus
+ */
+void fillCounterMessage(can_message_t& message)
+{
+  message.data[0]++;
+  message.data[7] -= 3;
+}
+
+
+/**
+ * @brief the write task's work for one scheduler tick
+ */
+void CANCallback(void* args)
+{
+  serviceCanTx(*(CanTxScheduler*)args, esp_timer_get_time());
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("  %-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
+
+
+/*
+===============================================================================================
+                                    Benchmark
+===============================================================================================
+*/
+
+struct BenchResult
+{
+  double demandFps = 0;
+  double sentFps = 0;
+  double maxFps = 0;                  // bitrate over the average bits per frame sent
+  double utilization = 0;
+  uint32_t deadlineMisses = 0;
+  uint32_t queueFull = 0;
+};
+
+/**
+ * @brief one node on a fresh controller, CAN_TX_MAX_MESSAGES messages adding up to loadPercent of the bus
+ */
+BenchResult runLoad(CanTxScheduler& scheduler, int loadPercent)
+{
+  SimCan* can = new SimCan(canBus);
+  halSim().selectCan(can);
+
+  can_general_config_t canConfig = CAN_GENERAL_CONFIG_DEFAULT((gpio_num_t)CAN_TX_PIN, (gpio_num_t)CAN_RX_PIN, CAN_MODE_NO_ACK);
+  can_timing_config_t canTimingConfig = CAN_TIMING_CONFIG_500KBITS();
+  can_filter_config_t canFilterConfig = CAN_FILTER_CONFIG_ACCEPT_ALL();
+  ESP_ERROR_CHECK(can_driver_install(&canConfig, &canTimingConfig, &canFilterConfig));
+  ESP_ERROR_CHECK(can_start());
+  ESP_ERROR_CHECK(can_reconfigure_alerts(CAN_ALERT_ALL, NULL));
+
+  const uint32_t periodUs = (uint32_t)(100.0 * CAN_TX_MAX_MESSAGES * BENCH_FRAME_BITS * 1e6 / ((double)loadPercent * BENCH_BITRATE));
+  for (int i = 0; i < CAN_TX_MAX_MESSAGES; i++) {
+    can_message_t message = {
+      .flags = CAN_MSG_FLAG_NONE,
+      .identifier = (uint32_t)(0x100 + i),
+      .data_length_code = 8,
+      .data = { (uint8_t)i, 0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, (uint8_t)(i * 7) },
+    };
+    scheduler.addPeriodic(message, periodUs, (uint8_t)(CAN_TX_MAX_MESSAGES - i), fillCounterMessage);
+  }
+
+  esp_timer_handle_t timer;
+  const esp_timer_create_args_t timerArgs = {
+    .callback = &CANCallback,
+    .arg = &scheduler,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "CAN TX Scheduler Timer",
+    .skip_unhandled_events = false,
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &timer));
+  ESP_ERROR_CHECK(esp_timer_start_periodic(timer, CAN_UPDATE_INTERVAL));
+
+  // measure from a running start, the first tick sends every message at once
+  halSim().clock.advance(BENCH_WARM_UP_US);
+  const CanTxStats before = scheduler.stats();
+  canBus.resetStats();
+  halSim().clock.advance(BENCH_RUN_US);
+  const CanTxStats after = scheduler.stats();
+
+  uint32_t frames = 0;
+  uint64_t bits = 0;
+  for (auto it = canBus.idStats().begin(); it != canBus.idStats().end(); ++it) {
+    frames += it->second.frames;
+    bits += it->second.bits;
+  }
+
+  BenchResult result;
+  result.demandFps = CAN_TX_MAX_MESSAGES * 1e6 / periodUs;
+  result.sentFps = frames * 1e6 / BENCH_RUN_US;
+  result.maxFps = frames != 0 ? (double)BENCH_BITRATE * frames / bits : 0;
+  result.utilization = canBus.utilization();
+  result.deadlineMisses = after.deadlineMisses - before.deadlineMisses;
+  result.queueFull = after.queueFull - before.queueFull;
+
+  // off the bus for good, the next run gets a fresh controller
+  esp_timer_stop(timer);
+  esp_timer_delete(timer);
+  can_stop();
+  can_driver_uninstall();
+  return result;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main()
+{
+  printf("%d periodic 8 byte messages, %u bit/s, %d us tick, TX queue %d, %.0f s per load\n\n", CAN_TX_MAX_MESSAGES,
+    BENCH_BITRATE, CAN_UPDATE_INTERVAL, SIM_CAN_DEFAULT_QUEUE_LENGTH, BENCH_RUN_US / 1e6);
+  printf("  %6s %10s %10s %10s %8s %11s %9s %10s\n", "load", "demand/s", "sent/s", "max/s", "of max", "utilization",
+    "deadline", "queue full");
+
+  BenchResult results[benchLoadCount];
+  for (size_t i = 0; i < benchLoadCount; i++) {
+    const BenchResult& result = results[i] = runLoad(canTxSchedulers[i], benchLoadPercents[i]);
+    printf("  %5d%% %10.0f %10.0f %10.0f %7.1f%% %10.1f%% %9u %10u\n", benchLoadPercents[i], result.demandFps,
+      result.sentFps, result.maxFps, result.sentFps * 100.0 / result.maxFps, result.utilization * 100.0,
+      result.deadlineMisses, result.queueFull);
+  }
+
+  printf("\n--- checks ---\n");
+  bool onTime = true;
+  bool full = true;
+  for (size_t i = 0; i < benchLoadCount; i++) {
+    const BenchResult& result = results[i];
+    if (benchLoadPercents[i] <= BENCH_ON_TIME_PERCENT) {
+      onTime = onTime && result.deadlineMisses == 0 && result.sentFps * 100 >= result.demandFps * BENCH_FULL_LOAD_PERCENT;
+    }
+    if (benchLoadPercents[i] >= BENCH_OVERLOAD_PERCENT) {
+      full = full && result.sentFps * 100 >= result.maxFps * BENCH_FULL_LOAD_PERCENT;
+    }
+  }
+  check(onTime, "below capacity every frame went out on time");
+  check(full, "past capacity the bus ran within 2% of its maximum frame rate");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
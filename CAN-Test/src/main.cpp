@@ -18,6 +18,12 @@
 #include "esp_err.h"
 #include <esp_timer.h>
 #include "driver/can.h"
+#include "can_test.h"
+#include <latency_histogram.h>
+#include <deferred_log.h>
+#include <static_task.h>
+#include <memory_report.h>
+#include <boot_sequencer.h>
 
 
 /*
@@ -26,14 +32,40 @@
 ===============================================================================================
 */
 
-#define CAN_TX_PIN                        23
-#define CAN_RX_PIN                        19
-#define MSG_ID                            0x555       // 11 bit standard format ID
-#define NUM_OF_MSGS                       10      
-
-#define CAN_UPDATE_INTERVAL               500000      // 0.5 seconds in microseconds
-#define TASK_STACK_SIZE                   4096        // in bytes
+#define TASK_STACK_SIZE                   4096        // in bytes, static
+#define CAN_TASK_CORE                     1           // core the CAN tasks are pinned to
+#define CAN_WRITE_TASK_PRIORITY           9
+#define CAN_READ_TASK_PRIORITY            10
+#define CAN_PROCESS_TASK_PRIORITY         5
+#define CAN_STATS_INTERVAL                1000        // in milliseconds
 #define MAIN_LOOP_DELAY                   1
+#define SERIAL_BAUD_RATE                  9600        // the deferred logger is throttled to this too
+#define LATENCY_REPORT_KEY                'l'         // serial key that prints the latency report
+#define LATENCY_RESET_KEY                 'r'         // serial key that clears it
+#define MEMORY_REPORT_KEY                 'm'         // serial key that prints the heap and stack report
+#define BOOT_REPORT_KEY                   'p'         // serial key that prints the boot profile
+
+
+/*
+===============================================================================================
+                                    Function Declarations 
+===============================================================================================
+*/
+
+// callbacks
+void CANCallback(void* args);
+
+// tasks
+void CANReadTask(void* pvParameters);
+void CANWriteTask(void* pvParameters);
+void CANProcessTask(void* pvParameters);
+
+// boot stages
+bool beginSerial(void* context);
+bool beginCanDriver(void* context);
+bool beginTxSchedule(void* context);
+bool beginCanTasks(void* context);
+bool beginCanTimer(void* context);
 
 
 /*
@@ -45,73 +77,142 @@
 // CAN Interface
 can_general_config_t canConfig = CAN_GENERAL_CONFIG_DEFAULT((gpio_num_t)CAN_TX_PIN, (gpio_num_t)CAN_RX_PIN, CAN_MODE_NO_ACK);   // set pins controller will use
 can_timing_config_t canTimingConfig = CAN_TIMING_CONFIG_500KBITS();         // the timing of the CAN bus
-can_filter_config_t canFilterConfig = CAN_FILTER_CONFIG_ACCEPT_ALL();       // filter so we only receive certain messages
+can_filter_config_t canFilterConfig = canDispatchTable.filterConfig();      // filter so we only receive messages in the table
+
+// long-lived CAN tasks on static stacks, started once during setup
+StaticTask<TASK_STACK_SIZE> canWriteTask;
+StaticTask<TASK_STACK_SIZE> canReadTask;
+StaticTask<TASK_STACK_SIZE> canProcessTask;
+
+// brings the node up, its profile is printed on demand over serial
+BootSequencer boot;
+esp_timer_handle_t canTimer = NULL;
+
+// owns every message this node transmits, only touched by the write task after setup
+CanTxScheduler canTxScheduler;
+
+// received frames waiting to be decoded, see can_test.h
+CanRxRing canRxRing;
+
+// timing instrumentation, printed on demand over serial
+PeriodMonitor canTimerMonitor(CAN_UPDATE_INTERVAL);
+LatencyHistogram canWriteWakeLatency;           // timer callback to write task running
+LatencyHistogram canServiceTime;                // one pass of the TX scheduler
+volatile uint32_t canTimerFiredAt = 0;          // low word of the tick time, a single store the write task cannot tear
+LatencySource latencySources[] = {
+  { "tx timer lateness", NULL, &canTimerMonitor },
+  { "tx task wake", &canWriteWakeLatency, NULL },
+  { "tx service", &canServiceTime, NULL },
+};
+
+// heap and task stacks, printed on demand over serial
+MemorySource memorySources[] = {
+  { "can write task", NULL, NULL, &canWriteTask },
+  { "can read task", NULL, NULL, &canReadTask },
+  { "can process task", NULL, NULL, &canProcessTask },
+  { "deferred log task", NULL, NULL, &deferredLog().task() },
+};
 
 
 /*
 ===============================================================================================
-                                    Function Declarations 
+                                            Setup 
 ===============================================================================================
 */
 
-// callbacks
-void CANCallback(void* args);
+void setup() {
+  // waits for a serial monitor only when built with -DBOOT_ATTACH_DELAY
+  bootAttachDelay();
+
+  // the driver and the TX schedule do not need each other, the tasks need both and the timer needs the tasks
+  // the UART and the driver allocate their interrupts on the core they are installed from, so they stay on setup's core
+  // everything logs through the deferred logger, records queued before the serial stage are printed once it is up
+  boot.add("serial", beginSerial, NULL, 0, BOOT_ON_CALLER);
+  const int canDriver = boot.add("can driver", beginCanDriver, NULL, 0, BOOT_ON_CALLER);
+  const int txSchedule = boot.add("tx schedule", beginTxSchedule, NULL);
+  const int canTasks = boot.add("can tasks", beginCanTasks, NULL, BOOT_AFTER(canDriver) | BOOT_AFTER(txSchedule));
+  boot.add("can timer", beginCanTimer, NULL, BOOT_AFTER(canTasks));
 
-// tasks
-void CANReadTask(void* pvParameters);
-void CANWriteTask(void* pvParameters);
+  // end setup
+  LOG_PRINTF("BOOT [ %s ] in %u us, '%c' prints the profile\n", boot.run() ? "SUCCESS" : "FAILED",
+    (uint32_t)(boot.endUs() - boot.beginUs()), BOOT_REPORT_KEY);
+}
 
 
 /*
 ===============================================================================================
-                                            Setup 
+                                        Boot Stages
 ===============================================================================================
 */
 
-void setup() {
-  // delay startup by 5 seconds
-  vTaskDelay(5000);
-
-  // start serial
-  Serial.begin(9600);
-  Serial.printf("\n\n|--- STARTING SETUP ---|\n\n");
-
-  // --------------------- initialize CAN Controller -------------------------- //
-  if (can_driver_install(&canConfig, &canTimingConfig, &canFilterConfig) == ESP_OK) {
-    Serial.printf("CAN INIT [ SUCCESS ]\n");
-
-    // start CAN interface
-    if (can_start() == ESP_OK) {
-      Serial.printf("CAN STARTED [ SUCCESS ]\n");
-
-      // track all alerts
-      if (can_reconfigure_alerts(CAN_ALERT_ALL, NULL) == ESP_OK) {
-        Serial.printf("CAN ALERTS [ SUCCESS ]\n");
-      } 
-      else {
-        Serial.printf("CAN ALERTS [ FAILED ]\n");
-      }
-    }
+
+/**
+ * @brief starts serial and the deferred logger, tasks log through it so they never wait on the UART
+ */
+bool beginSerial(void* context) {
+  Serial.begin(SERIAL_BAUD_RATE);
+  DeferredLogConfig logConfig;
+  logConfig.baudRate = SERIAL_BAUD_RATE;
+  return deferredLog().begin(Serial, logConfig);
+}
+
+
+/**
+ * @brief installs and starts the CAN controller with every alert tracked
+ */
+bool beginCanDriver(void* context) {
+  const char* failedStep = NULL;
+  if (startCanDriver(canConfig, canTimingConfig, canFilterConfig, &failedStep) != ESP_OK) {
+    LOG_PRINTF("CAN %s [ FAILED ]\n", failedStep);
+    return false;
   }
-  else {
-    Serial.printf("CAN INIT [ FAILED ]\n");
+  return true;
+}
+
+
+/**
+ * @brief adds every message this node sends to the TX scheduler
+ */
+bool beginTxSchedule(void* context) {
+  // transmit using self reception request
+  return scheduleTestMessage(canTxScheduler, CAN_MSG_FLAG_SELF);
+}
+
+
+/**
+ * @brief starts the CAN tasks on their static stacks
+ * the read task blocks on the driver's RX queue, the write task waits for a notification from the timer
+ * the process task is created first so the read task always has someone to notify
+ */
+bool beginCanTasks(void* context) {
+  if (!canProcessTask.start(CANProcessTask, "CAN-Process", NULL, CAN_PROCESS_TASK_PRIORITY)) {
+    LOG_PRINTF("CAN PROCESS TASK INIT [ FAILED ]\n");
+    return false;
+  }
+
+  if (!canReadTask.start(CANReadTask, "CAN-Read", NULL, CAN_READ_TASK_PRIORITY, CAN_TASK_CORE)) {
+    LOG_PRINTF("CAN READ TASK INIT [ FAILED ]\n");
+    return false;
   }
 
-  // ------------------------ initialize timers ------------------------------- //
-  // CAN Update
-  const esp_timer_create_args_t timer1_args = {
+  if (!canWriteTask.start(CANWriteTask, "CAN-Write", NULL, CAN_WRITE_TASK_PRIORITY, CAN_TASK_CORE)) {
+    LOG_PRINTF("CAN WRITE TASK INIT [ FAILED ]\n");
+    return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief starts the TX scheduler tick, the first frame goes out on its first tick
+ */
+bool beginCanTimer(void* context) {
+  const esp_timer_create_args_t canTimerArgs = {
     .callback = &CANCallback,
     .dispatch_method = ESP_TIMER_TASK,
-    .name = "CAN Read-Write Timer"
+    .name = "CAN TX Scheduler Timer"
   };
-  esp_timer_handle_t timer1;
-  ESP_ERROR_CHECK(esp_timer_create(&timer1_args, &timer1));
-
-  // start CAN timer
-  ESP_ERROR_CHECK(esp_timer_start_periodic(timer1, CAN_UPDATE_INTERVAL));
-
-  // end setup
-  Serial.printf("\n\n|--- END SETUP ---|\n\n");
+  return esp_timer_create(&canTimerArgs, &canTimer) == ESP_OK && esp_timer_start_periodic(canTimer, CAN_UPDATE_INTERVAL) == ESP_OK;
 }
 
 
@@ -123,18 +224,19 @@ void setup() {
 
 
 /**
- * @brief callback function for creating a new CAN Update task
+ * @brief callback function for signaling the CAN write task, no allocation happens here
  * 
- * @param args arguments to be passed to the task
+ * @param args arguments passed by the timer (unused)
  */
 void CANCallback(void* args) {
-  // init task parameters
-  static uint8_t ucParameterToPass;
-  TaskHandle_t xHandle = NULL;
+  int64_t now = esp_timer_get_time();
+  canTimerMonitor.mark(now);
+  canTimerFiredAt = (uint32_t)now;
 
-  // queue read and write tasks
-  xTaskCreate(CANWriteTask, "CAN-Write", TASK_STACK_SIZE, &ucParameterToPass, 9, &xHandle);
-  xTaskCreate(CANReadTask, "CAN-Read", TASK_STACK_SIZE, &ucParameterToPass, 10, &xHandle);
+  // wake the write task, the read task is already waiting on the RX queue
+  if (canWriteTask.handle() != NULL) {
+    xTaskNotifyGive(canWriteTask.handle());
+  }
 }
 
 
@@ -146,69 +248,128 @@ void CANCallback(void* args) {
 
 
 /**
- * @brief sends messages onto the can bus
+ * @brief services the TX scheduler every time the CAN timer ticks, never blocks on the driver
  * 
  * @param arg - argument passed via function pointer
  */
 void CANWriteTask(void *arg)
 {
-  // init can message to send
-  can_message_t tx_msg = {
-    .flags = CAN_MSG_FLAG_SELF,
-    .identifier = MSG_ID, 
-    .data_length_code = 1, 
-  };
-
-  // send messages
-  for (int i = 0; i < NUM_OF_MSGS; i++) {
-    // transmit messages using self reception request
-    tx_msg.data[0] = i;
-    int result = can_transmit(&tx_msg, portMAX_DELAY);
-    switch (result) {
-      case ESP_OK:
-        Serial.printf("Message Transmit Success!\n");
-      break;
-
-      case ESP_ERR_INVALID_STATE:
-        Serial.printf("ERROR: Invalid state!\n");
-      break;
-
-      case ESP_ERR_TIMEOUT:
-        Serial.printf("ERROR: Timeout!\n");
-      break;
-
-      default:
-          Serial.printf("ERROR: unhandled!\n");
-      break;
+  // init
+  bool firstFrameSent = false;
+
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // wait for the next scheduler tick
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    canWriteWakeLatency.record((uint32_t)start - canTimerFiredAt);     // unsigned, so right across the wrap too
+
+    // recover from bus-off if needed, then send whatever is due
+    serviceCanTx(canTxScheduler, start);
+    canServiceTime.record((uint32_t)(esp_timer_get_time() - start));
+
+    // the boot profile ends with the first frame the driver took
+    if (!firstFrameSent && canTxScheduler.stats().sent > 0) {
+      boot.mark("first can frame");
+      firstFrameSent = true;
     }
-
-    vTaskDelay(pdMS_TO_TICKS(10));
   }
-  
-  // end task
-  vTaskDelete(NULL);
 }
 
 
 /**
- * @brief receives messages from the can bus
+ * @brief receives messages from the can bus, blocking on the driver's RX queue between frames
+ * only copies frames into the RX ring so a slow consumer can never stall ingestion
  * 
  * @param arg - argument passed via function pointer
  */
 void CANReadTask(void *arg)
+{
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // receive message and hand it off to the process task
+    if (readCanFrame(canRxRing, portMAX_DELAY)) {
+      xTaskNotifyGive(canProcessTask.handle());
+    }
+    else {
+      // driver is not running (stopped or bus-off), back off instead of spinning
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+  }
+}
+
+
+/**
+ * @brief drains the RX ring, decoding and logging frames away from the read task
+ * 
+ * @param arg - argument passed via function pointer
+ */
+void CANProcessTask(void *arg)
 {
   // init
   can_message_t rx_message;
+  uint32_t lastOverflowCount = 0;
+  CanRxErrors rxErrors;
+  uint32_t lastDeadlineMisses = 0;
+  uint32_t lastBusOffEvents = 0;
+
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // wait for frames, waking up periodically to report ring statistics
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_STATS_INTERVAL));
+
+    // hand each frame to its handler
+    while (canRxRing.pop(rx_message)) {
+      switch (dispatchCanFrame(canDispatchTable, rx_message, rxErrors)) {
+        case CAN_DISPATCH_HANDLED:
+        break;
+
+        case CAN_DISPATCH_UNKNOWN_ID:
+          LOG_PRINTF("ERROR: no handler for ID 0x%03x (%u total)\n", rx_message.identifier, rxErrors.unknownId);
+        break;
+
+        case CAN_DISPATCH_BAD_DLC:
+          LOG_PRINTF("ERROR: bad DLC %d for ID 0x%03x (%u total)\n", rx_message.data_length_code, rx_message.identifier, rxErrors.badDlc);
+        break;
+      }
+    }
+
+    // only report when frames have been lost since the last report
+    uint32_t overflowCount = canRxRing.overflowCount();
+    if (overflowCount != lastOverflowCount) {
+      LOG_PRINTF("CAN RX RING: received: %u | overflows: %u | high water mark: %u / %u\n",
+        canRxRing.pushCount(), overflowCount, canRxRing.highWaterMark(), (unsigned)canRxRing.capacity());
+      lastOverflowCount = overflowCount;
+    }
 
-  // receive messages
-  for (int i = 0; i < NUM_OF_MSGS; i++) {
-    // receive message and print message data
-    ESP_ERROR_CHECK(can_receive(&rx_message, portMAX_DELAY));
-    Serial.printf("Msg received - Data = %d\n", rx_message.data[0]);
+    // same for the transmit side
+    const CanTxStats& txStats = canTxScheduler.stats();
+    if (txStats.deadlineMisses != lastDeadlineMisses || txStats.busOffEvents != lastBusOffEvents) {
+      LOG_PRINTF("CAN TX: sent: %u | queue full: %u | deadline misses: %u | bus-off: %u | recovered: %u | tx failed: %u\n",
+        txStats.sent, txStats.queueFull, txStats.deadlineMisses, txStats.busOffEvents, txStats.busRecoveries, txStats.txFailed);
+      lastDeadlineMisses = txStats.deadlineMisses;
+      lastBusOffEvents = txStats.busOffEvents;
+    }
   }
+}
+
+
+/*
+===============================================================================================
+                                    Message Handlers
+===============================================================================================
+*/
 
-  // end task
-  vTaskDelete(NULL);
+
+/**
+ * @brief handles the self-received test message
+ * 
+ * @param message the received frame
+ */
+void handleTestMessage(const can_message_t& message)
+{
+  const TestStatus status = TestStatus::unpack(message.data);
+  LOG_PRINTF("Msg received - Counter = %d | Uptime = %ds\n", status.counter, status.uptime);
 }
 
 
@@ -219,6 +380,23 @@ void CANReadTask(void *arg)
 */
 
 void loop() {
+  // print or clear the latency report on request
+  if (Serial.available() > 0) {
+    int key = Serial.read();
+    if (key == LATENCY_REPORT_KEY) {
+      printLatencyReport(Serial, latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == LATENCY_RESET_KEY) {
+      resetLatencyReport(latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == MEMORY_REPORT_KEY) {
+      printMemoryReport(Serial, memorySources, sizeof(memorySources) / sizeof(memorySources[0]));
+    }
+    else if (key == BOOT_REPORT_KEY) {
+      printBootReport(Serial, boot);
+    }
+  }
+
   // prevent watchdog from getting upset
   vTaskDelay(MAIN_LOOP_DELAY);   
-}
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+/**
+ * @file sim_main.cpp
+ * @brief load tests the CAN TX scheduler, RX ring and dispatch table on a timed, multi-node bus
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * FreeRTOS is not simulated: each node's write task work runs straight from its 1 ms
+ * esp_timer callback and the read / process tasks' work right after it. every node runs the
+ * task steps of can_tasks.h, the same ones main.cpp runs, through the driver API, on its own
+ * controller (halSim().selectCan), with its own schedule. the bus (sim_can_bus.h) takes each frame's real time on the wire at
+ * 500 kbit/s and arbitrates by ID, so the phases below show what the schedule does to the
+ * bus and to the lowest priority frames:
+ *   1. nominal     the vehicle's own traffic
+ *   2. overload    a logger floods high priority IDs, pushing the bus past 100%
+ *   3. bad node    the inverter's transceiver corrupts 30% of its frames until it goes bus-off
+ *   4. wrong rate  a tool at 250 kbit/s is plugged in and destroys frames while error active
+ *
+ * after the run the totals are checked against what each phase has to do to the nodes, and
+ * the exit code is 1 if any check failed.
+ *
+ * with --vcan <interface> the same nodes run in real time, bridged to SocketCAN, until killed.
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include <esp_timer.h>
+#include "driver/can.h"
+#include "can_test.h"
+#include <sim_can_bus.h>
+#include <sim_socketcan.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define SIM_BITRATE                       500000
+#define SIM_SEED                          7
+#define SIM_MAX_NODE_MESSAGES             4
+#define SIM_NODE_PHASE_STEP               137         // timer offset between nodes, ECUs are never in phase
+#define SIM_NOMINAL_US                    10000000
+#define SIM_OVERLOAD_US                   5000000
+#define SIM_BAD_NODE_US                   10000000
+#define SIM_WRONG_RATE_US                 5000000
+#define SIM_BAD_NODE_ERROR_PERMILLE       300
+#define SIM_MIN_DELIVERY_PERCENT          95          // of TEST_STATUS frames a listener must handle
+
+
+/*
+===============================================================================================
+                                  Global Variables
+===============================================================================================
+*/
+
+/**
+ * @brief one periodic frame a node sends
+ */
+struct SimMessage
+{
+  uint32_t id;
+  uint8_t dlc;
+  uint32_t periodUs;
+};
+
+/**
+ * @brief one ECU: a controller plus the CAN-Test task state, which is global in main.cpp
+ */
+struct Node
+{
+  const char* name;
+  SimMessage messages[SIM_MAX_NODE_MESSAGES];
+  bool timingMismatch;                // joins at 250 kbit/s
+
+  SimCan* can = NULL;
+  esp_timer_handle_t timer = NULL;
+  CanTxScheduler canTxScheduler = {};
+  CanRxRing canRxRing = {};
+  CanRxErrors rxErrors = {};
+  uint32_t handled = 0;
+  uint16_t lastCounter = 0;
+};
+
+TimedCanBus canBus(halSim().clock, SIM_BITRATE, SIM_SEED);
+Node* currentNode = NULL;
+
+// about 25% of the bus with every ID sent on time
+Node nodes[] = {
+  // name       messages (id, dlc, period)                                                   wrong rate
+  { "can-test", { { TestStatus::ID, TestStatus::DLC, MSG_PERIOD }, { 0x200, 8, 5000 } },      false },
+  { "inverter", { { 0x0A0, 8, 2000 }, { 0x0A1, 8, 10000 } },                                  false },
+  { "bms",      { { 0x100, 8, 10000 }, { 0x101, 8, 10000 }, { 0x102, 4, 100000 } },            false },
+  { "dash",     { { 0x300, 2, 100000 } },                                                    false },
+  { "logger",   { { 0x050, 8, 1000 }, { 0x051, 8, 1000 }, { 0x052, 8, 1000 } },               false },
+  { "tool",     { },                                                                         true },
+};
+const size_t nodeCount = sizeof(nodes) / sizeof(nodes[0]);
+Node& inverterNode = nodes[1];
+Node& loggerNode = nodes[4];
+Node& toolNode = nodes[5];
+Node& dashNode = nodes[3];
+int failures = 0;
+
+
+/*
+===============================================================================================
+                                    Simulated Tasks
+===============================================================================================
+*/
+
+/**
+ * @brief a rolling counter, so no two frames of one ID look the same on the wire
+ */
+void fillCounterMessage(can_message_t& message)
+{
+  message.data[0]++;
+}
+
+
+/**
+ * @brief the work of the write, read and process tasks for one scheduler tick of one node
+ */
+void CANCallback(void* args)
+{
+  Node& node = *(Node*)args;
+  currentNode = &node;
+  halSim().selectCan(node.can);
+  const int64_t now = esp_timer_get_time();
+
+  // write task
+  serviceCanTx(node.canTxScheduler, now);
+
+  // read task
+  while (readCanFrame(node.canRxRing, 0)) {
+  }
+
+  // process task
+  can_message_t message;
+  while (node.canRxRing.pop(message)) {
+    dispatchCanFrame(canDispatchTable, message, node.rxErrors);
+  }
+}
+
+
+void handleTestMessage(const can_message_t& message)
+{
+  currentNode->lastCounter = TestStatus::unpack(message.data).counter;
+  currentNode->handled++;
+}
+
+
+/*
+===============================================================================================
+                                    Nodes
+===============================================================================================
+*/
+
+/**
+ * @brief install and start a node's driver and schedule, then start its tick timer
+ */
+void startNode(Node& node)
+{
+  halSim().selectCan(node.can);
+
+  can_general_config_t canConfig = CAN_GENERAL_CONFIG_DEFAULT((gpio_num_t)CAN_TX_PIN, (gpio_num_t)CAN_RX_PIN, CAN_MODE_NORMAL);
+  can_timing_config_t canTimingConfig = CAN_TIMING_CONFIG_500KBITS();
+  can_timing_config_t toolTimingConfig = CAN_TIMING_CONFIG_250KBITS();
+  ESP_ERROR_CHECK(startCanDriver(canConfig, node.timingMismatch ? toolTimingConfig : canTimingConfig, canDispatchTable.filterConfig()));
+
+  for (int i = 0; i < SIM_MAX_NODE_MESSAGES && node.messages[i].periodUs != 0; i++) {
+    if (node.messages[i].id == TestStatus::ID) {
+      scheduleTestMessage(node.canTxScheduler, CAN_MSG_FLAG_NONE);
+      continue;
+    }
+    can_message_t message = {
+      .flags = CAN_MSG_FLAG_NONE,
+      .identifier = node.messages[i].id,
+      .data_length_code = node.messages[i].dlc,
+      .data = {},
+    };
+    node.canTxScheduler.addPeriodic(message, node.messages[i].periodUs, (uint8_t)(MSG_PRIORITY + 1 + i), fillCounterMessage);
+  }
+
+  const esp_timer_create_args_t timerArgs = {
+    .callback = &CANCallback,
+    .arg = &node,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "CAN TX Scheduler Timer",
+    .skip_unhandled_events = false,
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &node.timer));
+  ESP_ERROR_CHECK(esp_timer_start_periodic(node.timer, CAN_UPDATE_INTERVAL));
+}
+
+
+void stopNode(Node& node)
+{
+  halSim().selectCan(node.can);
+  esp_timer_stop(node.timer);
+  can_stop();
+  can_clear_transmit_queue();
+}
+
+
+void printNodes()
+{
+  printf("  %-10s %6s %10s %9s %9s %8s %10s %9s %7s\n", "node", "sent", "queue full", "deadline", "tx failed", "bus-off", "recovered", "handled", "bad DLC");
+  for (size_t i = 0; i < nodeCount; i++) {
+    const CanTxStats& txStats = nodes[i].canTxScheduler.stats();
+    printf("  %-10s %6u %10u %9u %9u %8u %10u %9u %7u\n", nodes[i].name, txStats.sent, txStats.queueFull, txStats.deadlineMisses,
+      txStats.txFailed, txStats.busOffEvents, txStats.busRecoveries, nodes[i].handled, nodes[i].rxErrors.badDlc);
+  }
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("  %-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
+
+
+/**
+ * @brief run a phase, then print the bus report for it
+ */
+void runPhase(const char* title, int64_t durationUs)
+{
+  canBus.resetStats();
+  halSim().clock.advance(durationUs);
+  printf("\n--- %s ---\n", title);
+  canBus.report(stdout);
+}
+
+
+/**
+ * @brief the same nodes, paced to the wall clock and bridged to a SocketCAN interface
+ */
+int runBridged(const char* interfaceName)
+{
+  SimSocketCanBridge bridge(canBus);
+  if (!bridge.open(interfaceName, SIM_BITRATE)) {
+    printf("cannot open SocketCAN interface %s\n", interfaceName);
+    return 1;
+  }
+  canBus.setName(bridge.can(), interfaceName);
+  printf("bridged to %s, running in real time (ctrl-c to stop)\n", interfaceName);
+
+  timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int64_t tickUs = 0; ; tickUs += CAN_UPDATE_INTERVAL) {
+    bridge.poll();
+    halSim().clock.advance(CAN_UPDATE_INTERVAL);
+
+    // sleep until the wall clock catches up with the simulation
+    timespec wake;
+    wake.tv_sec = start.tv_sec + (time_t)((start.tv_nsec + tickUs * 1000) / 1000000000);
+    wake.tv_nsec = (long)((start.tv_nsec + tickUs * 1000) % 1000000000);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+
+    if (tickUs % 10000000 == 0) {
+      canBus.report(stdout);
+      printf("  bridge: %u frames in, %u out, %u write failures\n", bridge.fromInterface(), bridge.toInterface(), bridge.writeFailed());
+      canBus.resetStats();
+    }
+  }
+  return 0;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  // controllers first, the logger and the tool join the bus later
+  for (size_t i = 0; i < nodeCount; i++) {
+    nodes[i].can = new SimCan(canBus);
+    canBus.setName(*nodes[i].can, nodes[i].name);
+  }
+  for (size_t i = 0; i < nodeCount; i++) {
+    if (&nodes[i] != &loggerNode && &nodes[i] != &toolNode) {
+      startNode(nodes[i]);
+      halSim().clock.advance(SIM_NODE_PHASE_STEP);
+    }
+  }
+
+  if (argc == 3 && strcmp(argv[1], "--vcan") == 0) {
+    return runBridged(argv[2]);
+  }
+
+  runPhase("1. nominal", SIM_NOMINAL_US);
+  bool onTime = true;
+  for (size_t i = 0; i < nodeCount; i++) {
+    const CanTxStats& txStats = nodes[i].canTxScheduler.stats();
+    onTime = onTime && txStats.deadlineMisses == 0 && txStats.queueFull == 0 && txStats.txFailed == 0;
+  }
+  check(onTime, "nominal: every frame sent on time");
+
+  startNode(loggerNode);
+  runPhase("2. overload: logger floods 0x050 - 0x052 every 1 ms", SIM_OVERLOAD_US);
+  stopNode(loggerNode);
+
+  canBus.setErrorRate(*inverterNode.can, SIM_BAD_NODE_ERROR_PERMILLE);
+  runPhase("3. bad node: 30% of the inverter's frames are corrupted", SIM_BAD_NODE_US);
+  canBus.setErrorRate(*inverterNode.can, 0);
+
+  startNode(toolNode);
+  runPhase("4. wrong rate: a 250 kbit/s tool joins the bus", SIM_WRONG_RATE_US);
+
+  printf("\n--- totals over %.0f s ---\n", halSim().clock.nowUs() / 1e6);
+  printNodes();
+
+  printf("\n--- checks ---\n");
+  bool dispatched = true;
+  for (size_t i = 0; i < nodeCount; i++) {
+    dispatched = dispatched && nodes[i].rxErrors.unknownId == 0 && nodes[i].rxErrors.badDlc == 0;
+  }
+  check(dispatched, "the filter only let TEST_STATUS through, always with its DLC");
+  const uint32_t testStatusSent = (uint32_t)(halSim().clock.nowUs() / MSG_PERIOD);
+  check(dashNode.handled * 100 >= testStatusSent * SIM_MIN_DELIVERY_PERCENT, "the dash handled TEST_STATUS through every phase");
+  const CanTxStats& inverterStats = inverterNode.canTxScheduler.stats();
+  check(inverterStats.busOffEvents > 0 && inverterStats.busRecoveries == inverterStats.busOffEvents,
+    "bad node: the inverter went bus-off and recovered every time");
+  check(nodes[0].canTxScheduler.stats().txFailed == 0, "can-test never failed a transmission");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
@@ -0,0 +1,335 @@
+/**
+ * @file test_main.cpp
+ * @brief can_dispatch.h's acceptance filters and dispatch, checked over every 11 bit ID
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the filters are checked the way the controller applies them: every standard ID is put in
+ * the acceptance register layout and compared against the generated code and mask, single or
+ * dual. the filters must let every listed ID through and, added up, let through exactly as
+ * many IDs as the best of the candidates (one cover, or two covers split on one ID bit) found
+ * by brute force, counting IDs. dispatch is run for every ID against the table's own lookup.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <unity.h>
+#include <can_dispatch.h>
+
+
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+#define RANDOM_TABLES                     2000
+#define MAX_RANDOM_IDS                    12
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief what one filter of the controller does with a standard data frame: RTR and data bits
+ * are 0, only the bits the mask cares about are compared
+ *
+ * @param half 0 for a single filter or the first of two, 1 for the second
+ */
+static bool filterHalfAccepts(const can_filter_config_t& filter, int half, uint16_t id)
+{
+  if (filter.single_filter) {
+    const uint32_t frame = (uint32_t)id << CAN_FILTER_SINGLE_ID_SHIFT;
+    return ((frame ^ filter.acceptance_code) & ~filter.acceptance_mask) == 0;
+  }
+  const uint32_t frame = (uint32_t)id << (half == 0 ? CAN_FILTER_DUAL_ID1_SHIFT : CAN_FILTER_DUAL_ID2_SHIFT);
+  const uint32_t bits = (half == 0 ? 0xFFFF0000 : 0x0000FFFF) & ~CAN_FILTER_DUAL_UNUSED_MASK;
+  return ((frame ^ filter.acceptance_code) & ~filter.acceptance_mask & bits) == 0;
+}
+
+static bool filterAccepts(const can_filter_config_t& filter, uint16_t id)
+{
+  return filterHalfAccepts(filter, 0, id) || (!filter.single_filter && filterHalfAccepts(filter, 1, id));
+}
+
+static uint32_t acceptedCount(const can_filter_config_t& filter)
+{
+  uint32_t count = 0;
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    count += filterAccepts(filter, id) ? 1 : 0;
+  }
+  return count;
+}
+
+/**
+ * @brief IDs each filter lets through, added up, an ID both let through counts twice
+ */
+static uint32_t filterCost(const can_filter_config_t& filter)
+{
+  uint32_t count = 0;
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    count += filterHalfAccepts(filter, 0, id) ? 1 : 0;
+    count += !filter.single_filter && filterHalfAccepts(filter, 1, id) ? 1 : 0;
+  }
+  return count;
+}
+
+/**
+ * @brief IDs let through by the tightest code / don't care pair over ids, counted one by one
+ */
+static std::vector<bool> bruteForceCover(const std::vector<uint16_t>& ids)
+{
+  std::vector<bool> accepted(CAN_STANDARD_ID_COUNT, false);
+  if (ids.empty()) {
+    return accepted;
+  }
+  uint16_t varying = 0;
+  for (size_t i = 0; i < ids.size(); i++) {
+    varying |= ids[i] ^ ids[0];
+  }
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    accepted[id] = ((id ^ ids[0]) & ~varying & CAN_STANDARD_ID_MASK) == 0;
+  }
+  return accepted;
+}
+
+/**
+ * @brief fewest IDs any of the candidate filters lets through, counted over the whole ID space
+ */
+static uint32_t bruteForceBest(const std::vector<uint16_t>& ids)
+{
+  const std::vector<bool> single = bruteForceCover(ids);
+  uint32_t best = 0;
+  for (int id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    best += single[id] ? 1 : 0;
+  }
+
+  for (int bit = 0; bit < 11; bit++) {
+    std::vector<uint16_t> zeros;
+    std::vector<uint16_t> ones;
+    for (size_t i = 0; i < ids.size(); i++) {
+      ((ids[i] >> bit) & 1 ? ones : zeros).push_back(ids[i]);
+    }
+    if (zeros.empty() || ones.empty()) {
+      continue;
+    }
+    // the controller lets an ID through once even if both filters match it, the generator
+    // counts it twice, so compare on the generator's terms
+    const std::vector<bool> first = bruteForceCover(zeros);
+    const std::vector<bool> second = bruteForceCover(ones);
+    uint32_t cost = 0;
+    for (int id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+      cost += (first[id] ? 1 : 0) + (second[id] ? 1 : 0);
+    }
+    best = cost < best ? cost : best;
+  }
+  return best;
+}
+
+/**
+ * @brief the generated filter over ids lets every one of them through, and is as tight as
+ * the brute-force best
+ */
+static void checkFilter(const std::vector<uint16_t>& ids)
+{
+  const can_filter_config_t filter = canFilterForIds(ids.data(), ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    TEST_ASSERT_TRUE_MESSAGE(filterAccepts(filter, ids[i]), "a listed ID is filtered out");
+  }
+  TEST_ASSERT_EQUAL_UINT32(bruteForceBest(ids), filterCost(filter));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(filterCost(filter), acceptedCount(filter));
+}
+
+
+/*
+===============================================================================================
+                                    Handlers
+===============================================================================================
+*/
+
+static uint16_t lastHandledId = 0;
+static int handledCount = 0;
+
+static void handleMessage(const can_message_t& message)
+{
+  lastHandledId = (uint16_t)message.identifier;
+  handledCount++;
+}
+
+constexpr CanMessageEntry messageTable[] = {
+  { 0x0C4,  8,  handleMessage },
+  { 0x0C5,  8,  handleMessage },
+  { 0x3E9,  4,  handleMessage },
+  { 0x555,  8,  handleMessage },
+  { 0x7FF,  0,  handleMessage },
+};
+constexpr auto dispatchTable = makeCanDispatchTable(messageTable);
+
+
+void setUp(void)
+{
+  randomState = 1;
+  lastHandledId = 0;
+  handledCount = 0;
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Filter Tests
+===============================================================================================
+*/
+
+void test_one_id_gets_an_exact_single_filter(void)
+{
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    const can_filter_config_t filter = canFilterForIds(&id, 1);
+    TEST_ASSERT_TRUE(filter.single_filter);
+    TEST_ASSERT_EQUAL_UINT32(1, acceptedCount(filter));
+    TEST_ASSERT_TRUE(filterAccepts(filter, id));
+  }
+}
+
+
+void test_two_distant_ids_get_an_exact_dual_filter(void)
+{
+  const std::vector<uint16_t> ids = { 0x000, 0x7FF };
+  const can_filter_config_t filter = canFilterForIds(ids.data(), ids.size());
+  TEST_ASSERT_FALSE(filter.single_filter);
+  TEST_ASSERT_EQUAL_UINT32(2, acceptedCount(filter));
+}
+
+
+void test_neighbouring_ids_share_a_single_filter(void)
+{
+  const std::vector<uint16_t> ids = { 0x100, 0x101, 0x102, 0x103 };
+  const can_filter_config_t filter = canFilterForIds(ids.data(), ids.size());
+  TEST_ASSERT_TRUE(filter.single_filter);
+  TEST_ASSERT_EQUAL_UINT32(4, acceptedCount(filter));
+  checkFilter(ids);
+}
+
+
+void test_random_tables_match_the_brute_force_filter(void)
+{
+  int singles = 0;
+  int duals = 0;
+  for (int table = 0; table < RANDOM_TABLES; table++) {
+    // half of them clustered, as the IDs of one ECU tend to be
+    std::vector<uint16_t> ids;
+    const size_t count = 1 + nextRandom() % MAX_RANDOM_IDS;
+    const uint16_t base = (uint16_t)(nextRandom() & CAN_STANDARD_ID_MASK);
+    const uint16_t spread = table % 2 == 0 ? 0x00F : CAN_STANDARD_ID_MASK;
+    while (ids.size() < count) {
+      const uint16_t id = (uint16_t)((base ^ (nextRandom() & spread)) & CAN_STANDARD_ID_MASK);
+      bool seen = false;
+      for (size_t i = 0; i < ids.size(); i++) {
+        seen |= ids[i] == id;
+      }
+      if (!seen) {
+        ids.push_back(id);
+      }
+    }
+    checkFilter(ids);
+    const can_filter_config_t filter = canFilterForIds(ids.data(), ids.size());
+    (filter.single_filter ? singles : duals)++;
+  }
+  // both layouts were exercised
+  TEST_ASSERT_GREATER_THAN(0, singles);
+  TEST_ASSERT_GREATER_THAN(0, duals);
+}
+
+
+void test_filter_is_a_constant_expression(void)
+{
+  constexpr can_filter_config_t filter = dispatchTable.filterConfig();
+  static_assert(filter.acceptance_mask != 0xFFFFFFFF, "the table must not accept everything");
+  const std::vector<uint16_t> ids = { 0x0C4, 0x0C5, 0x3E9, 0x555, 0x7FF };
+  const can_filter_config_t expected = canFilterForIds(ids.data(), ids.size());
+  TEST_ASSERT_EQUAL_HEX32(expected.acceptance_code, filter.acceptance_code);
+  TEST_ASSERT_EQUAL_HEX32(expected.acceptance_mask, filter.acceptance_mask);
+  checkFilter(ids);
+}
+
+
+/*
+===============================================================================================
+                                    Dispatch Tests
+===============================================================================================
+*/
+
+void test_every_id_dispatches_by_the_table(void)
+{
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    const CanMessageEntry* entry = dispatchTable.find(id);
+    can_message_t message = {};
+    message.identifier = id;
+    message.data_length_code = entry != NULL ? entry->dlc : 8;
+
+    handledCount = 0;
+    const CanDispatchResult result = dispatchTable.dispatch(message);
+    if (entry == NULL) {
+      TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_UNKNOWN_ID, result);
+      TEST_ASSERT_EQUAL_INT(0, handledCount);
+    }
+    else {
+      TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_HANDLED, result);
+      TEST_ASSERT_EQUAL_INT(1, handledCount);
+      TEST_ASSERT_EQUAL_UINT16(id, lastHandledId);
+      TEST_ASSERT_EQUAL_UINT16(id, entry->id);
+    }
+  }
+
+  int found = 0;
+  for (uint16_t id = 0; id < CAN_STANDARD_ID_COUNT; id++) {
+    found += dispatchTable.find(id) != NULL ? 1 : 0;
+  }
+  TEST_ASSERT_EQUAL_INT(dispatchTable.size(), found);
+}
+
+
+void test_wrong_length_and_extended_frames_are_not_handled(void)
+{
+  can_message_t message = {};
+  message.identifier = 0x3E9;
+  message.data_length_code = 8;
+  TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_BAD_DLC, dispatchTable.dispatch(message));
+
+  message.data_length_code = 4;
+  message.flags = CAN_MSG_FLAG_EXTD;
+  TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_UNKNOWN_ID, dispatchTable.dispatch(message));
+
+  // an extended ID whose low bits name a table entry
+  message.flags = CAN_MSG_FLAG_EXTD;
+  message.identifier = 0x10000000 | 0x3E9;
+  TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_UNKNOWN_ID, dispatchTable.dispatch(message));
+  message.flags = 0;
+  TEST_ASSERT_EQUAL_INT(CAN_DISPATCH_UNKNOWN_ID, dispatchTable.dispatch(message));
+  TEST_ASSERT_EQUAL_INT(0, handledCount);
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_one_id_gets_an_exact_single_filter);
+  RUN_TEST(test_two_distant_ids_get_an_exact_dual_filter);
+  RUN_TEST(test_neighbouring_ids_share_a_single_filter);
+  RUN_TEST(test_random_tables_match_the_brute_force_filter);
+  RUN_TEST(test_filter_is_a_constant_expression);
+  RUN_TEST(test_every_id_dispatches_by_the_table);
+  RUN_TEST(test_wrong_length_and_extended_frames_are_not_handled);
+  return UNITY_END();
+}
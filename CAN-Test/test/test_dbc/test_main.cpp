@@ -0,0 +1,308 @@
+/**
+ * @file test_main.cpp
+ * @brief the generated vehicle_dbc.h against the DBC's bit numbering, Intel and Motorola
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the generated pack() and unpack() bake every signal into shifts and masks. here they are
+ * checked three ways: a few frames worked out by hand from vehicle.dbc, random raw values
+ * through pack() and unpack() and back, and every signal read out of a packed frame (and
+ * written into a random one) by a plain bit-at-a-time reference that walks the DBC numbering:
+ * an Intel signal from its start bit upwards, a Motorola signal from its start bit (the most
+ * significant bit) down to bit 0 of a byte and on at bit 7 of the next.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "vehicle_dbc.h"
+
+
+/*
+===============================================================================================
+                                    Reference
+===============================================================================================
+*/
+
+#define RANDOM_FRAMES                     10000
+
+/**
+ * @brief one SG_ line of vehicle.dbc
+ */
+struct SignalDefinition
+{
+  const char* name;
+  int start;
+  int length;
+  bool intel;                         // @1, little endian
+  bool isSigned;
+};
+
+const SignalDefinition testStatusSignals[] = {
+  { "COUNTER",        0,  8,  true,   false },
+  { "UPTIME",         8,  16, true,   false },
+  { "COOLANT_TEMP",   24, 12, true,   true  },
+  { "FAULT_ACTIVE",   36, 1,  true,   false },
+  { "PACK_VOLTAGE",   47, 16, false,  false },
+  { "PACK_CURRENT",   63, 8,  false,  true  },
+};
+
+const SignalDefinition nodeStatusSignals[] = {
+  { "COUNTER",            0,  8,  true,   false },
+  { "IMD_FAULT",          8,  1,  true,   false },
+  { "BMS_FAULT",          9,  1,  true,   false },
+  { "FAN_ENABLE",         10, 1,  true,   false },
+  { "FAULT_LAMP",         11, 1,  true,   false },
+  { "PEERS_ONLINE",       12, 4,  true,   false },
+  { "TELEMETRY_DELIVERY", 16, 8,  true,   false },
+  { "UPTIME",             24, 8,  true,   false },
+};
+
+/**
+ * @brief frame bit positions of a signal, most significant first
+ */
+static void signalBits(const SignalDefinition& signal, int* bits)
+{
+  int position = signal.start;
+  for (int i = 0; i < signal.length; i++) {
+    if (signal.intel) {
+      bits[signal.length - 1 - i] = signal.start + i;
+    }
+    else {
+      bits[i] = position;
+      position = position % 8 == 0 ? position + 15 : position - 1;
+    }
+  }
+}
+
+static int64_t referenceRead(const SignalDefinition& signal, const uint8_t* data)
+{
+  int bits[64];
+  signalBits(signal, bits);
+  uint64_t raw = 0;
+  for (int i = 0; i < signal.length; i++) {
+    raw = raw << 1 | ((data[bits[i] / 8] >> (bits[i] % 8)) & 1);
+  }
+  if (signal.isSigned && (raw >> (signal.length - 1)) & 1) {
+    return (int64_t)raw - ((int64_t)1 << signal.length);
+  }
+  return (int64_t)raw;
+}
+
+static void referenceWrite(const SignalDefinition& signal, int64_t value, uint8_t* data)
+{
+  int bits[64];
+  signalBits(signal, bits);
+  for (int i = 0; i < signal.length; i++) {
+    const int bit = ((uint64_t)value >> (signal.length - 1 - i)) & 1;
+    data[bits[i] / 8] = (uint8_t)((data[bits[i] / 8] & ~(1 << (bits[i] % 8))) | bit << (bits[i] % 8));
+  }
+}
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief any raw value the signal can hold
+ */
+static int64_t randomRaw(const SignalDefinition& signal)
+{
+  const uint64_t raw = ((uint64_t)nextRandom() << 32 | nextRandom()) & ((1ull << signal.length) - 1);
+  return signal.isSigned ? dbcSignExtend(raw, signal.length) : (int64_t)raw;
+}
+
+static void randomFrame(uint8_t* data)
+{
+  for (int i = 0; i < 8; i++) {
+    data[i] = (uint8_t)nextRandom();
+  }
+}
+
+static int64_t testStatusSignal(const TestStatus& message, int index)
+{
+  const int64_t values[] = { message.counter, message.uptime, message.coolantTemp, message.faultActive,
+    message.packVoltage, message.packCurrent };
+  return values[index];
+}
+
+static int64_t nodeStatusSignal(const NodeStatus& message, int index)
+{
+  const int64_t values[] = { message.counter, message.imdFault, message.bmsFault, message.fanEnable,
+    message.faultLamp, message.peersOnline, message.telemetryDelivery, message.uptime };
+  return values[index];
+}
+
+
+void setUp(void)
+{
+  randomState = 1;
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Tests
+===============================================================================================
+*/
+
+void test_frames_worked_out_by_hand(void)
+{
+  TestStatus status;
+  status.counter = 0xA5;
+  status.uptime = 0x1234;                 // Intel: low byte first, bytes 1 and 2
+  status.coolantTemp = -2;                // 12 bits from bit 24: 0xFFE, byte 3 and the low nibble of byte 4
+  status.faultActive = 1;                 // bit 36, bit 4 of byte 4
+  status.packVoltage = 0xBEEF;            // Motorola from bit 47: byte 5 then byte 6
+  status.packCurrent = -3;                // Motorola from bit 63: byte 7
+  uint8_t data[8] = {};
+  status.pack(data);
+
+  const uint8_t expected[8] = { 0xA5, 0x34, 0x12, 0xFE, 0x1F, 0xBE, 0xEF, 0xFD };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, 8);
+
+  const TestStatus back = TestStatus::unpack(expected);
+  TEST_ASSERT_EQUAL_INT(-2, back.coolantTemp);
+  TEST_ASSERT_EQUAL_HEX16(0xBEEF, back.packVoltage);
+  TEST_ASSERT_EQUAL_INT(-3, back.packCurrent);
+
+  NodeStatus node;
+  node.fanEnable = 1;                     // bit 10
+  node.peersOnline = 0xC;                 // bits 12 - 15
+  node.uptime = 0x7E;                     // byte 3
+  uint8_t nodeData[8] = {};
+  node.pack(nodeData);
+  const uint8_t nodeExpected[8] = { 0x00, 0xC4, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00 };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(nodeExpected, nodeData, 8);
+}
+
+
+void test_scaled_signals(void)
+{
+  TestStatus status;
+  status.setPhysicalPackVoltage(400.0f);
+  TEST_ASSERT_EQUAL_UINT16(40000, status.packVoltage);
+  status.setPhysicalCoolantTemp(-40.0f);
+  TEST_ASSERT_EQUAL_INT(0, status.coolantTemp);
+  status.setPhysicalCoolantTemp(90.5f);
+  TEST_ASSERT_EQUAL_INT(1305, status.coolantTemp);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 90.5f, status.physicalCoolantTemp());
+  status.setPhysicalPackCurrent(-256);
+  TEST_ASSERT_EQUAL_INT(-128, status.packCurrent);
+  TEST_ASSERT_EQUAL_INT64(-256, status.physicalPackCurrent());
+}
+
+
+void test_round_trip_of_random_raw_values(void)
+{
+  for (int frame = 0; frame < RANDOM_FRAMES; frame++) {
+    TestStatus status;
+    status.counter = (uint8_t)randomRaw(testStatusSignals[0]);
+    status.uptime = (uint16_t)randomRaw(testStatusSignals[1]);
+    status.coolantTemp = (int16_t)randomRaw(testStatusSignals[2]);
+    status.faultActive = (uint8_t)randomRaw(testStatusSignals[3]);
+    status.packVoltage = (uint16_t)randomRaw(testStatusSignals[4]);
+    status.packCurrent = (int8_t)randomRaw(testStatusSignals[5]);
+    uint8_t data[8] = {};
+    status.pack(data);
+    const TestStatus back = TestStatus::unpack(data);
+    for (int i = 0; i < 6; i++) {
+      TEST_ASSERT_EQUAL_INT64_MESSAGE(testStatusSignal(status, i), testStatusSignal(back, i), testStatusSignals[i].name);
+    }
+
+    NodeStatus node;
+    node.counter = (uint8_t)randomRaw(nodeStatusSignals[0]);
+    node.imdFault = (uint8_t)randomRaw(nodeStatusSignals[1]);
+    node.bmsFault = (uint8_t)randomRaw(nodeStatusSignals[2]);
+    node.fanEnable = (uint8_t)randomRaw(nodeStatusSignals[3]);
+    node.faultLamp = (uint8_t)randomRaw(nodeStatusSignals[4]);
+    node.peersOnline = (uint8_t)randomRaw(nodeStatusSignals[5]);
+    node.telemetryDelivery = (uint8_t)randomRaw(nodeStatusSignals[6]);
+    node.uptime = (uint8_t)randomRaw(nodeStatusSignals[7]);
+    node.pack(data);
+    const NodeStatus nodeBack = NodeStatus::unpack(data);
+    for (int i = 0; i < 8; i++) {
+      TEST_ASSERT_EQUAL_INT64_MESSAGE(nodeStatusSignal(node, i), nodeStatusSignal(nodeBack, i), nodeStatusSignals[i].name);
+    }
+  }
+}
+
+
+void test_unpack_matches_the_reference_on_random_frames(void)
+{
+  for (int frame = 0; frame < RANDOM_FRAMES; frame++) {
+    uint8_t data[8];
+    randomFrame(data);
+    const TestStatus status = TestStatus::unpack(data);
+    for (int i = 0; i < 6; i++) {
+      TEST_ASSERT_EQUAL_INT64_MESSAGE(referenceRead(testStatusSignals[i], data), testStatusSignal(status, i), testStatusSignals[i].name);
+    }
+    const NodeStatus node = NodeStatus::unpack(data);
+    for (int i = 0; i < 8; i++) {
+      TEST_ASSERT_EQUAL_INT64_MESSAGE(referenceRead(nodeStatusSignals[i], data), nodeStatusSignal(node, i), nodeStatusSignals[i].name);
+    }
+  }
+}
+
+
+void test_pack_matches_the_reference_signal_by_signal(void)
+{
+  // one signal set at a time, so a signal spilling into its neighbour's bits shows up
+  for (int frame = 0; frame < RANDOM_FRAMES; frame++) {
+    const int index = frame % 6;
+    const SignalDefinition& signal = testStatusSignals[index];
+    const int64_t value = randomRaw(signal);
+
+    TestStatus status;
+    switch (index) {
+      case 0: status.counter = (uint8_t)value; break;
+      case 1: status.uptime = (uint16_t)value; break;
+      case 2: status.coolantTemp = (int16_t)value; break;
+      case 3: status.faultActive = (uint8_t)value; break;
+      case 4: status.packVoltage = (uint16_t)value; break;
+      default: status.packCurrent = (int8_t)value; break;
+    }
+    uint8_t data[8] = {};
+    status.pack(data);
+
+    uint8_t expected[8] = {};
+    referenceWrite(signal, value, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, 8);
+  }
+}
+
+
+void test_unpack_is_a_constant_expression(void)
+{
+  constexpr uint8_t frame[8] = { 0x01, 0x10, 0x0E, 0x00, 0x00, 0x9C, 0x40, 0x80 };
+  constexpr TestStatus status = TestStatus::unpack(frame);
+  static_assert(status.uptime == 3600, "uptime is Intel from bit 8");
+  static_assert(status.packVoltage == 40000, "pack voltage is Motorola from bit 47");
+  static_assert(status.packCurrent == -128, "pack current is signed Motorola from bit 63");
+  TEST_ASSERT_EQUAL_UINT8(1, status.counter);
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_worked_out_by_hand);
+  RUN_TEST(test_scaled_signals);
+  RUN_TEST(test_round_trip_of_random_raw_values);
+  RUN_TEST(test_unpack_matches_the_reference_on_random_frames);
+  RUN_TEST(test_pack_matches_the_reference_signal_by_signal);
+  RUN_TEST(test_unpack_is_a_constant_expression);
+  return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_main.cpp
+ * @brief the CAN task bodies allocate nothing once the node is up
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a lone node runs can_tasks.h's write, read and process steps from a 1 ms timer on the
+ * simulated board, receiving its own TEST_STATUS back, like main.cpp in CAN_MODE_NO_ACK.
+ * after a warm-up every allocation is counted: operator new always, malloc as well where
+ * glibc lets the test stand in front of it. the simulated driver sizes its queues at install,
+ * so anything counted comes from the code under test.
+ */
+
+#include <stdlib.h>
+#include <new>
+#include <unity.h>
+#include "can_test.h"
+
+
+/*
+===============================================================================================
+                                    Allocation Counter
+===============================================================================================
+*/
+
+static volatile bool countAllocations = false;
+static volatile size_t allocations = 0;
+
+#ifdef __GLIBC__
+// operator new allocates through malloc, so counting malloc counts both
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+  allocations += countAllocations ? 1 : 0;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+  allocations += countAllocations ? 1 : 0;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+  allocations += countAllocations ? 1 : 0;
+  return __libc_realloc(pointer, size);
+}
+#else
+void* operator new(size_t size)
+{
+  allocations += countAllocations ? 1 : 0;
+  void* pointer = malloc(size == 0 ? 1 : size);
+  if (pointer == NULL) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+  free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+  free(pointer);
+}
+#endif
+
+
+/*
+===============================================================================================
+                                    Node
+===============================================================================================
+*/
+
+#define WARM_UP_US                        1000000
+#define STEADY_STATE_US                   10000000
+
+CanTxScheduler canTxScheduler;
+CanRxRing canRxRing;
+CanRxErrors rxErrors;
+esp_timer_handle_t canTimer = NULL;
+uint32_t handled = 0;
+
+
+void handleTestMessage(const can_message_t& message)
+{
+  (void)TestStatus::unpack(message.data);
+  handled++;
+}
+
+
+/**
+ * @brief the write, read and process tasks back to back, as the simulation runs them
+ */
+void CANCallback(void* args)
+{
+  (void)args;
+  serviceCanTx(canTxScheduler, esp_timer_get_time());
+  while (readCanFrame(canRxRing, 0)) {
+  }
+  can_message_t message;
+  while (canRxRing.pop(message)) {
+    dispatchCanFrame(canDispatchTable, message, rxErrors);
+  }
+}
+
+
+/**
+ * @brief install the driver and start the tick, once for every test
+ */
+void setUp(void)
+{
+  if (canTimer != NULL) {
+    return;
+  }
+
+  can_general_config_t canConfig = CAN_GENERAL_CONFIG_DEFAULT((gpio_num_t)CAN_TX_PIN, (gpio_num_t)CAN_RX_PIN, CAN_MODE_NO_ACK);
+  can_timing_config_t canTimingConfig = CAN_TIMING_CONFIG_500KBITS();
+  TEST_ASSERT_EQUAL(ESP_OK, startCanDriver(canConfig, canTimingConfig, canDispatchTable.filterConfig()));
+  TEST_ASSERT_TRUE(scheduleTestMessage(canTxScheduler, CAN_MSG_FLAG_SELF));
+
+  const esp_timer_create_args_t timerArgs = {
+    .callback = &CANCallback,
+    .arg = NULL,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "CAN TX Scheduler Timer",
+    .skip_unhandled_events = false,
+  };
+  TEST_ASSERT_EQUAL(ESP_OK, esp_timer_create(&timerArgs, &canTimer));
+  TEST_ASSERT_EQUAL(ESP_OK, esp_timer_start_periodic(canTimer, CAN_UPDATE_INTERVAL));
+
+  // first frames, first alerts, lazily built statics
+  halSim().clock.advance(WARM_UP_US);
+}
+
+
+void tearDown(void)
+{
+  countAllocations = false;
+}
+
+
+/*
+===============================================================================================
+                                    Tests
+===============================================================================================
+*/
+
+void test_steady_state_allocates_nothing(void)
+{
+  const uint32_t handledBefore = handled;
+  allocations = 0;
+  countAllocations = true;
+  halSim().clock.advance(STEADY_STATE_US);
+  countAllocations = false;
+
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+  TEST_ASSERT_EQUAL_UINT32(STEADY_STATE_US / MSG_PERIOD, handled - handledBefore);
+  TEST_ASSERT_EQUAL_UINT32(0, rxErrors.unknownId + rxErrors.badDlc);
+  TEST_ASSERT_EQUAL_UINT32(0, canRxRing.overflowCount());
+}
+
+
+void test_bus_off_and_recovery_allocate_nothing(void)
+{
+  const uint32_t busOffBefore = canTxScheduler.stats().busOffEvents;
+  allocations = 0;
+  countAllocations = true;
+  halSim().currentCan().forceBusOff();
+  halSim().clock.advance(STEADY_STATE_US);
+  countAllocations = false;
+
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+  TEST_ASSERT_EQUAL_UINT32(busOffBefore + 1, canTxScheduler.stats().busOffEvents);
+  TEST_ASSERT_EQUAL_UINT32(canTxScheduler.stats().busOffEvents, canTxScheduler.stats().busRecoveries);
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_state_allocates_nothing);
+  RUN_TEST(test_bus_off_and_recovery_allocate_nothing);
+  return UNITY_END();
+}
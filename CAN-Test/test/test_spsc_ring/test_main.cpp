@@ -0,0 +1,179 @@
+/**
+ * @file test_main.cpp
+ * @brief CanRxRing between two threads at and beyond full bus load
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a producer thread stands in for the read task, a consumer thread for the process task. at
+ * 1 Mbit/s a bus full of the shortest standard frames (47 bits with the interframe space,
+ * before stuffing) carries 21276 frames/s, the most the read task can ever be asked to move.
+ * the producer pushes them at that rate, waking every millisecond and handing over the frames
+ * that have arrived one at a time, and the consumer must take every one, in order. a second
+ * run pushes as fast as it can so the ring does fill, and every frame must then be either
+ * popped or counted as an overflow.
+ *
+ * the threads only count, the assertions run on the test thread after both have joined.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unity.h>
+#include "can_test.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BUS_BITRATE                       1000000
+#define MIN_FRAME_BITS                    47          // SOF to EOF of a 0 byte standard frame plus 3 bits interframe space
+#define BUS_FRAMES_PER_SECOND             (BUS_BITRATE / MIN_FRAME_BITS)
+#define BUS_SECONDS                       2
+#define UNPACED_FRAMES                    2000000
+
+
+void handleTestMessage(const can_message_t& message)
+{
+  (void)message;
+}
+
+
+/*
+===============================================================================================
+                                    Producer and Consumer
+===============================================================================================
+*/
+
+struct ConsumerResult
+{
+  uint32_t popped = 0;
+  uint32_t outOfOrder = 0;            // sequence numbers not above the previous one
+  uint32_t lastSequence = 0;
+};
+
+static can_message_t frameNumbered(uint32_t sequence)
+{
+  can_message_t message = {};
+  message.identifier = TestStatus::ID;
+  message.data_length_code = 4;
+  message.data[0] = (uint8_t)sequence;
+  message.data[1] = (uint8_t)(sequence >> 8);
+  message.data[2] = (uint8_t)(sequence >> 16);
+  message.data[3] = (uint8_t)(sequence >> 24);
+  return message;
+}
+
+static uint32_t sequenceOf(const can_message_t& message)
+{
+  return (uint32_t)message.data[0] | (uint32_t)message.data[1] << 8 | (uint32_t)message.data[2] << 16
+    | (uint32_t)message.data[3] << 24;
+}
+
+/**
+ * @brief pop until the producer is done and the ring is empty, sequences start at 1
+ */
+static void consume(CanRxRing& ring, const std::atomic<bool>& producerDone, ConsumerResult& result)
+{
+  can_message_t message;
+  for (;;) {
+    if (ring.pop(message)) {
+      const uint32_t sequence = sequenceOf(message);
+      result.outOfOrder += sequence <= result.lastSequence ? 1 : 0;
+      result.lastSequence = sequence;
+      result.popped++;
+    }
+    else if (producerDone.load(std::memory_order_acquire) && ring.empty()) {
+      return;
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Tests
+===============================================================================================
+*/
+
+void test_full_bus_load_loses_no_frame(void)
+{
+  static CanRxRing ring;
+  std::atomic<bool> producerDone(false);
+  ConsumerResult result;
+  std::thread consumer(consume, std::ref(ring), std::cref(producerDone), std::ref(result));
+
+  // every millisecond, push the frames the bus has carried since the start
+  const uint32_t total = BUS_FRAMES_PER_SECOND * BUS_SECONDS;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint32_t sequence = 0;
+  uint32_t tick = 0;
+  while (sequence < total) {
+    const uint64_t elapsedUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    uint64_t due = elapsedUs * BUS_FRAMES_PER_SECOND / 1000000;
+    due = due > total ? total : due;
+    while (sequence < due) {
+      ring.push(frameNumbered(++sequence));
+      std::this_thread::yield();      // one frame at a time, as can_receive() hands them over
+    }
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(++tick));
+  }
+  producerDone.store(true, std::memory_order_release);
+  consumer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, ring.overflowCount());
+  TEST_ASSERT_EQUAL_UINT32(total, ring.pushCount());
+  TEST_ASSERT_EQUAL_UINT32(total, result.popped);
+  TEST_ASSERT_EQUAL_UINT32(0, result.outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(total, result.lastSequence);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(CAN_RX_RING_SIZE, ring.highWaterMark());
+}
+
+
+void test_overflows_are_counted_not_lost(void)
+{
+  static CanRxRing ring;
+  std::atomic<bool> producerDone(false);
+  ConsumerResult result;
+  std::thread consumer(consume, std::ref(ring), std::cref(producerDone), std::ref(result));
+
+  for (uint32_t sequence = 1; sequence <= UNPACED_FRAMES; sequence++) {
+    ring.push(frameNumbered(sequence));
+  }
+  producerDone.store(true, std::memory_order_release);
+  consumer.join();
+
+  // dropped frames leave gaps, never reorder or duplicate
+  TEST_ASSERT_EQUAL_UINT32(UNPACED_FRAMES, ring.pushCount() + ring.overflowCount());
+  TEST_ASSERT_EQUAL_UINT32(ring.pushCount(), result.popped);
+  TEST_ASSERT_EQUAL_UINT32(0, result.outOfOrder);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(CAN_RX_RING_SIZE, ring.highWaterMark());
+  TEST_ASSERT_TRUE(ring.empty());
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_full_bus_load_loses_no_frame);
+  RUN_TEST(test_overflows_are_counted_not_lost);
+  return UNITY_END();
+}
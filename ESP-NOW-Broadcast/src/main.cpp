@@ -12,7 +12,21 @@
 
 // --- defines --- // 
 #define TIMER_INTERRUPT_PRESCALER       80          // this is based off to the clock speed (assuming 80 MHz)
-#define TIMER_0_INTERVAL                1000000     // 1 second in microseconds
+#define TIMER_0_INTERVAL                1000000     // 1 second in microseconds, also the slowest adaptive interval
+#define BROADCAST_MIN_INTERVAL          100000      // fastest adaptive interval, in microseconds
+#define BROADCAST_TASK_STACK_SIZE       4096        // in bytes, static
+#define BROADCAST_TASK_PRIORITY         5
+#define BROADCAST_TASK_CORE             1
+#define STATS_PRINT_INTERVAL            5000        // 5 seconds in milliseconds
+#define MESH_TTL                        3           // hops a broadcast may take
+#define MESH_RX_QUEUE_LENGTH            8           // received frames waiting for the broadcast task, pool and queue
+#define NOTIFY_SEND                     0x01        // broadcast task notification bits
+#define NOTIFY_RECEIVE                  0x02
+
+// 1 restores the old behavior of sending from inside the timer ISR, only useful to compare
+// the latency numbers against the deferred path, never enable it in real firmware.
+// frames sent from the ISR go straight to each node and are not relayed by the mesh
+#define SEND_FROM_ISR                   0
 
 
 // --- includes --- // 
@@ -20,6 +34,14 @@
 #include <WiFi.h>
 #include <esp_wifi.h>
 #include <esp_now.h>
+#include <esp_timer.h>
+#include <espnow_wire.h>
+#include <espnow_link.h>
+#include <espnow_mesh.h>
+#include <seqlock.h>
+#include <static_pool.h>
+#include <static_task.h>
+#include <memory_report.h>
 
 
 // --- global variables --- //
@@ -34,14 +56,85 @@ struct DataStruct
   int counterLoop = 0;
 } data; 
 
-// ESP-Now Connection C0:49:EF:46:23:B8
-uint8_t targetMacAddress[] = {0xC4, 0xDE, 0xE2, 0xC0, 0x75, 0x80};       // change this to the mac address of your target device
+// ESP-Now mesh: every node gets the same list, a node skips its own address
+uint8_t meshNodes[][6] = {
+  {0xC4, 0xDE, 0xE2, 0xC0, 0x75, 0x80},
+  {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10},
+};                                                                       // change these to the mac addresses of your nodes
+uint8_t deviceMacAddress[6];
+
+// delivery tracking, the timer period follows the slowest peer's rate controller
+EspNowLink link;
+uint32_t broadcastIntervalUs = TIMER_0_INTERVAL;
+
+// floods our frames to every node and relays everyone else's
+bool sendMeshFrame(const uint8_t* macAddress, const uint8_t* frame, size_t length, void* context);
+void onMeshMessage(const EspNowMeshMessage& message, void* context);
+EspNowMesh mesh(sendMeshFrame, onMeshMessage);
+
+// received frames are copied out of the Wi-Fi task into a pool slot, only the pointer goes
+// through the queue to the broadcast task, which returns the slot when it is done
+struct MeshRxFrame
+{
+  uint8_t macAddress[6];
+  uint8_t length;
+  uint8_t data[ESPNOW_WIRE_MAX_FRAME_SIZE];
+};
+StaticPool<MeshRxFrame, MESH_RX_QUEUE_LENGTH> meshRxFrames;
+StaticQueue<MeshRxFrame*, MESH_RX_QUEUE_LENGTH> meshRxQueue;
+volatile uint32_t meshRxDropped = 0;
+
+// last message from any node, published by the broadcast task and printed by loop()
+struct ReceivedMessage
+{
+  int counterTimer0 = 0;
+  int counterLoop = 0;
+  uint8_t macAddress[6] = {};
+  uint32_t messages = 0;
+  uint32_t rejected = 0;
+};
+ReceivedMessage rxMessage;                    // only touched by the broadcast task
+SeqLock<ReceivedMessage> rxSnapshot;
+uint32_t lastPrintedSequence = 0;
+
+// outgoing frame, built in place by broadcastFrame()
+uint8_t txFrame[ESPNOW_WIRE_MAX_FRAME_SIZE];
+uint16_t txSequence = 0;
+
+// TX and relay task, woken by the timer ISR and the receive callback
+StaticTask<BROADCAST_TASK_STACK_SIZE> meshTask;
+
+// static memory, printed with the other stats
+MemorySource memorySources[] = {
+  { "broadcast task", NULL, NULL, &meshTask },
+  { "mesh rx frames", &meshRxFrames, NULL, NULL },
+};
+
+// latency instrumentation, all times in microseconds, updated and read under timerMux
+struct LatencyStats
+{
+  uint32_t count = 0;
+  uint32_t lastUs = 0;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+};
+LatencyStats isrStats;                        // ISR entry to ISR exit
+LatencyStats sendStats;                       // ISR entry to esp_now_send() returning
+volatile uint32_t timerFiredAt = 0;           // low word of when the ISR last ran, a single store the task cannot tear
+unsigned long lastStatsPrint = 0;
 
 
 // --- function headers --- //
 void sendBroadcast();
-void onDataSent(const uint8_t* macAddress, esp_now_send_status_t status);
+void broadcastTask(void* pvParameters);
+void broadcastFrame();
+void recordLatency(LatencyStats& stats, uint32_t latencyUs);
+void printLatency(const char* name, const LatencyStats& stats);
+void printDelivery();
+void printMesh();
+void printMemory();
 void onDataReceived(const uint8_t* macAddress, const uint8_t* data, int dataLength);
+void handleFrame(const uint8_t* macAddress, const EspNowFrameView& frame);
 void formatMacAddress(const uint8_t *macAddress, char *buffer, int maxLength);
 
 
@@ -51,23 +144,57 @@ void setup()
   // initialize serial connection for the serial monitor & debugging
   Serial.begin(9600);
 
-  // initialize timer 0
-  timer0 = timerBegin(0, TIMER_INTERRUPT_PRESCALER, true);
-  timerAttachInterrupt(timer0, &sendBroadcast, true);
-  timerAlarmWrite(timer0, TIMER_0_INTERVAL, true);
-  timerAlarmEnable(timer0);
-
   // --- initialize ESP-NOW ---//
   // turn on wifi access point 
   WiFi.mode(WIFI_STA);
-  Serial.printf("DEVICE MAC ADDRESS: %s\n", WiFi.macAddress());
+  WiFi.macAddress(deviceMacAddress);
+  char deviceMacStr[18];
+  formatMacAddress(deviceMacAddress, deviceMacStr, 18);
+  Serial.printf("DEVICE MAC ADDRESS: %s\n", deviceMacStr);
 
   // init ESP-NOW service
   esp_err_t initResult = esp_now_init();
   Serial.printf("ESP-NOW INIT [ %s ]\n", initResult == ESP_OK ? "SUCCESS" : "FAILED");
 
   // setup ESP-NOW connections
+  meshRxQueue.begin();
+
+  // track send completions, starting at the old fixed interval
+  EspNowRateConfig rateConfig;
+  rateConfig.minIntervalUs = BROADCAST_MIN_INTERVAL;
+  rateConfig.maxIntervalUs = TIMER_0_INTERVAL;
+  rateConfig.stepUs = BROADCAST_MIN_INTERVAL / 2;
+  rateConfig.adjustEvery = 5;
+  link.begin();
+  mesh.begin(deviceMacAddress);
+
+  // register every other node once, sending never has to touch the peer list
+  for (size_t i = 0; i < sizeof(meshNodes) / sizeof(meshNodes[0]); i++) {
+    if (mesh.addPeer(meshNodes[i]) == ESPNOW_MESH_INVALID_PEER) {
+      continue;
+    }
+
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, meshNodes[i], 6);
+    peerInfo.channel = 0;
+    peerInfo.encrypt = false;
+    esp_err_t peerResult = esp_now_add_peer(&peerInfo);
+    link.addPeer(meshNodes[i], rateConfig);
+
+    char macStr[18];
+    formatMacAddress(meshNodes[i], macStr, 18);
+    Serial.printf("ESP-NOW PEER CONNECTION %s [ %s ]\n", macStr, peerResult == ESP_OK ? "SUCCESS" : "FAILED");
+  }
+
+  // the TX task has to exist before the timer or a received frame can wake it
+  meshTask.start(broadcastTask, "Broadcast", NULL, BROADCAST_TASK_PRIORITY, BROADCAST_TASK_CORE);
   esp_now_register_recv_cb(onDataReceived);
+
+  // initialize timer 0
+  timer0 = timerBegin(0, TIMER_INTERRUPT_PRESCALER, true);
+  timerAttachInterrupt(timer0, &sendBroadcast, true);
+  timerAlarmWrite(timer0, broadcastIntervalUs, true);
+  timerAlarmEnable(timer0);
 }
 
 
@@ -76,36 +203,241 @@ void loop()
 {
   // increment loop counter
   data.counterLoop += 2;
+
+  // follow the rate controller of the slowest peer, every hop has to keep up
+  uint32_t interval = BROADCAST_MIN_INTERVAL;
+  for (int i = 0; i < link.peerCount(); i++) {
+    uint32_t peerInterval = link.intervalUs(i);
+    interval = peerInterval > interval ? peerInterval : interval;
+  }
+  if (interval != broadcastIntervalUs) {
+    broadcastIntervalUs = interval;
+    timerAlarmWrite(timer0, broadcastIntervalUs, true);
+  }
+
+  // print each new message outside the Wi-Fi task
+  if (rxSnapshot.sequence() != lastPrintedSequence) {
+    ReceivedMessage message;
+    lastPrintedSequence = rxSnapshot.read(message);
+
+    char macStr[18];
+    formatMacAddress(message.macAddress, macStr, 18);
+    Serial.printf("Received message from: %s | timer: %d | loop: %d | messages: %u | rejected: %u\n",
+      macStr, message.counterTimer0, message.counterLoop, message.messages, message.rejected);
+  }
+
+  // report latency numbers
+  if (millis() - lastStatsPrint >= STATS_PRINT_INTERVAL) {
+    printLatency(SEND_FROM_ISR ? "ISR (send in ISR)" : "ISR (deferred)", isrStats);
+    printLatency(SEND_FROM_ISR ? "SEND (send in ISR)" : "SEND (deferred)", sendStats);
+    printDelivery();
+    printMesh();
+    printMemory();
+    lastStatsPrint = millis();
+  }
 }
 
 
 /**
- * @brief ISR function to encapsulate the message broadcast
+ * @brief timer 0 ISR, only wakes the broadcast task
  * 
  */
-void sendBroadcast()
+void IRAM_ATTR sendBroadcast()
 {
-  // disable interrupts
+  int64_t start = esp_timer_get_time();
+  timerFiredAt = (uint32_t)start;
+  data.counterTimer0++;
+
+#if SEND_FROM_ISR
+  // old path: the whole send happens inside the ISR critical section
   portENTER_CRITICAL_ISR(&timerMux);
+  broadcastFrame();
+  portEXIT_CRITICAL_ISR(&timerMux);
+  recordLatency(sendStats, (uint32_t)(esp_timer_get_time() - start));
+  recordLatency(isrStats, (uint32_t)(esp_timer_get_time() - start));
+#else
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  xTaskNotifyFromISR(meshTask.handle(), NOTIFY_SEND, eSetBits, &higherPriorityTaskWoken);
+  recordLatency(isrStats, (uint32_t)(esp_timer_get_time() - start));
 
-  // get peer information
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(&peerInfo.peer_addr, targetMacAddress, 6);
-  if (!esp_now_is_peer_exist(targetMacAddress))
-  {
-    esp_now_add_peer(&peerInfo);
+  // switch straight to the broadcast task if it outranks whatever was interrupted
+  if (higherPriorityTaskWoken) {
+    portYIELD_FROM_ISR();
   }
+#endif
+}
 
-  // send broadcast
-  esp_err_t broadcastResult = esp_now_send(targetMacAddress, (const uint8_t*) &data, sizeof(data));
 
-  // re-enable interrupts
-  portEXIT_CRITICAL_ISR(&timerMux);
+/**
+ * @brief sends a broadcast every time the timer ISR fires and relays received frames
+ * the mesh is only ever used from this task, so it needs no lock
+ * 
+ * @param arg - argument passed via function pointer
+ */
+void broadcastTask(void* arg)
+{
+  for (;;) {
+    uint32_t notification = 0;
+    xTaskNotifyWait(0, ULONG_MAX, &notification, portMAX_DELAY);
+
+    if (notification & NOTIFY_SEND) {
+      broadcastFrame();
+      recordLatency(sendStats, (uint32_t)esp_timer_get_time() - timerFiredAt);      // unsigned, so right across the wrap too
+    }
+
+    // deliver and relay everything that arrived since the last wake up
+    MeshRxFrame* rxFrame = NULL;
+    while (xQueueReceive(meshRxQueue.handle(), &rxFrame, 0) == pdTRUE) {
+      if (!mesh.onReceive(rxFrame->macAddress, rxFrame->data, rxFrame->length, (uint32_t)esp_timer_get_time())) {
+        // not relayed, a node sending straight to us
+        EspNowFrameView frame;
+        if (EspNowFrameView::parse(rxFrame->data, rxFrame->length, frame) == ESPNOW_PARSE_OK) {
+          handleFrame(rxFrame->macAddress, frame);
+        }
+        else {
+          rxMessage.rejected++;
+          rxSnapshot.publish(rxMessage);
+        }
+      }
+      meshRxFrames.destroy(rxFrame);
+    }
+  }
+}
+
+
+/**
+ * @brief builds the data frame and hands it to ESP-NOW
+ * 
+ */
+void broadcastFrame()
+{
+  // build the frame straight into the send buffer, this device has no button
+  EspNowFrameWriter writer(txFrame, sizeof(txFrame));
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, txSequence++, millis());
+  size_t frameSize = writer.finish(EspNowDataView::write(payload, data.counterTimer0, data.counterLoop, false));
+
+#if SEND_FROM_ISR
+  // the mesh is not ISR safe, send to each node directly
+  for (int i = 0; i < link.peerCount(); i++) {
+    link.send(i, txFrame, frameSize);
+  }
+#else
+  // flood it to the mesh, the outcome of each hop arrives in the link's send callback
+  mesh.send(txFrame, frameSize, MESH_TTL);
+#endif
+}
+
+
+/**
+ * @brief sends one mesh frame to one node, called by the mesh
+ * 
+ * @param macAddress the node to send to
+ * @param frame the frame to send
+ * @param length size of the frame in bytes
+ * @param context unused
+ * @return true if ESP-NOW accepted the frame
+ */
+bool sendMeshFrame(const uint8_t* macAddress, const uint8_t* frame, size_t length, void* context)
+{
+  int peer = link.findPeer(macAddress);
+  if (peer == ESPNOW_LINK_INVALID_PEER) {
+    return esp_now_send(macAddress, frame, length) == ESP_OK;
+  }
+  return link.send(peer, frame, length) == ESP_OK;
+}
+
+
+/**
+ * @brief receives each new message from the mesh, called by the mesh from the broadcast task
+ * 
+ * @param message the message, only valid during the call
+ * @param context unused
+ */
+void onMeshMessage(const EspNowMeshMessage& message, void* context)
+{
+  handleFrame(message.origin, message.frame);
+}
+
+
+/**
+ * @brief adds one measurement to a set of latency stats, safe to call from an ISR
+ * the 64 bit total takes two stores, so the update is one critical section
+ * 
+ * @param stats the stats to update
+ * @param latencyUs the measurement in microseconds
+ */
+void IRAM_ATTR recordLatency(LatencyStats& stats, uint32_t latencyUs)
+{
+  portENTER_CRITICAL_SAFE(&timerMux);
+  stats.lastUs = latencyUs;
+  stats.totalUs += latencyUs;
+  if (latencyUs > stats.maxUs) {
+    stats.maxUs = latencyUs;
+  }
+  stats.count++;
+  portEXIT_CRITICAL_SAFE(&timerMux);
+}
+
+
+/**
+ * @brief prints one set of latency stats
+ * 
+ * @param name label for the line
+ * @param stats the stats to print
+ */
+void printLatency(const char* name, const LatencyStats& stats)
+{
+  // copy under the lock, never print while holding it
+  portENTER_CRITICAL(&timerMux);
+  LatencyStats snapshot = stats;
+  portEXIT_CRITICAL(&timerMux);
+
+  uint32_t count = snapshot.count;
+  Serial.printf("%s latency: count: %u | last: %u us | avg: %u us | max: %u us\n",
+    name, count, snapshot.lastUs, count ? (uint32_t)(snapshot.totalUs / count) : 0, snapshot.maxUs);
+}
+
+
+/**
+ * @brief prints delivery stats for the target and the current broadcast interval
+ * 
+ */
+void printDelivery()
+{
+  for (int i = 0; i < link.peerCount(); i++) {
+    EspNowPeerStats stats = link.stats(i);
+    Serial.printf("DELIVERY [%d]: acked: %u | nacked: %u | lost: %u | ratio: %.1f%% | ack latency avg: %u us max: %u us\n",
+      i, stats.acked, stats.nacked, stats.lost, link.delivery(i) * 100.0f, stats.averageLatencyUs, stats.maxLatencyUs);
+  }
+  Serial.printf("DELIVERY: interval: %u us\n", broadcastIntervalUs);
+}
+
+
+/**
+ * @brief prints the relay counters
+ * 
+ */
+void printMesh()
+{
+  EspNowMeshStats stats = mesh.stats();
+  Serial.printf("MESH: sent: %u | received: %u | delivered: %u | duplicates: %u | stale: %u | forwarded: %u | ttl expired: %u | queue drops: %u\n",
+    stats.originated, stats.received, stats.delivered, stats.duplicates, stats.stale, stats.forwarded, stats.ttlExpired, meshRxDropped);
+}
+
+
+/**
+ * @brief prints the heap, the broadcast task's stack and the rx frame pool
+ * 
+ */
+void printMemory()
+{
+  printMemoryReport(Serial, memorySources, sizeof(memorySources) / sizeof(memorySources[0]));
 }
 
 
 /**
  * @brief callback function for when a message is received from a broadcast
+ * runs in the Wi-Fi task: only copies the frame to the broadcast task, never blocks or prints
  * 
  * @param macAddress the mac address of the incoming message
  * @param data the content of the message
@@ -113,19 +445,54 @@ void sendBroadcast()
  */
 void onDataReceived(const uint8_t* macAddress, const uint8_t* incomingData, int dataLength)
 {
-  // disable interrupts
-  portENTER_CRITICAL_ISR(&timerMux);
+  if (dataLength <= 0 || dataLength > ESPNOW_WIRE_MAX_FRAME_SIZE) {
+    meshRxDropped++;
+    return;
+  }
 
-  // copy incoming data into the local data structure
-  memcpy(&data, incomingData, sizeof(incomingData));
+  // every slot still waiting for the broadcast task means the frame is dropped
+  MeshRxFrame* rxFrame = meshRxFrames.create();
+  if (rxFrame == NULL) {
+    meshRxDropped++;
+    return;
+  }
+  memcpy(rxFrame->macAddress, macAddress, 6);
+  rxFrame->length = (uint8_t)dataLength;
+  memcpy(rxFrame->data, incomingData, dataLength);
 
-  // print the address of the incoming message
-  char macStr[18];
-  formatMacAddress(macAddress, macStr, 18);
-  Serial.printf("Received message from: %s\n", macStr);
+  if (xQueueSend(meshRxQueue.handle(), &rxFrame, 0) != pdTRUE) {
+    meshRxFrames.destroy(rxFrame);
+    meshRxDropped++;
+    return;
+  }
 
-  // re-enable interrupts
-  portEXIT_CRITICAL_ISR(&timerMux);
+  // without the task the frame waits in the queue for its first wake up
+  if (meshTask.handle() != NULL) {
+    xTaskNotify(meshTask.handle(), NOTIFY_RECEIVE, eSetBits);
+  }
+}
+
+
+/**
+ * @brief reads a data frame and publishes it for loop(), anything else is dropped
+ * 
+ * @param macAddress the node the frame came from (the origin for relayed frames)
+ * @param frame the validated frame
+ */
+void handleFrame(const uint8_t* macAddress, const EspNowFrameView& frame)
+{
+  EspNowDataView payload;
+  if (EspNowDataView::from(frame, payload)) {
+    rxMessage.counterTimer0 = payload.counterTimer0();
+    rxMessage.counterLoop = payload.counterLoop();
+    memcpy(rxMessage.macAddress, macAddress, 6);
+    rxMessage.messages++;
+  }
+  else {
+    rxMessage.rejected++;
+  }
+
+  rxSnapshot.publish(rxMessage);
 }
 
 
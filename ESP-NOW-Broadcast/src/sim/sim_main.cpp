@@ -0,0 +1,255 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the flooding mesh on a line of simulated nodes over a lossy simulated radio
+ * 
+ * each node hears the SIM_RADIO_RANGE nodes on either side of it, so a message from the first
+ * node needs one hop per SIM_RADIO_RANGE nodes to reach the end of the line, and most nodes
+ * hear it over several paths. with MESH_TTL hops allowed, nodes further away than that are
+ * never reached, which the report shows as zero deliveries.
+ * 
+ * after the run the deliveries and duplicates are checked: every node within reach gets every
+ * message at most once and at least about as often as one lossy path would carry it, the
+ * copies that come over the other paths are dropped as duplicates, nothing travels further
+ * than the TTL, and every frame a node hears is accounted for. the exit code is 1 if any check failed.
+ * 
+ * the radios and meshes are built in a static arena that is sealed once the line is set up,
+ * and received frames go through a pool of MESH_RX_QUEUE_LENGTH slots per node like on the
+ * board, so the memory rows at the end show what the mesh needs and that nothing allocates
+ * after startup.
+ * 
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define MESH_TTL                        3           // same as main.cpp
+#define MESH_RX_QUEUE_LENGTH            8           // same as main.cpp
+#define SIM_NODES                       8
+#define SIM_RADIO_RANGE                 2           // nodes a node hears on either side
+#define SIM_LOSS_PERCENT                10
+#define SEND_INTERVAL                   200000      // origin sends every 200 ms
+#define SIM_DURATION_US                 60000000
+#define SIM_MESSAGES                    (SIM_DURATION_US / SEND_INTERVAL)
+
+
+// --- includes --- // 
+#include <stdio.h>
+#include <math.h>
+#include <hal_sim.h>
+#include <espnow_wire.h>
+#include <espnow_mesh.h>
+#include <static_pool.h>
+#include <static_arena.h>
+#include <memory_report.h>
+
+
+// --- global variables --- //
+bool sendMeshFrame(const uint8_t* macAddress, const uint8_t* frame, size_t length, void* context);
+void onMeshMessage(const EspNowMeshMessage& message, void* context);
+
+// a received frame waiting for the mesh, as in main.cpp
+struct MeshRxFrame
+{
+  uint8_t macAddress[HAL_MAC_SIZE];
+  uint8_t length;
+  uint8_t data[ESPNOW_WIRE_MAX_FRAME_SIZE];
+};
+
+// one simulated board running the mesh
+struct Node
+{
+  uint8_t mac[HAL_MAC_SIZE];
+  SimRadio* radio;
+  EspNowMesh* mesh;
+  StaticPool<MeshRxFrame, MESH_RX_QUEUE_LENGTH> rxFrames;
+  uint32_t delivered = 0;
+  uint32_t hopTotal = 0;
+  uint8_t maxHops = 0;
+  uint8_t deliveries[SIM_MESSAGES] = {};         // per origin sequence
+};
+Node nodes[SIM_NODES];
+uint16_t sequence = 0;
+int failures = 0;
+
+// everything main() builds once
+StaticArena<SIM_NODES * (sizeof(SimRadio) + sizeof(EspNowMesh) + 2 * alignof(max_align_t))> startupArena;
+
+
+// --- function headers --- //
+void sendTimer(void* context);
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context);
+void checkDeliveries();
+void check(bool passed, const char* what);
+
+
+// --- main --- // 
+int main()
+{
+  SimRadioMedium& medium = halSim().radioMedium;
+  medium.setLoss(SIM_LOSS_PERCENT);
+
+  for (int i = 0; i < SIM_NODES; i++) {
+    const uint8_t mac[HAL_MAC_SIZE] = { 0x24, 0x6F, 0x28, 0x10, 0x00, (uint8_t)i };
+    memcpy(nodes[i].mac, mac, HAL_MAC_SIZE);
+    nodes[i].radio = startupArena.create<SimRadio>(medium, mac);
+    nodes[i].mesh = startupArena.create<EspNowMesh>(sendMeshFrame, onMeshMessage, &nodes[i]);
+    nodes[i].radio->begin();
+    nodes[i].radio->onReceive(onReceive, &nodes[i]);
+    nodes[i].mesh->begin(mac);
+  }
+
+  // a line, each node in range of SIM_RADIO_RANGE nodes either side
+  for (int i = 0; i < SIM_NODES; i++) {
+    for (int j = i - SIM_RADIO_RANGE; j <= i + SIM_RADIO_RANGE; j++) {
+      if (j >= 0 && j < SIM_NODES && j != i) {
+        nodes[i].radio->addPeer(nodes[j].mac);
+        nodes[i].mesh->addPeer(nodes[j].mac);
+      }
+    }
+  }
+
+  startupArena.seal();
+
+  SimTimer sender(halSim().clock);
+  sender.start(SEND_INTERVAL, sendTimer, NULL);
+  halSim().clock.advance(SIM_DURATION_US);
+
+  printf("simulated %.0f s, %d nodes in a line, range %d, %u%% loss, TTL %d, %u messages sent\n",
+    halSim().clock.nowUs() / 1e6, SIM_NODES, SIM_RADIO_RANGE, SIM_LOSS_PERCENT, MESH_TTL, sequence);
+  for (int i = 0; i < SIM_NODES; i++) {
+    const EspNowMeshStats stats = nodes[i].mesh->stats();
+    printf("node %d: delivered %4u (%5.1f%%, %.2f hops avg) | received %4u | forwarded %4u | duplicates %4u | ttl expired %4u\n",
+      i, nodes[i].delivered, sequence ? 100.0 * nodes[i].delivered / sequence : 0.0, nodes[i].delivered ? (double)nodes[i].hopTotal / nodes[i].delivered : 0.0,
+      stats.received, stats.forwarded, stats.duplicates, stats.ttlExpired);
+  }
+
+  MemorySource memorySources[SIM_NODES + 1];
+  char names[SIM_NODES][20];
+  memorySources[0] = { "startup arena", NULL, &startupArena, NULL };
+  for (int i = 0; i < SIM_NODES; i++) {
+    snprintf(names[i], sizeof(names[i]), "node %d rx frames", i);
+    memorySources[i + 1] = { names[i], &nodes[i].rxFrames, NULL, NULL };
+  }
+  printf("\n%s\n", memoryReportHeader());
+  char row[MEMORY_REPORT_ROW_SIZE];
+  for (int i = 0; i < SIM_NODES + 1; i++) {
+    formatMemoryRow(row, sizeof(row), memorySources[i]);
+    printf("%s\n", row);
+  }
+  printf("static total %u bytes, arena %s\n", memoryReportTotalBytes(memorySources, SIM_NODES + 1),
+    startupArena.sealed() ? "sealed" : "open");
+
+  printf("\n--- checks ---\n");
+  checkDeliveries();
+  bool noPoolFailures = true;
+  for (int i = 0; i < SIM_NODES; i++) {
+    noPoolFailures = noPoolFailures && nodes[i].rxFrames.usage().failures == 0;
+  }
+  check(noPoolFailures, "every received frame got an rx slot");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief check every node's deliveries and duplicates against what the line allows
+ */
+void checkDeliveries()
+{
+  bool atMostOnce = true;
+  bool asOftenAsOnePath = true;
+  bool withinTtl = true;
+  bool accounted = true;
+  uint32_t duplicates = 0;
+  for (int i = 0; i < SIM_NODES; i++) {
+    const Node& node = nodes[i];
+    const EspNowMeshStats stats = node.mesh->stats();
+    for (int m = 0; m < SIM_MESSAGES; m++) {
+      atMostOnce = atMostOnce && node.deliveries[m] <= 1;
+    }
+
+    // the fewest hops to this node, a single path of them delivers (1 - loss)^hops of the messages,
+    // give or take 3 standard deviations, the furthest node in reach has no other path
+    const int hops = (i + SIM_RADIO_RANGE - 1) / SIM_RADIO_RANGE;
+    if (i == 0 || hops > MESH_TTL) {
+      withinTtl = withinTtl && node.delivered == 0;
+    }
+    else {
+      const double onePath = pow(1.0 - SIM_LOSS_PERCENT / 100.0, hops);
+      const double expected = sequence * onePath;
+      asOftenAsOnePath = asOftenAsOnePath && node.delivered >= expected - 3 * sqrt(expected * (1.0 - onePath));
+      withinTtl = withinTtl && node.maxHops <= MESH_TTL;
+    }
+
+    accounted = accounted && stats.received == stats.delivered + stats.duplicates + stats.stale + stats.malformed
+      && stats.delivered == node.delivered && stats.stale == 0 && stats.malformed == 0;
+    duplicates += stats.duplicates;
+  }
+
+  check(atMostOnce, "no node delivered a message twice");
+  check(duplicates > 0, "copies over parallel paths were dropped as duplicates");
+  check(asOftenAsOnePath, "nodes in reach delivered at least what one lossy path carries");
+  check(withinTtl, "no message went further than the TTL, the origin kept its own");
+  check(accounted, "every frame heard was delivered or dropped as a duplicate");
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("%-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
+
+
+/**
+ * @brief the first node floods one data frame, the air then carries every relay to completion
+ */
+void sendTimer(void* context)
+{
+  (void)context;
+  uint8_t frame[ESPNOW_MESH_MAX_INNER_SIZE];
+  EspNowFrameWriter writer(frame, sizeof(frame));
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, sequence, (uint32_t)halSim().clock.nowUs());
+  const size_t length = writer.finish(EspNowDataView::write(payload, sequence, sequence, false));
+  nodes[0].mesh->send(frame, length, MESH_TTL);
+  sequence++;
+  halSim().radioMedium.run();
+}
+
+
+bool sendMeshFrame(const uint8_t* macAddress, const uint8_t* frame, size_t length, void* context)
+{
+  return ((Node*)context)->radio->send(macAddress, frame, length);
+}
+
+
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context)
+{
+  Node* node = (Node*)context;
+  MeshRxFrame* rxFrame = node->rxFrames.create();
+  if (rxFrame == NULL || length > sizeof(rxFrame->data)) {
+    node->rxFrames.destroy(rxFrame);
+    return;
+  }
+  memcpy(rxFrame->macAddress, mac, HAL_MAC_SIZE);
+  rxFrame->length = (uint8_t)length;
+  memcpy(rxFrame->data, data, length);
+  node->mesh->onReceive(rxFrame->macAddress, rxFrame->data, rxFrame->length, (uint32_t)halSim().clock.nowUs());
+  node->rxFrames.destroy(rxFrame);
+}
+
+
+void onMeshMessage(const EspNowMeshMessage& message, void* context)
+{
+  Node* node = (Node*)context;
+  node->delivered++;
+  node->hopTotal += message.hops;
+  node->maxHops = message.hops > node->maxHops ? message.hops : node->maxHops;
+  if (message.sequence < SIM_MESSAGES) {
+    node->deliveries[message.sequence]++;
+  }
+}
@@ -0,0 +1,341 @@
+/**
+ * @file test_main.cpp
+ * @brief exhaustion, peak accounting and seal() of StaticPool and StaticArena
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the mesh receive queue lives in a StaticPool and memory_report.h sizes it from usage(), so
+ * the numbers have to be exact: a full pool returns NULL and counts it instead of handing out
+ * a slot twice, a freed slot comes back, and the peak is the most objects ever out at once,
+ * checked against a model over a long random run. the arena has to align every piece, fail
+ * and count what does not fit, and refuse everything once it is sealed.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <unity.h>
+#include <static_pool.h>
+#include <static_arena.h>
+
+
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+#define POOL_OBJECTS                      8
+#define RANDOM_STEPS                      100000
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+static int liveObjects = 0;
+
+/**
+ * @brief counts its constructions and destructions in liveObjects
+ */
+struct Tracked
+{
+  explicit Tracked(uint32_t value = 0) : value(value) { liveObjects++; }
+  ~Tracked() { liveObjects--; }
+
+  uint32_t value;
+  double alignment;
+};
+
+static bool aligned(const void* pointer, size_t align)
+{
+  return (uintptr_t)pointer % align == 0;
+}
+
+
+void setUp(void)
+{
+  randomState = 1;
+  liveObjects = 0;
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Pool
+===============================================================================================
+*/
+
+void test_pool_hands_out_every_slot_once_then_fails(void)
+{
+  static StaticPool<Tracked, POOL_OBJECTS> pool;
+  Tracked* objects[POOL_OBJECTS];
+  for (int i = 0; i < POOL_OBJECTS; i++) {
+    objects[i] = pool.create((uint32_t)i);
+    TEST_ASSERT_NOT_NULL(objects[i]);
+    TEST_ASSERT_TRUE(pool.owns(objects[i]));
+    TEST_ASSERT_TRUE(aligned(objects[i], alignof(Tracked)));
+    TEST_ASSERT_EQUAL_UINT32(i, objects[i]->value);
+    for (int j = 0; j < i; j++) {
+      TEST_ASSERT_TRUE(objects[i] != objects[j]);
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(POOL_OBJECTS, liveObjects);
+
+  // full: every further create fails, is counted and constructs nothing
+  TEST_ASSERT_NULL(pool.create(99u));
+  TEST_ASSERT_NULL(pool.create(99u));
+  TEST_ASSERT_EQUAL_INT(POOL_OBJECTS, liveObjects);
+
+  const StaticMemoryUsage usage = pool.usage();
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, usage.capacity);
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, usage.used);
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, usage.peak);
+  TEST_ASSERT_EQUAL_UINT32(2, usage.failures);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(Tracked), usage.unitBytes);
+
+  // the values survived the failed creates
+  for (int i = 0; i < POOL_OBJECTS; i++) {
+    TEST_ASSERT_EQUAL_UINT32(i, objects[i]->value);
+  }
+}
+
+void test_pool_reuses_a_destroyed_slot(void)
+{
+  static StaticPool<Tracked, POOL_OBJECTS> pool;
+  Tracked* objects[POOL_OBJECTS];
+  for (int i = 0; i < POOL_OBJECTS; i++) {
+    objects[i] = pool.create((uint32_t)i);
+  }
+
+  pool.destroy(objects[3]);
+  TEST_ASSERT_EQUAL_INT(POOL_OBJECTS - 1, liveObjects);
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS - 1, pool.usage().used);
+
+  Tracked* again = pool.create(42u);
+  TEST_ASSERT_TRUE(again == objects[3]);
+  TEST_ASSERT_EQUAL_UINT32(42, again->value);
+  TEST_ASSERT_NULL(pool.create(43u));
+
+  // NULL is ignored, not given back as a slot
+  pool.destroy(NULL);
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, pool.usage().used);
+  TEST_ASSERT_NULL(pool.create(44u));
+
+  for (int i = 0; i < POOL_OBJECTS; i++) {
+    pool.destroy(objects[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(0, liveObjects);
+  TEST_ASSERT_EQUAL_UINT32(0, pool.usage().used);
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, pool.usage().peak);
+}
+
+void test_pool_owns_only_its_slots(void)
+{
+  static StaticPool<Tracked, POOL_OBJECTS> pool;
+  static StaticPool<Tracked, POOL_OBJECTS> other;
+  Tracked local;
+  Tracked* object = pool.create();
+  TEST_ASSERT_TRUE(pool.owns(object));
+  TEST_ASSERT_FALSE(other.owns(object));
+  TEST_ASSERT_FALSE(pool.owns(&local));
+  TEST_ASSERT_FALSE(pool.owns((const Tracked*)((const uint8_t*)object + 1)));
+  TEST_ASSERT_FALSE(pool.owns(NULL));
+  pool.destroy(object);
+}
+
+void test_pool_peak_follows_the_most_objects_out(void)
+{
+  static StaticPool<Tracked, POOL_OBJECTS> pool;
+  Tracked* out[POOL_OBJECTS];
+  uint32_t count = 0;
+  uint32_t peak = 0;
+  uint32_t failures = 0;
+  for (uint32_t step = 0; step < RANDOM_STEPS; step++) {
+    // lean towards creating so the pool runs full now and then
+    if (nextRandom() % 8 < 5) {
+      Tracked* object = pool.create(step);
+      if (count == POOL_OBJECTS) {
+        TEST_ASSERT_NULL(object);
+        failures++;
+      }
+      else {
+        TEST_ASSERT_NOT_NULL(object);
+        out[count++] = object;
+        peak = count > peak ? count : peak;
+      }
+    }
+    else if (count > 0) {
+      const uint32_t index = nextRandom() % count;
+      pool.destroy(out[index]);
+      out[index] = out[--count];
+    }
+
+    const StaticMemoryUsage usage = pool.usage();
+    TEST_ASSERT_EQUAL_UINT32(count, usage.used);
+    TEST_ASSERT_EQUAL_UINT32(peak, usage.peak);
+    TEST_ASSERT_EQUAL_UINT32(failures, usage.failures);
+    TEST_ASSERT_EQUAL_INT((int)count, liveObjects);
+  }
+  TEST_ASSERT_EQUAL_UINT32(POOL_OBJECTS, peak);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, failures);
+
+  while (count > 0) {
+    pool.destroy(out[--count]);
+  }
+}
+
+void test_pool_reset_peak_starts_from_what_is_out(void)
+{
+  static StaticPool<Tracked, POOL_OBJECTS> pool;
+  Tracked* objects[POOL_OBJECTS];
+  for (int i = 0; i < POOL_OBJECTS; i++) {
+    objects[i] = pool.create();
+  }
+  TEST_ASSERT_NULL(pool.create());
+  for (int i = 2; i < POOL_OBJECTS; i++) {
+    pool.destroy(objects[i]);
+  }
+
+  pool.resetPeak();
+  StaticMemoryUsage usage = pool.usage();
+  TEST_ASSERT_EQUAL_UINT32(2, usage.used);
+  TEST_ASSERT_EQUAL_UINT32(2, usage.peak);
+  TEST_ASSERT_EQUAL_UINT32(0, usage.failures);
+
+  objects[2] = pool.create();
+  pool.destroy(objects[2]);
+  usage = pool.usage();
+  TEST_ASSERT_EQUAL_UINT32(2, usage.used);
+  TEST_ASSERT_EQUAL_UINT32(3, usage.peak);
+
+  pool.destroy(objects[0]);
+  pool.destroy(objects[1]);
+}
+
+
+/*
+===============================================================================================
+                                    Arena
+===============================================================================================
+*/
+
+void test_arena_aligns_every_piece(void)
+{
+  static StaticArena<256> arena;
+  uint8_t* byte = (uint8_t*)arena.allocate(1, 1);
+  uint32_t* word = (uint32_t*)arena.allocate(sizeof(uint32_t), alignof(uint32_t));
+  uint8_t* odd = (uint8_t*)arena.allocate(3, 1);
+  double* value = arena.create<double>(1.5);
+  void* wide = arena.allocate(1, 32);
+  TEST_ASSERT_NOT_NULL(byte);
+  TEST_ASSERT_NOT_NULL(word);
+  TEST_ASSERT_NOT_NULL(odd);
+  TEST_ASSERT_NOT_NULL(value);
+  TEST_ASSERT_NOT_NULL(wide);
+  TEST_ASSERT_TRUE(aligned(word, alignof(uint32_t)));
+  TEST_ASSERT_TRUE(aligned(value, alignof(double)));
+  TEST_ASSERT_TRUE(aligned(wide, 32));
+  TEST_ASSERT_TRUE((uint8_t*)word >= byte + 1);
+  TEST_ASSERT_TRUE(odd >= (uint8_t*)(word + 1));
+  TEST_ASSERT_TRUE((uint8_t*)value >= odd + 3);
+  TEST_ASSERT_TRUE(wide > (void*)value);
+  TEST_ASSERT_EQUAL_FLOAT(1.5f, (float)*value);
+
+  // used counts the padding too, and is never more than the arena
+  const StaticMemoryUsage usage = arena.usage();
+  TEST_ASSERT_EQUAL_UINT32(256, usage.capacity);
+  TEST_ASSERT_EQUAL_UINT32(1, usage.unitBytes);
+  TEST_ASSERT_EQUAL_UINT32((uint8_t*)wide + 1 - byte, usage.used);
+  TEST_ASSERT_EQUAL_UINT32(usage.used, usage.peak);
+  TEST_ASSERT_EQUAL_UINT32(256 - usage.used, arena.remaining());
+  TEST_ASSERT_EQUAL_UINT32(0, usage.failures);
+}
+
+void test_arena_fails_what_does_not_fit(void)
+{
+  static StaticArena<64> arena;
+  TEST_ASSERT_NOT_NULL(arena.allocate(60, 1));
+  TEST_ASSERT_NULL(arena.allocate(8, 1));
+  TEST_ASSERT_NULL(arena.allocate(4, 8));                 // fits, but not once aligned
+  TEST_ASSERT_NULL(arena.allocate(SIZE_MAX, 1));          // no wrap around
+  TEST_ASSERT_EQUAL_UINT32(4, arena.remaining());
+  TEST_ASSERT_EQUAL_UINT32(3, arena.usage().failures);
+  TEST_ASSERT_EQUAL_UINT32(60, arena.usage().used);
+
+  // the rest still fits exactly
+  TEST_ASSERT_NOT_NULL(arena.allocate(4, 1));
+  TEST_ASSERT_EQUAL_UINT32(0, arena.remaining());
+  TEST_ASSERT_NULL(arena.allocate(1, 1));
+  TEST_ASSERT_EQUAL_UINT32(64, arena.usage().peak);
+  TEST_ASSERT_EQUAL_UINT32(4, arena.usage().failures);
+}
+
+void test_arena_create_array_limits_and_initializes(void)
+{
+  static StaticArena<128> arena;
+  TEST_ASSERT_NULL(arena.createArray<uint32_t>(0));
+  TEST_ASSERT_NULL(arena.createArray<uint32_t>(33));
+  TEST_ASSERT_NULL(arena.createArray<uint32_t>(SIZE_MAX / 2));   // count * size would wrap
+  TEST_ASSERT_EQUAL_UINT32(3, arena.usage().failures);
+  TEST_ASSERT_EQUAL_UINT32(0, arena.usage().used);
+
+  int16_t* values = arena.createArray<int16_t>(16);
+  TEST_ASSERT_NOT_NULL(values);
+  for (int i = 0; i < 16; i++) {
+    TEST_ASSERT_EQUAL_INT(0, values[i]);
+  }
+
+  Tracked* objects = arena.createArray<Tracked>(2);
+  TEST_ASSERT_NOT_NULL(objects);
+  TEST_ASSERT_TRUE(aligned(objects, alignof(Tracked)));
+  TEST_ASSERT_EQUAL_INT(2, liveObjects);
+  TEST_ASSERT_EQUAL_UINT32(0, objects[1].value);
+}
+
+void test_arena_seal_refuses_every_later_allocation(void)
+{
+  static StaticArena<128> arena;
+  TEST_ASSERT_NOT_NULL(arena.allocate(16, 1));
+  TEST_ASSERT_FALSE(arena.sealed());
+  arena.seal();
+  TEST_ASSERT_TRUE(arena.sealed());
+
+  // plenty of room left, still nothing, and every attempt counted
+  TEST_ASSERT_NULL(arena.allocate(1, 1));
+  TEST_ASSERT_NULL(arena.create<Tracked>(1u));
+  TEST_ASSERT_NULL(arena.createArray<uint8_t>(4));
+  TEST_ASSERT_EQUAL_INT(0, liveObjects);
+
+  const StaticMemoryUsage usage = arena.usage();
+  TEST_ASSERT_EQUAL_UINT32(16, usage.used);
+  TEST_ASSERT_EQUAL_UINT32(16, usage.peak);
+  TEST_ASSERT_EQUAL_UINT32(3, usage.failures);
+  TEST_ASSERT_EQUAL_UINT32(112, arena.remaining());
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_pool_hands_out_every_slot_once_then_fails);
+  RUN_TEST(test_pool_reuses_a_destroyed_slot);
+  RUN_TEST(test_pool_owns_only_its_slots);
+  RUN_TEST(test_pool_peak_follows_the_most_objects_out);
+  RUN_TEST(test_pool_reset_peak_starts_from_what_is_out);
+  RUN_TEST(test_arena_aligns_every_piece);
+  RUN_TEST(test_arena_fails_what_does_not_fit);
+  RUN_TEST(test_arena_create_array_limits_and_initializes);
+  RUN_TEST(test_arena_seal_refuses_every_later_allocation);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file espnow_receiver.h
+ * @brief receive state and frame handling of the ESP-NOW receiver, shared by main.cpp and the
+ * simulation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every frame is validated before anything in it is trusted. single data frames are read in
+ * place, batches are unpacked into samples in time order. the state is private to the
+ * receive callback, which publishes a copy through a SeqLock after every frame.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+
+
+/*
+===============================================================================================
+                                    State
+===============================================================================================
+*/
+
+/**
+ * @brief the sender's counters and button, as last received
+ */
+struct DataStruct
+{
+  int counterTimer0 = 0;
+  int counterLoop = 0;
+  bool buttonState = false;
+};
+
+/**
+ * @brief everything the receive callback tracks
+ */
+struct ReceiverState
+{
+  DataStruct data;
+  int messageCounter = 0;
+  int messageLength = 0;
+  uint8_t recievedAddress = 0;
+  uint16_t lastSequence = 0;
+  int sampleCounter = 0;
+  uint32_t lastSampleTimestamp = 0;
+  int rejectedCounter = 0;
+  EspNowParseResult lastRejectReason = ESPNOW_PARSE_OK;
+  int rejected[ESPNOW_PARSE_BAD_CRC + 1] = {};          // by parse result, frames that did not parse
+};
+
+
+/*
+===============================================================================================
+                                    Frame Handling
+===============================================================================================
+*/
+
+/**
+ * @brief applies one unbatched sample to the receive state
+ *
+ * @param sample the sample, only valid during the call
+ * @param context the ReceiverState
+ */
+inline void applySample(const EspNowSample& sample, void* context)
+{
+  ReceiverState& state = *(ReceiverState*)context;
+  switch (sample.producerId) {
+    case ESPNOW_PRODUCER_COUNTERS:
+      if (sample.length >= 8) {
+        state.data.counterTimer0 = espNowReadU32(sample.data);
+        state.data.counterLoop = espNowReadU32(sample.data + 4);
+      }
+    break;
+
+    case ESPNOW_PRODUCER_BUTTON:
+      if (sample.length >= 1) {
+        state.data.buttonState = sample.data[0] != 0;
+      }
+    break;
+
+    default:
+    break;
+  }
+
+  state.sampleCounter++;
+  state.lastSampleTimestamp = sample.timestampUs;
+}
+
+/**
+ * @brief validates a received frame and applies it to the receive state, never blocks or prints
+ *
+ * @param mac the mac address of the sender
+ * @param data the received bytes
+ * @param len the number of received bytes
+ * @return false if the frame was rejected
+ */
+inline bool receiveFrame(ReceiverState& state, const uint8_t* mac, const uint8_t* data, int len)
+{
+  // validate the frame before trusting anything in it
+  EspNowFrameView frame;
+  EspNowDataView payload;
+  const EspNowParseResult result = EspNowFrameView::parse(data, len, frame);
+  if (result != ESPNOW_PARSE_OK) {
+    state.rejectedCounter++;
+    state.rejected[result]++;
+    state.lastRejectReason = result;
+    return false;
+  }
+
+  // batches are unpacked into samples in time order, single data frames are read in place
+  if (frame.type() == ESPNOW_FRAME_BATCH) {
+    if (EspNowBatchReader::forEachSample(frame, applySample, &state) < 0) {
+      state.rejectedCounter++;
+      return false;
+    }
+  }
+  else if (EspNowDataView::from(frame, payload)) {
+    state.data.counterTimer0 = payload.counterTimer0();
+    state.data.counterLoop = payload.counterLoop();
+    state.data.buttonState = payload.buttonState();
+  }
+  else {
+    state.rejectedCounter++;
+    return false;
+  }
+  state.lastSequence = frame.sequence();
+
+  // update message trackers
+  state.messageCounter++;
+  state.messageLength = len;
+  state.recievedAddress = *mac;
+  return true;
+}
@@ -17,25 +17,27 @@
 #include <WiFi.h>
 #include <esp_wifi.h>
 #include <esp_now.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <seqlock.h>
+#include "espnow_receiver.h"
 
 
 // --- global variables --- //
-int messageCounter = 0;
-int messageLength = 0;
-uint8_t recievedAddress = 0;
+// only touched by the receive callback, which publishes a copy after every message
+ReceiverState rxState;
 
+// what loop() reads, never torn even though the callback runs in the Wi-Fi task
+SeqLock<ReceiverState> rxSnapshot;
 
-// data struct
-struct DataStruct
-{
-  int counterTimer0 = 0;
-  int counterLoop = 0;
-  bool buttonState = false;
-} data; 
+// read once in setup(), printed with every update
+uint8_t deviceMacAddress[6];
+char deviceMacStr[18];
 
 
 // --- function headers --- //
 void onDataArrived(const uint8_t * mac, const uint8_t *incomingData, int len);
+void formatMacAddress(const uint8_t *macAddress, char *buffer, int maxLength);
 
 
 // --- setup --- // 
@@ -48,7 +50,9 @@ void setup()
   // --- initialize ESP-NOW ---//
   // turn on wifi access point 
   WiFi.mode(WIFI_STA);
-  Serial.printf("DEVICE MAC ADDRESS: %s\n", WiFi.macAddress());
+  WiFi.macAddress(deviceMacAddress);
+  formatMacAddress(deviceMacAddress, deviceMacStr, 18);
+  Serial.printf("DEVICE MAC ADDRESS: %s\n", deviceMacStr);
 
   // init ESP-NOW service
   esp_err_t initResult = esp_now_init();
@@ -62,15 +66,22 @@ void setup()
 // --- loop --- // 
 void loop()
 {
+  // take a consistent copy of everything the callback has seen
+  ReceiverState state;
+  rxSnapshot.read(state);
+
   // print updated data
-  Serial.print("DEVICE MAC ADDRESS: ");
-  Serial.println(WiFi.macAddress());
-  Serial.printf("FROM: %d\n", recievedAddress);
-  Serial.printf("messages received: %d\n", messageCounter);
-  Serial.printf("message size: %d\n", messageLength);
-  Serial.printf("Button State: %s\n", data.buttonState ? "pressed" : "not pressed");
-  Serial.printf("Loop Counter: %d\n", data.counterLoop);
-  Serial.printf("Timer Counter: %d\n", data.counterTimer0);
+  Serial.printf("DEVICE MAC ADDRESS: %s\n", deviceMacStr);
+  Serial.printf("FROM: %d\n", state.recievedAddress);
+  Serial.printf("messages received: %d\n", state.messageCounter);
+  Serial.printf("message size: %d\n", state.messageLength);
+  Serial.printf("sequence: %d\n", state.lastSequence);
+  Serial.printf("samples received: %d\n", state.sampleCounter);
+  Serial.printf("last sample time: %u us\n", state.lastSampleTimestamp);
+  Serial.printf("messages rejected: %d (last reason: %s)\n", state.rejectedCounter, espNowParseResultName(state.lastRejectReason));
+  Serial.printf("Button State: %s\n", state.data.buttonState ? "pressed" : "not pressed");
+  Serial.printf("Loop Counter: %d\n", state.data.counterLoop);
+  Serial.printf("Timer Counter: %d\n", state.data.counterTimer0);
   Serial.println("--------------------------------------------------------------------------------");
 
   delay(1000);
@@ -78,18 +89,30 @@ void loop()
 
 
 /**
- * @brief 
+ * @brief callback function for when a message arrives, validates the frame and reads it in place
+ * runs in the Wi-Fi task: updates the private state and publishes it, never blocks or prints
+ * 
+ * @param mac the mac address of the sender
+ * @param incomingData the received bytes
+ * @param len the number of received bytes
+ */
+void onDataArrived(const uint8_t * mac, const uint8_t *incomingData, int len)
+{
+  receiveFrame(rxState, mac, incomingData, len);
+
+  // hand the whole message to loop() at once
+  rxSnapshot.publish(rxState);
+}
+
+
+/**
+ * @brief Formats MAC Address
  * 
- * @param mac 
- * @param incomingData 
- * @param len 
- */void onDataArrived(const uint8_t * mac, const uint8_t *incomingData, int len)
+ * @param macAddress the mac address to be converted
+ * @param buffer the string buffer
+ * @param maxLength the max length the output can be
+ */
+void formatMacAddress(const uint8_t *macAddress, char *buffer, int maxLength)
 {
-  // copy the data to the local data structure
-  memcpy(&data, incomingData, sizeof(data));
-
-  // update message trackers
-  messageCounter++;
-  messageLength = len;
-  recievedAddress = *mac;
-}
\ No newline at end of file
+  snprintf(buffer, maxLength, "%02x:%02x:%02x:%02x:%02x:%02x", macAddress[0], macAddress[1], macAddress[2], macAddress[3], macAddress[4], macAddress[5]);
+}
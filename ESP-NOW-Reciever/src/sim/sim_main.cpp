@@ -0,0 +1,163 @@
+/**
+ * @file sim_main.cpp
+ * @brief feeds the receiver's frame validation a simulated sender, including damaged frames
+ * 
+ * the sender alternates single data frames and small batches every 100 ms. every fifth frame
+ * is damaged on the way (bad magic, bad version, truncated, bad CRC in turn) and must be
+ * rejected. frames go through espnow_receiver.h and the state is published through a SeqLock
+ * exactly as main.cpp does. the counts are checked at the end, the exit code is 1 if any
+ * check failed.
+ * 
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define SEND_INTERVAL                   100000      // in microseconds
+#define DAMAGE_EVERY                    5           // every nth frame is damaged
+#define BATCH_SAMPLES                   4
+#define SIM_DURATION_US                 10000000
+
+
+// --- includes --- // 
+#include <stdio.h>
+#include <hal_sim.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <seqlock.h>
+#include "espnow_receiver.h"
+
+
+// --- global variables --- //
+ReceiverState rxState;
+SeqLock<ReceiverState> rxSnapshot;
+
+const uint8_t receiverMacAddress[] = {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10};
+SimRadio receiver(halSim().radioMedium, receiverMacAddress);
+
+uint16_t sequence = 0;
+uint32_t counterLoop = 0;
+uint32_t batchesSent = 0;
+int failures = 0;
+
+void sendBatch(const uint8_t* frame, size_t length, void* context);
+EspNowAggregatorConfig aggregatorConfig;
+EspNowAggregator aggregator(aggregatorConfig, sendBatch);
+
+
+// --- function headers --- //
+void sendTimer(void* context);
+void onDataArrived(const uint8_t* mac, const uint8_t* data, size_t length, void* context);
+void check(bool passed, const char* what);
+
+
+// --- main --- // 
+int main()
+{
+  halSim().radio.begin();
+  halSim().radio.addPeer(receiverMacAddress);
+  receiver.begin();
+  receiver.onReceive(onDataArrived, NULL);
+
+  // batches only go out when flushed
+  aggregatorConfig.latencyBudgetUs = SIM_DURATION_US;
+  aggregator.configure(aggregatorConfig);
+
+  SimTimer sender(halSim().clock);
+  sender.start(SEND_INTERVAL, sendTimer, NULL);
+  halSim().clock.advance(SIM_DURATION_US);
+
+  ReceiverState state;
+  rxSnapshot.read(state);
+  printf("simulated %.0f s: %u frames sent\n", halSim().clock.nowUs() / 1e6, sequence);
+  printf("messages received: %d | samples received: %d | last loop counter: %d\n", state.messageCounter, state.sampleCounter, state.data.counterLoop);
+  for (int result = ESPNOW_PARSE_TRUNCATED; result <= ESPNOW_PARSE_BAD_CRC; result++) {
+    printf("rejected %-12s %d\n", espNowParseResultName((EspNowParseResult)result), state.rejected[result]);
+  }
+
+  // damage cycles through the four reasons, one in DAMAGE_EVERY frames
+  const int damaged = sequence / DAMAGE_EVERY;
+  check(state.rejectedCounter == damaged, "every damaged frame was rejected");
+  check(state.messageCounter == sequence - damaged, "every intact frame was received");
+  check(state.rejected[ESPNOW_PARSE_BAD_MAGIC] == damaged / 4 && state.rejected[ESPNOW_PARSE_BAD_VERSION] == damaged / 4 &&
+    state.rejected[ESPNOW_PARSE_TRUNCATED] == damaged / 4 && state.rejected[ESPNOW_PARSE_BAD_CRC] == damaged / 4 &&
+    state.rejected[ESPNOW_PARSE_BAD_LENGTH] == 0, "each damage was rejected for its own reason");
+  check(state.sampleCounter <= (int)batchesSent * BATCH_SAMPLES && state.sampleCounter >= (int)(batchesSent - damaged) * BATCH_SAMPLES,
+    "every sample of an intact batch was unpacked");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief send the next frame, damaging every DAMAGE_EVERY-th one
+ */
+void sendTimer(void* context)
+{
+  (void)context;
+  counterLoop++;
+  const uint32_t now = (uint32_t)halSim().clock.nowUs();
+
+  if (sequence % 2 == 0) {
+    uint8_t frame[ESPNOW_WIRE_MAX_FRAME_SIZE];
+    EspNowFrameWriter writer(frame, sizeof(frame));
+    uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, sequence, now);
+    sendBatch(frame, writer.finish(EspNowDataView::write(payload, now / 1000000, counterLoop, counterLoop % 2)), NULL);
+  }
+  else {
+    for (int i = 0; i < BATCH_SAMPLES; i++) {
+      uint8_t counters[8];
+      espNowWriteU32(counters, now / 1000000);
+      espNowWriteU32(counters + 4, counterLoop);
+      aggregator.add(ESPNOW_PRODUCER_COUNTERS, now - (BATCH_SAMPLES - i) * 1000, counters, sizeof(counters));
+    }
+    aggregator.flush();
+    batchesSent++;
+  }
+  halSim().radioMedium.run();
+}
+
+
+/**
+ * @brief hands a frame to the radio, damaged if its turn has come
+ */
+void sendBatch(const uint8_t* frame, size_t length, void* context)
+{
+  (void)context;
+  uint8_t copy[ESPNOW_WIRE_MAX_FRAME_SIZE];
+  memcpy(copy, frame, length);
+  espNowWriteU16(copy + ESPNOW_WIRE_SEQUENCE_OFFSET, sequence);
+  espNowWriteU16(copy + ESPNOW_WIRE_CRC_OFFSET, espNowFrameCrc(copy, espNowReadU16(copy + ESPNOW_WIRE_LENGTH_OFFSET)));
+
+  if (++sequence % DAMAGE_EVERY == 0) {
+    switch ((sequence / DAMAGE_EVERY) % 4) {
+      case 0:   copy[ESPNOW_WIRE_MAGIC_OFFSET] ^= 0xFF;         break;
+      case 1:   copy[ESPNOW_WIRE_VERSION_OFFSET]++;             break;
+      case 2:   length -= 1;                                    break;
+      default:  copy[length - 1] ^= 0x01;                       break;
+    }
+  }
+  halSim().radio.send(receiverMacAddress, copy, length);
+}
+
+
+/**
+ * @brief main.cpp's receive callback
+ */
+void onDataArrived(const uint8_t* mac, const uint8_t* data, size_t length, void* context)
+{
+  (void)context;
+  receiveFrame(rxState, mac, data, (int)length);
+  rxSnapshot.publish(rxState);
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("%-48s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+/**
+ * @file test_main.cpp
+ * @brief espnow_wire.h's frame validation, one case per parse result and a fuzz run
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every reason EspNowFrameView::parse() can give is produced from a good frame by breaking
+ * exactly the one thing it checks. the fuzz run then feeds it random buffers: pure noise,
+ * noise behind a good magic and version, and good data and batch frames with random bytes
+ * changed, cut short or resealed with a fresh CRC, so the payload views behind parse() see
+ * hostile lengths too. each buffer sits right against a page the process may not read (at
+ * the end of its page, or at the start), so a read of a single byte outside it stops the test
+ * with the case that caused it instead of passing by luck.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unity.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+
+
+/*
+===============================================================================================
+                                    Guarded Buffer
+===============================================================================================
+*/
+
+#define FUZZ_CASES                        200000
+
+/**
+ * @brief one readable page between two that are not
+ */
+struct GuardedPage
+{
+  uint8_t* base = NULL;               // the first guard page
+  size_t pageSize = 0;
+
+  bool map()
+  {
+    pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    void* pages = mmap(NULL, 3 * pageSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+      return false;
+    }
+    base = (uint8_t*)pages;
+    return mprotect(base + pageSize, pageSize, PROT_READ | PROT_WRITE) == 0;
+  }
+
+  /**
+   * @brief where a buffer of length bytes starts when it ends at the upper guard page
+   */
+  uint8_t* endingAtGuard(size_t length) { return base + 2 * pageSize - length; }
+
+  /**
+   * @brief where a buffer starts when it starts right after the lower guard page
+   */
+  uint8_t* startingAtGuard() { return base + pageSize; }
+};
+
+static GuardedPage guarded;
+static sigjmp_buf outOfBounds;
+static volatile sig_atomic_t inParse = 0;
+
+static void onSegmentationFault(int signal)
+{
+  if (inParse) {
+    siglongjmp(outOfBounds, 1);
+  }
+  // not ours, fall back to the default action
+  ::signal(signal, SIG_DFL);
+  raise(signal);
+}
+
+
+/*
+===============================================================================================
+                                    Frames
+===============================================================================================
+*/
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+static size_t buildDataFrame(uint8_t* buffer)
+{
+  EspNowFrameWriter writer(buffer, ESPNOW_WIRE_MAX_FRAME_SIZE);
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, 7, 123456);
+  return writer.finish(EspNowDataView::write(payload, 1000, 2000, true));
+}
+
+/**
+ * @brief a batch of random samples, as the aggregator lays it out
+ */
+static size_t buildBatchFrame(uint8_t* buffer)
+{
+  EspNowFrameWriter writer(buffer, ESPNOW_WIRE_MAX_FRAME_SIZE);
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_BATCH, 8, 654321);
+  espNowWriteU32(payload + ESPNOW_BATCH_BASE_TIMESTAMP_OFFSET, nextRandom());
+  uint16_t position = ESPNOW_BATCH_HEADER_SIZE;
+  uint8_t count = 0;
+  for (;;) {
+    const uint8_t length = (uint8_t)(nextRandom() % 12);
+    if (position + ESPNOW_BATCH_RECORD_HEADER_SIZE + length > ESPNOW_WIRE_MAX_PAYLOAD_SIZE || nextRandom() % 10 == 0) {
+      break;
+    }
+    uint8_t* record = payload + position;
+    record[0] = (uint8_t)(nextRandom() % 4);
+    record[1] = (uint8_t)nextRandom();
+    record[2] = (uint8_t)nextRandom();
+    record[3] = (uint8_t)nextRandom();
+    record[4] = length;
+    for (uint8_t i = 0; i < length; i++) {
+      record[ESPNOW_BATCH_RECORD_HEADER_SIZE + i] = (uint8_t)nextRandom();
+    }
+    position += ESPNOW_BATCH_RECORD_HEADER_SIZE + length;
+    count++;
+  }
+  payload[ESPNOW_BATCH_COUNT_OFFSET] = count;
+  return writer.finish(position);
+}
+
+static void reseal(uint8_t* frame)
+{
+  uint16_t payloadLength = espNowReadU16(frame + ESPNOW_WIRE_LENGTH_OFFSET);
+  payloadLength = payloadLength > ESPNOW_WIRE_MAX_PAYLOAD_SIZE ? ESPNOW_WIRE_MAX_PAYLOAD_SIZE : payloadLength;
+  espNowWriteU16(frame + ESPNOW_WIRE_CRC_OFFSET, espNowFrameCrc(frame, payloadLength));
+}
+
+static void sumSample(const EspNowSample& sample, void* context)
+{
+  uint32_t& sum = *(uint32_t*)context;
+  for (uint8_t i = 0; i < sample.length; i++) {
+    sum += sample.data[i];
+  }
+}
+
+/**
+ * @brief parse a buffer and read everything a receiver would read out of it
+ */
+static EspNowParseResult parseAndRead(const uint8_t* data, int length)
+{
+  EspNowFrameView frame;
+  const EspNowParseResult result = EspNowFrameView::parse(data, length, frame);
+  if (result != ESPNOW_PARSE_OK) {
+    return result;
+  }
+
+  volatile uint32_t sum = frame.sequence() + frame.timestamp() + frame.payloadLength();
+  EspNowDataView payload;
+  if (EspNowDataView::from(frame, payload)) {
+    sum = sum + payload.counterTimer0() + payload.counterLoop() + (payload.buttonState() ? 1 : 0);
+  }
+  uint32_t sampleSum = 0;
+  EspNowBatchReader::forEachSample(frame, sumSample, &sampleSum);
+  sum = sum + sampleSum;
+  return result;
+}
+
+
+static uint8_t frame[ESPNOW_WIRE_MAX_FRAME_SIZE + 16];
+
+void setUp(void)
+{
+  randomState = 1;
+  memset(frame, 0, sizeof(frame));
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Parse Results
+===============================================================================================
+*/
+
+void test_good_frames_parse(void)
+{
+  size_t size = buildDataFrame(frame);
+  TEST_ASSERT_EQUAL_size_t(ESPNOW_WIRE_HEADER_SIZE + ESPNOW_DATA_PAYLOAD_SIZE, size);
+  EspNowFrameView view;
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_OK, EspNowFrameView::parse(frame, (int)size, view));
+  EspNowDataView payload;
+  TEST_ASSERT_TRUE(EspNowDataView::from(view, payload));
+  TEST_ASSERT_EQUAL_UINT32(1000, payload.counterTimer0());
+  TEST_ASSERT_EQUAL_UINT32(2000, payload.counterLoop());
+  TEST_ASSERT_TRUE(payload.buttonState());
+  TEST_ASSERT_EQUAL_UINT16(7, view.sequence());
+  TEST_ASSERT_EQUAL_UINT32(123456, view.timestamp());
+
+  // trailing bytes past the frame are not part of it
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_OK, EspNowFrameView::parse(frame, (int)size + 5, view));
+
+  size = buildBatchFrame(frame);
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_OK, EspNowFrameView::parse(frame, (int)size, view));
+  TEST_ASSERT_GREATER_OR_EQUAL(0, EspNowBatchReader::forEachSample(view, sumSample, &randomState));
+}
+
+
+void test_truncated(void)
+{
+  const size_t size = buildDataFrame(frame);
+  EspNowFrameView view;
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_TRUNCATED, EspNowFrameView::parse(NULL, (int)size, view));
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_TRUNCATED, EspNowFrameView::parse(frame, 0, view));
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_TRUNCATED, EspNowFrameView::parse(frame, -1, view));
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_TRUNCATED, EspNowFrameView::parse(frame, ESPNOW_WIRE_HEADER_SIZE - 1, view));
+
+  // a whole header, but less payload than it claims
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_TRUNCATED, EspNowFrameView::parse(frame, (int)size - 1, view));
+}
+
+
+void test_bad_magic(void)
+{
+  const size_t size = buildDataFrame(frame);
+  frame[ESPNOW_WIRE_MAGIC_OFFSET] ^= 0x01;
+  reseal(frame);
+  EspNowFrameView view;
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_BAD_MAGIC, EspNowFrameView::parse(frame, (int)size, view));
+}
+
+
+void test_bad_version(void)
+{
+  const size_t size = buildDataFrame(frame);
+  frame[ESPNOW_WIRE_VERSION_OFFSET] = ESPNOW_WIRE_VERSION + 1;
+  reseal(frame);
+  EspNowFrameView view;
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_BAD_VERSION, EspNowFrameView::parse(frame, (int)size, view));
+}
+
+
+void test_bad_length(void)
+{
+  buildDataFrame(frame);
+  espNowWriteU16(frame + ESPNOW_WIRE_LENGTH_OFFSET, ESPNOW_WIRE_MAX_PAYLOAD_SIZE + 1);
+  EspNowFrameView view;
+
+  // reported as too long for any frame even when the buffer would hold it
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_BAD_LENGTH, EspNowFrameView::parse(frame, (int)sizeof(frame), view));
+  espNowWriteU16(frame + ESPNOW_WIRE_LENGTH_OFFSET, 0xFFFF);
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_BAD_LENGTH, EspNowFrameView::parse(frame, (int)sizeof(frame), view));
+
+  // the longest payload a frame holds is fine
+  espNowWriteU16(frame + ESPNOW_WIRE_LENGTH_OFFSET, ESPNOW_WIRE_MAX_PAYLOAD_SIZE);
+  reseal(frame);
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_OK, EspNowFrameView::parse(frame, ESPNOW_WIRE_MAX_FRAME_SIZE, view));
+}
+
+
+void test_bad_crc(void)
+{
+  const size_t size = buildDataFrame(frame);
+  EspNowFrameView view;
+
+  // every single bit flip in the header or the payload is caught
+  for (size_t bit = 0; bit < size * 8; bit++) {
+    if (bit / 8 == ESPNOW_WIRE_MAGIC_OFFSET || bit / 8 == ESPNOW_WIRE_VERSION_OFFSET || bit / 8 == ESPNOW_WIRE_LENGTH_OFFSET
+      || bit / 8 == ESPNOW_WIRE_LENGTH_OFFSET + 1) {
+      continue;                       // caught earlier, with their own results
+    }
+    frame[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_BAD_CRC, EspNowFrameView::parse(frame, (int)size, view));
+    frame[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+  }
+  TEST_ASSERT_EQUAL_INT(ESPNOW_PARSE_OK, EspNowFrameView::parse(frame, (int)size, view));
+}
+
+
+/*
+===============================================================================================
+                                    Fuzz
+===============================================================================================
+*/
+
+void test_fuzz_never_reads_outside_the_buffer(void)
+{
+  TEST_ASSERT_TRUE_MESSAGE(guarded.map(), "no guard pages");
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = onSegmentationFault;
+  sigaction(SIGSEGV, &action, NULL);
+  sigaction(SIGBUS, &action, NULL);
+
+  int results[ESPNOW_PARSE_BAD_CRC + 1] = {};
+  for (int i = 0; i < FUZZ_CASES; i++) {
+    // build the case in the scratch frame
+    size_t length;
+    switch (i % 4) {
+      case 0:
+        length = nextRandom() % (ESPNOW_WIRE_MAX_FRAME_SIZE + 1);
+        for (size_t b = 0; b < length; b++) {
+          frame[b] = (uint8_t)nextRandom();
+        }
+        if (length > ESPNOW_WIRE_VERSION_OFFSET && nextRandom() % 2 == 0) {
+          frame[ESPNOW_WIRE_MAGIC_OFFSET] = ESPNOW_WIRE_MAGIC;
+          frame[ESPNOW_WIRE_VERSION_OFFSET] = ESPNOW_WIRE_VERSION;
+        }
+      break;
+
+      default:
+        length = i % 4 == 1 ? buildDataFrame(frame) : buildBatchFrame(frame);
+        for (uint32_t changes = nextRandom() % 4; changes > 0; changes--) {
+          frame[nextRandom() % length] = (uint8_t)nextRandom();
+        }
+        if (nextRandom() % 3 == 0) {
+          length = nextRandom() % (length + 1);
+        }
+        if (nextRandom() % 2 == 0) {
+          reseal(frame);
+        }
+      break;
+    }
+
+    // then against a guard page, and parse it there
+    uint8_t* data = i % 2 == 0 ? guarded.endingAtGuard(length) : guarded.startingAtGuard();
+    memcpy(data, frame, length);
+    inParse = 1;
+    if (sigsetjmp(outOfBounds, 1) != 0) {
+      inParse = 0;
+      char message[96];
+      snprintf(message, sizeof(message), "read outside the buffer, case %d, %u bytes", i, (unsigned)length);
+      TEST_FAIL_MESSAGE(message);
+    }
+    results[parseAndRead(data, (int)length)]++;
+    inParse = 0;
+  }
+
+  printf("fuzz results:");
+  for (int result = ESPNOW_PARSE_OK; result <= ESPNOW_PARSE_BAD_CRC; result++) {
+    printf(" %s %d", espNowParseResultName((EspNowParseResult)result), results[result]);
+  }
+  printf("\n");
+
+  // every path of parse() was taken, good frames included
+  for (int result = ESPNOW_PARSE_OK; result <= ESPNOW_PARSE_BAD_CRC; result++) {
+    TEST_ASSERT_GREATER_THAN(0, results[result]);
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_good_frames_parse);
+  RUN_TEST(test_truncated);
+  RUN_TEST(test_bad_magic);
+  RUN_TEST(test_bad_version);
+  RUN_TEST(test_bad_length);
+  RUN_TEST(test_bad_crc);
+  RUN_TEST(test_fuzz_never_reads_outside_the_buffer);
+  return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_main.cpp
+ * @brief SeqLock<ReceiverState> with one writer and one reader thread, checking for torn copies
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the writer stands in for the receive callback and publishes as fast as it can, the reader
+ * for the loop task and copies the state out as fast as it can. every field of a published
+ * state is derived from one number, so a copy mixing two publishes shows up as fields that
+ * disagree. the reader also checks that copies never go back in time and that the sequence
+ * read() returns belongs to the copy, and alternates with tryRead() to count the copies that
+ * overlapped a publish: if none did, the run proved nothing and fails.
+ *
+ * the threads only count, the assertions run on the test thread after both have joined.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unity.h>
+#include <seqlock.h>
+#include "espnow_receiver.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define STRESS_SECONDS                    2
+
+
+/**
+ * @brief a state whose every field follows from n, the default constructed one is n = 0
+ */
+static ReceiverState stateNumbered(int n)
+{
+  ReceiverState state;
+  state.data.counterTimer0 = n * 3;
+  state.data.counterLoop = n * 5;
+  state.data.buttonState = (n & 1) != 0;
+  state.messageCounter = n;
+  state.messageLength = n * 7;
+  state.recievedAddress = (uint8_t)n;
+  state.lastSequence = (uint16_t)(n * 11);
+  state.sampleCounter = n * 13;
+  state.lastSampleTimestamp = (uint32_t)n * 17;
+  state.rejectedCounter = -n;
+  state.lastRejectReason = (EspNowParseResult)(n % (ESPNOW_PARSE_BAD_CRC + 1));
+  for (int i = 0; i <= ESPNOW_PARSE_BAD_CRC; i++) {
+    state.rejected[i] = n * (19 + i);
+  }
+  return state;
+}
+
+static bool isConsistent(const ReceiverState& state)
+{
+  const int n = state.messageCounter;
+  bool consistent = state.data.counterTimer0 == n * 3 && state.data.counterLoop == n * 5
+    && state.data.buttonState == ((n & 1) != 0) && state.messageLength == n * 7 && state.recievedAddress == (uint8_t)n
+    && state.lastSequence == (uint16_t)(n * 11) && state.sampleCounter == n * 13
+    && state.lastSampleTimestamp == (uint32_t)n * 17 && state.rejectedCounter == -n
+    && state.lastRejectReason == (EspNowParseResult)(n % (ESPNOW_PARSE_BAD_CRC + 1));
+  for (int i = 0; i <= ESPNOW_PARSE_BAD_CRC; i++) {
+    consistent = consistent && state.rejected[i] == n * (19 + i);
+  }
+  return consistent;
+}
+
+
+/*
+===============================================================================================
+                                    Writer and Reader
+===============================================================================================
+*/
+
+struct ReaderResult
+{
+  uint32_t reads = 0;
+  uint32_t torn = 0;                  // copies whose fields came from different publishes
+  uint32_t backwards = 0;             // copies older than the one before
+  uint32_t wrongSequence = 0;         // read() returned a sequence that is not the copy's
+  uint32_t overlapped = 0;            // tryRead() calls that a publish got in the way of
+  int newest = 0;
+};
+
+static void write(SeqLock<ReceiverState>& lock, const std::atomic<bool>& stop, int& published)
+{
+  int n = 0;
+  while (!stop.load(std::memory_order_relaxed)) {
+    lock.publish(stateNumbered(++n));
+  }
+  published = n;
+}
+
+static void read(const SeqLock<ReceiverState>& lock, const std::atomic<bool>& stop, ReaderResult& result)
+{
+  ReceiverState state;
+  while (!stop.load(std::memory_order_relaxed)) {
+    if (result.reads % 2 == 0) {
+      const uint32_t sequence = lock.read(state);
+      result.wrongSequence += sequence != (uint32_t)state.messageCounter * 2 ? 1 : 0;
+    }
+    else if (!lock.tryRead(state)) {
+      result.overlapped++;
+      continue;
+    }
+
+    result.reads++;
+    result.torn += isConsistent(state) ? 0 : 1;
+    result.backwards += state.messageCounter < result.newest ? 1 : 0;
+    result.newest = state.messageCounter > result.newest ? state.messageCounter : result.newest;
+  }
+}
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Tests
+===============================================================================================
+*/
+
+void test_single_thread_round_trip(void)
+{
+  SeqLock<ReceiverState> lock;
+  ReceiverState state = stateNumbered(5);
+  TEST_ASSERT_EQUAL_UINT32(0, lock.sequence());
+  TEST_ASSERT_EQUAL_UINT32(0, lock.read(state));
+  TEST_ASSERT_EQUAL_INT(0, state.messageCounter);
+
+  lock.publish(stateNumbered(1));
+  lock.publish(stateNumbered(2));
+  TEST_ASSERT_EQUAL_UINT32(4, lock.sequence());
+  TEST_ASSERT_EQUAL_UINT32(4, lock.read(state));
+  TEST_ASSERT_TRUE(isConsistent(state));
+  TEST_ASSERT_EQUAL_INT(2, state.messageCounter);
+
+  state = ReceiverState();
+  TEST_ASSERT_TRUE(lock.tryRead(state));
+  TEST_ASSERT_EQUAL_INT(2, state.messageCounter);
+}
+
+
+void test_reader_never_sees_a_torn_copy(void)
+{
+  static SeqLock<ReceiverState> lock;
+  std::atomic<bool> stop(false);
+  ReaderResult result;
+  int published = 0;
+  std::thread reader(read, std::cref(lock), std::cref(stop), std::ref(result));
+  std::thread writer(write, std::ref(lock), std::cref(stop), std::ref(published));
+
+  std::this_thread::sleep_for(std::chrono::seconds(STRESS_SECONDS));
+  stop.store(true, std::memory_order_relaxed);
+  writer.join();
+  reader.join();
+
+  printf("%d publishes, %u reads, %u tryRead() overlaps\n", published, result.reads, result.overlapped);
+  TEST_ASSERT_GREATER_THAN(0, published);
+  TEST_ASSERT_GREATER_THAN(0, result.reads);
+  TEST_ASSERT_GREATER_THAN_MESSAGE(0, result.overlapped, "reader and writer never overlapped, nothing was tested");
+  TEST_ASSERT_EQUAL_UINT32(0, result.torn);
+  TEST_ASSERT_EQUAL_UINT32(0, result.backwards);
+  TEST_ASSERT_EQUAL_UINT32(0, result.wrongSequence);
+  TEST_ASSERT_TRUE(result.newest <= published);
+
+  // once the writer is done the reader gets the last publish
+  ReceiverState state;
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)published * 2, lock.read(state));
+  TEST_ASSERT_EQUAL_INT(published, state.messageCounter);
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_single_thread_round_trip);
+  RUN_TEST(test_reader_never_sees_a_torn_copy);
+  return UNITY_END();
+}
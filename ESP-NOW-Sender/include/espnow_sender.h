@@ -0,0 +1,73 @@
+/**
+ * @file espnow_sender.h
+ * @brief rate limits and the sampling step of the ESP-NOW sender, shared by main.cpp and the
+ * simulation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * each sample cycle queues the counters (and on the device the button) with the aggregator,
+ * which sends a frame once the batch is full or as old as the latency budget. the budget
+ * follows the rate controller: on a lossy link it grows, so fewer, fuller frames go out.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <espnow_link.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define TELEMETRY_MIN_LATENCY_BUDGET    10000       // batch interval on a clean link, in microseconds
+#define TELEMETRY_MAX_LATENCY_BUDGET    200000      // batch interval on a lossy link, in microseconds
+#define TELEMETRY_TARGET_DELIVERY       0.95f       // delivery ratio the rate controller holds
+
+
+/*
+===============================================================================================
+                                    Sampling
+===============================================================================================
+*/
+
+/**
+ * @brief the rate controller's limits, it starts at the slowest rate and speeds up while
+ * frames get through
+ */
+inline EspNowRateConfig telemetryRateConfig()
+{
+  EspNowRateConfig rateConfig;
+  rateConfig.targetDelivery = TELEMETRY_TARGET_DELIVERY;
+  rateConfig.minIntervalUs = TELEMETRY_MIN_LATENCY_BUDGET;
+  rateConfig.maxIntervalUs = TELEMETRY_MAX_LATENCY_BUDGET;
+  return rateConfig;
+}
+
+/**
+ * @brief queue this cycle's counters, a frame only goes out once the batch is full or old enough
+ */
+inline void queueCounterSample(EspNowAggregator& aggregator, uint32_t nowUs, uint32_t counterTimer0, uint32_t counterLoop)
+{
+  uint8_t counters[8];
+  espNowWriteU32(counters, counterTimer0);
+  espNowWriteU32(counters + 4, counterLoop);
+  aggregator.add(ESPNOW_PRODUCER_COUNTERS, nowUs, counters, sizeof(counters));
+}
+
+/**
+ * @brief follow the rate controller, a longer budget means fewer, fuller frames
+ *
+ * @param budgetUs the controller's current interval
+ */
+inline void followLatencyBudget(EspNowAggregator& aggregator, EspNowAggregatorConfig& config, uint32_t budgetUs)
+{
+  if (budgetUs != config.latencyBudgetUs) {
+    config.latencyBudgetUs = budgetUs;
+    aggregator.configure(config);
+  }
+}
@@ -0,0 +1,211 @@
+/**
+ * @file bench_main.cpp
+ * @brief packets/s and payload efficiency of the batching sender for a range of latency budgets
+ *
+ * the sampling step is espnow_sender.h's plus the button, the samples main.cpp queues every
+ * cycle, once at main.cpp's 100 Hz and once at a 1 kHz cycle, where batches fill up before the
+ * budget runs out. the budget is fixed for each run instead of following the rate controller, and
+ * the radio is clean, so every sample has to arrive. for each run the table shows the frames
+ * per second the sender puts on the air, the samples per frame, why frames were sent, the
+ * share of the ESP-NOW payload that is sample data and the share of everything on the air,
+ * counting the 802.11 action frame and ESP-NOW's vendor element around every frame, and the
+ * worst time from a sample being taken to it being received.
+ *
+ * checks: every sample arrives within its budget plus one sample cycle and one radio poll, and
+ * a longer budget never sends more frames or less efficiently. the exit code is 1 if any
+ * check failed.
+ *
+ * build and run: pio run -e native_bench -t exec
+ *
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- //
+#define RADIO_POLL_INTERVAL             1000        // how often the air delivers, in microseconds
+#define BENCH_RUN_US                    10000000
+#define BENCH_AIR_OVERHEAD_BYTES        43          // 802.11 header, action category, ESP-NOW vendor element and FCS
+#define BENCH_EFFICIENCY_TOLERANCE      0.005       // the last, partial batch of a run may be a little emptier
+
+
+// --- includes --- //
+#include <stdio.h>
+#include <hal_sim.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <espnow_link.h>
+#include "espnow_sender.h"
+
+
+// --- global variables --- //
+const uint8_t targetMacAddress[] = {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10};
+SimRadio receiver(halSim().radioMedium, targetMacAddress);
+
+const uint32_t benchSampleIntervals[] = { 10000, 1000 };                                  // 100 Hz as main.cpp, and 1 kHz
+const uint32_t benchLatencyBudgets[] = { 0, 1000, 5000, 10000, 20000, 50000, 100000, 200000 };
+const size_t benchBudgetCount = sizeof(benchLatencyBudgets) / sizeof(benchLatencyBudgets[0]);
+
+/**
+ * @brief one run, the sender's side and what arrived
+ */
+struct BenchRun
+{
+  EspNowAggregator* aggregator = NULL;
+  uint32_t counterLoop = 0;
+  uint32_t samplesReceived = 0;
+  uint32_t framesReceived = 0;
+  uint32_t worstLatencyUs = 0;
+};
+
+BenchRun* currentRun = NULL;
+int failures = 0;
+
+
+// --- function headers --- //
+void runBudget(BenchRun& run, uint32_t sampleIntervalUs);
+void sampleTimer(void* context);
+void radioTimer(void* context);
+void sendFrame(const uint8_t* frame, size_t length, void* context);
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context);
+void receiveSample(const EspNowSample& sample, void* context);
+void check(bool passed, const char* what);
+
+
+// --- main --- //
+int main()
+{
+  SimRadio& sender = halSim().radio;
+  sender.begin();
+  sender.addPeer(targetMacAddress);
+  receiver.begin();
+  receiver.onReceive(onReceive, NULL);
+
+  bool inTime = true;
+  bool allReceived = true;
+  bool batchingPays = true;
+  for (size_t rate = 0; rate < sizeof(benchSampleIntervals) / sizeof(benchSampleIntervals[0]); rate++) {
+    const uint32_t interval = benchSampleIntervals[rate];
+    printf("--- %u samples/s, 2 producers, %.0f s per budget ---\n", 2 * 1000000 / interval, BENCH_RUN_US / 1e6);
+    printf("  %9s %9s %10s %11s %11s %12s %12s %11s\n", "budget", "frames/s", "per frame", "size flush", "age flush",
+      "payload eff", "on-air eff", "worst lat");
+
+    double lastFramesPerSecond = 0;
+    double lastEfficiency = 0;
+    for (size_t i = 0; i < benchBudgetCount; i++) {
+      EspNowAggregatorConfig config;
+      config.latencyBudgetUs = benchLatencyBudgets[i];
+      EspNowAggregator aggregator(config, sendFrame);
+      BenchRun run;
+      run.aggregator = &aggregator;
+      runBudget(run, interval);
+
+      const EspNowAggregatorStats& stats = aggregator.stats();
+      const double framesPerSecond = stats.frames * 1e6 / BENCH_RUN_US;
+      const double efficiency = stats.frameBytes != 0 ? (double)stats.sampleBytes / stats.frameBytes : 0;
+      const double airEfficiency = (double)stats.sampleBytes / (stats.frameBytes + (double)stats.frames * BENCH_AIR_OVERHEAD_BYTES);
+      printf("  %6.1f ms %9.1f %10.1f %11u %11u %11.1f%% %11.1f%% %8.1f ms\n", benchLatencyBudgets[i] / 1000.0,
+        framesPerSecond, stats.frames != 0 ? (double)stats.samples / stats.frames : 0, stats.sizeFlushes, stats.ageFlushes,
+        efficiency * 100, airEfficiency * 100, run.worstLatencyUs / 1000.0);
+
+      inTime = inTime && run.worstLatencyUs <= benchLatencyBudgets[i] + interval + RADIO_POLL_INTERVAL;
+      allReceived = allReceived && run.samplesReceived == stats.samples && run.framesReceived == stats.frames;
+      if (i > 0) {
+        batchingPays = batchingPays && framesPerSecond <= lastFramesPerSecond && efficiency >= lastEfficiency - BENCH_EFFICIENCY_TOLERANCE;
+      }
+      lastFramesPerSecond = framesPerSecond;
+      lastEfficiency = efficiency;
+    }
+    printf("\n");
+  }
+
+  printf("--- checks ---\n");
+  check(allReceived, "every sample and every frame arrived");
+  check(inTime, "every sample arrived within budget + one cycle + one radio poll");
+  check(batchingPays, "a longer budget never sent more frames or less efficiently");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief sample for BENCH_RUN_US, then send what is left and let the air deliver it
+ */
+void runBudget(BenchRun& run, uint32_t sampleIntervalUs)
+{
+  currentRun = &run;
+  SimTimer samples(halSim().clock);
+  SimTimer radio(halSim().clock);
+  samples.start(sampleIntervalUs, sampleTimer, NULL);
+  radio.start(RADIO_POLL_INTERVAL, radioTimer, NULL);
+  halSim().clock.advance(BENCH_RUN_US);
+  samples.stop();
+  radio.stop();
+
+  run.aggregator->flush();
+  halSim().radioMedium.run();
+  currentRun = NULL;
+}
+
+
+/**
+ * @brief one pass of main.cpp's loop(), with a fixed budget
+ */
+void sampleTimer(void* context)
+{
+  (void)context;
+  BenchRun& run = *currentRun;
+  run.counterLoop++;
+
+  const uint32_t now = (uint32_t)halSim().clock.nowUs();
+  queueCounterSample(*run.aggregator, now, now / 1000000, run.counterLoop);
+  const uint8_t button = (uint8_t)(run.counterLoop & 1);
+  run.aggregator->add(ESPNOW_PRODUCER_BUTTON, now, &button, sizeof(button));
+  run.aggregator->poll(now);
+}
+
+
+void radioTimer(void* context)
+{
+  (void)context;
+  halSim().radioMedium.run();
+}
+
+
+void sendFrame(const uint8_t* frame, size_t length, void* context)
+{
+  (void)context;
+  halSim().radio.send(targetMacAddress, frame, length);
+}
+
+
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context)
+{
+  (void)mac;
+  (void)context;
+  EspNowFrameView frame;
+  if (EspNowFrameView::parse(data, (int)length, frame) == ESPNOW_PARSE_OK && frame.type() == ESPNOW_FRAME_BATCH) {
+    EspNowBatchReader::forEachSample(frame, receiveSample);
+    currentRun->framesReceived++;
+  }
+}
+
+
+void receiveSample(const EspNowSample& sample, void* context)
+{
+  (void)context;
+  BenchRun& run = *currentRun;
+  const uint32_t latencyUs = (uint32_t)halSim().clock.nowUs() - sample.timestampUs;
+  run.worstLatencyUs = latencyUs > run.worstLatencyUs ? latencyUs : run.worstLatencyUs;
+  run.samplesReceived++;
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("%-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
@@ -11,6 +11,8 @@
 #define TIMER_INTERRUPT_PRESCALER       80          // this is based off to the clock speed (assuming 80 MHz)
 #define TIMER_0_INTERVAL                1000000     // 1 second in microseconds
 #define BUTTON_PIN                      3           // button pin, GPIO 36, ADC1_CH0
+#define SAMPLE_INTERVAL                 10          // 100 Hz sampling, in milliseconds
+#define STATUS_PRINT_INTERVAL           1000        // 1 second in milliseconds
 
 
 // --- includes --- // 
@@ -18,6 +20,10 @@
 #include <WiFi.h>
 #include <esp_wifi.h>
 #include <esp_now.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <espnow_link.h>
+#include "espnow_sender.h"
 
 
 // --- global variables --- //
@@ -36,12 +42,25 @@ struct DataStruct
 // ESP-Now Connection
 // MAC Address: 90:38:0C:EA:D7:60
 uint8_t targetMacAddress[] = {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10};       // change this to the target address!
+uint8_t deviceMacAddress[6];
+char deviceMacStr[18];
 esp_now_peer_info targetInfo;
 
+// tracks delivery of every frame and slows batching down when frames are lost
+EspNowLink link;
+int targetPeer = ESPNOW_LINK_INVALID_PEER;
+
+// batches samples into as few frames as the latency budget allows
+void sendFrame(const uint8_t* frame, size_t length, void* context);
+EspNowAggregatorConfig aggregatorConfig;
+EspNowAggregator aggregator(aggregatorConfig, sendFrame);
+int sendFailures = 0;
+unsigned long lastStatusPrint = 0;
+
 
 // --- function headers --- //
-void sendData();
-void onDataSent();
+void printStatus();
+void formatMacAddress(const uint8_t *macAddress, char *buffer, int maxLength);
 void timer0ISR();
 
 
@@ -64,7 +83,9 @@ void setup()
   // turn on wifi access point 
   WiFi.mode(WIFI_STA);
   // esp_wifi_set_mac(WIFI_IF_STA, &deviceMacAddress[0]);
-  Serial.printf("DEVICE MAC ADDRESS: %s\n", WiFi.macAddress());
+  WiFi.macAddress(deviceMacAddress);
+  formatMacAddress(deviceMacAddress, deviceMacStr, 18);
+  Serial.printf("DEVICE MAC ADDRESS: %s\n", deviceMacStr);
 
   // init ESP-NOW service
   esp_err_t initResult = esp_now_init();
@@ -78,6 +99,14 @@ void setup()
   // add receiver as a peer
   esp_err_t peerConnectionResult = esp_now_add_peer(&targetInfo);
   Serial.printf("ESP-NOW PEER CONNECTION [ %s ]\n", peerConnectionResult == ESP_OK ? "SUCCESS" : "FAILED");
+
+  // track send completions, the controller starts at the slowest rate and speeds up while frames get through
+  link.begin();
+  targetPeer = link.addPeer(targetMacAddress, telemetryRateConfig());
+
+  // configure batching
+  aggregatorConfig.latencyBudgetUs = link.intervalUs(targetPeer);
+  aggregator.configure(aggregatorConfig);
 }
 
 
@@ -90,31 +119,63 @@ void loop()
   // read button state
   data.buttonState = digitalRead(BUTTON_PIN);
 
-  // transmit updated message
-  sendData();
+  // queue this cycle's samples, a frame only goes out once the batch is full or old enough
+  uint32_t now = micros();
+  queueCounterSample(aggregator, now, data.counterTimer0, data.counterLoop);
+
+  uint8_t button = data.buttonState;
+  aggregator.add(ESPNOW_PRODUCER_BUTTON, now, &button, sizeof(button));
+  aggregator.poll(now);
+
+  // follow the rate controller, a longer budget means fewer, fuller frames
+  followLatencyBudget(aggregator, aggregatorConfig, link.intervalUs(targetPeer));
 
-  // delay the sending of the next message
-  delay(1000);
+  // print a summary instead of a line per message
+  if (millis() - lastStatusPrint >= STATUS_PRINT_INTERVAL) {
+    printStatus();
+    lastStatusPrint = millis();
+  }
+
+  // delay the next sample
+  delay(SAMPLE_INTERVAL);
 }
 
 
 /**
- * @brief function to encapsulate the message sending process
+ * @brief sends a finished batch frame, called by the aggregator
  * 
+ * @param frame the frame to send
+ * @param length size of the frame in bytes
+ * @param context unused
  */
-void sendData()
+void sendFrame(const uint8_t* frame, size_t length, void* context)
 {
-  // send message
-  esp_err_t result = esp_now_send(targetMacAddress, (uint8_t *) &data, sizeof(data));
+  if (link.send(targetPeer, frame, length) != ESP_OK) {
+    sendFailures++;
+  }
+}
+
+
+/**
+ * @brief prints batching and delivery statistics
+ * 
+ */
+void printStatus()
+{
+  const EspNowAggregatorStats& stats = aggregator.stats();
+  EspNowPeerStats linkStats = link.stats(targetPeer);
 
-  // print result
   Serial.printf("\n\n-------------------\n");
-  Serial.print("DEVICE MAC ADDRESS: ");
-  Serial.println(WiFi.macAddress());
+  Serial.printf("DEVICE MAC ADDRESS: %s\n", deviceMacStr);
 
   Serial.printf("Counter: %d\n", data.counterLoop);
-
-  Serial.printf("Message Send Status [ %s ]\n", result == ESP_OK ? "SUCCESS" : "FAILED");
+  Serial.printf("Samples: %u | Frames: %u | Send Failures: %d\n", stats.samples, stats.frames, sendFailures);
+  Serial.printf("Samples per Frame: %u | Payload Efficiency: %u%%\n",
+    stats.frames ? stats.samples / stats.frames : 0, stats.frameBytes ? (uint32_t)(100ULL * stats.sampleBytes / stats.frameBytes) : 0);
+  Serial.printf("Acked: %u | Nacked: %u | Lost: %u | Delivery: %.1f%%\n",
+    linkStats.acked, linkStats.nacked, linkStats.lost, link.delivery(targetPeer) * 100.0f);
+  Serial.printf("Send Latency: %u us avg | %u us max | Batch Interval: %u us\n",
+    linkStats.averageLatencyUs, linkStats.maxLatencyUs, aggregatorConfig.latencyBudgetUs);
   Serial.printf("-------------------\n");
 }
 
@@ -132,4 +193,17 @@ void timer0ISR()
 
   // re-enable interrupts
   portEXIT_CRITICAL_ISR(&timerMux);
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Formats MAC Address
+ * 
+ * @param macAddress the mac address to be converted
+ * @param buffer the string buffer
+ * @param maxLength the max length the output can be
+ */
+void formatMacAddress(const uint8_t *macAddress, char *buffer, int maxLength)
+{
+  snprintf(buffer, maxLength, "%02x:%02x:%02x:%02x:%02x:%02x", macAddress[0], macAddress[1], macAddress[2], macAddress[3], macAddress[4], macAddress[5]);
+}
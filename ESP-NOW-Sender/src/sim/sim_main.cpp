@@ -0,0 +1,190 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the batching sender against a simulated receiver over a lossy simulated radio
+ * 
+ * the radio is clean for the first third of the run, loses 30% of frames in the middle third
+ * and is clean again at the end, so the rate controller can be watched backing off and
+ * recovering. send completions are reported every millisecond. the sampling step is
+ * espnow_sender.h's, the one main.cpp runs. each phase ends with a check of what the
+ * controller did in it, the exit code is 1 if any check failed.
+ * 
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define SAMPLE_INTERVAL                 10000       // 100 Hz sampling as main.cpp, in microseconds
+#define RADIO_POLL_INTERVAL             1000        // how often the air delivers, in microseconds
+#define SIM_PHASE_US                    20000000    // length of each loss phase
+#define SIM_LOSSY_PERCENT               30
+#define SIM_REPORT_INTERVAL             5000000
+
+
+// --- includes --- // 
+#include <stdio.h>
+#include <hal_sim.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <espnow_link.h>
+#include "espnow_sender.h"
+
+
+// --- global variables --- //
+const uint8_t targetMacAddress[] = {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10};
+SimRadio receiver(halSim().radioMedium, targetMacAddress);
+
+EspNowLinkTracker link;
+int targetPeer = ESPNOW_LINK_INVALID_PEER;
+
+void sendFrame(const uint8_t* frame, size_t length, void* context);
+EspNowAggregatorConfig aggregatorConfig;
+EspNowAggregator aggregator(aggregatorConfig, sendFrame);
+
+uint32_t counterLoop = 0;
+uint32_t samplesReceived = 0;
+uint32_t framesReceived = 0;
+int failures = 0;
+
+
+// --- function headers --- //
+void sampleTimer(void* context);
+void radioTimer(void* context);
+void onSent(const uint8_t* mac, bool delivered, void* context);
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context);
+void countSample(const EspNowSample& sample, void* context);
+void printStatus();
+void check(bool passed, const char* what);
+
+
+// --- main --- // 
+int main()
+{
+  SimRadio& sender = halSim().radio;
+  sender.begin();
+  sender.addPeer(targetMacAddress);
+  sender.onSent(onSent, NULL);
+  receiver.begin();
+  receiver.onReceive(onReceive, NULL);
+
+  targetPeer = link.addPeer(targetMacAddress, telemetryRateConfig());
+  aggregatorConfig.latencyBudgetUs = link.controller(targetPeer).intervalUs();
+  aggregator.configure(aggregatorConfig);
+
+  SimTimer samples(halSim().clock);
+  SimTimer radio(halSim().clock);
+  samples.start(SAMPLE_INTERVAL, sampleTimer, NULL);
+  radio.start(RADIO_POLL_INTERVAL, radioTimer, NULL);
+
+  const uint8_t loss[] = { 0, SIM_LOSSY_PERCENT, 0 };
+  for (size_t phase = 0; phase < sizeof(loss); phase++) {
+    halSim().radioMedium.setLoss(loss[phase]);
+    printf("--- %u%% loss ---\n", loss[phase]);
+    const EspNowPeerStats before = link.stats(targetPeer);
+    for (int64_t t = 0; t < SIM_PHASE_US; t += SIM_REPORT_INTERVAL) {
+      halSim().clock.advance(SIM_REPORT_INTERVAL);
+      printStatus();
+    }
+
+    const EspNowPeerStats after = link.stats(targetPeer);
+    const uint32_t budget = link.controller(targetPeer).intervalUs();
+    if (loss[phase] != 0) {
+      check(after.nacked > before.nacked && budget == TELEMETRY_MAX_LATENCY_BUDGET, "lossy: frames lost, batching backed off to the slowest rate");
+    }
+    else {
+      check(after.nacked == before.nacked && budget < TELEMETRY_MAX_LATENCY_BUDGET, "clean: nothing lost, batching sped up");
+    }
+  }
+
+  // every sample in a frame the receiver got is counted, the lost frames' samples are not
+  const EspNowAggregatorStats& stats = aggregator.stats();
+  check(framesReceived == link.stats(targetPeer).acked && samplesReceived <= stats.samples, "the receiver got exactly the acknowledged frames");
+  check(link.controller(targetPeer).delivery() >= TELEMETRY_TARGET_DELIVERY, "delivery recovered to the target");
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief one pass of main.cpp's loop(), without the button
+ */
+void sampleTimer(void* context)
+{
+  (void)context;
+  counterLoop++;
+
+  const uint32_t now = (uint32_t)halSim().clock.nowUs();
+  queueCounterSample(aggregator, now, now / 1000000, counterLoop);
+  aggregator.poll(now);
+
+  followLatencyBudget(aggregator, aggregatorConfig, link.controller(targetPeer).intervalUs());
+}
+
+
+void radioTimer(void* context)
+{
+  (void)context;
+  halSim().radioMedium.run();
+}
+
+
+/**
+ * @brief what EspNowLink::send does, minus the lock
+ */
+void sendFrame(const uint8_t* frame, size_t length, void* context)
+{
+  (void)context;
+  if (halSim().radio.send(targetMacAddress, frame, length)) {
+    link.onSent(targetPeer, espNowReadU16(frame + ESPNOW_WIRE_SEQUENCE_OFFSET), (uint32_t)halSim().clock.nowUs());
+  }
+  else {
+    link.onRejected(targetPeer);
+  }
+}
+
+
+void onSent(const uint8_t* mac, bool delivered, void* context)
+{
+  (void)context;
+  link.onComplete(mac, delivered, (uint32_t)halSim().clock.nowUs());
+}
+
+
+void onReceive(const uint8_t* mac, const uint8_t* data, size_t length, void* context)
+{
+  (void)mac;
+  (void)context;
+  EspNowFrameView frame;
+  if (EspNowFrameView::parse(data, (int)length, frame) == ESPNOW_PARSE_OK && frame.type() == ESPNOW_FRAME_BATCH) {
+    EspNowBatchReader::forEachSample(frame, countSample);
+    framesReceived++;
+  }
+}
+
+
+void countSample(const EspNowSample& sample, void* context)
+{
+  (void)sample;
+  (void)context;
+  samplesReceived++;
+}
+
+
+void printStatus()
+{
+  const EspNowAggregatorStats& stats = aggregator.stats();
+  const EspNowPeerStats& linkStats = link.stats(targetPeer);
+  printf("%5.1f s | samples %u -> %u received | frames %u (%u per frame) | acked %u nacked %u | delivery %.1f%% | batch interval %u us\n",
+    halSim().clock.nowUs() / 1e6, stats.samples, samplesReceived, stats.frames, stats.frames ? stats.samples / stats.frames : 0,
+    linkStats.acked, linkStats.nacked, link.controller(targetPeer).delivery() * 100.0f, aggregatorConfig.latencyBudgetUs);
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("%-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+/**
+ * @file test_main.cpp
+ * @brief espnow_link.h's rate control loop against a simulated lossy link
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the sender sends one frame per interval the controller asks for and the simulated link
+ * completes it a few milliseconds later, delivered or not, through EspNowLinkTracker like the
+ * send callback does on the ESP32. the controller runs with the sender's limits
+ * (telemetryRateConfig). on a link that loses a fixed share of frames, the interval has to end
+ * up at the fastest rate when that share is within the target and at the slowest when it is
+ * not. on a congested link, which loses more the faster it is driven, there is one interval
+ * where delivery meets the target: the controller has to find it and hold delivery there,
+ * without settling on a rate much slower than it.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include <espnow_link.h>
+#include "espnow_sender.h"
+
+
+/*
+===============================================================================================
+                                    Simulated Link
+===============================================================================================
+*/
+
+#define LINK_LATENCY_US                   2000        // send to callback, shorter than any interval
+#define CONVERGE_FRAMES                   5000        // the controller starts at the slowest rate
+#define MEASURE_FRAMES                    20000
+#define DELIVERY_TOLERANCE                0.02f
+#define CONGESTION_KNEE_US                50000       // the link loses nothing extra at this interval or slower
+#define CONGESTION_SLOPE                  0.5f        // extra loss per unit of rate above the knee's
+
+static const uint8_t peerMac[] = {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10};
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief share of frames lost when sending every intervalUs
+ */
+struct SimLink
+{
+  float baseLoss = 0;
+  bool congested = false;
+
+  float lossAt(uint32_t intervalUs) const
+  {
+    float loss = baseLoss;
+    if (congested && intervalUs < CONGESTION_KNEE_US) {
+      loss += CONGESTION_SLOPE * ((float)CONGESTION_KNEE_US / intervalUs - 1.0f);
+    }
+    return loss < 1.0f ? loss : 1.0f;
+  }
+
+  /**
+   * @brief the slowest interval at which the link still loses more than the target allows
+   */
+  uint32_t intervalAtTarget() const
+  {
+    uint32_t intervalUs = TELEMETRY_MAX_LATENCY_BUDGET;
+    while (intervalUs > TELEMETRY_MIN_LATENCY_BUDGET && 1.0f - lossAt(intervalUs - 1) >= TELEMETRY_TARGET_DELIVERY) {
+      intervalUs--;
+    }
+    return intervalUs;
+  }
+};
+
+/**
+ * @brief what happened over the measured frames
+ */
+struct LinkRun
+{
+  uint32_t frames = 0;
+  uint32_t delivered = 0;
+  uint64_t intervalSumUs = 0;
+  uint32_t fastestIntervalUs = UINT32_MAX;
+  uint32_t slowestIntervalUs = 0;
+
+  float delivery() const { return frames != 0 ? (float)delivered / frames : 0; }
+  uint32_t averageIntervalUs() const { return frames != 0 ? (uint32_t)(intervalSumUs / frames) : 0; }
+};
+
+static EspNowLinkTracker tracker;
+static int peer = ESPNOW_LINK_INVALID_PEER;
+static uint32_t nowUs = 0;
+static uint16_t sequence = 0;
+
+/**
+ * @brief send frames at the controller's interval, complete each one on the link
+ */
+static LinkRun sendOver(const SimLink& link, uint32_t frames)
+{
+  LinkRun run;
+  for (uint32_t i = 0; i < frames; i++) {
+    const uint32_t intervalUs = tracker.controller(peer).intervalUs();
+    tracker.onSent(peer, sequence++, nowUs);
+
+    const bool delivered = nextRandom() % 1000000 >= (uint32_t)(link.lossAt(intervalUs) * 1000000);
+    tracker.onComplete(peerMac, delivered, nowUs + LINK_LATENCY_US);
+    nowUs += intervalUs;
+
+    run.frames++;
+    run.delivered += delivered ? 1 : 0;
+    run.intervalSumUs += intervalUs;
+    run.fastestIntervalUs = intervalUs < run.fastestIntervalUs ? intervalUs : run.fastestIntervalUs;
+    run.slowestIntervalUs = intervalUs > run.slowestIntervalUs ? intervalUs : run.slowestIntervalUs;
+  }
+  return run;
+}
+
+void setUp(void)
+{
+  randomState = 1;
+  nowUs = 0;
+  sequence = 0;
+  tracker = EspNowLinkTracker();
+  peer = tracker.addPeer(peerMac, telemetryRateConfig());
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Fixed Loss
+===============================================================================================
+*/
+
+void test_clean_link_runs_at_the_fastest_rate(void)
+{
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MAX_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+  SimLink link;
+  sendOver(link, CONVERGE_FRAMES);
+  const LinkRun run = sendOver(link, MEASURE_FRAMES);
+
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MIN_LATENCY_BUDGET, run.slowestIntervalUs);
+  TEST_ASSERT_EQUAL_UINT32(run.frames, run.delivered);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, tracker.controller(peer).delivery());
+
+  const EspNowPeerStats& stats = tracker.stats(peer);
+  TEST_ASSERT_EQUAL_UINT32(CONVERGE_FRAMES + MEASURE_FRAMES, stats.sent);
+  TEST_ASSERT_EQUAL_UINT32(stats.sent, stats.acked);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.lost);
+  TEST_ASSERT_EQUAL_UINT32(LINK_LATENCY_US, stats.maxLatencyUs);
+  TEST_ASSERT_EQUAL_UINT16((uint16_t)(sequence - 1), stats.lastAckedSequence);
+}
+
+
+void test_loss_within_target_keeps_the_fastest_rate(void)
+{
+  SimLink link;
+  link.baseLoss = 0.02f;
+  sendOver(link, CONVERGE_FRAMES);
+  const LinkRun run = sendOver(link, MEASURE_FRAMES);
+
+  // the smoothed ratio dips below target now and then, the rate always comes back
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MIN_LATENCY_BUDGET, run.fastestIntervalUs);
+  TEST_ASSERT_UINT32_WITHIN(TELEMETRY_MIN_LATENCY_BUDGET / 2, TELEMETRY_MIN_LATENCY_BUDGET, run.averageIntervalUs());
+  TEST_ASSERT_FLOAT_WITHIN(DELIVERY_TOLERANCE, 1.0f - link.baseLoss, run.delivery());
+}
+
+
+void test_loss_past_target_backs_off_to_the_slowest_rate(void)
+{
+  SimLink link;
+  link.baseLoss = 0.3f;
+  sendOver(link, CONVERGE_FRAMES);
+  const LinkRun run = sendOver(link, MEASURE_FRAMES);
+
+  // nothing the rate does helps, so it stays where it costs the least air time
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MAX_LATENCY_BUDGET, run.fastestIntervalUs);
+  TEST_ASSERT_FLOAT_WITHIN(DELIVERY_TOLERANCE, 1.0f - link.baseLoss, run.delivery());
+  TEST_ASSERT_TRUE(tracker.controller(peer).delivery() < TELEMETRY_TARGET_DELIVERY);
+}
+
+
+void test_recovers_after_a_lossy_phase(void)
+{
+  SimLink lossy;
+  lossy.baseLoss = 0.3f;
+  SimLink clean;
+  sendOver(clean, CONVERGE_FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MIN_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+  sendOver(lossy, CONVERGE_FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MAX_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+  sendOver(clean, CONVERGE_FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MIN_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+}
+
+
+/*
+===============================================================================================
+                                    Congestion
+===============================================================================================
+*/
+
+void test_congested_link_converges_to_the_target_delivery(void)
+{
+  SimLink link;
+  link.baseLoss = 0.01f;
+  link.congested = true;
+  const uint32_t atTargetUs = link.intervalAtTarget();
+  TEST_ASSERT_TRUE(atTargetUs > TELEMETRY_MIN_LATENCY_BUDGET && atTargetUs < TELEMETRY_MAX_LATENCY_BUDGET);
+
+  sendOver(link, CONVERGE_FRAMES);
+  const LinkRun run = sendOver(link, MEASURE_FRAMES);
+  printf("congestion: target at %u us, interval %u..%u us, average %u us, delivery %.3f\n", atTargetUs,
+    run.fastestIntervalUs, run.slowestIntervalUs, run.averageIntervalUs(), run.delivery());
+
+  // delivery holds the target, the controller keeps probing past it and backing off
+  TEST_ASSERT_TRUE(run.delivery() >= TELEMETRY_TARGET_DELIVERY - DELIVERY_TOLERANCE);
+  TEST_ASSERT_TRUE(run.fastestIntervalUs < atTargetUs);
+  TEST_ASSERT_TRUE(run.slowestIntervalUs < TELEMETRY_MAX_LATENCY_BUDGET);
+
+  // and on average sends at least half as fast as the best rate that meets the target
+  TEST_ASSERT_TRUE(run.averageIntervalUs() <= 2 * atTargetUs);
+}
+
+
+/*
+===============================================================================================
+                                    Tracking
+===============================================================================================
+*/
+
+void test_missing_callbacks_count_as_lost(void)
+{
+  // ESPNOW_LINK_MAX_IN_FLIGHT frames wait for their callback, the one after pushes the oldest out
+  for (int i = 0; i < ESPNOW_LINK_MAX_IN_FLIGHT + 3; i++) {
+    tracker.onSent(peer, sequence++, nowUs);
+    nowUs += 1000;
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, tracker.stats(peer).lost);
+
+  // the next callback belongs to the oldest frame still in flight, sent at 3 ms
+  tracker.onComplete(peerMac, true, nowUs);
+  TEST_ASSERT_EQUAL_UINT16(3, tracker.stats(peer).lastAckedSequence);
+  TEST_ASSERT_EQUAL_UINT32(nowUs - 3000, tracker.stats(peer).lastLatencyUs);
+
+  // a callback from a peer that is not tracked changes nothing
+  const uint8_t stranger[] = {1, 2, 3, 4, 5, 6};
+  TEST_ASSERT_FALSE(tracker.onComplete(stranger, true, nowUs));
+  TEST_ASSERT_EQUAL_UINT32(1, tracker.stats(peer).acked);
+}
+
+
+void test_rejected_sends_slow_the_rate(void)
+{
+  SimLink clean;
+  sendOver(clean, CONVERGE_FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MIN_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+
+  // each back-off holds for a smoothing window before the next one
+  const uint32_t sent = tracker.stats(peer).sent;
+  for (int i = 0; i < 400; i++) {
+    tracker.onSent(peer, sequence++, nowUs);
+    tracker.onRejected(peer);
+  }
+  TEST_ASSERT_EQUAL_UINT32(sent, tracker.stats(peer).sent);
+  TEST_ASSERT_EQUAL_UINT32(400, tracker.stats(peer).rejected);
+  TEST_ASSERT_EQUAL_UINT32(TELEMETRY_MAX_LATENCY_BUDGET, tracker.controller(peer).intervalUs());
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_link_runs_at_the_fastest_rate);
+  RUN_TEST(test_loss_within_target_keeps_the_fastest_rate);
+  RUN_TEST(test_loss_past_target_backs_off_to_the_slowest_rate);
+  RUN_TEST(test_recovers_after_a_lossy_phase);
+  RUN_TEST(test_congested_link_converges_to_the_target_delivery);
+  RUN_TEST(test_missing_callbacks_count_as_lost);
+  RUN_TEST(test_rejected_sends_slow_the_rate);
+  return UNITY_END();
+}
@@ -0,0 +1,149 @@
+/**
+ * @file gpio_test.h
+ * @brief pins, state and the update cycle of the GPIO test, shared by main.cpp and the simulation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * each update flips one of the four outputs in turn: IMD fault, BMS fault, fan enable, brake
+ * light enable, then starts over. the four pins are one GpioPort, so an update drives them all
+ * with the set / clear registers instead of four gpio_set_level calls.
+ *
+ * the two fault lines are also watched as inputs, in loopback: their edge interrupts stand in
+ * for fault signals from outside and show how fast a fault reaches the task that reacts to it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "driver/gpio.h"
+#include <gpio_port.h>
+#include <gpio_input.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define IMD_FAULT_PIN                     32
+#define BMS_FAULT_PIN                     33
+#define FAN_ENABLE_PIN                    25
+#define BRAKE_LIGHT_ENABLE_PIN            26
+
+// level bits of GpioOutputs, in the order of its pin list
+#define IMD_FAULT_LEVEL                   0x1
+#define BMS_FAULT_LEVEL                   0x2
+#define FAN_ENABLE_LEVEL                  0x4
+#define BRAKE_LIGHT_ENABLE_LEVEL          0x8
+
+typedef GpioPort<IMD_FAULT_PIN, BMS_FAULT_PIN, FAN_ENABLE_PIN, BRAKE_LIGHT_ENABLE_PIN> GpioOutputs;
+
+// fault inputs, indices (change mask bits) in the GpioInputs of beginFaultInputs()
+#define IMD_FAULT_INPUT                   0
+#define BMS_FAULT_INPUT                   1
+#define FAULT_INPUT_DEBOUNCE_US           1000        // lockout after a fault edge
+
+
+/**
+ * @brief structure to keep track of GPIO states
+ */
+struct GPIOData
+{
+  bool imdFaultActive = false;
+  bool bmsFaultActive = false;
+  bool fanEnableActive = false;
+  bool brakeLightEnableActive = false;
+
+  int cycleCounter = 1;
+};
+
+
+/*
+===============================================================================================
+                                    Fault Inputs
+===============================================================================================
+*/
+
+/**
+ * @brief watch the IMD and BMS fault pins in loopback, lockout debounced so a fault is taken
+ * on its first edge
+ *
+ * @param notify called from the ISR with the input bits, e.g. GpioInputs::notifyTask
+ */
+inline esp_err_t beginFaultInputs(GpioInputs& inputs, GpioInputNotify notify, void* context)
+{
+  GpioInputConfig config;
+  config.mode = GPIO_DEBOUNCE_LOCKOUT;
+  config.debounceUs = FAULT_INPUT_DEBOUNCE_US;
+  config.loopback = true;
+
+  config.pin = IMD_FAULT_PIN;
+  inputs.add(config);
+  config.pin = BMS_FAULT_PIN;
+  inputs.add(config);
+
+  inputs.setNotify(notify, context);
+  return inputs.begin();
+}
+
+
+/*
+===============================================================================================
+                                    Update Cycle
+===============================================================================================
+*/
+
+/**
+ * @brief the four states as GpioOutputs levels
+ */
+inline uint32_t gpioOutputLevels(const GPIOData& data)
+{
+  return (data.imdFaultActive ? IMD_FAULT_LEVEL : 0) | (data.bmsFaultActive ? BMS_FAULT_LEVEL : 0) |
+    (data.fanEnableActive ? FAN_ENABLE_LEVEL : 0) | (data.brakeLightEnableActive ? BRAKE_LIGHT_ENABLE_LEVEL : 0);
+}
+
+/**
+ * @brief flip the state the cycle counter points at and drive all four pins
+ */
+inline void applyGpioCycle(GPIOData& data)
+{
+  // flip data states based on the cycle counter
+  switch (data.cycleCounter) {
+    case 1:
+      data.imdFaultActive = !data.imdFaultActive;
+    break;
+
+    case 2:
+      data.bmsFaultActive = !data.bmsFaultActive;
+    break;
+
+    case 3:
+      data.fanEnableActive = !data.fanEnableActive;
+    break;
+
+    case 4:
+      data.brakeLightEnableActive = !data.brakeLightEnableActive;
+    break;
+    
+    default:
+      data.cycleCounter = 0;
+    break;
+  }
+
+  // update gpio states, all four together
+  GpioOutputs::write(gpioOutputLevels(data));
+}
+
+/**
+ * @brief move the cycle counter on, 1 to 4 and around again
+ */
+inline void nextGpioCycle(GPIOData& data)
+{
+  if (data.cycleCounter >= 4) {
+    data.cycleCounter = 1;
+  }
+  else {
+    data.cycleCounter++;
+  }
+}
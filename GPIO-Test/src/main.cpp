@@ -17,6 +17,13 @@
 #include <stdlib.h>
 #include "esp_err.h"
 #include <esp_timer.h>
+#include <latency_histogram.h>
+#include <deferred_log.h>
+#include <telemetry.h>
+#include <static_task.h>
+#include <memory_report.h>
+#include <boot_sequencer.h>
+#include "gpio_test.h"
 
 
 /*
@@ -25,14 +32,20 @@
 ===============================================================================================
 */
 
-#define IMD_FAULT_PIN                     32
-#define BMS_FAULT_PIN                     33
-#define FAN_ENABLE_PIN                    25
-#define BRAKE_LIGHT_ENABLE_PIN            26
-
 #define GPIO_UPDATE_INTERVAL              1500000     // 1.5 seconds in microseconds
-#define TASK_STACK_SIZE                   4096        // in bytes
+#define TASK_STACK_SIZE                   4096        // in bytes, static
+#define GPIO_TASK_PRIORITY                10
+#define FAULT_TASK_PRIORITY               20          // above everything that is not a driver
 #define MAIN_LOOP_DELAY                   1
+#define SERIAL_BAUD_RATE                  9600        // the deferred logger is throttled to this too
+#define LATENCY_REPORT_KEY                'l'         // serial key that prints the latency report
+#define LATENCY_RESET_KEY                 'r'         // serial key that clears it
+#define GPIO_BENCHMARK_KEY                'b'         // serial key that runs the GPIO write benchmark
+#define MEMORY_REPORT_KEY                 'm'         // serial key that prints the heap and stack report
+#define BOOT_REPORT_KEY                   'p'         // serial key that prints the boot profile
+#define GPIO_BENCHMARK_UPDATES            10000       // updates of all four pins per method
+#define TELEMETRY_OUTPUT                  0           // 1 sends the GPIO states as binary telemetry (tools/telemetry_decoder) instead of text
+#define GPIO_TELEMETRY_CHANNEL            1
 
 
 /*
@@ -41,17 +54,42 @@
 ===============================================================================================
 */
 
-// structure to keep track of GPIO states
-struct GPIOData
-{
-  bool imdFaultActive = false;
-  bool bmsFaultActive = false;
-  bool fanEnableActive = false;
-  bool brakeLightEnableActive = false;
+// GPIO states, see gpio_test.h
+GPIOData data;
 
-  int cycleCounter = 1;
+// binary telemetry channel for the same states
+const char* const gpioTelemetryFields[] = { "cycle", "imd", "bms", "fan", "brake" };
+TelemetryChannel gpioTelemetry(GPIO_TELEMETRY_CHANNEL, "gpio", gpioTelemetryFields, 5);
+
+// timing instrumentation, printed on demand over serial
+PeriodMonitor gpioTimerMonitor(GPIO_UPDATE_INTERVAL);
+LatencyHistogram gpioTaskStartLatency;          // timer callback to the GPIO task running
+LatencyHistogram faultIsrLatency;               // fault output written to its edge interrupt
+LatencyHistogram faultReactionLatency;          // edge interrupt to the fault task handling it
+volatile uint32_t gpioTimerFiredAt = 0;         // low words of the times, single stores the reading task cannot tear
+volatile uint32_t gpioOutputsWrittenAt = 0;
+LatencySource latencySources[] = {
+  { "gpio timer lateness", NULL, &gpioTimerMonitor },
+  { "gpio task start", &gpioTaskStartLatency, NULL },
+  { "fault isr", &faultIsrLatency, NULL },
+  { "fault reaction", &faultReactionLatency, NULL },
 };
-GPIOData data;
+
+// the fault lines read back through their edge interrupts, see gpio_test.h
+GpioInputs faultInputs;
+
+// both tasks live for the whole program on static stacks, the timer only wakes the GPIO task
+StaticTask<TASK_STACK_SIZE> gpioTask;
+StaticTask<TASK_STACK_SIZE> faultTask;
+MemorySource memorySources[] = {
+  { "gpio task", NULL, NULL, &gpioTask },
+  { "fault task", NULL, NULL, &faultTask },
+  { "deferred log task", NULL, NULL, &deferredLog().task() },
+};
+
+// brings the node up, its profile is printed on demand over serial
+BootSequencer boot;
+esp_timer_handle_t gpioTimer = NULL;
 
 
 /*
@@ -65,6 +103,17 @@ void GPIOCallback(void* args);
 
 // tasks
 void GPIOTask(void* pvParameters);
+void FaultTask(void* pvParameters);
+
+// benchmark
+void runGpioBenchmark();
+
+// boot stages
+bool beginSerial(void* context);
+bool beginOutputs(void* context);
+bool beginFaults(void* context);
+bool beginGpioTask(void* context);
+bool beginGpioTimer(void* context);
 
 
 /*
@@ -74,39 +123,88 @@ void GPIOTask(void* pvParameters);
 */
 
 void setup() {
-  // delay startup by 5 seconds
-  vTaskDelay(5000);
+  // waits for a serial monitor only when built with -DBOOT_ATTACH_DELAY
+  bootAttachDelay();
+
+  // the fault inputs read the fault outputs back, the timer drives the outputs through the GPIO task
+  // the UART and the fault inputs attach interrupts, which stay on setup's core
+  // everything logs through the deferred logger, records queued before the serial stage are printed once it is up
+  boot.add("serial", beginSerial, NULL, 0, BOOT_ON_CALLER);
+  const int outputs = boot.add("outputs", beginOutputs, NULL);
+  boot.add("fault inputs", beginFaults, NULL, BOOT_AFTER(outputs), BOOT_ON_CALLER);
+  const int gpioTaskStage = boot.add("gpio task", beginGpioTask, NULL);
+  boot.add("gpio timer", beginGpioTimer, NULL, BOOT_AFTER(outputs) | BOOT_AFTER(gpioTaskStage));
+
+  // end setup
+  LOG_PRINTF("BOOT [ %s ] in %u us, '%c' prints the profile\n", boot.run() ? "SUCCESS" : "FAILED",
+    (uint32_t)(boot.endUs() - boot.beginUs()), BOOT_REPORT_KEY);
+}
+
+
+/*
+===============================================================================================
+                                        Boot Stages
+===============================================================================================
+*/
+
+
+/**
+ * @brief starts serial and the deferred logger, the GPIO task logs through it so it never waits on the UART
+ */
+bool beginSerial(void* context) {
+  Serial.begin(SERIAL_BAUD_RATE);
+  DeferredLogConfig logConfig;
+  logConfig.baudRate = SERIAL_BAUD_RATE;
+  return deferredLog().begin(Serial, logConfig);
+}
+
+
+/**
+ * @brief sets up the four outputs
+ */
+bool beginOutputs(void* context) {
+  const bool ok = gpio_set_direction((gpio_num_t)IMD_FAULT_PIN, GPIO_MODE_OUTPUT) == ESP_OK &&
+    gpio_set_direction((gpio_num_t)BMS_FAULT_PIN, GPIO_MODE_OUTPUT) == ESP_OK &&
+    gpio_set_direction((gpio_num_t)FAN_ENABLE_PIN, GPIO_MODE_OUTPUT) == ESP_OK &&
+    gpio_set_direction((gpio_num_t)BRAKE_LIGHT_ENABLE_PIN, GPIO_MODE_OUTPUT) == ESP_OK;
+  LOG_PRINTF("GPIO INIT OUTPUTS [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
+}
 
-  // start serial
-  Serial.begin(9600);
-  Serial.printf("\n\n|--- STARTING SETUP ---|\n\n");
 
-  // ------------------------- initialize GPIO -------------------------------- //
+/**
+ * @brief fault inputs, the task exists before the first edge can notify it
+ */
+bool beginFaults(void* context) {
+  const bool ok = faultTask.start(FaultTask, "Fault-Inputs", NULL, FAULT_TASK_PRIORITY) &&
+    beginFaultInputs(faultInputs, &GpioInputs::notifyTask, faultTask.handle()) == ESP_OK;
+  LOG_PRINTF("GPIO INIT FAULT INPUTS [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
+}
 
-  // setup outputs
-  ESP_ERROR_CHECK(gpio_set_direction((gpio_num_t)IMD_FAULT_PIN, GPIO_MODE_OUTPUT));
-  ESP_ERROR_CHECK(gpio_set_direction((gpio_num_t)BMS_FAULT_PIN, GPIO_MODE_OUTPUT));
-  ESP_ERROR_CHECK(gpio_set_direction((gpio_num_t)FAN_ENABLE_PIN, GPIO_MODE_OUTPUT));
-  ESP_ERROR_CHECK(gpio_set_direction((gpio_num_t)BRAKE_LIGHT_ENABLE_PIN, GPIO_MODE_OUTPUT));
-  Serial.printf("GPIO INIT OUTPUTS [ SUCCESS ]\n");
+
+/**
+ * @brief the GPIO task waits for the timer, created once instead of on every tick
+ */
+bool beginGpioTask(void* context) {
+  const bool ok = gpioTask.start(GPIOTask, "GPIO-Update", NULL, GPIO_TASK_PRIORITY);
+  LOG_PRINTF("GPIO TASK INIT [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
+}
 
 
-  // ------------------------ initialize timers ------------------------------- //
-  // GPIO Update
-  const esp_timer_create_args_t timer1_args = {
+/**
+ * @brief starts the GPIO update timer
+ */
+bool beginGpioTimer(void* context) {
+  const esp_timer_create_args_t gpioTimerArgs = {
     .callback = &GPIOCallback,
     .dispatch_method = ESP_TIMER_TASK,
     .name = "GPIO Update Timer"
   };
-  esp_timer_handle_t timer1;
-  ESP_ERROR_CHECK(esp_timer_create(&timer1_args, &timer1));
-
-  // start CAN timer
-  ESP_ERROR_CHECK(esp_timer_start_periodic(timer1, GPIO_UPDATE_INTERVAL));
-  Serial.printf("GPIO TIMER INIT [ SUCCESS ]\n");
-
-  // end setup
-  Serial.printf("\n\n|--- END SETUP ---|\n\n");
+  const bool ok = esp_timer_create(&gpioTimerArgs, &gpioTimer) == ESP_OK && esp_timer_start_periodic(gpioTimer, GPIO_UPDATE_INTERVAL) == ESP_OK;
+  LOG_PRINTF("GPIO TIMER INIT [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
 }
 
 
@@ -118,17 +216,19 @@ void setup() {
 
 
 /**
- * @brief callback function for creating a new GPIO Update task
+ * @brief callback function for waking the GPIO Update task, no allocation happens here
  * 
- * @param args arguments to be passed to the task
+ * @param args arguments passed by the timer (unused)
  */
 void GPIOCallback(void* args) {
-  // init task parameters
-  static uint8_t ucParameterToPass;
-  TaskHandle_t xHandle = NULL;
+  int64_t now = esp_timer_get_time();
+  gpioTimerMonitor.mark(now);
+  gpioTimerFiredAt = (uint32_t)now;
 
-  // queue GPIO task for execution
-  xTaskCreate(GPIOTask, "GPIO-Update", TASK_STACK_SIZE, &ucParameterToPass, 10, &xHandle);
+  // wake the GPIO task
+  if (gpioTask.handle() != NULL) {
+    xTaskNotifyGive(gpioTask.handle());
+  }
 }
 
 
@@ -140,54 +240,169 @@ void GPIOCallback(void* args) {
 
 
 /**
- * @brief updates gpio data and pins
+ * @brief updates gpio data and pins every time the GPIO timer ticks
  * 
  * @param arg - argument passed via function pointer
  */
 void GPIOTask(void *arg)
 {
-  // flip data states based on the cycle counter
-  switch (data.cycleCounter) {
-    case 1:
-      data.imdFaultActive = !data.imdFaultActive;
-    break;
-
-    case 2:
-      data.bmsFaultActive = !data.bmsFaultActive;
-    break;
-
-    case 3:
-      data.fanEnableActive = !data.fanEnableActive;
-    break;
-
-    case 4:
-      data.brakeLightEnableActive = !data.brakeLightEnableActive;
-    break;
-    
-    default:
-      data.cycleCounter = 0;
-    break;
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // wait for the next timer tick
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    gpioTaskStartLatency.record((uint32_t)esp_timer_get_time() - gpioTimerFiredAt);     // unsigned, so right across the wrap too
+
+    // flip the next state and update gpio states
+    gpioOutputsWrittenAt = (uint32_t)esp_timer_get_time();
+    applyGpioCycle(data);
+
+    // print update
+#if TELEMETRY_OUTPUT
+    const int32_t values[] = { data.cycleCounter, data.imdFaultActive, data.bmsFaultActive, data.fanEnableActive, data.brakeLightEnableActive };
+    gpioTelemetry.write(Serial, (uint32_t)esp_timer_get_time(), values);
+#else
+    LOG_PRINTF("cycle: %d | imd: %d | bms: %d | fan: %d | brake: %d\r", data.cycleCounter, data.imdFaultActive, data.bmsFaultActive, data.fanEnableActive, data.brakeLightEnableActive);
+#endif
+
+    // update cycle counter
+    nextGpioCycle(data);
+  }
+}
+
+
+/**
+ * @brief reacts to fault input changes, woken by their edge interrupts instead of polling
+ * 
+ * @param arg - argument passed via function pointer
+ */
+void FaultTask(void *arg)
+{
+  for (;;) {
+    // sleep until an edge, or until a lockout the debouncer has to look at ends
+    TickType_t timeout = portMAX_DELAY;
+    const int64_t deadline = faultInputs.nextDeadlineUs();
+    if (deadline != GPIO_INPUT_NO_DEADLINE) {
+      const int64_t waitUs = deadline - esp_timer_get_time();
+      timeout = waitUs > 0 ? pdMS_TO_TICKS((uint32_t)(waitUs + 999) / 1000) : 0;
+    }
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, ULONG_MAX, &bits, timeout);
+
+    const int64_t now = esp_timer_get_time();
+    const uint32_t changed = faultInputs.service(now);
+    for (int i = 0; i < faultInputs.size(); i++) {
+      if ((changed & (1u << i)) == 0) {
+        continue;
+      }
+      const GpioInputState fault = faultInputs.state(i);
+      faultIsrLatency.record((uint32_t)fault.edgeUs - gpioOutputsWrittenAt);
+      faultReactionLatency.record((uint32_t)(now - fault.edgeUs));
+      LOG_PRINTF("%s fault: %d (%u us after the edge, %u bounces)\r", i == IMD_FAULT_INPUT ? "imd" : "bms", fault.active,
+        (uint32_t)(now - fault.edgeUs), fault.bounces);
+    }
   }
+}
+
+
+/*
+===============================================================================================
+                                    Benchmark
+===============================================================================================
+*/
+
+
+/**
+ * @brief print one benchmark row, converting CPU cycles to nanoseconds
+ */
+void printGpioBenchmarkRow(const char* method, uint64_t totalCycles, uint64_t totalSkew, uint32_t maxSkew)
+{
+  const uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+  const uint32_t updateNs = (uint32_t)(totalCycles * 1000 / cyclesPerUs / GPIO_BENCHMARK_UPDATES);
+  Serial.printf("  %-26s %5u ns/update (%8u updates/s) | skew avg %5u ns, max %6u ns\n", method, updateNs,
+    updateNs != 0 ? 1000000000u / updateNs : 0, (uint32_t)(totalSkew * 1000 / cyclesPerUs / GPIO_BENCHMARK_UPDATES),
+    maxSkew * 1000 / cyclesPerUs);
+}
+
 
-  // update gpio states
-  gpio_set_level((gpio_num_t)IMD_FAULT_PIN, data.imdFaultActive);
-  gpio_set_level((gpio_num_t)BMS_FAULT_PIN, data.bmsFaultActive);
-  gpio_set_level((gpio_num_t)FAN_ENABLE_PIN, data.fanEnableActive);
-  gpio_set_level((gpio_num_t)BRAKE_LIGHT_ENABLE_PIN, data.brakeLightEnableActive);
-  
-  // print update
-  Serial.printf("cycle: %d | imd: %d | bms: %d | fan: %d | brake: %d\r", data.cycleCounter, data.imdFaultActive, data.bmsFaultActive, data.fanEnableActive, data.brakeLightEnableActive);
-
-  // update cycle counter
-  if (data.cycleCounter >= 4) {
-    data.cycleCounter = 1;
+/**
+ * @brief toggle all four outputs per pin and through GpioOutputs, print the update rate and the
+ * skew between the first and the last pin changing
+ *
+ * per pin, the skew runs from the first gpio_set_level returning to the last one returning.
+ * for the port it is the whole write, an upper bound. the pins flicker at full speed for a
+ * few milliseconds: the fault inputs watching the IMD and BMS lines are paused meanwhile, so
+ * the fault task never sees the flicker, but external hardware on the pins still would.
+ */
+void runGpioBenchmark()
+{
+  uint64_t totalCycles = 0;
+  uint64_t totalSkew = 0;
+  uint32_t maxSkew = 0;
+
+  if (faultInputs.pause() != ESP_OK) {
+    Serial.printf("gpio benchmark: fault inputs could not be paused, not run\n");
+    faultInputs.resume();
+    return;
   }
-  else {
-    data.cycleCounter++;
+  Serial.printf("gpio benchmark, %d updates of 4 pins:\n", GPIO_BENCHMARK_UPDATES);
+
+  // one driver call per pin
+  for (int i = 0; i < GPIO_BENCHMARK_UPDATES; i++) {
+    const uint32_t level = i & 1;
+    const uint32_t start = ESP.getCycleCount();
+    gpio_set_level((gpio_num_t)IMD_FAULT_PIN, level);
+    const uint32_t first = ESP.getCycleCount();
+    gpio_set_level((gpio_num_t)BMS_FAULT_PIN, level);
+    gpio_set_level((gpio_num_t)FAN_ENABLE_PIN, level);
+    gpio_set_level((gpio_num_t)BRAKE_LIGHT_ENABLE_PIN, level);
+    const uint32_t last = ESP.getCycleCount();
+    totalCycles += last - start;
+    totalSkew += last - first;
+    maxSkew = last - first > maxSkew ? last - first : maxSkew;
   }
+  printGpioBenchmarkRow("gpio_set_level x4", totalCycles, totalSkew, maxSkew);
+
+  // the port with levels computed at run time, what GPIOTask does
+  totalCycles = 0;
+  totalSkew = 0;
+  maxSkew = 0;
+  for (int i = 0; i < GPIO_BENCHMARK_UPDATES; i++) {
+    const uint32_t levels = (i & 1) ? 0xF : 0x0;
+    const uint32_t start = ESP.getCycleCount();
+    GpioOutputs::write(levels);
+    const uint32_t cycles = ESP.getCycleCount() - start;
+    totalCycles += cycles;
+    totalSkew += cycles;
+    maxSkew = cycles > maxSkew ? cycles : maxSkew;
+  }
+  printGpioBenchmarkRow("GpioOutputs::write(levels)", totalCycles, totalSkew, maxSkew);
+
+  // the port with constant masks
+  totalCycles = 0;
+  totalSkew = 0;
+  maxSkew = 0;
+  for (int i = 0; i < GPIO_BENCHMARK_UPDATES; i++) {
+    uint32_t start;
+    uint32_t cycles;
+    if (i & 1) {
+      start = ESP.getCycleCount();
+      GpioOutputs::write<0xF>();
+      cycles = ESP.getCycleCount() - start;
+    }
+    else {
+      start = ESP.getCycleCount();
+      GpioOutputs::write<0x0>();
+      cycles = ESP.getCycleCount() - start;
+    }
+    totalCycles += cycles;
+    totalSkew += cycles;
+    maxSkew = cycles > maxSkew ? cycles : maxSkew;
+  }
+  printGpioBenchmarkRow("GpioOutputs::write<L>()", totalCycles, totalSkew, maxSkew);
 
-  // end task
-  vTaskDelete(NULL);
+  // put the outputs back the way the GPIO task left them, then let the fault inputs see the lines again
+  GpioOutputs::write(gpioOutputLevels(data));
+  faultInputs.resume();
 }
 
 
@@ -198,6 +413,26 @@ void GPIOTask(void *arg)
 */
 
 void loop() {
+  // print or clear the latency report on request
+  if (Serial.available() > 0) {
+    int key = Serial.read();
+    if (key == LATENCY_REPORT_KEY) {
+      printLatencyReport(Serial, latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == LATENCY_RESET_KEY) {
+      resetLatencyReport(latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == GPIO_BENCHMARK_KEY) {
+      runGpioBenchmark();
+    }
+    else if (key == MEMORY_REPORT_KEY) {
+      printMemoryReport(Serial, memorySources, sizeof(memorySources) / sizeof(memorySources[0]));
+    }
+    else if (key == BOOT_REPORT_KEY) {
+      printBootReport(Serial, boot);
+    }
+  }
+
   // prevent watchdog from getting upset
   vTaskDelay(MAIN_LOOP_DELAY);   
 }
\ No newline at end of file
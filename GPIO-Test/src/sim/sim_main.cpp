@@ -0,0 +1,437 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the GPIO update cycle on the simulated board
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the update runs straight from the esp_timer callback instead of waking the GPIO task,
+ * FreeRTOS is not simulated. before the run, GpioOutputs' masks are checked against the pin
+ * list, at compile time for a few constants and at run time for every combination of levels.
+ *
+ * the fault task is a one-shot timer the fault inputs' notify hook starts SIM_TASK_WAKE_US
+ * after the edge (a guess at the device's context switch), and the timer rearms itself for
+ * the debouncer's next deadline. before the update run, scripted edge sequences (bounce,
+ * glitches, spikes) are injected on two spare input pins, one per debounce mode, and what
+ * the debouncer made of them is checked against what each sequence should produce.
+ *
+ * after the update run the fault inputs are paused while the four pins flicker like main.cpp's
+ * GPIO benchmark: the fault task must not see a single edge of it, and a fault line left on
+ * the other level has to come through as exactly one change on resume.
+ */
+
+/*
+===============================================================================================
+                                    Includes 
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include "esp_err.h"
+#include <esp_timer.h>
+#include <latency_histogram.h>
+#include "gpio_test.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define GPIO_UPDATE_INTERVAL              1500000     // same as main.cpp
+#define SIM_DURATION_US                   60000000    // one minute of virtual time
+#define SIM_TRACE_CYCLES                  8           // updates printed in full
+#define SIM_PIN_BIT(pin)                  (1ull << (pin))
+#define SIM_TASK_WAKE_US                  20          // notify to the consumer running
+#define SIM_BUTTON_PIN                    34          // spare input pins for the edge sequences
+#define SIM_SENSOR_PIN                    35
+#define SIM_BUTTON_DEBOUNCE_US            20000
+#define SIM_BENCHMARK_UPDATES             10000       // main.cpp's GPIO_BENCHMARK_UPDATES
+
+// the masks are constant expressions, so the pin map is checked by the compiler
+static_assert(GpioOutputs::pins() == (SIM_PIN_BIT(32) | SIM_PIN_BIT(33) | SIM_PIN_BIT(25) | SIM_PIN_BIT(26)), "pin map");
+static_assert(GpioOutputs::setMask(IMD_FAULT_LEVEL | FAN_ENABLE_LEVEL) == (SIM_PIN_BIT(32) | SIM_PIN_BIT(25)), "set mask");
+static_assert(GpioOutputs::clearMask(IMD_FAULT_LEVEL | FAN_ENABLE_LEVEL) == (SIM_PIN_BIT(33) | SIM_PIN_BIT(26)), "clear mask");
+static_assert(GpioOutputs::usesLowBank() && GpioOutputs::usesHighBank(), "25 / 26 are in GPIO.out, 32 / 33 in GPIO.out1");
+
+
+/*
+===============================================================================================
+                                  Global Variables
+===============================================================================================
+*/
+
+GPIOData data;
+uint32_t updates = 0;
+
+/**
+ * @brief a task that waits on a GpioInputs' notifications, as a one-shot timer
+ */
+struct SimInputTask
+{
+  GpioInputs inputs;
+  esp_timer_handle_t timer = NULL;
+  LatencyHistogram reaction;                    // first edge to the task seeing the change
+  bool trace = false;
+};
+
+SimInputTask faultTask;
+SimInputTask sequenceTask;
+
+/**
+ * @brief one scripted edge, time relative to the start of its sequence
+ */
+struct SimEdge
+{
+  uint32_t atUs;
+  uint8_t pin;
+  uint8_t level;
+};
+
+/**
+ * @brief an edge sequence and what the debouncer must make of it
+ */
+struct SimSequence
+{
+  const char* name;
+  const SimEdge* edges;
+  int count;
+  uint32_t changes;
+  uint32_t glitches;
+};
+
+
+/*
+===============================================================================================
+                                    Callback Functions
+===============================================================================================
+*/
+
+void GPIOCallback(void* args)
+{
+  (void)args;
+  faultTask.trace = updates < SIM_TRACE_CYCLES;
+  applyGpioCycle(data);
+  if (updates++ < SIM_TRACE_CYCLES) {
+    printf("%6.1f s  cycle: %d | imd: %d | bms: %d | fan: %d | brake: %d\n", esp_timer_get_time() / 1e6, data.cycleCounter,
+      gpio_get_level((gpio_num_t)IMD_FAULT_PIN), gpio_get_level((gpio_num_t)BMS_FAULT_PIN),
+      gpio_get_level((gpio_num_t)FAN_ENABLE_PIN), gpio_get_level((gpio_num_t)BRAKE_LIGHT_ENABLE_PIN));
+  }
+  nextGpioCycle(data);
+}
+
+
+/**
+ * @brief ISR notify hook, wakes the task like xTaskNotifyFromISR would
+ */
+bool notifyInputTask(uint32_t bits, void* context)
+{
+  SimInputTask& task = *(SimInputTask*)context;
+  (void)bits;
+  esp_timer_stop(task.timer);
+  esp_timer_start_once(task.timer, SIM_TASK_WAKE_US);
+  return true;
+}
+
+
+/**
+ * @brief the task body: service, record the changes, sleep until the next deadline
+ */
+void inputTaskCallback(void* args)
+{
+  SimInputTask& task = *(SimInputTask*)args;
+  const int64_t now = esp_timer_get_time();
+  const uint32_t changed = task.inputs.service(now);
+  for (int i = 0; i < task.inputs.size(); i++) {
+    if ((changed & (1u << i)) == 0) {
+      continue;
+    }
+    const GpioInputState state = task.inputs.state(i);
+    task.reaction.record((uint32_t)(now - state.edgeUs));
+    if (task.trace) {
+      printf("%10.6f s  pin %d: %d, edge at %.6f s, %u bounces\n", now / 1e6, task.inputs.pin(i), state.active,
+        state.edgeUs / 1e6, state.bounces);
+    }
+  }
+
+  const int64_t deadline = task.inputs.nextDeadlineUs();
+  if (deadline != GPIO_INPUT_NO_DEADLINE) {
+    esp_timer_start_once(task.timer, deadline > now ? (uint64_t)(deadline - now) : 0);
+  }
+}
+
+
+void createInputTask(SimInputTask& task, const char* name)
+{
+  const esp_timer_create_args_t timerArgs = {
+    .callback = &inputTaskCallback,
+    .arg = &task,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = name,
+    .skip_unhandled_events = false,
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &task.timer));
+}
+
+
+void printReaction(const char* name, const LatencyHistogram& histogram)
+{
+  const LatencySummary summary = histogram.summary();
+  printf("%-16s %u changes, reaction p50 %u us, p99 %u us, max %u us\n", name, summary.count, summary.p50, summary.p99, summary.max);
+}
+
+
+/*
+===============================================================================================
+                                    Edge Sequences
+===============================================================================================
+*/
+
+// the button is active low with a pull-up and settles for 20 ms
+const SimEdge buttonPress[] = {
+  { 0, SIM_BUTTON_PIN, 0 }, { 300, SIM_BUTTON_PIN, 1 }, { 800, SIM_BUTTON_PIN, 0 }, { 1500, SIM_BUTTON_PIN, 1 },
+  { 3000, SIM_BUTTON_PIN, 0 },
+  { 150000, SIM_BUTTON_PIN, 1 }, { 150400, SIM_BUTTON_PIN, 0 }, { 151000, SIM_BUTTON_PIN, 1 },
+};
+const SimEdge buttonGlitch[] = {
+  { 0, SIM_BUTTON_PIN, 0 }, { 2000, SIM_BUTTON_PIN, 1 },
+  { 50000, SIM_BUTTON_PIN, 0 }, { 50010, SIM_BUTTON_PIN, 1 }, { 50020, SIM_BUTTON_PIN, 0 }, { 50030, SIM_BUTTON_PIN, 1 },
+};
+const SimEdge buttonChatter[] = {
+  // a contact that never rests for 20 ms is never taken
+  { 0, SIM_BUTTON_PIN, 0 }, { 15000, SIM_BUTTON_PIN, 1 }, { 30000, SIM_BUTTON_PIN, 0 }, { 45000, SIM_BUTTON_PIN, 1 },
+  { 60000, SIM_BUTTON_PIN, 0 }, { 75000, SIM_BUTTON_PIN, 1 },
+};
+
+// the sensor is a fault line, active high with lockout
+const SimEdge sensorBounce[] = {
+  { 0, SIM_SENSOR_PIN, 1 }, { 100, SIM_SENSOR_PIN, 0 }, { 250, SIM_SENSOR_PIN, 1 }, { 400, SIM_SENSOR_PIN, 0 },
+  { 600, SIM_SENSOR_PIN, 1 },
+  { 20000, SIM_SENSOR_PIN, 0 }, { 20050, SIM_SENSOR_PIN, 1 }, { 20120, SIM_SENSOR_PIN, 0 },
+};
+const SimEdge sensorSpike[] = {
+  // taken on the first edge, then the lockout end sees the line back low and undoes it
+  { 0, SIM_SENSOR_PIN, 1 }, { 200, SIM_SENSOR_PIN, 0 },
+};
+const SimEdge sensorEndOfLockout[] = {
+  // a 1 us dip right before the lockout ends and back up on its last tick: no change
+  { 0, SIM_SENSOR_PIN, 1 }, { FAULT_INPUT_DEBOUNCE_US - 1, SIM_SENSOR_PIN, 0 }, { FAULT_INPUT_DEBOUNCE_US, SIM_SENSOR_PIN, 1 },
+  { 30000, SIM_SENSOR_PIN, 0 },
+};
+
+#define SIM_SEQUENCE(edges, changes, glitches) { #edges, edges, sizeof(edges) / sizeof(edges[0]), changes, glitches }
+
+const SimSequence sequences[] = {
+  SIM_SEQUENCE(buttonPress, 2, 0),
+  SIM_SEQUENCE(buttonGlitch, 0, 2),
+  SIM_SEQUENCE(buttonChatter, 0, 1),
+  SIM_SEQUENCE(sensorBounce, 2, 0),
+  SIM_SEQUENCE(sensorSpike, 2, 0),
+  SIM_SEQUENCE(sensorEndOfLockout, 2, 0),
+};
+
+
+/**
+ * @brief drive the spare pins through every sequence, 200 ms apart, and compare the results
+ * @return sequences that did not match
+ */
+int runEdgeSequences()
+{
+  halSim().gpio.setMode(SIM_BUTTON_PIN, HAL_PIN_INPUT_PULLUP);
+  halSim().gpio.setMode(SIM_SENSOR_PIN, HAL_PIN_INPUT);
+
+  GpioInputConfig config;
+  config.pin = SIM_BUTTON_PIN;
+  config.mode = GPIO_DEBOUNCE_SETTLE;
+  config.debounceUs = SIM_BUTTON_DEBOUNCE_US;
+  config.activeLow = true;
+  config.pull = GPIO_PULLUP_ONLY;
+  sequenceTask.inputs.add(config);
+  config.pin = SIM_SENSOR_PIN;
+  config.mode = GPIO_DEBOUNCE_LOCKOUT;
+  config.debounceUs = FAULT_INPUT_DEBOUNCE_US;
+  config.activeLow = false;
+  config.pull = GPIO_FLOATING;
+  sequenceTask.inputs.add(config);
+
+  createInputTask(sequenceTask, "Sequence Task");
+  sequenceTask.inputs.setNotify(&notifyInputTask, &sequenceTask);
+  ESP_ERROR_CHECK(sequenceTask.inputs.begin());
+
+  int mismatches = 0;
+  printf("%-20s %6s %8s %8s %8s\n", "sequence", "edges", "changes", "glitches", "");
+  for (size_t s = 0; s < sizeof(sequences) / sizeof(sequences[0]); s++) {
+    const SimSequence& sequence = sequences[s];
+    const int index = sequence.edges[0].pin == SIM_BUTTON_PIN ? 0 : 1;
+    const GpioInputState before = sequenceTask.inputs.state(index);
+
+    const int64_t start = halSim().clock.nowUs();
+    for (int e = 0; e < sequence.count; e++) {
+      halSim().clock.advance(start + sequence.edges[e].atUs - halSim().clock.nowUs());
+      halSim().gpio.setInput(sequence.edges[e].pin, sequence.edges[e].level);
+    }
+    halSim().clock.advance(start + 200000 - halSim().clock.nowUs());
+
+    const GpioInputState after = sequenceTask.inputs.state(index);
+    const uint32_t changes = after.changes - before.changes;
+    const uint32_t glitches = after.glitches - before.glitches;
+    const bool match = changes == sequence.changes && glitches == sequence.glitches;
+    printf("%-20s %6u %8u %8u %8s\n", sequence.name, after.edges - before.edges, changes, glitches, match ? "ok" : "MISMATCH");
+    if (!match) {
+      printf("  expected %u changes, %u glitches\n", sequence.changes, sequence.glitches);
+      mismatches++;
+    }
+  }
+
+  printReaction("edge sequences", sequenceTask.reaction);
+  sequenceTask.inputs.end();
+  return mismatches;
+}
+
+
+/**
+ * @brief every combination of levels: masks against a per pin reference, then written and read back
+ * @return combinations that did not match
+ */
+int checkGpioMasks(const int* pins, int count)
+{
+  int mismatches = 0;
+  for (uint32_t levels = 0; levels < (1u << count); levels++) {
+    uint64_t set = 0;
+    uint64_t clear = 0;
+    for (int i = 0; i < count; i++) {
+      if ((levels >> i) & 1) {
+        set |= SIM_PIN_BIT(pins[i]);
+      }
+      else {
+        clear |= SIM_PIN_BIT(pins[i]);
+      }
+    }
+
+    GpioOutputs::write(levels);
+    bool match = GpioOutputs::setMask(levels) == set && GpioOutputs::clearMask(levels) == clear;
+    for (int i = 0; i < count; i++) {
+      match = match && gpio_get_level((gpio_num_t)pins[i]) == (int)((levels >> i) & 1);
+    }
+    if (!match) {
+      printf("levels 0x%X: set 0x%010llX clear 0x%010llX, expected 0x%010llX / 0x%010llX\n", levels,
+        (unsigned long long)GpioOutputs::setMask(levels), (unsigned long long)GpioOutputs::clearMask(levels),
+        (unsigned long long)set, (unsigned long long)clear);
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+
+/**
+ * @brief the GPIO benchmark's flicker with the fault inputs paused, then one real change across a pause
+ * @return what went wrong, 0 if nothing
+ */
+int checkPausedFaultInputs()
+{
+  int mismatches = 0;
+  GpioInputState before[2] = { faultTask.inputs.state(IMD_FAULT_INPUT), faultTask.inputs.state(BMS_FAULT_INPUT) };
+  const uint32_t levels = gpioOutputLevels(data);
+
+  ESP_ERROR_CHECK(faultTask.inputs.pause());
+  for (int i = 0; i < SIM_BENCHMARK_UPDATES; i++) {
+    GpioOutputs::write((i & 1) ? 0xF : 0x0);
+    halSim().clock.advance(1);
+  }
+  GpioOutputs::write(levels);
+  ESP_ERROR_CHECK(faultTask.inputs.resume());
+  halSim().clock.advance(FAULT_INPUT_DEBOUNCE_US * 2);
+
+  for (int i = 0; i < 2; i++) {
+    const GpioInputState after = faultTask.inputs.state(i);
+    printf("paused fault input %d: %u edges, %u changes during %d updates\n", faultTask.inputs.pin(i),
+      after.edges - before[i].edges, after.changes - before[i].changes, SIM_BENCHMARK_UPDATES);
+    mismatches += after.edges != before[i].edges || after.changes != before[i].changes ? 1 : 0;
+  }
+
+  // the IMD line moves while paused and stays there, the BMS line ends where it was
+  before[0] = faultTask.inputs.state(IMD_FAULT_INPUT);
+  before[1] = faultTask.inputs.state(BMS_FAULT_INPUT);
+  ESP_ERROR_CHECK(faultTask.inputs.pause());
+  GpioOutputs::write(levels ^ IMD_FAULT_LEVEL);
+  halSim().clock.advance(100);
+  ESP_ERROR_CHECK(faultTask.inputs.resume());
+  halSim().clock.advance(FAULT_INPUT_DEBOUNCE_US * 2);
+  const GpioInputState imd = faultTask.inputs.state(IMD_FAULT_INPUT);
+  const GpioInputState bms = faultTask.inputs.state(BMS_FAULT_INPUT);
+  const bool caughtUp = imd.changes - before[0].changes == 1 && imd.active == ((levels & IMD_FAULT_LEVEL) == 0)
+    && bms.changes == before[1].changes && bms.edges == before[1].edges;
+  printf("fault line moved while paused: imd %u changes, bms %u changes %s\n", imd.changes - before[0].changes,
+    bms.changes - before[1].changes, caughtUp ? "ok" : "MISMATCH");
+  mismatches += caughtUp ? 0 : 1;
+
+  GpioOutputs::write(levels);
+  halSim().clock.advance(FAULT_INPUT_DEBOUNCE_US * 2);
+  return mismatches;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main()
+{
+  const int pins[] = { IMD_FAULT_PIN, BMS_FAULT_PIN, FAN_ENABLE_PIN, BRAKE_LIGHT_ENABLE_PIN };
+  const int pinCount = sizeof(pins) / sizeof(pins[0]);
+  for (int i = 0; i < pinCount; i++) {
+    ESP_ERROR_CHECK(gpio_set_direction((gpio_num_t)pins[i], GPIO_MODE_OUTPUT));
+  }
+
+  const int mismatches = checkGpioMasks(pins, pinCount);
+  printf("mask check: %d level combinations, %d mismatches\n", 1 << pinCount, mismatches);
+  GpioOutputs::write(0);
+  const uint32_t checkWrites = halSim().gpio.maskWrites();
+  uint32_t checkPinWrites[pinCount];
+  uint32_t checkPinEdges[pinCount];
+  for (int i = 0; i < pinCount; i++) {
+    checkPinWrites[i] = halSim().gpio.writes(pins[i]);
+    checkPinEdges[i] = halSim().gpio.edges(pins[i]);
+  }
+
+  // scripted edges on the spare pins, then the fault lines in loopback for the update run
+  const int sequenceMismatches = runEdgeSequences();
+  printf("edge sequences: %d mismatches\n", sequenceMismatches);
+
+  createInputTask(faultTask, "Fault Task");
+  ESP_ERROR_CHECK(beginFaultInputs(faultTask.inputs, &notifyInputTask, &faultTask));
+
+  const esp_timer_create_args_t timerArgs = {
+    .callback = &GPIOCallback,
+    .arg = NULL,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "GPIO Update Timer",
+    .skip_unhandled_events = false,
+  };
+  esp_timer_handle_t timer;
+  ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &timer));
+  ESP_ERROR_CHECK(esp_timer_start_periodic(timer, GPIO_UPDATE_INTERVAL));
+
+  halSim().clock.advance(SIM_DURATION_US);
+
+  // every pin is rewritten on each update but only changes on one update in four
+  printf("simulated %.0f s, %u updates, %u port writes\n", halSim().clock.nowUs() / 1e6, updates, halSim().gpio.maskWrites() - checkWrites);
+  for (int i = 0; i < pinCount; i++) {
+    printf("pin %d: %u writes, %u edges\n", pins[i], halSim().gpio.writes(pins[i]) - checkPinWrites[i], halSim().gpio.edges(pins[i]) - checkPinEdges[i]);
+  }
+
+  // the fault lines change on one update in four each, every change reaches the task
+  for (int i = 0; i < faultTask.inputs.size(); i++) {
+    const GpioInputState state = faultTask.inputs.state(i);
+    printf("fault input %d: %u edges, %u changes\n", faultTask.inputs.pin(i), state.edges, state.changes);
+  }
+  printReaction("fault", faultTask.reaction);
+
+  esp_timer_stop(timer);
+  esp_timer_delete(timer);
+  const int pauseMismatches = checkPausedFaultInputs();
+  return mismatches != 0 || sequenceMismatches != 0 || pauseMismatches != 0 ? 1 : 0;
+}
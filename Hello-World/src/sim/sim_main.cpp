@@ -0,0 +1,42 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the sketch on the simulated board for the native environment
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define SIM_DURATION_US           10000000    // 10 seconds of virtual time
+#define SIM_LOOP_COST_US          10          // time one loop() pass takes besides its delays
+#define SIM_PRINT_INTERVAL_US     1000000     // the sketch prints a line a second
+
+
+// --- includes --- // 
+#include <Arduino.h>
+
+
+// --- function headers --- //
+void setup();
+void loop();
+
+
+// --- main --- // 
+int main()
+{
+  halSim().log.setCapture(true);
+  halSimRunSketch(setup, loop, SIM_DURATION_US, SIM_LOOP_COST_US);
+
+  // count the lines the sketch printed
+  const std::string& text = halSim().log.text();
+  size_t lines = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    lines += text[i] == '\n';
+  }
+  printf("\nsimulated %.1f s: %u lines, %u bytes\n", halSim().clock.nowUs() / 1e6, (unsigned)lines, (unsigned)text.size());
+  if (lines != SIM_DURATION_US / SIM_PRINT_INTERVAL_US) {
+    printf("expected %d lines [ FAILED ]\n", SIM_DURATION_US / SIM_PRINT_INTERVAL_US);
+    return 1;
+  }
+  return 0;
+}
@@ -15,16 +15,39 @@
 #define LED_2_PIN                 6           // physical pin the LED is connected to 
 #define LED_3_PIN                 7           // physical pin the LED is connected to 
 #define BUTTON_PIN                5           // physical pin the push button is connected to 
-#define POTENTIOMETER_PIN         3           // physical pin the potentiometer is connected to 
+#define POTENTIOMETER_PIN         34          // physical pin the potentiometer is connected to, must be on ADC1
+#define POTENTIOMETER_ADC_CHANNEL ADC1_CHANNEL_6  // GPIO 34
+#define ADC_REPORT_INTERVAL       1000        // ms between ADC stream reports
+#define BUTTON_DEBOUNCE_US        20000       // the button has to rest this long before a press or release counts
+#define POTENTIOMETER_HYSTERESIS  16          // counts below a threshold before the LEDs step back down
 
 
 // --- includes --- // 
 #include <Arduino.h>
+#include <gpio_port.h>
+#include <gpio_input.h>
+#include <adc_stream.h>
+#include <dsp.h>
+
+
+// --- LED port --- //
+typedef GpioPort<LED_1_PIN, LED_2_PIN, LED_3_PIN> LedPort;    // bit 0 is LED 1, bit 1 LED 2, bit 2 LED 3
+
+
+// --- button --- //
+GpioInputs buttonInput;                       // edge interrupt driven, input 0 is the button
+
+
+// --- potentiometer --- //
+AdcStream adc;                                // sampled continuously through DMA, filtered in the background
+int potentiometerInput = -1;
+DspBands<int, POTENTIOMETER_HYSTERESIS, 200, 500, 900> potentiometerBands;   // band 0 below 200 up to band 3 from 900
 
 
 // --- global variables --- //
 bool pushButtonState = false;
 int potentiometerPosition = 0;
+unsigned long lastAdcReport = 0;
 
 
 // --- setup --- // 
@@ -33,9 +56,17 @@ void setup()
   // initialize serial connection for the serial monitor & debugging
   Serial.begin(9600);
 
-  // initialize input pins
-  pinMode(BUTTON_PIN, INPUT);
-  pinMode(POTENTIOMETER_PIN, INPUT);
+  // initialize input pins, the button is debounced from its edge interrupts
+  GpioInputConfig button;
+  button.pin = BUTTON_PIN;
+  button.mode = GPIO_DEBOUNCE_SETTLE;
+  button.debounceUs = BUTTON_DEBOUNCE_US;
+  buttonInput.add(button);
+  buttonInput.begin();
+  potentiometerInput = adc.add(POTENTIOMETER_ADC_CHANNEL);
+  if (adc.begin() != ESP_OK) {
+    Serial.printf("ADC STREAM INIT [ FAILED ]\n");
+  }
 
   // initalize output pins
   pinMode(LED_1_PIN, OUTPUT);
@@ -47,41 +78,47 @@ void setup()
 // --- loop --- // 
 void loop()
 {
-  // read push button state
-  pushButtonState = digitalRead(BUTTON_PIN);
+  // read the debounced push button state, on the 64 bit clock the edges are stamped with
+  buttonInput.service(esp_timer_get_time());
+  pushButtonState = buttonInput.active(0);
 
   // print push button state to serial monitor
   Serial.printf("push button state: %s\n", pushButtonState ? "pressed" : "not pressed");
 
-  // read potentiometer position
-  potentiometerPosition = analogRead(POTENTIOMETER_PIN);
-
-  // light LEDs according to potentiometer position
-  if (potentiometerPosition >= 900)
+  // read the filtered potentiometer position, stays 0 until the filter has settled
+  AdcChannelSnapshot potentiometer;
+  if (adc.read(potentiometerInput, potentiometer))
   {
-    digitalWrite(LED_1_PIN, true);
-    digitalWrite(LED_2_PIN, true);
-    digitalWrite(LED_3_PIN, true);
+    potentiometerPosition = AdcChannelFilter::counts(potentiometer.value);
   }
 
-  else if (potentiometerPosition >= 500 && potentiometerPosition < 900)
-  {
-    digitalWrite(LED_1_PIN, true);
-    digitalWrite(LED_2_PIN, true);
-    digitalWrite(LED_3_PIN, false);
-  }
-  
-  else if (potentiometerPosition >= 200 && potentiometerPosition < 500)
+  // report the ADC stream's rate, its CPU share and the last potentiometer window
+  if (millis() - lastAdcReport >= ADC_REPORT_INTERVAL)
   {
-    digitalWrite(LED_1_PIN, true);
-    digitalWrite(LED_2_PIN, true);
-    digitalWrite(LED_3_PIN, false);
+    lastAdcReport = millis();
+    const AdcStreamStats stats = adc.stats();
+    Serial.printf("adc: %.0f samples/s, filter load %.2f%% | potentiometer min %u mean %u max %u\n", stats.samplesPerSecond(),
+      stats.load() * 100, AdcChannelFilter::counts(potentiometer.min), AdcChannelFilter::counts(potentiometer.mean),
+      AdcChannelFilter::counts(potentiometer.max));
   }
 
-  else 
+  // light one more LED per potentiometer band, all three change on the same write
+  switch (potentiometerBands.process(potentiometerPosition))
   {
-    digitalWrite(LED_1_PIN, false);
-    digitalWrite(LED_2_PIN, false);
-    digitalWrite(LED_3_PIN, false);
+    case 3:
+      LedPort::write<0x7>();
+      break;
+
+    case 2:
+      LedPort::write<0x3>();
+      break;
+
+    case 1:
+      LedPort::write<0x1>();
+      break;
+
+    default:
+      LedPort::write<0x0>();
+      break;
   }
 }
@@ -0,0 +1,112 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the sketch on the simulated board for the native environment
+ * 
+ * the potentiometer sweeps from 0 to full scale and back while the button is pressed every
+ * other second, then the ADC stream's throughput and the LED pattern seen for each
+ * potentiometer band are printed. the exit code is 1 if a band showed the wrong LEDs, the
+ * stream dropped frames or a button press was missed
+ * 
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define LED_1_PIN                 4           // same pins as main.cpp
+#define LED_2_PIN                 6
+#define LED_3_PIN                 7
+#define BUTTON_PIN                5
+#define POTENTIOMETER_PIN         34
+
+#define SIM_DURATION_US           20000000    // 20 seconds of virtual time
+#define SIM_SWEEP_US              10000000    // one full potentiometer sweep up and down
+#define SIM_LOOP_COST_US          100         // time one loop() pass takes besides its delays
+#define SIM_BANDS                 4           // potentiometer bands reported, split at the sketch's thresholds
+#define ADC_FULL_SCALE            4095
+
+
+// --- includes --- // 
+#include <Arduino.h>
+#include <gpio_input.h>
+#include <adc_stream.h>
+
+
+// --- global variables --- //
+extern GpioInputs buttonInput;                // main.cpp
+extern AdcStream adc;
+extern int potentiometerPosition;
+const int bandStart[SIM_BANDS + 1] = { 0, 200, 500, 900, ADC_FULL_SCALE + 1 };
+const uint8_t bandExpected[SIM_BANDS] = { 0x0, 0x1, 0x3, 0x7 };   // one more LED per band
+uint8_t bandPattern[SIM_BANDS];               // LED bits seen last in each band, the way down ends below the hysteresis
+uint32_t bandSamples[SIM_BANDS];
+
+
+// --- function headers --- //
+void setup();
+void loop();
+uint16_t potentiometer(uint8_t pin, int64_t nowUs, void* context);
+void observeLoop();
+
+
+// --- main --- // 
+int main()
+{
+  // the sketch prints every pass, keep it out of the terminal
+  halSim().log.setEcho(NULL);
+  halSim().adc.setSource(potentiometer, NULL);
+
+  halSimRunSketch(setup, observeLoop, SIM_DURATION_US, SIM_LOOP_COST_US);
+
+  const AdcStreamStats stats = adc.stats();
+  AdcChannelSnapshot snapshot;
+  printf("simulated %.1f s, %.1f s spent waiting on the UART\n", halSim().clock.nowUs() / 1e6, Serial.blockedUs() / 1e6);
+  printf("adc: %u conversions in %u frames (%.0f/s), %llu dropped, %u filter outputs\n", stats.samples, stats.frames,
+    stats.samplesPerSecond(), (unsigned long long)simAdcDigi().dropped, adc.read(0, snapshot) ? snapshot.outputs : 0);
+  const GpioInputState button = buttonInput.state(0);
+  printf("button: %u edges, %u debounced changes, %u glitches\n", button.edges, button.changes, button.glitches);
+  int failures = 0;
+  for (int band = 0; band < SIM_BANDS; band++) {
+    const bool match = bandPattern[band] == bandExpected[band] && bandSamples[band] > 0;
+    printf("potentiometer %4d - %4d: LEDs %c%c%c (%u samples)%s\n", bandStart[band], bandStart[band + 1] - 1,
+      bandPattern[band] & 1 ? '1' : '-', bandPattern[band] & 2 ? '2' : '-', bandPattern[band] & 4 ? '3' : '-', bandSamples[band],
+      match ? "" : " [ FAILED ]");
+    failures += match ? 0 : 1;
+  }
+  if (simAdcDigi().dropped != 0 || button.changes != button.edges || button.glitches != 0) {
+    printf("adc dropped frames or the button missed a press [ FAILED ]\n");
+    failures++;
+  }
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief triangle wave over the full ADC range, sampled by the ADC stream's DMA
+ */
+uint16_t potentiometer(uint8_t pin, int64_t nowUs, void* context)
+{
+  (void)context;
+  const int64_t phase = nowUs % SIM_SWEEP_US;
+  const int64_t half = SIM_SWEEP_US / 2;
+  const int64_t rise = phase < half ? phase : SIM_SWEEP_US - phase;
+  return pin == POTENTIOMETER_PIN ? (uint16_t)(rise * ADC_FULL_SCALE / half) : 0;
+}
+
+
+/**
+ * @brief one sketch pass, then record which LEDs it left on for the filtered position it read
+ */
+void observeLoop()
+{
+  // the button is pressed every other second
+  halSim().gpio.setInput(BUTTON_PIN, (halSim().clock.nowUs() / 1000000) % 2);
+  loop();
+
+  int band = 0;
+  while (potentiometerPosition >= bandStart[band + 1]) {
+    band++;
+  }
+  bandPattern[band] = (halSim().gpio.output(LED_1_PIN) ? 1 : 0) | (halSim().gpio.output(LED_2_PIN) ? 2 : 0) | (halSim().gpio.output(LED_3_PIN) ? 4 : 0);
+  bandSamples[band]++;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the sketch on the simulated board for the native environment
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define LED_PIN                   4           // same pin as main.cpp
+#define SIM_DURATION_US           10000000    // 10 seconds of virtual time
+#define SIM_LOOP_COST_US          10          // time one loop() pass takes besides its delays
+#define SIM_TOGGLE_INTERVAL_US    1000000     // the sketch flips the LED every second
+
+
+// --- includes --- // 
+#include <Arduino.h>
+
+
+// --- function headers --- //
+void setup();
+void loop();
+
+
+// --- main --- // 
+int main()
+{
+  halSimRunSketch(setup, loop, SIM_DURATION_US, SIM_LOOP_COST_US);
+
+  // one edge per second is expected
+  printf("\nsimulated %.1f s: LED pin %d toggled %u times, now %s\n", halSim().clock.nowUs() / 1e6, LED_PIN,
+    halSim().gpio.edges(LED_PIN), halSim().gpio.output(LED_PIN) ? "on" : "off");
+  if (halSim().gpio.edges(LED_PIN) != SIM_DURATION_US / SIM_TOGGLE_INTERVAL_US) {
+    printf("expected %d toggles [ FAILED ]\n", SIM_DURATION_US / SIM_TOGGLE_INTERVAL_US);
+    return 1;
+  }
+  return 0;
+}
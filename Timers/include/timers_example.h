@@ -0,0 +1,84 @@
+/**
+ * @file timers_example.h
+ * @brief the tick and the four software timers of the Timers example, shared by main.cpp and
+ * the simulation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * one hardware timer ticks the wheel every TICK_INTERVAL microseconds. timers 1 and 2 only
+ * count, so they run straight in the tick ISR, timers 3 and 4 stand in for real work and run
+ * in the deferred task. each timer's callback gets its TimerEvent as the context.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <timer_wheel.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define TICK_INTERVAL                     1000        // 1 ms wheel tick in microseconds
+#define TIMER_1_INTERVAL                  500         // 0.5 seconds in ticks
+#define TIMER_2_INTERVAL                  1000        // 1 second in ticks
+#define TIMER_3_INTERVAL                  2000        // 2 second in ticks
+#define TIMER_4_INTERVAL                  5000        // 5 seconds in ticks
+#define TIMER_POOL_SIZE                   16          // most software timers running at once
+
+// timer counters, to keep track of how many times each callback has been called
+enum TimerEvent
+{
+  TIMER_EVENT_1,
+  TIMER_EVENT_2,
+  TIMER_EVENT_3,
+  TIMER_EVENT_4,
+  TIMER_EVENT_COUNT,
+};
+
+typedef TimerWheel<TIMER_POOL_SIZE> ExampleTimerWheel;
+
+/**
+ * @brief one software timer of the example, its period in ticks and where its callback runs
+ */
+struct ExampleTimer
+{
+  uint32_t intervalTicks;
+  TimerMode mode;
+};
+
+static const ExampleTimer exampleTimers[TIMER_EVENT_COUNT] = {
+  { TIMER_1_INTERVAL, TIMER_RUN_IN_ISR },
+  { TIMER_2_INTERVAL, TIMER_RUN_IN_ISR },
+  { TIMER_3_INTERVAL, TIMER_RUN_DEFERRED },
+  { TIMER_4_INTERVAL, TIMER_RUN_DEFERRED },
+};
+
+
+/*
+===============================================================================================
+                                    Setup
+===============================================================================================
+*/
+
+/**
+ * @brief start the four timers, they only run once the tick does
+ *
+ * @param callbacks one per TimerEvent, called with the event as the context
+ * @param ids set to each timer's id, TIMER_WHEEL_INVALID_ID if it could not be started
+ * @return true if all four are running
+ */
+inline bool startExampleTimers(ExampleTimerWheel& wheel, const TimerCallback callbacks[TIMER_EVENT_COUNT], TimerId ids[TIMER_EVENT_COUNT])
+{
+  bool started = true;
+  for (size_t event = 0; event < TIMER_EVENT_COUNT; event++) {
+    const ExampleTimer& timer = exampleTimers[event];
+    ids[event] = wheel.start(timer.intervalTicks, timer.intervalTicks, callbacks[event], (void*)event, timer.mode);
+    started = started && ids[event] != TIMER_WHEEL_INVALID_ID;
+  }
+  return started;
+}
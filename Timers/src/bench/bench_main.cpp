@@ -0,0 +1,263 @@
+/**
+ * @file bench_main.cpp
+ * @brief tick() cost and expiry jitter of the timer wheel with thousands of timers running
+ *
+ * each run fills a wheel with periodic timers of random period (1 tick to BENCH_MAX_PERIOD, so
+ * every level and every cascade is used) and random phase, then ticks it BENCH_TICKS times and
+ * times every single tick(). the cost of a tick is not flat: most ticks only look at one slot,
+ * but when a level wraps, a whole slot of the level above is cascaded down in the same tick,
+ * and that worst case is what the tick ISR has to fit in. the table shows the distribution
+ * (latency_histogram.h, in ns instead of us) next to the most timers cascaded in one tick, what
+ * cancel() + start() costs, and the same timers kept in a plain array that is scanned every
+ * tick, for reference. the max also catches the host preempting the bench, p99.9 is the
+ * wheel's own worst case.
+ *
+ * jitter is counted in ticks: every callback checks it runs on exactly the tick its timer's
+ * period and phase say, and every timer has to fire exactly as often as they allow. the exit
+ * code is 1 if any timer fired off its tick or too often or too rarely.
+ *
+ * build and run: pio run -e native_bench -t exec
+ *
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- //
+#define BENCH_TICKS                     1000000     // 1000 s at the examples' 1 ms tick
+#define BENCH_SCAN_TICKS                20000
+#define BENCH_MAX_PERIOD                100000      // 100 s
+#define BENCH_MAX_TIMERS                16384
+
+
+// --- includes --- //
+#include <stdio.h>
+#include <chrono>
+#include <timer_wheel.h>
+#include <latency_histogram.h>
+
+
+// --- global variables --- //
+/**
+ * @brief what a timer expects of the wheel, its context
+ */
+struct BenchTimer
+{
+  uint32_t firstTick;
+  uint32_t period;
+  uint32_t nextTick;              // the tick it has to fire on next
+  uint32_t expiries;
+};
+BenchTimer benchTimers[BENCH_MAX_TIMERS];
+
+uint32_t currentTick = 0;         // the tick being run, the wheel's now() once tick() has returned
+uint32_t offTickExpiries = 0;
+uint32_t worstJitterTicks = 0;
+uint32_t random = 1;
+int failures = 0;
+
+/**
+ * @brief one row of the results table
+ */
+struct BenchResult
+{
+  double tickMeanNs = 0;
+  LatencySummary tickNs;
+  uint32_t tickP999Ns = 0;
+  uint32_t worstCascade = 0;      // most timers moved down a level in one tick
+  double scanMeanNs = 0;
+  double restartNs = 0;
+  uint32_t expiries = 0;
+  bool exact = true;              // every timer fired on its ticks, as often as it should
+  bool restarted = true;          // every cancel() found its timer, every start() got one
+};
+
+
+// --- function headers --- //
+template <size_t Timers> BenchResult runWheel();
+void fillTimers(size_t count);
+void expire(void* context);
+double scanTimers(size_t count);
+bool checkExpiries(size_t count);
+uint32_t nextRandom();
+void check(bool passed, const char* what);
+
+
+// --- main --- //
+int main()
+{
+  printf("periodic timers, periods 1..%u ticks, random phase, %u ticks per run, ns per tick on this host\n\n", BENCH_MAX_PERIOD, BENCH_TICKS);
+  printf("  %6s %9s %6s %6s %6s %7s %7s %13s %10s %13s %10s\n", "timers", "tick mean", "p50", "p90", "p99", "p99.9", "max",
+    "worst cascade", "scan mean", "cancel+start", "expiries");
+
+  BenchResult results[3];
+  results[0] = runWheel<1024>();
+  results[1] = runWheel<4096>();
+  results[2] = runWheel<BENCH_MAX_TIMERS>();
+
+  bool exact = true;
+  bool restarted = true;
+  for (int i = 0; i < 3; i++) {
+    exact = exact && results[i].exact;
+    restarted = restarted && results[i].restarted;
+  }
+  printf("\n--- checks ---\n");
+  check(exact && offTickExpiries == 0, "every timer fired on its tick, as often as its period says");
+  check(restarted, "every cancel() found its timer, every start() got one");
+  printf("worst jitter %u ticks, %u expiries off their tick\n", worstJitterTicks, offTickExpiries);
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
+
+
+/**
+ * @brief one wheel of Timers timers, timed tick by tick
+ */
+template <size_t Timers>
+BenchResult runWheel()
+{
+  static TimerWheel<Timers> wheel;
+  static LatencyHistogram tickHistogram;
+  static TimerId ids[Timers];
+  BenchResult result;
+
+  fillTimers(Timers);
+  currentTick = wheel.now();
+  for (size_t i = 0; i < Timers; i++) {
+    ids[i] = wheel.start(benchTimers[i].firstTick, benchTimers[i].period, expire, &benchTimers[i], TIMER_RUN_IN_ISR);
+    benchTimers[i].firstTick += currentTick;
+    benchTimers[i].nextTick = benchTimers[i].firstTick;
+  }
+
+  // every tick on its own, the clock reads are part of the numbers
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_TICKS; i++) {
+    currentTick++;
+    const uint32_t cascades = wheel.stats().cascades;
+    const std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+    wheel.tick();
+    tickHistogram.record((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before).count());
+    result.worstCascade = wheel.stats().cascades - cascades > result.worstCascade ? wheel.stats().cascades - cascades : result.worstCascade;
+  }
+  result.tickMeanNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_TICKS;
+  result.tickNs = tickHistogram.summary();
+  result.tickP999Ns = tickHistogram.percentile(0.999f);
+  result.expiries = wheel.stats().expired;
+  result.exact = checkExpiries(Timers) && wheel.stats().overruns == 0 && wheel.stats().poolExhausted == 0;
+
+  // moving a timer: cancel it and start it again with a new delay, into a full wheel
+  bool restarted = true;
+  for (size_t i = 0; i < Timers; i++) {
+    restarted = restarted && wheel.cancel(ids[i]);
+    ids[i] = wheel.start(1 + nextRandom() % BENCH_MAX_PERIOD, 0, expire, &benchTimers[i], TIMER_RUN_IN_ISR);
+  }
+  const std::chrono::steady_clock::time_point restartStart = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_TICKS; i++) {
+    const size_t index = i % Timers;
+    restarted = wheel.cancel(ids[index]) && restarted;
+    ids[index] = wheel.start(1 + i % BENCH_MAX_PERIOD, 0, expire, &benchTimers[index], TIMER_RUN_IN_ISR);
+  }
+  result.restartNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - restartStart).count() / BENCH_TICKS;
+  for (size_t i = 0; i < Timers; i++) {
+    restarted = wheel.cancel(ids[i]) && restarted;
+  }
+  result.restarted = restarted && wheel.stats().poolExhausted == 0;
+
+  result.scanMeanNs = scanTimers(Timers);
+
+  printf("  %6u %9.1f %6u %6u %6u %7u %7u %13u %10.1f %13.1f %10u\n", (unsigned)Timers, result.tickMeanNs, result.tickNs.p50,
+    result.tickNs.p90, result.tickNs.p99, result.tickP999Ns, result.tickNs.max, result.worstCascade, result.scanMeanNs,
+    result.restartNs, result.expiries);
+  return result;
+}
+
+
+/**
+ * @brief random periods and phases for the first count timers, firstTick is relative until started
+ */
+void fillTimers(size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    BenchTimer& timer = benchTimers[i];
+    timer.period = 1 + nextRandom() % BENCH_MAX_PERIOD;
+    timer.firstTick = 1 + nextRandom() % timer.period;
+    timer.expiries = 0;
+  }
+}
+
+
+/**
+ * @brief the timers' callback, runs in tick() like an ISR callback
+ */
+void expire(void* context)
+{
+  BenchTimer& timer = *(BenchTimer*)context;
+  if (currentTick != timer.nextTick) {
+    const uint32_t jitter = (int32_t)(currentTick - timer.nextTick) < 0 ? timer.nextTick - currentTick : currentTick - timer.nextTick;
+    worstJitterTicks = jitter > worstJitterTicks ? jitter : worstJitterTicks;
+    offTickExpiries++;
+  }
+  timer.nextTick += timer.period;
+  timer.expiries++;
+}
+
+
+/**
+ * @brief the same timers as a plain array, every one looked at on every tick
+ * @return mean ns per tick
+ */
+double scanTimers(size_t count)
+{
+  static uint32_t expires[BENCH_MAX_TIMERS];
+  for (size_t i = 0; i < count; i++) {
+    expires[i] = benchTimers[i].nextTick;
+  }
+
+  uint32_t now = currentTick;
+  volatile uint32_t expired = 0;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t tick = 0; tick < BENCH_SCAN_TICKS; tick++) {
+    now++;
+    for (size_t i = 0; i < count; i++) {
+      if (expires[i] == now) {
+        expires[i] += benchTimers[i].period;
+        expired = expired + 1;
+      }
+    }
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_SCAN_TICKS;
+}
+
+
+/**
+ * @brief every timer fired once on its first tick and once per period after it, up to now
+ */
+bool checkExpiries(size_t count)
+{
+  bool exact = true;
+  for (size_t i = 0; i < count; i++) {
+    const BenchTimer& timer = benchTimers[i];
+    const uint32_t expected = (int32_t)(currentTick - timer.firstTick) >= 0 ? (currentTick - timer.firstTick) / timer.period + 1 : 0;
+    exact = exact && timer.expiries == expected;
+  }
+  return exact;
+}
+
+
+uint32_t nextRandom()
+{
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  return random;
+}
+
+
+/**
+ * @brief print a check's result, count it if it failed
+ */
+void check(bool passed, const char* what)
+{
+  printf("%-64s %s\n", what, passed ? "ok" : "FAILED");
+  failures += passed ? 0 : 1;
+}
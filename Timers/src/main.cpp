@@ -12,141 +12,269 @@
 
 // --- defines --- // 
 #define CLOCK_PRESCALER                 80          // this is based off to the clock speed (assuming 80 MHz)
-#define TIMER_1_INTERVAL                500000      // 0.5 seconds in microseconds
-#define TIMER_2_INTERVAL                1000000     // 1 second in microseconds
-#define TIMER_3_INTERVAL                2000000     // 2 second in microseconds
-#define TIMER_4_INTERVAL                5000000     // 5 seconds in microseconds
+#define DEFERRED_TASK_STACK_SIZE        4096        // in bytes, static
+#define DEFERRED_TASK_PRIORITY          5
+#define DEFERRED_TASK_CORE              1
+#define LATENCY_REPORT_KEY              'l'         // serial key that prints the latency report
+#define LATENCY_RESET_KEY               'r'         // serial key that clears it
+#define BOOT_REPORT_KEY                 'p'         // serial key that prints the boot profile
+#define SERIAL_BAUD_RATE                9600        // the deferred logger is throttled to this too
+#define MAIN_LOOP_DELAY                 1
+#define TELEMETRY_OUTPUT                0           // 1 sends the counts as binary telemetry (tools/telemetry_decoder) instead of text
+#define TIMER_TELEMETRY_CHANNEL         1
 
 
 // --- includes --- // 
 #include <Arduino.h>
 #include <esp_timer.h>
+#include <timer_wheel.h>
+#include <event_counters.h>
+#include <latency_histogram.h>
+#include <deferred_log.h>
+#include <telemetry.h>
+#include <static_task.h>
+#include <boot_sequencer.h>
+#include "timers_example.h"
 
 
 // --- global variables --- //
 
-// timer counters, to keep track of how many times an ISR has been called
-int counter1 = 0;
-int counter2 = 0;
-int counter3 = 0;
-int counter4 = 0;
+// timer counters, to keep track of how many times each callback has been called
+EventCounters<TIMER_EVENT_COUNT> timerEvents;
 
+// binary telemetry channel for the same counts
+const char* const timerTelemetryFields[] = { "timer1", "timer2", "timer3", "timer4" };
+TelemetryChannel timerTelemetry(TIMER_TELEMETRY_CHANNEL, "timers", timerTelemetryFields, TIMER_EVENT_COUNT);
 
-// Hardware Timers
-hw_timer_t *timer1 = NULL;
-hw_timer_t *timer2 = NULL;
-hw_timer_t *timer3 = NULL;
-hw_timer_t *timer4 = NULL;
-portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Hardware Timer, the only one used: it drives every software timer through the wheel
+hw_timer_t *tickTimer = NULL;
+ExampleTimerWheel timerWheel;
+
+// runs the deferred timer callbacks
+StaticTask<DEFERRED_TASK_STACK_SIZE> deferredTimerTask;
+
+// brings the board up, its profile is printed on demand over serial
+BootSequencer boot;
+
+// timing instrumentation, printed on demand over serial
+PeriodMonitor tickMonitor(TICK_INTERVAL);
+PeriodMonitor timer1Monitor(TIMER_1_INTERVAL * TICK_INTERVAL);
+PeriodMonitor timer3Monitor(TIMER_3_INTERVAL * TICK_INTERVAL);
+LatencyHistogram deferredLatency;               // tick ISR queueing a callback to the deferred task running it
+volatile uint32_t deferredQueuedAt = 0;         // low word of the tick time, a single store the deferred task cannot tear
+LatencySource latencySources[] = {
+  { "tick ISR lateness", NULL, &tickMonitor },
+  { "timer 1 lateness", NULL, &timer1Monitor },
+  { "timer 3 lateness", NULL, &timer3Monitor },
+  { "deferred wake", &deferredLatency, NULL },
+};
 
 
 // --- function headers --- //
-void callbackFunction1();
-void callbackFunction2();
-void callbackFunction3();
-void callbackFunction4();
+void tickISR();
+void deferredTask(void* pvParameters);
+void callbackFunction1(void* context);
+void callbackFunction2(void* context);
+void callbackFunction3(void* context);
+void callbackFunction4(void* context);
+bool beginSerial(void* context);
+bool beginTimerWheel(void* context);
+bool beginDeferredTask(void* context);
+bool beginTickTimer(void* context);
 
 
 // --- setup --- // 
 void setup()
 {
-  // startup delay
-  delay(3000);
+  // waits for a serial monitor only when built with -DBOOT_ATTACH_DELAY
+  bootAttachDelay();
+
+  // the tick needs the wheel filled and the deferred task there to wake, the rest is independent
+  // the UART and the tick interrupt are attached on setup's core like before
+  boot.add("serial", beginSerial, NULL, 0, BOOT_ON_CALLER);
+  const int wheel = boot.add("timer wheel", beginTimerWheel, NULL);
+  const int deferred = boot.add("deferred task", beginDeferredTask, NULL);
+  boot.add("tick timer", beginTickTimer, NULL, BOOT_AFTER(wheel) | BOOT_AFTER(deferred), BOOT_ON_CALLER);
+
+  LOG_PRINTF("BOOT [ %s ] in %u us, '%c' prints the profile\n", boot.run() ? "SUCCESS" : "FAILED",
+    (uint32_t)(boot.endUs() - boot.beginUs()), BOOT_REPORT_KEY);
+}
 
-  // initialize serial connection for the serial monitor & debugging
-  Serial.begin(9600);
 
-  // --- initialize timer interrupts --- //
+// --- boot stages --- //
 
-  // timer 1 - Sensor Update
-  timer1 = timerBegin(0, CLOCK_PRESCALER, true);
-  timerAttachInterrupt(timer1, &callbackFunction1, true);
-  timerAlarmWrite(timer1, TIMER_1_INTERVAL, true);
+/**
+ * @brief initialize serial connection for the serial monitor & debugging, everything logs through the deferred logger
+ */
+bool beginSerial(void* context)
+{
+  Serial.begin(SERIAL_BAUD_RATE);
+  DeferredLogConfig logConfig;
+  logConfig.baudRate = SERIAL_BAUD_RATE;
+  return deferredLog().begin(Serial, logConfig);
+}
 
-  timer2 = timerBegin(1, CLOCK_PRESCALER, true);
-  timerAttachInterrupt(timer2, &callbackFunction2, true);
-  timerAlarmWrite(timer2, TIMER_2_INTERVAL, true);
 
-  timer3 = timerBegin(2, CLOCK_PRESCALER, true);
-  timerAttachInterrupt(timer3, &callbackFunction3, true);
-  timerAlarmWrite(timer3, TIMER_3_INTERVAL, true);
+/**
+ * @brief starts the four software timers, they only run once the tick does
+ */
+bool beginTimerWheel(void* context)
+{
+  // timers 1 & 2 only count and run in the tick ISR, timers 3 & 4 run in the deferred task (timers_example.h)
+  const TimerCallback callbacks[TIMER_EVENT_COUNT] = { callbackFunction1, callbackFunction2, callbackFunction3, callbackFunction4 };
+  TimerId ids[TIMER_EVENT_COUNT];
+  const bool started = startExampleTimers(timerWheel, callbacks, ids);
+
+  for (int i = 0; i < TIMER_EVENT_COUNT; i++) {
+    LOG_PRINTF("TIMER %d STATUS: %s\n", i + 1, ids[i] != TIMER_WHEEL_INVALID_ID ? "RUNNING" : "DISABLED");
+  }
+  return started;
+}
+
+
+/**
+ * @brief the deferred task has to exist before the tick can wake it
+ */
+bool beginDeferredTask(void* context)
+{
+  return deferredTimerTask.start(deferredTask, "Deferred Timers", NULL, DEFERRED_TASK_PRIORITY, DEFERRED_TASK_CORE);
+}
 
-  timer4 = timerBegin(3, CLOCK_PRESCALER, true);
-  timerAttachInterrupt(timer4, &callbackFunction4, true);
-  timerAlarmWrite(timer4, TIMER_4_INTERVAL, true);
 
-  // start timers
-  timerAlarmEnable(timer1);
-  timerAlarmEnable(timer2);
-  timerAlarmEnable(timer3);
-  timerAlarmEnable(timer4);
+/**
+ * @brief initialize the tick interrupt
+ */
+bool beginTickTimer(void* context)
+{
+  tickTimer = timerBegin(0, CLOCK_PRESCALER, true);
+  timerAttachInterrupt(tickTimer, &tickISR, true);
+  timerAlarmWrite(tickTimer, TICK_INTERVAL, true);
+  timerAlarmEnable(tickTimer);
 
-  Serial.printf("TIMER 1 STATUS: %s\n", timerAlarmEnabled(timer1) ? "RUNNING" : "DISABLED");
-  Serial.printf("TIMER 2 STATUS: %s\n", timerAlarmEnabled(timer2) ? "RUNNING" : "DISABLED");
-  Serial.printf("TIMER 3 STATUS: %s\n", timerAlarmEnabled(timer3) ? "RUNNING" : "DISABLED");
-  Serial.printf("TIMER 4 STATUS: %s\n", timerAlarmEnabled(timer4) ? "RUNNING" : "DISABLED");
+  LOG_PRINTF("TICK TIMER STATUS: %s\n", timerAlarmEnabled(tickTimer) ? "RUNNING" : "DISABLED");
+  return timerAlarmEnabled(tickTimer);
 }
 
 
 // --- loop --- // 
 void loop()
 {
-  // print timer interrupt counts 
-  Serial.printf("timer 1 (0.5 sec): %d | timer 2 (1 sec): %d | timer 3 (2 sec): %d |  timer 4 (5 sec): %d\r", counter1, counter2, counter3, counter4);
+  // print or clear the latency report on request
+  if (Serial.available() > 0) {
+    int key = Serial.read();
+    if (key == LATENCY_REPORT_KEY) {
+      printLatencyReport(Serial, latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == LATENCY_RESET_KEY) {
+      resetLatencyReport(latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == BOOT_REPORT_KEY) {
+      printBootReport(Serial, boot);
+    }
+  }
+
+  // log timer interrupt counts, only when one has changed so the line is not rewritten thousands of times a second
+  static EventCounterSnapshot<TIMER_EVENT_COUNT> lastCounts;
+  EventCounterSnapshot<TIMER_EVENT_COUNT> counts;
+  timerEvents.snapshot(counts);
+  if (counts.since(lastCounts).total() != 0) {
+#if TELEMETRY_OUTPUT
+    int32_t values[TIMER_EVENT_COUNT];
+    for (int i = 0; i < TIMER_EVENT_COUNT; i++) {
+      values[i] = (int32_t)counts.counts[i];
+    }
+    timerTelemetry.write(Serial, (uint32_t)esp_timer_get_time(), values);
+#else
+    LOG_PRINTF("timer 1 (0.5 sec): %u | timer 2 (1 sec): %u | timer 3 (2 sec): %u |  timer 4 (5 sec): %u\r",
+      counts.counts[TIMER_EVENT_1], counts.counts[TIMER_EVENT_2], counts.counts[TIMER_EVENT_3], counts.counts[TIMER_EVENT_4]);
+#endif
+    lastCounts = counts;
+  }
+
+  // give the lower priority tasks (and the logger) a chance to run
+  vTaskDelay(MAIN_LOOP_DELAY);
 }
 
 
 /**
- * @brief Timer 1 ISR - increments timer 1 counter
+ * @brief tick ISR - advances the timer wheel and wakes the deferred task if anything is queued
  * 
  */
-void callbackFunction1() 
-{  
-  portENTER_CRITICAL_ISR(&timerMux);
+void IRAM_ATTR tickISR()
+{
+  int64_t now = esp_timer_get_time();
+  tickMonitor.mark(now);
+
+  if (timerWheel.tick() == 0) {
+    return;
+  }
+  deferredQueuedAt = (uint32_t)now;
+
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(deferredTimerTask.handle(), &higherPriorityTaskWoken);
+  if (higherPriorityTaskWoken) {
+    portYIELD_FROM_ISR();
+  }
+}
 
-  counter1++;
 
-  portEXIT_CRITICAL_ISR(&timerMux);
+/**
+ * @brief runs deferred timer callbacks whenever the tick ISR queues some
+ * 
+ * @param pvParameters - argument passed via function pointer
+ */
+void deferredTask(void* pvParameters)
+{
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    deferredLatency.record((uint32_t)esp_timer_get_time() - deferredQueuedAt);     // unsigned, so right across the wrap too
+    timerWheel.runDeferred();
+  }
 }
 
 
 /**
- * @brief Timer 2 ISR - increments timer 2 counter
+ * @brief Timer 1 callback (ISR) - increments timer 1 counter
  * 
+ * @param context unused
  */
-void callbackFunction2() 
+void IRAM_ATTR callbackFunction1(void* context) 
 {  
-  portENTER_CRITICAL_ISR(&timerMux);
-
-  counter2++;
-
-  portEXIT_CRITICAL_ISR(&timerMux);
+  timer1Monitor.mark(esp_timer_get_time());
+  timerEvents.increment(TIMER_EVENT_1);
 }
 
 
 /**
- * @brief Timer 3 ISR - increments timer 3 counter
+ * @brief Timer 2 callback (ISR) - increments timer 2 counter
  * 
+ * @param context unused
  */
-void callbackFunction3() 
+void IRAM_ATTR callbackFunction2(void* context) 
 {  
-  portENTER_CRITICAL_ISR(&timerMux);
-
-  counter3++;
-
-  portEXIT_CRITICAL_ISR(&timerMux);
+  timerEvents.increment(TIMER_EVENT_2);
 }
 
 
 /**
- * @brief Timer 4 ISR - increments timer 4 counter
+ * @brief Timer 3 callback (deferred task) - increments timer 3 counter
  * 
+ * @param context unused
  */
-void callbackFunction4() 
+void callbackFunction3(void* context) 
 {  
-  portENTER_CRITICAL_ISR(&timerMux);
+  timer3Monitor.mark(esp_timer_get_time());
+  timerEvents.increment(TIMER_EVENT_3);
+}
 
-  counter4++;
 
-  portEXIT_CRITICAL_ISR(&timerMux);
+/**
+ * @brief Timer 4 callback (deferred task) - increments timer 4 counter
+ * 
+ * @param context unused
+ */
+void callbackFunction4(void* context) 
+{  
+  timerEvents.increment(TIMER_EVENT_4);
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * @file sim_main.cpp
+ * @brief runs the timer wheel example on the simulated board
+ * 
+ * FreeRTOS is not simulated, so the deferred task is stood in for by running the deferred
+ * queue straight after each tick. the tick and the timers come from include/timers_example.h
+ * like in main.cpp, so the counts should match main.cpp on hardware exactly, the exit code is
+ * 1 if they do not.
+ * 
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+
+// --- defines --- // 
+#define SIM_DURATION_US                 60000000    // one minute of virtual time
+
+
+// --- includes --- // 
+#include <stdio.h>
+#include <esp_timer.h>
+#include <timer_wheel.h>
+#include <event_counters.h>
+#include <latency_histogram.h>
+#include "timers_example.h"
+
+
+// --- global variables --- //
+EventCounters<TIMER_EVENT_COUNT> timerEvents;
+ExampleTimerWheel timerWheel;
+PeriodMonitor timer1Monitor(TIMER_1_INTERVAL * TICK_INTERVAL);
+PeriodMonitor timer3Monitor(TIMER_3_INTERVAL * TICK_INTERVAL);
+
+
+// --- function headers --- //
+void tick(void* context);
+void countEvent(void* context);
+bool simulateExample();
+
+
+// --- main --- // 
+int main()
+{
+  return simulateExample() ? 0 : 1;
+}
+
+
+/**
+ * @brief the four timers of main.cpp, ticked by a simulated 1 ms hardware timer for a minute
+ * @return true if every timer fired on time, as often as its period says
+ */
+bool simulateExample()
+{
+  // the same wheel setup as main.cpp, every timer counting its own event
+  const TimerCallback callbacks[TIMER_EVENT_COUNT] = { countEvent, countEvent, countEvent, countEvent };
+  TimerId ids[TIMER_EVENT_COUNT];
+  if (!startExampleTimers(timerWheel, callbacks, ids)) {
+    printf("timers could not be started [ FAILED ]\n");
+    return false;
+  }
+
+  SimTimer tickTimer(halSim().clock);
+  tickTimer.start(TICK_INTERVAL, tick, NULL);
+  halSim().clock.advance(SIM_DURATION_US);
+  tickTimer.stop();
+
+  EventCounterSnapshot<TIMER_EVENT_COUNT> counts;
+  timerEvents.snapshot(counts);
+  const TimerWheelStats& stats = timerWheel.stats();
+  printf("simulated %.0f s: timer 1: %u | timer 2: %u | timer 3: %u | timer 4: %u\n", halSim().clock.nowUs() / 1e6,
+    counts.counts[TIMER_EVENT_1], counts.counts[TIMER_EVENT_2], counts.counts[TIMER_EVENT_3], counts.counts[TIMER_EVENT_4]);
+  printf("wheel: ticks %u | expired %u | deferred %u | dropped %u | cascades %u\n",
+    stats.ticks, stats.expired, stats.deferredRun, stats.deferredDropped, stats.cascades);
+  printf("timer 1 lateness max %u us (%u missed) | timer 3 lateness max %u us (%u missed)\n",
+    timer1Monitor.lateness().max(), timer1Monitor.missed(), timer3Monitor.lateness().max(), timer3Monitor.missed());
+
+  const uint32_t ticks = SIM_DURATION_US / TICK_INTERVAL;
+  const bool passed = counts.counts[TIMER_EVENT_1] == ticks / TIMER_1_INTERVAL && counts.counts[TIMER_EVENT_2] == ticks / TIMER_2_INTERVAL &&
+    counts.counts[TIMER_EVENT_3] == ticks / TIMER_3_INTERVAL && counts.counts[TIMER_EVENT_4] == ticks / TIMER_4_INTERVAL &&
+    stats.deferredDropped == 0 && timer1Monitor.missed() == 0 && timer3Monitor.missed() == 0;
+  if (!passed) {
+    printf("expected timer 1: %u | timer 2: %u | timer 3: %u | timer 4: %u, none late [ FAILED ]\n",
+      ticks / TIMER_1_INTERVAL, ticks / TIMER_2_INTERVAL, ticks / TIMER_3_INTERVAL, ticks / TIMER_4_INTERVAL);
+  }
+  return passed;
+}
+
+
+/**
+ * @brief simulated tick ISR, the deferred task is assumed to run right after it
+ */
+void tick(void* context)
+{
+  (void)context;
+  if (timerWheel.tick() != 0) {
+    timerWheel.runDeferred();
+  }
+}
+
+
+/**
+ * @brief shared callback, the context is the event to count
+ */
+void countEvent(void* context)
+{
+  const size_t event = (size_t)context;
+  if (event == TIMER_EVENT_1) {
+    timer1Monitor.mark(esp_timer_get_time());
+  }
+  else if (event == TIMER_EVENT_3) {
+    timer3Monitor.mark(esp_timer_get_time());
+  }
+  timerEvents.increment(event);
+}
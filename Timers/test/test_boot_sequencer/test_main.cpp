@@ -0,0 +1,177 @@
+/**
+ * @file test_main.cpp
+ * @brief BootSequencer's rules on the host path: dependency order, skip cascade, stage placement
+ * and what add() refuses
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * without ESP_PLATFORM run() takes the stages one by one on the calling thread, which is how
+ * the sims boot. the tests check that a stage still waits for stages added earlier that it
+ * depends on, that a failure skips its dependents and theirs without running them while the
+ * rest boots, and that every stage ends up on worker 0. the threaded path, with helper tasks
+ * and BOOT_ON_CALLER stages kept off them, is checked by tools/boot_sequencer_test.
+ */
+
+#include <stdint.h>
+#include <unity.h>
+#include <boot_sequencer.h>
+
+
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+#define TEST_STAGES                       6
+
+/**
+ * @brief what one stage saw, the context of its stage function
+ */
+struct StageProbe
+{
+  bool fails = false;
+  int calls = 0;
+  int position = -1;                  // in the order the stages ran
+};
+
+static int ran = 0;
+
+static bool runStage(void* context)
+{
+  StageProbe* probe = (StageProbe*)context;
+  probe->calls++;
+  probe->position = ran++;
+  return !probe->fails;
+}
+
+
+void setUp(void)
+{
+  ran = 0;
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Tests
+===============================================================================================
+*/
+
+void test_stages_run_after_their_dependencies(void)
+{
+  BootSequencer boot;
+  StageProbe probes[TEST_STAGES];
+  const int serial = boot.add("serial", runStage, &probes[0]);
+  const int driver = boot.add("can driver", runStage, &probes[1], 0, BOOT_ON_CALLER);
+  const int schedule = boot.add("tx schedule", runStage, &probes[2]);
+  const int tasks = boot.add("can tasks", runStage, &probes[3], BOOT_AFTER(driver) | BOOT_AFTER(schedule));
+  boot.add("can timer", runStage, &probes[4], BOOT_AFTER(tasks), BOOT_ON_CALLER);
+  boot.add("wifi", runStage, &probes[5], BOOT_AFTER(serial));
+  TEST_ASSERT_EQUAL_INT(TEST_STAGES, boot.stageCount());
+
+  TEST_ASSERT_TRUE(boot.run());
+  TEST_ASSERT_TRUE(boot.succeeded());
+  for (int i = 0; i < TEST_STAGES; i++) {
+    const BootStage& stage = boot.stage(i);
+    TEST_ASSERT_EQUAL_INT(BOOT_STAGE_DONE, stage.state);
+    TEST_ASSERT_EQUAL_INT(1, probes[i].calls);
+    TEST_ASSERT_EQUAL_INT(0, stage.worker);
+    TEST_ASSERT_TRUE(stage.startUs <= stage.endUs);
+    TEST_ASSERT_TRUE(stage.startUs >= boot.beginUs() && stage.endUs <= boot.endUs());
+    for (int j = 0; j < i; j++) {
+      if (stage.dependsOn & BOOT_AFTER(j)) {
+        TEST_ASSERT_LESS_THAN(probes[i].position, probes[j].position);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(1, boot.workersUsed());
+}
+
+void test_a_failure_skips_its_dependents_and_theirs(void)
+{
+  BootSequencer boot;
+  StageProbe probes[TEST_STAGES];
+  probes[1].fails = true;
+  const int serial = boot.add("serial", runStage, &probes[0]);
+  const int driver = boot.add("can driver", runStage, &probes[1], 0, BOOT_ON_CALLER);
+  const int schedule = boot.add("tx schedule", runStage, &probes[2]);
+  const int tasks = boot.add("can tasks", runStage, &probes[3], BOOT_AFTER(driver) | BOOT_AFTER(schedule));
+  boot.add("can timer", runStage, &probes[4], BOOT_AFTER(tasks), BOOT_ON_CALLER);
+  boot.add("wifi", runStage, &probes[5], BOOT_AFTER(serial));
+
+  TEST_ASSERT_FALSE(boot.run());
+  TEST_ASSERT_FALSE(boot.succeeded());
+  const BootStageState expected[TEST_STAGES] = {
+    BOOT_STAGE_DONE, BOOT_STAGE_FAILED, BOOT_STAGE_DONE, BOOT_STAGE_SKIPPED, BOOT_STAGE_SKIPPED, BOOT_STAGE_DONE,
+  };
+  for (int i = 0; i < TEST_STAGES; i++) {
+    TEST_ASSERT_EQUAL_INT(expected[i], boot.stage(i).state);
+    TEST_ASSERT_EQUAL_INT(expected[i] == BOOT_STAGE_SKIPPED ? 0 : 1, probes[i].calls);
+  }
+  TEST_ASSERT_EQUAL_STRING("skipped", bootStageStateName(boot.stage(4).state));
+}
+
+void test_add_refuses_what_it_cannot_order(void)
+{
+  BootSequencer boot;
+  StageProbe probes[BOOT_MAX_STAGES + 1];
+  TEST_ASSERT_EQUAL_INT(-1, boot.add("nothing", NULL, NULL));
+  TEST_ASSERT_EQUAL_INT(-1, boot.add("itself", runStage, &probes[0], BOOT_AFTER(0)));
+  TEST_ASSERT_EQUAL_INT(0, boot.add("first", runStage, &probes[0]));
+  TEST_ASSERT_EQUAL_INT(-1, boot.add("later one", runStage, &probes[1], BOOT_AFTER(1)));
+  for (int i = 1; i < BOOT_MAX_STAGES; i++) {
+    TEST_ASSERT_EQUAL_INT(i, boot.add("more", runStage, &probes[i], BOOT_AFTER(i - 1)));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, boot.add("one too many", runStage, &probes[BOOT_MAX_STAGES]));
+
+  TEST_ASSERT_TRUE(boot.run());
+  for (int i = 0; i < BOOT_MAX_STAGES; i++) {
+    TEST_ASSERT_EQUAL_INT(i, probes[i].position);
+  }
+
+  // once started, no more stages and no second run
+  TEST_ASSERT_EQUAL_INT(-1, boot.add("too late", runStage, &probes[BOOT_MAX_STAGES]));
+  TEST_ASSERT_FALSE(boot.run());
+  TEST_ASSERT_EQUAL_INT(0, probes[BOOT_MAX_STAGES].calls);
+}
+
+void test_marks_are_kept_once_each(void)
+{
+  BootSequencer boot;
+  StageProbe probe;
+  boot.add("serial", runStage, &probe);
+  TEST_ASSERT_TRUE(boot.run());
+
+  static const char* const firstFrame = "first can frame";
+  boot.mark(firstFrame);
+  const int64_t first = boot.markAt(0).atUs;
+  boot.mark(firstFrame);
+  TEST_ASSERT_EQUAL_INT(1, boot.markCount());
+  TEST_ASSERT_TRUE(boot.markAt(0).atUs == first);
+  TEST_ASSERT_TRUE(first >= boot.endUs());
+
+  for (int i = 0; i < BOOT_MAX_MARKS + 2; i++) {
+    static const char* const names[] = { "a", "b", "c", "d", "e", "f" };
+    boot.mark(names[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(BOOT_MAX_MARKS, boot.markCount());
+  TEST_ASSERT_EQUAL_STRING(firstFrame, boot.markAt(0).name);
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_stages_run_after_their_dependencies);
+  RUN_TEST(test_a_failure_skips_its_dependents_and_theirs);
+  RUN_TEST(test_add_refuses_what_it_cannot_order);
+  RUN_TEST(test_marks_are_kept_once_each);
+  return UNITY_END();
+}
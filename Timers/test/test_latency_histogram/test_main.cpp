@@ -0,0 +1,267 @@
+/**
+ * @file test_main.cpp
+ * @brief accuracy bounds of LatencyHistogram and the phase tracking of PeriodMonitor
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the histogram promises that a value lands in a bucket no wider than 1/16 of its lower bound,
+ * so a percentile is never below the true value and never more than 6.25% above it (and
+ * never above the maximum). the tests check the buckets over the whole 32 bit range and the
+ * percentiles of a few distributions against the exact ones from the sorted values.
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <unity.h>
+#include <latency_histogram.h>
+
+
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+#define RANDOM_VALUES                     100000
+#define PERIOD_US                         1000
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief the exact value percentile() is after, same rank rule
+ */
+static uint32_t exactPercentile(std::vector<uint32_t>& values, float fraction)
+{
+  std::sort(values.begin(), values.end());
+  const uint32_t total = (uint32_t)values.size();
+  uint32_t rank = (uint32_t)(fraction * total + 0.5f);
+  rank = rank < 1 ? 1 : (rank > total ? total : rank);
+  return values[rank - 1];
+}
+
+/**
+ * @brief every percentile of interest within [exact, exact + exact / 16], and not above max
+ */
+static void checkPercentiles(const LatencyHistogram& histogram, std::vector<uint32_t>& values)
+{
+  const float fractions[] = { 0.0f, 0.01f, 0.25f, 0.5f, 0.9f, 0.99f, 0.999f, 1.0f };
+  const uint32_t max = *std::max_element(values.begin(), values.end());
+  TEST_ASSERT_EQUAL_UINT32(max, histogram.max());
+  TEST_ASSERT_EQUAL_UINT32(values.size(), histogram.count());
+
+  for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+    const uint32_t exact = exactPercentile(values, fractions[i]);
+    const uint32_t reported = histogram.percentile(fractions[i]);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(exact, reported);
+    TEST_ASSERT_TRUE(reported <= (uint64_t)exact + exact / LATENCY_SUB_BUCKETS);       // 64 bit, the top buckets reach UINT32_MAX
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(max, reported);
+  }
+}
+
+
+void setUp(void)
+{
+  randomState = 1;
+}
+
+void tearDown(void)
+{
+}
+
+
+/*
+===============================================================================================
+                                    Histogram
+===============================================================================================
+*/
+
+void test_small_values_have_a_bucket_each(void)
+{
+  for (uint32_t value = 0; value < LATENCY_SUB_BUCKETS; value++) {
+    TEST_ASSERT_EQUAL_INT((int)value, LatencyHistogram::bucketOf(value));
+    TEST_ASSERT_EQUAL_UINT32(value, LatencyHistogram::bucketUpperBound((int)value));
+  }
+}
+
+
+void test_buckets_tile_the_32_bit_range(void)
+{
+  // consecutive buckets meet with no gap, each no wider than 1/16 of its lower bound
+  uint32_t lower = 0;
+  for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+    const uint32_t upper = LatencyHistogram::bucketUpperBound(bucket);
+    TEST_ASSERT_EQUAL_INT(bucket, LatencyHistogram::bucketOf(lower));
+    TEST_ASSERT_EQUAL_INT(bucket, LatencyHistogram::bucketOf(upper));
+    if (bucket >= LATENCY_SUB_BUCKETS) {
+      TEST_ASSERT_LESS_OR_EQUAL_UINT32(lower / LATENCY_SUB_BUCKETS, upper - lower);
+    }
+    if (bucket + 1 < LATENCY_BUCKETS) {
+      TEST_ASSERT_EQUAL_INT(bucket + 1, LatencyHistogram::bucketOf(upper + 1));
+    }
+    lower = upper + 1;
+  }
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, LatencyHistogram::bucketUpperBound(LATENCY_BUCKETS - 1));
+}
+
+
+void test_every_value_falls_at_or_below_its_bucket_bound(void)
+{
+  for (uint32_t value = 0; value < (1u << 20); value++) {
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value)), value);
+  }
+  for (int i = 0; i < RANDOM_VALUES; i++) {
+    const uint32_t value = nextRandom();
+    const uint32_t upper = LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(upper, value);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(value / LATENCY_SUB_BUCKETS, upper - value);
+  }
+}
+
+
+void test_empty_histogram_reports_zero(void)
+{
+  LatencyHistogram histogram;
+  const LatencySummary summary = histogram.summary();
+  TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p50);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p99);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.max);
+}
+
+
+void test_percentiles_of_uniform_values(void)
+{
+  static LatencyHistogram histogram;
+  histogram.reset();
+  std::vector<uint32_t> values;
+  for (int i = 0; i < RANDOM_VALUES; i++) {
+    values.push_back(nextRandom() % 5000);
+    histogram.record(values.back());
+  }
+  checkPercentiles(histogram, values);
+}
+
+
+void test_percentiles_of_values_over_every_magnitude(void)
+{
+  // log-uniform, 1 us to 4000 s, so every bucket range gets values
+  static LatencyHistogram histogram;
+  histogram.reset();
+  std::vector<uint32_t> values;
+  for (int i = 0; i < RANDOM_VALUES; i++) {
+    values.push_back(nextRandom() >> (nextRandom() % 32));
+    histogram.record(values.back());
+  }
+  checkPercentiles(histogram, values);
+}
+
+
+void test_percentiles_of_a_long_tail(void)
+{
+  // a tight mode with rare outliers, what a timer's lateness looks like
+  static LatencyHistogram histogram;
+  histogram.reset();
+  std::vector<uint32_t> values;
+  for (int i = 0; i < RANDOM_VALUES; i++) {
+    values.push_back(nextRandom() % 1000 == 0 ? 2000 + nextRandom() % 50000 : 20 + nextRandom() % 8);
+    histogram.record(values.back());
+  }
+  checkPercentiles(histogram, values);
+}
+
+
+void test_reset_clears_the_histogram(void)
+{
+  static LatencyHistogram histogram;
+  histogram.record(100);
+  histogram.record(UINT32_MAX);
+  histogram.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.count());
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.max());
+  histogram.record(7);
+  TEST_ASSERT_EQUAL_UINT32(7, histogram.percentile(1.0f));
+}
+
+
+/*
+===============================================================================================
+                                    Period Monitor
+===============================================================================================
+*/
+
+void test_period_monitor_records_lateness_and_missed_periods(void)
+{
+  static PeriodMonitor monitor(PERIOD_US);
+  monitor.mark(10000);                      // sets the phase
+  monitor.mark(11000 + 30);                 // 30 us late
+  monitor.mark(12000);                      // on time
+  monitor.mark(15000 + 5);                  // taken as the 13000 call, 14000 and 15000 skipped
+
+  TEST_ASSERT_EQUAL_UINT32(3, monitor.lateness().count());
+  TEST_ASSERT_EQUAL_UINT32(2000 + 5, monitor.lateness().max());
+  TEST_ASSERT_EQUAL_UINT32(2, monitor.missed());
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.early());
+}
+
+
+void test_period_monitor_takes_the_earlier_phase(void)
+{
+  static PeriodMonitor monitor(PERIOD_US);
+  monitor.mark(10000 + 200);                // the first call was late
+  monitor.mark(11000);                      // early against it: the phase moves
+  monitor.mark(12000);
+
+  TEST_ASSERT_EQUAL_UINT32(1, monitor.early());
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.lateness().max());
+}
+
+
+void test_period_monitor_reset_is_done_by_the_next_mark(void)
+{
+  static PeriodMonitor monitor(PERIOD_US);
+  monitor.mark(10000);
+  monitor.mark(14000);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, monitor.missed());
+
+  // reset() only asks, the counters read 0 until mark() has started over
+  monitor.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.missed());
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.lateness().count());
+
+  // a new phase, as if the first call after the reset were the first call ever
+  monitor.mark(50000 + 123);
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.lateness().count());
+  monitor.mark(51000 + 123);
+  TEST_ASSERT_EQUAL_UINT32(1, monitor.lateness().count());
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.lateness().max());
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.missed());
+}
+
+
+int main(int argc, char** argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_small_values_have_a_bucket_each);
+  RUN_TEST(test_buckets_tile_the_32_bit_range);
+  RUN_TEST(test_every_value_falls_at_or_below_its_bucket_bound);
+  RUN_TEST(test_empty_histogram_reports_zero);
+  RUN_TEST(test_percentiles_of_uniform_values);
+  RUN_TEST(test_percentiles_of_values_over_every_magnitude);
+  RUN_TEST(test_percentiles_of_a_long_tail);
+  RUN_TEST(test_reset_clears_the_histogram);
+  RUN_TEST(test_period_monitor_records_lateness_and_missed_periods);
+  RUN_TEST(test_period_monitor_takes_the_earlier_phase);
+  RUN_TEST(test_period_monitor_reset_is_done_by_the_next_mark);
+  return UNITY_END();
+}
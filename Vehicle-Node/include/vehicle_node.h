@@ -0,0 +1,143 @@
+/**
+ * @file vehicle_node.h
+ * @brief pins, shared state and the NODE_STATUS message of the vehicle node
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the vehicle node puts the examples together on one board: it sends NODE_STATUS on the CAN
+ * bus and listens for TEST_STATUS from a CAN-Test node, watches the IMD and BMS fault lines
+ * through their edge interrupts, runs the radiator fan from the coolant temperature it hears
+ * on the bus, and forwards both CAN payloads over ESP-NOW to the dash and the pit.
+ *
+ * each piece of state has exactly one task writing it, published through a SeqLock so the
+ * others read a consistent copy without a lock: the fault task owns FaultState, the CAN
+ * process task BusState and the telemetry timer LinkState.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "driver/gpio.h"
+#include <gpio_port.h>
+#include <gpio_input.h>
+#include "vehicle_dbc.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_TX_PIN                        23
+#define CAN_RX_PIN                        19
+#define IMD_FAULT_PIN                     32          // fault lines from the safety circuit, high is a fault
+#define BMS_FAULT_PIN                     33
+#define FAN_ENABLE_PIN                    25
+#define FAULT_LAMP_PIN                    26
+
+// one port per output, so the fault task and the fan timer never rewrite each other's pin
+typedef GpioPort<FAN_ENABLE_PIN> FanOutput;
+typedef GpioPort<FAULT_LAMP_PIN> FaultLampOutput;
+
+// fault inputs, indices (change mask bits) in the GpioInputs of beginFaultInputs()
+#define IMD_FAULT_INPUT                   0
+#define BMS_FAULT_INPUT                   1
+#define FAULT_INPUT_DEBOUNCE_US           1000        // lockout after a fault edge
+
+// radiator fan, in tenths of a degree C
+#define FAN_ON_TEMP                       600
+#define FAN_OFF_TEMP                      550
+
+#define ESPNOW_MAX_NODE_PEERS             2           // dash and pit
+
+
+/**
+ * @brief the fault lines, written by the fault task only
+ */
+struct FaultState
+{
+  bool imdFault = false;
+  bool bmsFault = false;
+  uint32_t changes = 0;
+};
+
+/**
+ * @brief the last TEST_STATUS heard on the bus, written by the CAN process task only
+ */
+struct BusState
+{
+  uint8_t payload[8] = {};
+  uint32_t receivedAtUs = 0;
+  uint32_t frames = 0;                // 0 until the first TEST_STATUS
+};
+
+/**
+ * @brief how the ESP-NOW telemetry is doing, written by the telemetry timer only
+ */
+struct LinkState
+{
+  uint8_t peersOnline = 0;            // peers that acknowledged a frame in the last second
+  uint8_t delivery = 0;               // percent, the slowest peer
+};
+
+
+/*
+===============================================================================================
+                                    Fault Inputs
+===============================================================================================
+*/
+
+/**
+ * @brief watch the IMD and BMS fault lines, lockout debounced so a fault is taken on its first edge
+ *
+ * @param notify called from the ISR with the input bits, e.g. GpioInputs::notifyTask
+ */
+inline esp_err_t beginFaultInputs(GpioInputs& inputs, GpioInputNotify notify, void* context)
+{
+  GpioInputConfig config;
+  config.mode = GPIO_DEBOUNCE_LOCKOUT;
+  config.debounceUs = FAULT_INPUT_DEBOUNCE_US;
+  config.pull = GPIO_PULLUP_ONLY;       // a broken wire reads as a fault
+
+  config.pin = IMD_FAULT_PIN;
+  inputs.add(config);
+  config.pin = BMS_FAULT_PIN;
+  inputs.add(config);
+
+  inputs.setNotify(notify, context);
+  return inputs.begin();
+}
+
+
+/*
+===============================================================================================
+                                    Node Status
+===============================================================================================
+*/
+
+/**
+ * @brief coolant temperature of a TEST_STATUS payload in tenths of a degree C, without floats
+ */
+inline int coolantTempDeci(const TestStatus& status)
+{
+  return status.coolantTemp - 400;
+}
+
+/**
+ * @brief NODE_STATUS from the current state, the counter is the caller's
+ */
+inline NodeStatus makeNodeStatus(uint8_t counter, const FaultState& faults, bool fanOn, const LinkState& link, int64_t uptimeUs)
+{
+  NodeStatus status;
+  status.counter = counter;
+  status.imdFault = faults.imdFault;
+  status.bmsFault = faults.bmsFault;
+  status.fanEnable = fanOn;
+  status.faultLamp = faults.imdFault || faults.bmsFault;
+  status.peersOnline = link.peersOnline > 15 ? 15 : link.peersOnline;
+  status.telemetryDelivery = link.delivery;
+  const int64_t minutes = uptimeUs / 60000000;
+  status.uptime = (uint8_t)(minutes > 255 ? 255 : minutes);
+  return status;
+}
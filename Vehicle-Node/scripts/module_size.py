@@ -0,0 +1,167 @@
+"""
+@file module_size.py
+@brief code size and static RAM of every shared library, from the probes in src/size
+@version 1.0
+@date 2026-10-17
+
+each probe in src/size is one translation unit that uses one library the way the examples
+do, so what its object holds is that module's flash (text, with read-only data) and RAM
+(data + bss) cost. the probes are built with a section per function and object, so the
+sizes can be split by symbol: on the host the drivers are the simulated board, whose inline
+code and singletons would land in every probe that touches one, and symbols of Hal (Hal*,
+Sim*, halSim, the std containers behind them) are left out. the table lists every library with its version from
+lib/<name>/library.json.
+
+runs as a PlatformIO post: extra script of the native_size env, after the program links:
+
+    pio run -e native_size
+
+or by hand, compiling the probes itself with the host compiler:
+
+    python scripts/module_size.py [--cxx g++] [--size size]
+
+the figures are for the host compiler at -Os, not Xtensa: they rank the modules and show
+what a change costs, the ESP32 image is what `pio run -t size` reports.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+
+# --- modules --- #
+
+# library, probe source in src/size
+MODULES = [
+    ("AdcStream", "adc_stream.cpp"),
+    ("BootSequencer", "boot_sequencer.cpp"),
+    ("CanService", "can_service.cpp"),
+    ("DeferredLog", "deferred_log.cpp"),
+    ("Dsp", "dsp.cpp"),
+    ("EspNowLink", "espnow_link.cpp"),
+    ("EspNowMesh", "espnow_mesh.cpp"),
+    ("EspNowTelemetry", "espnow_telemetry.cpp"),
+    ("EspNowWire", "espnow_wire.cpp"),
+    ("GpioInput", "gpio_input.cpp"),
+    ("GpioPort", "gpio_port.cpp"),
+    ("Instrumentation", "instrumentation.cpp"),
+    ("SeqLock", "seqlock.cpp"),
+    ("StaticMemory", "static_memory.cpp"),
+    ("Telemetry", "telemetry.cpp"),
+    ("TimerScheduler", "timer_scheduler.cpp"),
+]
+
+
+def library_version(lib_dir, name):
+    try:
+        with open(os.path.join(lib_dir, name, "library.json"), "r") as manifest:
+            return json.load(manifest).get("version", "?")
+    except (OSError, ValueError):
+        return "?"
+
+
+# symbols of the simulated board, not of the module, the containers are the sim's too: no library allocates
+HAL_SYMBOL_PATTERN = re.compile(r"\b(?:Hal|Sim)[A-Z]\w*|\bhalSim\b|\bhal_\w+|\bstd::(?:vector|deque)<")
+
+# section name prefixes, longest first, and what they count as
+SECTION_KINDS = [
+    (".data.rel.ro.local", "data"),
+    (".data.rel.ro", "data"),
+    (".data.rel.local", "data"),
+    (".data.rel", "data"),
+    (".rodata", "text"),
+    (".text", "text"),
+    (".data", "data"),
+    (".tbss", "bss"),
+    (".bss", "bss"),
+]
+
+
+def demangle(names):
+    if not names:
+        return []
+    output = subprocess.check_output(["c++filt"], input="\n".join(names) + "\n", universal_newlines=True)
+    return output.splitlines()
+
+
+def measure(size_tool, path):
+    """
+    @brief text, data and bss of one object built with -ffunction-sections -fdata-sections,
+    every function and object has its own section, named after its symbol
+    """
+    output = subprocess.check_output([size_tool, "-A", path], universal_newlines=True)
+    sections = []
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) != 3 or not fields[1].isdigit():
+            continue
+        for prefix, kind in SECTION_KINDS:
+            if fields[0] == prefix or fields[0].startswith(prefix + "."):
+                sections.append((kind, fields[0][len(prefix) + 1:], int(fields[1])))
+                break
+
+    totals = {"text": 0, "data": 0, "bss": 0}
+    for (kind, _, size), symbol in zip(sections, demangle([symbol for _, symbol, _ in sections])):
+        if not HAL_SYMBOL_PATTERN.search(symbol):
+            totals[kind] += size
+    return totals["text"], totals["data"], totals["bss"]
+
+
+def report(lib_dir, size_tool, objects):
+    """
+    @brief print the table, objects maps a library name to its probe object
+    """
+    print("%-16s %-8s %8s %8s %8s %8s" % ("module", "version", "text", "data", "bss", "ram"))
+    total = [0, 0, 0]
+    for name, _ in MODULES:
+        text, data, bss = measure(size_tool, objects[name])
+        total = [total[0] + text, total[1] + data, total[2] + bss]
+        print("%-16s %-8s %8u %8u %8u %8u" % (name, library_version(lib_dir, name), text, data, bss, data + bss))
+    print("%-16s %-8s %8u %8u %8u %8u" % ("total", "", total[0], total[1], total[2], total[1] + total[2]))
+
+
+# --- entry points --- #
+
+def after_build(source, target, env):
+    project_dir = env.subst("$PROJECT_DIR")
+    build_dir = env.subst("$BUILD_DIR")
+    objects = {}
+    for name, probe in MODULES:
+        objects[name] = os.path.join(build_dir, "src", "size", os.path.splitext(probe)[0] + ".o")
+    report(os.path.join(project_dir, "..", "lib"), env.subst("$SIZETOOL") or "size", objects)
+
+
+def standalone(arguments):
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    lib_dir = os.path.join(project_dir, "..", "lib")
+    includes = ["-I" + os.path.join(lib_dir, "Hal", "sim")]
+    for name in sorted(os.listdir(lib_dir)):
+        if os.path.isdir(os.path.join(lib_dir, name, "src")):
+            includes.append("-I" + os.path.join(lib_dir, name, "src"))
+
+    objects = {}
+    with tempfile.TemporaryDirectory() as build_dir:
+        for name, probe in MODULES:
+            objects[name] = os.path.join(build_dir, os.path.splitext(probe)[0] + ".o")
+            subprocess.check_call([arguments.cxx, "-std=gnu++17", "-Os", "-ffunction-sections", "-fdata-sections", "-c"] + includes +
+                [os.path.join(project_dir, "src", "size", probe), "-o", objects[name]])
+        report(lib_dir, arguments.size, objects)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    env.AddPostAction("$PROGPATH", after_build)
+elif __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="code size and static RAM per shared library")
+    parser.add_argument("--cxx", default="g++", help="compiler for the probes")
+    parser.add_argument("--size", default="size", help="size tool matching the compiler")
+    standalone(parser.parse_args())
+    sys.exit(0)
@@ -0,0 +1,813 @@
+/**
+ * @file main.cpp
+ * @brief vehicle node: CAN, fault inputs, fan control and ESP-NOW telemetry on one board
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * built entirely from the shared libraries in ../lib, see vehicle_node.h for what the node does
+ * and lib/README.md for the modules. one hardware tick drives the timer wheel: the CAN write
+ * task is woken from the tick ISR every millisecond, the fan, telemetry and link timers run in
+ * the deferred task. the fault inputs wake their own task from their edge interrupts.
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+// standard includes
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include "esp_err.h"
+#include <esp_timer.h>
+#include "driver/can.h"
+#include <WiFi.h>
+#include <esp_now.h>
+#include <spsc_ring.h>
+#include <can_dispatch.h>
+#include <can_tx_scheduler.h>
+#include <can_tasks.h>
+#include <timer_wheel.h>
+#include <espnow_wire.h>
+#include <espnow_aggregator.h>
+#include <espnow_link.h>
+#include <seqlock.h>
+#include <dsp.h>
+#include <latency_histogram.h>
+#include <deferred_log.h>
+#include <static_task.h>
+#include <memory_report.h>
+#include <boot_sequencer.h>
+#include "vehicle_node.h"                 // includes vehicle_dbc.h, generated from ../dbc/vehicle.dbc at build time
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CLOCK_PRESCALER                   80          // this is based off to the clock speed (assuming 80 MHz)
+#define TICK_INTERVAL                     1000        // 1 ms wheel tick in microseconds
+#define CAN_TICK_INTERVAL                 1           // TX scheduler tick, in wheel ticks
+#define FAN_INTERVAL                      100         // in wheel ticks
+#define TELEMETRY_INTERVAL                20          // in wheel ticks
+#define LINK_STATS_INTERVAL               1000        // in wheel ticks
+#define TIMER_POOL_SIZE                   8           // most software timers running at once
+
+#define NODE_STATUS_PERIOD                100000      // 100 milliseconds in microseconds
+#define NODE_STATUS_PRIORITY              2
+#define BUS_STATUS_TIMEOUT                500000      // TEST_STATUS older than this leaves the fan on, in microseconds
+
+#define TASK_STACK_SIZE                   4096        // in bytes, static
+#define CAN_TASK_CORE                     1           // core the CAN tasks are pinned to
+#define CAN_WRITE_TASK_PRIORITY           9
+#define CAN_READ_TASK_PRIORITY            10
+#define CAN_PROCESS_TASK_PRIORITY         5
+#define FAULT_TASK_PRIORITY               20          // above everything that is not a driver
+#define DEFERRED_TASK_PRIORITY            4
+#define CAN_RX_RING_SIZE                  64          // frames buffered between the read and process tasks
+
+#define TELEMETRY_MIN_LATENCY_BUDGET      10000       // batch interval on a clean link, in microseconds
+#define TELEMETRY_MAX_LATENCY_BUDGET      200000      // batch interval on a lossy link, in microseconds
+#define TELEMETRY_TARGET_DELIVERY         0.95f       // delivery ratio the rate controller holds
+
+#define MAIN_LOOP_DELAY                   1
+#define SERIAL_BAUD_RATE                  9600        // the deferred logger is throttled to this too
+#define LATENCY_REPORT_KEY                'l'         // serial key that prints the latency report
+#define LATENCY_RESET_KEY                 'r'         // serial key that clears it
+#define MEMORY_REPORT_KEY                 'm'         // serial key that prints the heap and stack report
+#define BOOT_REPORT_KEY                   'p'         // serial key that prints the boot profile
+#define STATUS_REPORT_KEY                 's'         // serial key that prints the node status
+
+
+/*
+===============================================================================================
+                                    Function Declarations
+===============================================================================================
+*/
+
+// interrupts and timer callbacks
+void tickISR();
+void canTickCallback(void* context);
+void fanCallback(void* context);
+void telemetryCallback(void* context);
+void linkStatsCallback(void* context);
+void fillNodeStatus(can_message_t& message);
+void sendFrame(const uint8_t* frame, size_t length, void* context);
+
+// tasks
+void CANReadTask(void* pvParameters);
+void CANWriteTask(void* pvParameters);
+void CANProcessTask(void* pvParameters);
+void FaultTask(void* pvParameters);
+void DeferredTask(void* pvParameters);
+
+// message handlers
+void handleTestMessage(const can_message_t& message);
+
+// reports
+void printStatus();
+
+// boot stages
+bool beginSerial(void* context);
+bool beginCanDriver(void* context);
+bool beginTxSchedule(void* context);
+bool beginOutputs(void* context);
+bool beginFaults(void* context);
+bool beginWifi(void* context);
+bool beginCanTasks(void* context);
+bool beginTimerWheel(void* context);
+bool beginDeferredTask(void* context);
+bool beginTickTimer(void* context);
+bool beginTelemetry(void* context);
+
+
+/*
+===============================================================================================
+                                  Global Variables
+===============================================================================================
+*/
+
+// every message this node listens to, add a row here to receive a new ID
+constexpr CanMessageEntry canMessageTable[] = {
+  // id             dlc                 handler
+  { TestStatus::ID,   TestStatus::DLC,    handleTestMessage },
+};
+constexpr auto canDispatchTable = makeCanDispatchTable(canMessageTable);
+
+// CAN Interface, on a real bus with other nodes acknowledging
+can_general_config_t canConfig = CAN_GENERAL_CONFIG_DEFAULT((gpio_num_t)CAN_TX_PIN, (gpio_num_t)CAN_RX_PIN, CAN_MODE_NORMAL);
+can_timing_config_t canTimingConfig = CAN_TIMING_CONFIG_500KBITS();
+can_filter_config_t canFilterConfig = canDispatchTable.filterConfig();
+
+// owns every message this node transmits, only touched by the write task after setup
+CanTxScheduler canTxScheduler;
+int nodeStatusHandle = CAN_TX_INVALID_HANDLE;
+
+// received frames waiting to be decoded, written only by the read task and read only by the process task
+SpscRing<can_message_t, CAN_RX_RING_SIZE> canRxRing;
+
+// one hardware timer drives every periodic job through the wheel
+hw_timer_t* tickTimer = NULL;
+TimerWheel<TIMER_POOL_SIZE> timerWheel;
+BaseType_t tickTaskWoken = pdFALSE;             // only touched by the tick ISR and the callbacks it runs
+
+// the state every task shares, one writer each, see vehicle_node.h
+SeqLock<FaultState> faultState;
+SeqLock<BusState> busState;
+SeqLock<LinkState> linkState;
+std::atomic<bool> faultsChanged(false);         // the fault task asks the write task for an early NODE_STATUS
+std::atomic<bool> fanOn(true);                  // on until the first coolant temperature says otherwise
+
+// the fault lines and the fan, see vehicle_node.h
+GpioInputs faultInputs;
+DspHysteresis<int, FAN_OFF_TEMP, FAN_ON_TEMP> fanControl;
+
+// ESP-NOW peers, the dash and the pit
+uint8_t peerMacAddresses[ESPNOW_MAX_NODE_PEERS][6] = {
+  {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x10},         // change these to the target addresses!
+  {0xE0, 0x5A, 0x1B, 0x15, 0xEC, 0x11},
+};
+int peers[ESPNOW_MAX_NODE_PEERS];
+int peerCount = 0;
+uint32_t peerAcked[ESPNOW_MAX_NODE_PEERS];       // acked counts at the last link stats, deferred task only
+EspNowLink link;
+
+// batches NODE_STATUS and TEST_STATUS payloads, only used from the deferred task
+EspNowAggregatorConfig aggregatorConfig;
+EspNowAggregator aggregator(aggregatorConfig, sendFrame);
+uint32_t sendFailures = 0;
+
+// long-lived tasks on static stacks, started once during setup
+StaticTask<TASK_STACK_SIZE> canWriteTask;
+StaticTask<TASK_STACK_SIZE> canReadTask;
+StaticTask<TASK_STACK_SIZE> canProcessTask;
+StaticTask<TASK_STACK_SIZE> faultTask;
+StaticTask<TASK_STACK_SIZE> deferredTask;
+
+// brings the node up, its profile is printed on demand over serial
+BootSequencer boot;
+
+// timing instrumentation, printed on demand over serial
+PeriodMonitor tickMonitor(TICK_INTERVAL);
+LatencyHistogram canWriteWakeLatency;           // tick ISR to write task running
+LatencyHistogram canServiceTime;                // one pass of the TX scheduler
+LatencyHistogram faultReactionLatency;          // edge interrupt to the fault task handling it
+LatencyHistogram deferredLatency;               // tick ISR queueing a callback to the deferred task running it
+volatile uint32_t tickFiredAt = 0;              // low word of the tick time, a single store the tasks cannot tear
+LatencySource latencySources[] = {
+  { "tick ISR lateness", NULL, &tickMonitor },
+  { "tx task wake", &canWriteWakeLatency, NULL },
+  { "tx service", &canServiceTime, NULL },
+  { "fault reaction", &faultReactionLatency, NULL },
+  { "deferred wake", &deferredLatency, NULL },
+};
+
+// heap and task stacks, printed on demand over serial
+MemorySource memorySources[] = {
+  { "can write task", NULL, NULL, &canWriteTask },
+  { "can read task", NULL, NULL, &canReadTask },
+  { "can process task", NULL, NULL, &canProcessTask },
+  { "fault task", NULL, NULL, &faultTask },
+  { "deferred task", NULL, NULL, &deferredTask },
+  { "deferred log task", NULL, NULL, &deferredLog().task() },
+};
+
+
+/*
+===============================================================================================
+                                            Setup
+===============================================================================================
+*/
+
+void setup() {
+  // waits for a serial monitor only when built with -DBOOT_ATTACH_DELAY
+  bootAttachDelay();
+
+  // CAN, the fault inputs and Wi-Fi do not need each other, so a slow radio never holds up the bus
+  // the tick needs the CAN tasks, the wheel, the deferred task and the fan output, telemetry needs Wi-Fi and the wheel
+  // the UART, the CAN driver, the fault inputs and the tick attach interrupts, which stay on setup's core
+  // the Wi-Fi driver allocates its interrupt from its own task, so it can start on a helper
+  boot.add("serial", beginSerial, NULL, 0, BOOT_ON_CALLER);
+  const int canDriver = boot.add("can driver", beginCanDriver, NULL, 0, BOOT_ON_CALLER);
+  const int txSchedule = boot.add("tx schedule", beginTxSchedule, NULL);
+  const int outputs = boot.add("outputs", beginOutputs, NULL);
+  boot.add("fault inputs", beginFaults, NULL, BOOT_AFTER(outputs), BOOT_ON_CALLER);
+  const int wifi = boot.add("wifi", beginWifi, NULL);
+  const int canTasks = boot.add("can tasks", beginCanTasks, NULL, BOOT_AFTER(canDriver) | BOOT_AFTER(txSchedule));
+  const int wheel = boot.add("timer wheel", beginTimerWheel, NULL);
+  const int deferred = boot.add("deferred task", beginDeferredTask, NULL);
+  boot.add("tick timer", beginTickTimer, NULL, BOOT_AFTER(canTasks) | BOOT_AFTER(wheel) | BOOT_AFTER(deferred) |
+    BOOT_AFTER(outputs), BOOT_ON_CALLER);
+  boot.add("telemetry", beginTelemetry, NULL, BOOT_AFTER(wifi) | BOOT_AFTER(wheel));
+
+  // end setup
+  LOG_PRINTF("BOOT [ %s ] in %u us, '%c' prints the profile\n", boot.run() ? "SUCCESS" : "FAILED",
+    (uint32_t)(boot.endUs() - boot.beginUs()), BOOT_REPORT_KEY);
+}
+
+
+/*
+===============================================================================================
+                                        Boot Stages
+===============================================================================================
+*/
+
+
+/**
+ * @brief starts serial and the deferred logger, tasks log through it so they never wait on the UART
+ */
+bool beginSerial(void* context) {
+  Serial.begin(SERIAL_BAUD_RATE);
+  DeferredLogConfig logConfig;
+  logConfig.baudRate = SERIAL_BAUD_RATE;
+  return deferredLog().begin(Serial, logConfig);
+}
+
+
+/**
+ * @brief installs and starts the CAN controller with every alert tracked
+ */
+bool beginCanDriver(void* context) {
+  const char* failedStep = NULL;
+  if (startCanDriver(canConfig, canTimingConfig, canFilterConfig, &failedStep) != ESP_OK) {
+    LOG_PRINTF("CAN %s [ FAILED ]\n", failedStep);
+    return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief adds NODE_STATUS to the TX scheduler, periodic and sent early when a fault line changes
+ */
+bool beginTxSchedule(void* context) {
+  can_message_t nodeStatusMessage = {
+    .flags = CAN_MSG_FLAG_NONE,
+    .identifier = NodeStatus::ID,
+    .data_length_code = NodeStatus::DLC,
+  };
+  nodeStatusHandle = canTxScheduler.addPeriodic(nodeStatusMessage, NODE_STATUS_PERIOD, NODE_STATUS_PRIORITY, fillNodeStatus);
+  return nodeStatusHandle != CAN_TX_INVALID_HANDLE;
+}
+
+
+/**
+ * @brief the fan starts on and the fault lamp off, until the first reading says otherwise
+ */
+bool beginOutputs(void* context) {
+  const bool ok = gpio_set_direction((gpio_num_t)FAN_ENABLE_PIN, GPIO_MODE_OUTPUT) == ESP_OK &&
+    gpio_set_direction((gpio_num_t)FAULT_LAMP_PIN, GPIO_MODE_OUTPUT) == ESP_OK;
+  FanOutput::write(1);
+  FaultLampOutput::write(0);
+  LOG_PRINTF("GPIO INIT OUTPUTS [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
+}
+
+
+/**
+ * @brief fault inputs, the task exists before the first edge can notify it
+ */
+bool beginFaults(void* context) {
+  const bool ok = faultTask.start(FaultTask, "Fault-Inputs", NULL, FAULT_TASK_PRIORITY) &&
+    beginFaultInputs(faultInputs, &GpioInputs::notifyTask, faultTask.handle()) == ESP_OK;
+  LOG_PRINTF("GPIO INIT FAULT INPUTS [ %s ]\n", ok ? "SUCCESS" : "FAILED");
+  return ok;
+}
+
+
+/**
+ * @brief Wi-Fi station, ESP-NOW and the peers, each peer's rate controller starts at the slowest rate
+ */
+bool beginWifi(void* context) {
+  WiFi.mode(WIFI_STA);
+  if (esp_now_init() != ESP_OK || link.begin() != ESP_OK) {
+    LOG_PRINTF("ESP-NOW INIT [ FAILED ]\n");
+    return false;
+  }
+
+  EspNowRateConfig rateConfig;
+  rateConfig.targetDelivery = TELEMETRY_TARGET_DELIVERY;
+  rateConfig.minIntervalUs = TELEMETRY_MIN_LATENCY_BUDGET;
+  rateConfig.maxIntervalUs = TELEMETRY_MAX_LATENCY_BUDGET;
+  for (int i = 0; i < ESPNOW_MAX_NODE_PEERS; i++) {
+    esp_now_peer_info peerInfo = {};
+    memcpy(peerInfo.peer_addr, peerMacAddresses[i], 6);
+    peerInfo.channel = 0;
+    peerInfo.encrypt = false;
+    if (esp_now_add_peer(&peerInfo) != ESP_OK) {
+      LOG_PRINTF("ESP-NOW PEER %d [ FAILED ]\n", i);
+      continue;
+    }
+    peers[peerCount++] = link.addPeer(peerMacAddresses[i], rateConfig);
+  }
+  LOG_PRINTF("ESP-NOW INIT [ SUCCESS ] with %d peers\n", peerCount);
+  return peerCount > 0;
+}
+
+
+/**
+ * @brief starts the CAN tasks on their static stacks
+ * the process task is created first so the read task always has someone to notify
+ */
+bool beginCanTasks(void* context) {
+  if (!canProcessTask.start(CANProcessTask, "CAN-Process", NULL, CAN_PROCESS_TASK_PRIORITY)) {
+    LOG_PRINTF("CAN PROCESS TASK INIT [ FAILED ]\n");
+    return false;
+  }
+
+  if (!canReadTask.start(CANReadTask, "CAN-Read", NULL, CAN_READ_TASK_PRIORITY, CAN_TASK_CORE)) {
+    LOG_PRINTF("CAN READ TASK INIT [ FAILED ]\n");
+    return false;
+  }
+
+  if (!canWriteTask.start(CANWriteTask, "CAN-Write", NULL, CAN_WRITE_TASK_PRIORITY, CAN_TASK_CORE)) {
+    LOG_PRINTF("CAN WRITE TASK INIT [ FAILED ]\n");
+    return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief the CAN tick runs straight in the tick ISR, the fan in the deferred task
+ */
+bool beginTimerWheel(void* context) {
+  const TimerId canTick = timerWheel.start(CAN_TICK_INTERVAL, CAN_TICK_INTERVAL, canTickCallback, NULL, TIMER_RUN_IN_ISR);
+  const TimerId fan = timerWheel.start(FAN_INTERVAL, FAN_INTERVAL, fanCallback, NULL, TIMER_RUN_DEFERRED);
+  return canTick != TIMER_WHEEL_INVALID_ID && fan != TIMER_WHEEL_INVALID_ID;
+}
+
+
+/**
+ * @brief the deferred task has to exist before the tick can wake it
+ */
+bool beginDeferredTask(void* context) {
+  return deferredTask.start(DeferredTask, "Deferred Timers", NULL, DEFERRED_TASK_PRIORITY);
+}
+
+
+/**
+ * @brief initialize the tick interrupt, everything periodic runs from here on
+ */
+bool beginTickTimer(void* context) {
+  tickTimer = timerBegin(0, CLOCK_PRESCALER, true);
+  timerAttachInterrupt(tickTimer, &tickISR, true);
+  timerAlarmWrite(tickTimer, TICK_INTERVAL, true);
+  timerAlarmEnable(tickTimer);
+
+  LOG_PRINTF("TICK TIMER STATUS: %s\n", timerAlarmEnabled(tickTimer) ? "RUNNING" : "DISABLED");
+  return timerAlarmEnabled(tickTimer);
+}
+
+
+/**
+ * @brief starts the telemetry and link timers, the batch interval follows the slowest peer
+ */
+bool beginTelemetry(void* context) {
+  aggregatorConfig.latencyBudgetUs = TELEMETRY_MAX_LATENCY_BUDGET;
+  aggregator.configure(aggregatorConfig);
+
+  const TimerId telemetry = timerWheel.start(TELEMETRY_INTERVAL, TELEMETRY_INTERVAL, telemetryCallback, NULL, TIMER_RUN_DEFERRED);
+  const TimerId linkStats = timerWheel.start(LINK_STATS_INTERVAL, LINK_STATS_INTERVAL, linkStatsCallback, NULL, TIMER_RUN_DEFERRED);
+  return telemetry != TIMER_WHEEL_INVALID_ID && linkStats != TIMER_WHEEL_INVALID_ID;
+}
+
+
+/*
+===============================================================================================
+                                    Callback Functions
+===============================================================================================
+*/
+
+
+/**
+ * @brief tick ISR - advances the timer wheel and wakes the deferred task if anything is queued
+ */
+void IRAM_ATTR tickISR()
+{
+  int64_t now = esp_timer_get_time();
+  tickMonitor.mark(now);
+  tickFiredAt = (uint32_t)now;
+
+  tickTaskWoken = pdFALSE;
+  if (timerWheel.tick() != 0) {
+    vTaskNotifyGiveFromISR(deferredTask.handle(), &tickTaskWoken);
+  }
+  if (tickTaskWoken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+
+/**
+ * @brief CAN timer (ISR) - wakes the write task, the yield is left to the tick ISR
+ *
+ * @param context unused
+ */
+void IRAM_ATTR canTickCallback(void* context)
+{
+  vTaskNotifyGiveFromISR(canWriteTask.handle(), &tickTaskWoken);
+}
+
+
+/**
+ * @brief fan timer (deferred task) - switches the fan on the coolant temperature, on when the bus went quiet
+ *
+ * @param context unused
+ */
+void fanCallback(void* context)
+{
+  BusState bus;
+  busState.read(bus);
+
+  bool on = true;
+  if (bus.frames != 0 && (uint32_t)esp_timer_get_time() - bus.receivedAtUs < BUS_STATUS_TIMEOUT) {
+    on = fanControl.process(coolantTempDeci(TestStatus::unpack(bus.payload)));
+  }
+  FanOutput::write(on);
+  fanOn.store(on, std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief telemetry timer (deferred task) - queues NODE_STATUS every time and TEST_STATUS when a new one came in
+ *
+ * @param context unused
+ */
+void telemetryCallback(void* context)
+{
+  static uint8_t counter = 0;
+  static uint32_t lastBusFrames = 0;
+  const uint32_t now = (uint32_t)esp_timer_get_time();
+
+  FaultState faults;
+  LinkState linkNow;
+  faultState.read(faults);
+  linkState.read(linkNow);
+  uint8_t payload[8];
+  makeNodeStatus(counter++, faults, fanOn.load(std::memory_order_relaxed), linkNow, esp_timer_get_time()).pack(payload);
+  aggregator.add(ESPNOW_PRODUCER_NODE_STATUS, now, payload, NodeStatus::DLC);
+
+  BusState bus;
+  busState.read(bus);
+  if (bus.frames != lastBusFrames) {
+    aggregator.add(ESPNOW_PRODUCER_BUS_STATUS, bus.receivedAtUs, bus.payload, TestStatus::DLC);
+    lastBusFrames = bus.frames;
+  }
+  aggregator.poll(now);
+}
+
+
+/**
+ * @brief link timer (deferred task) - counts the peers that acknowledged something and follows the slowest one
+ *
+ * @param context unused
+ */
+void linkStatsCallback(void* context)
+{
+  LinkState state;
+  uint32_t budget = TELEMETRY_MIN_LATENCY_BUDGET;
+  float delivery = 1.0f;
+  for (int i = 0; i < peerCount; i++) {
+    const EspNowPeerStats stats = link.stats(peers[i]);
+    if (stats.acked != peerAcked[i]) {
+      state.peersOnline++;
+      peerAcked[i] = stats.acked;
+    }
+    const uint32_t interval = link.intervalUs(peers[i]);
+    budget = interval > budget ? interval : budget;
+    const float peerDelivery = link.delivery(peers[i]);
+    delivery = peerDelivery < delivery ? peerDelivery : delivery;
+  }
+  state.delivery = (uint8_t)(delivery * 100.0f + 0.5f);
+  linkState.publish(state);
+
+  // a longer budget means fewer, fuller frames
+  if (budget != aggregatorConfig.latencyBudgetUs) {
+    aggregatorConfig.latencyBudgetUs = budget;
+    aggregator.configure(aggregatorConfig);
+  }
+}
+
+
+/**
+ * @brief sends a finished batch frame to every peer, called by the aggregator
+ *
+ * @param frame the frame to send
+ * @param length size of the frame in bytes
+ * @param context unused
+ */
+void sendFrame(const uint8_t* frame, size_t length, void* context)
+{
+  for (int i = 0; i < peerCount; i++) {
+    if (link.send(peers[i], frame, length) != ESP_OK) {
+      sendFailures++;
+    }
+  }
+}
+
+
+/**
+ * @brief refreshes NODE_STATUS right before it is sent, on the write task
+ *
+ * @param message the frame about to be transmitted
+ */
+void fillNodeStatus(can_message_t& message)
+{
+  static uint8_t counter = 0;
+
+  FaultState faults;
+  LinkState linkNow;
+  faultState.read(faults);
+  linkState.read(linkNow);
+  makeNodeStatus(counter++, faults, fanOn.load(std::memory_order_relaxed), linkNow, esp_timer_get_time()).pack(message.data);
+}
+
+
+/*
+===============================================================================================
+                                FreeRTOS Task Functions
+===============================================================================================
+*/
+
+
+/**
+ * @brief services the TX scheduler every time the CAN timer ticks, never blocks on the driver
+ *
+ * @param arg - argument passed via function pointer
+ */
+void CANWriteTask(void *arg)
+{
+  // init
+  bool firstFrameSent = false;
+
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // wait for the next scheduler tick
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    canWriteWakeLatency.record((uint32_t)start - tickFiredAt);         // unsigned, so right across the wrap too
+
+    // a fault line changed, the bus hears it now rather than at the next period
+    if (faultsChanged.exchange(false, std::memory_order_acq_rel)) {
+      canTxScheduler.markChanged(nodeStatusHandle);
+    }
+
+    // recover from bus-off if needed, then send whatever is due
+    serviceCanTx(canTxScheduler, start);
+    canServiceTime.record((uint32_t)(esp_timer_get_time() - start));
+
+    // the boot profile ends with the first frame the driver took
+    if (!firstFrameSent && canTxScheduler.stats().sent > 0) {
+      boot.mark("first can frame");
+      firstFrameSent = true;
+    }
+  }
+}
+
+
+/**
+ * @brief receives messages from the can bus, blocking on the driver's RX queue between frames
+ * only copies frames into the RX ring so a slow consumer can never stall ingestion
+ *
+ * @param arg - argument passed via function pointer
+ */
+void CANReadTask(void *arg)
+{
+  // the task lives for the lifetime of the program
+  for (;;) {
+    // receive message and hand it off to the process task
+    if (readCanFrame(canRxRing, portMAX_DELAY)) {
+      xTaskNotifyGive(canProcessTask.handle());
+    }
+    else {
+      // driver is not running (stopped or bus-off), back off instead of spinning
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+  }
+}
+
+
+/**
+ * @brief drains the RX ring and hands each frame to its handler
+ *
+ * @param arg - argument passed via function pointer
+ */
+void CANProcessTask(void *arg)
+{
+  // init
+  can_message_t rx_message;
+  CanRxErrors rxErrors;
+
+  // the task lives for the lifetime of the program
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    while (canRxRing.pop(rx_message)) {
+      switch (dispatchCanFrame(canDispatchTable, rx_message, rxErrors)) {
+        case CAN_DISPATCH_HANDLED:
+        break;
+
+        case CAN_DISPATCH_UNKNOWN_ID:
+          LOG_PRINTF("ERROR: no handler for ID 0x%03x (%u total)\n", rx_message.identifier, rxErrors.unknownId);
+        break;
+
+        case CAN_DISPATCH_BAD_DLC:
+          LOG_PRINTF("ERROR: bad DLC %d for ID 0x%03x (%u total)\n", rx_message.data_length_code, rx_message.identifier, rxErrors.badDlc);
+        break;
+      }
+    }
+  }
+}
+
+
+/**
+ * @brief reacts to fault input changes, woken by their edge interrupts instead of polling
+ * drives the fault lamp and asks the write task for an early NODE_STATUS
+ *
+ * @param arg - argument passed via function pointer
+ */
+void FaultTask(void *arg)
+{
+  FaultState state;
+
+  for (;;) {
+    // sleep until an edge, or until a lockout the debouncer has to look at ends
+    TickType_t timeout = portMAX_DELAY;
+    const int64_t deadline = faultInputs.nextDeadlineUs();
+    if (deadline != GPIO_INPUT_NO_DEADLINE) {
+      const int64_t waitUs = deadline - esp_timer_get_time();
+      timeout = waitUs > 0 ? pdMS_TO_TICKS((uint32_t)(waitUs + 999) / 1000) : 0;
+    }
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, ULONG_MAX, &bits, timeout);
+
+    const int64_t now = esp_timer_get_time();
+    const uint32_t changed = faultInputs.service(now);
+    if (changed == 0) {
+      continue;
+    }
+
+    state.imdFault = faultInputs.state(IMD_FAULT_INPUT).active;
+    state.bmsFault = faultInputs.state(BMS_FAULT_INPUT).active;
+    state.changes++;
+    FaultLampOutput::write(state.imdFault || state.bmsFault);
+    faultState.publish(state);
+    faultsChanged.store(true, std::memory_order_release);
+
+    for (int i = 0; i < faultInputs.size(); i++) {
+      if (changed & (1u << i)) {
+        const GpioInputState fault = faultInputs.state(i);
+        faultReactionLatency.record((uint32_t)(now - fault.edgeUs));
+        LOG_PRINTF("%s fault: %d\n", i == IMD_FAULT_INPUT ? "imd" : "bms", fault.active);
+      }
+    }
+  }
+}
+
+
+/**
+ * @brief runs deferred timer callbacks whenever the tick ISR queues some
+ *
+ * @param pvParameters - argument passed via function pointer
+ */
+void DeferredTask(void* pvParameters)
+{
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    deferredLatency.record((uint32_t)esp_timer_get_time() - tickFiredAt);
+    timerWheel.runDeferred();
+  }
+}
+
+
+/*
+===============================================================================================
+                                    Message Handlers
+===============================================================================================
+*/
+
+
+/**
+ * @brief keeps the last TEST_STATUS for the fan and the telemetry, on the process task
+ *
+ * @param message the received frame
+ */
+void handleTestMessage(const can_message_t& message)
+{
+  static BusState state;
+
+  memcpy(state.payload, message.data, TestStatus::DLC);
+  state.receivedAtUs = (uint32_t)esp_timer_get_time();
+  state.frames++;
+  busState.publish(state);
+}
+
+
+/*
+===============================================================================================
+                                    Reports
+===============================================================================================
+*/
+
+
+/**
+ * @brief faults, fan, bus and link in a few lines
+ */
+void printStatus()
+{
+  FaultState faults;
+  BusState bus;
+  LinkState linkNow;
+  faultState.read(faults);
+  busState.read(bus);
+  linkState.read(linkNow);
+  const CanTxStats& txStats = canTxScheduler.stats();
+  const EspNowAggregatorStats& telemetryStats = aggregator.stats();
+
+  Serial.printf("\nimd fault: %d | bms fault: %d | changes: %u | fan: %d\n", faults.imdFault, faults.bmsFault, faults.changes,
+    fanOn.load(std::memory_order_relaxed));
+  Serial.printf("CAN RX: test status frames: %u | coolant: %d.%d C | ring overflows: %u\n", bus.frames,
+    coolantTempDeci(TestStatus::unpack(bus.payload)) / 10, abs(coolantTempDeci(TestStatus::unpack(bus.payload)) % 10),
+    canRxRing.overflowCount());
+  Serial.printf("CAN TX: sent: %u | queue full: %u | deadline misses: %u | bus-off: %u | recovered: %u\n",
+    txStats.sent, txStats.queueFull, txStats.deadlineMisses, txStats.busOffEvents, txStats.busRecoveries);
+  Serial.printf("ESP-NOW: peers online: %u / %d | delivery: %u%% | frames: %u | send failures: %u | batch interval: %u us\n",
+    linkNow.peersOnline, peerCount, linkNow.delivery, telemetryStats.frames, sendFailures, aggregatorConfig.latencyBudgetUs);
+}
+
+
+/*
+===============================================================================================
+                                    Main Loop
+===============================================================================================
+*/
+
+void loop() {
+  // print or clear the reports on request
+  if (Serial.available() > 0) {
+    int key = Serial.read();
+    if (key == LATENCY_REPORT_KEY) {
+      printLatencyReport(Serial, latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == LATENCY_RESET_KEY) {
+      resetLatencyReport(latencySources, sizeof(latencySources) / sizeof(latencySources[0]));
+    }
+    else if (key == MEMORY_REPORT_KEY) {
+      printMemoryReport(Serial, memorySources, sizeof(memorySources) / sizeof(memorySources[0]));
+    }
+    else if (key == BOOT_REPORT_KEY) {
+      printBootReport(Serial, boot);
+    }
+    else if (key == STATUS_REPORT_KEY) {
+      printStatus();
+    }
+  }
+
+  // prevent watchdog from getting upset
+  vTaskDelay(MAIN_LOOP_DELAY);
+}
@@ -0,0 +1,19 @@
+/**
+ * @file adc_stream.cpp
+ * @brief size probe: AdcStream with one channel, filters included
+ */
+
+#include <adc_stream.h>
+#include "size_probes.h"
+
+AdcStream probeAdc;
+
+void sizeProbeAdcStream()
+{
+  const int channel = probeAdc.add(ADC1_CHANNEL_6);
+  AdcChannelSnapshot snapshot;
+  if (probeAdc.read(channel, snapshot)) {
+    sizeProbeSink = AdcChannelFilter::counts(snapshot.mean);
+  }
+  sizeProbeSink = probeAdc.stats().samples;
+}
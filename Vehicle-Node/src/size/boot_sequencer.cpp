@@ -0,0 +1,25 @@
+/**
+ * @file boot_sequencer.cpp
+ * @brief size probe: BootSequencer with two dependent stages
+ */
+
+#include <boot_sequencer.h>
+#include "size_probes.h"
+
+BootSequencer probeBoot;
+
+static bool probeStage(void* context)
+{
+  sizeProbeSink++;
+  return true;
+}
+
+void sizeProbeBootSequencer()
+{
+  const int first = probeBoot.add("first", probeStage, NULL);
+  probeBoot.add("second", probeStage, NULL, BOOT_AFTER(first));
+  sizeProbeSink = probeBoot.run();
+  probeBoot.mark("done");
+  char row[BOOT_ROW_SIZE];
+  sizeProbeSink = formatBootRow(row, sizeof(row), probeBoot.stage(0));
+}
@@ -0,0 +1,42 @@
+/**
+ * @file can_service.cpp
+ * @brief size probe: TX scheduler, dispatch table and RX ring through the CAN task steps
+ */
+
+#include <spsc_ring.h>
+#include <can_dispatch.h>
+#include <can_tx_scheduler.h>
+#include <can_tasks.h>
+#include "size_probes.h"
+
+static void probeHandler(const can_message_t& message)
+{
+  sizeProbeSink = message.data[0];
+}
+
+constexpr CanMessageEntry probeMessageTable[] = {
+  { 0x123, 8, probeHandler },
+  { 0x124, 4, probeHandler },
+};
+constexpr auto probeDispatchTable = makeCanDispatchTable(probeMessageTable);
+
+CanTxScheduler probeTxScheduler;
+SpscRing<can_message_t, 64> probeRxRing;
+CanRxErrors probeRxErrors;
+
+void sizeProbeCanService()
+{
+  can_message_t message = {};
+  message.identifier = 0x123;
+  message.data_length_code = 8;
+  const int handle = probeTxScheduler.addPeriodic(message, 100000, 1);
+  probeTxScheduler.markChanged(handle);
+  serviceCanTx(probeTxScheduler, 0);
+
+  while (readCanFrame(probeRxRing, 0)) {
+  }
+  while (probeRxRing.pop(message)) {
+    sizeProbeSink = dispatchCanFrame(probeDispatchTable, message, probeRxErrors);
+  }
+  sizeProbeSink = probeDispatchTable.filterConfig().acceptance_code;
+}
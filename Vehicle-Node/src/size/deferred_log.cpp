@@ -0,0 +1,18 @@
+/**
+ * @file deferred_log.cpp
+ * @brief size probe: the deferred logger, queueing one record and formatting it
+ */
+
+#include <deferred_log.h>
+#include "size_probes.h"
+
+static void probeSink(const uint8_t* data, size_t length, void* context)
+{
+  sizeProbeSink += (uint32_t)length;
+}
+
+void sizeProbeDeferredLog()
+{
+  LOG_PRINTF("probe %d %s %f\n", 1, "text", 1.5f);
+  sizeProbeSink = (uint32_t)deferredLog().drain(DEFERRED_LOG_TEXT, 256, probeSink, NULL);
+}
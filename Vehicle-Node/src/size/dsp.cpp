@@ -0,0 +1,19 @@
+/**
+ * @file dsp.cpp
+ * @brief size probe: one of each filter kernel
+ */
+
+#include <dsp.h>
+#include "size_probes.h"
+
+constexpr DspBiquadDesign probeLowpass = dspLowpass(10, 1000, DSP_BUTTERWORTH_Q);
+DspBiquad<DspQ15> probeBiquad(probeLowpass);
+DspMovingAverage<int16_t, 8> probeAverage;
+DspMedian<int16_t, 5> probeMedian;
+DspHysteresis<int, 550, 600> probeHysteresis;
+
+void sizeProbeDsp()
+{
+  const int16_t x = (int16_t)sizeProbeSink;
+  sizeProbeSink = probeBiquad.process(x) + probeAverage.process(x) + probeMedian.process(x) + probeHysteresis.process(x);
+}
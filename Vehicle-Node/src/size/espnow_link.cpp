@@ -0,0 +1,18 @@
+/**
+ * @file espnow_link.cpp
+ * @brief size probe: delivery tracking and rate control for two peers
+ */
+
+#include <espnow_link.h>
+#include "size_probes.h"
+
+EspNowLinkTracker probeLink;
+
+void sizeProbeEspNowLink()
+{
+  const uint8_t mac[6] = { 0x24, 0x6F, 0x28, 0x10, 0x00, 0x01 };
+  const int peer = probeLink.addPeer(mac);
+  probeLink.onSent(peer, 1, 0);
+  probeLink.onComplete(mac, true, 1000);
+  sizeProbeSink = probeLink.stats(peer).acked + probeLink.controller(peer).intervalUs();
+}
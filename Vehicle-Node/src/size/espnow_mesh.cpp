@@ -0,0 +1,35 @@
+/**
+ * @file espnow_mesh.cpp
+ * @brief size probe: the mesh relay with its peer table and duplicate cache
+ */
+
+#include <espnow_mesh.h>
+#include "size_probes.h"
+
+static bool probeSend(const uint8_t* mac, const uint8_t* frame, size_t length, void* context)
+{
+  sizeProbeSink += (uint32_t)length;
+  return true;
+}
+
+static void probeDeliver(const EspNowMeshMessage& message, void* context)
+{
+  sizeProbeSink++;
+}
+
+EspNowMesh probeMesh(probeSend, probeDeliver);
+
+void sizeProbeEspNowMesh()
+{
+  const uint8_t self[6] = { 0x24, 0x6F, 0x28, 0x10, 0x00, 0x00 };
+  const uint8_t peer[6] = { 0x24, 0x6F, 0x28, 0x10, 0x00, 0x01 };
+  probeMesh.begin(self);
+  probeMesh.addPeer(peer);
+
+  uint8_t frame[ESPNOW_MESH_MAX_INNER_SIZE];
+  EspNowFrameWriter writer(frame, sizeof(frame));
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, 0, 0);
+  const size_t length = writer.finish(EspNowDataView::write(payload, 0, 0, false));
+  sizeProbeSink = probeMesh.send(frame, length);
+  sizeProbeSink = probeMesh.onReceive(peer, frame, (int)length, 0);
+}
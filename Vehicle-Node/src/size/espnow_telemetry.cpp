@@ -0,0 +1,33 @@
+/**
+ * @file espnow_telemetry.cpp
+ * @brief size probe: the batching aggregator and the receiver's walk over a batch
+ */
+
+#include <espnow_aggregator.h>
+#include "size_probes.h"
+
+static void probeSample(const EspNowSample& sample, void* context)
+{
+  sizeProbeSink += sample.length;
+}
+
+// stands in for the radio, the batch is read back the way the receiver does
+static void probeSend(const uint8_t* frame, size_t length, void* context)
+{
+  EspNowFrameView view;
+  if (EspNowFrameView::parse(frame, (int)length, view) == ESPNOW_PARSE_OK) {
+    sizeProbeSink = EspNowBatchReader::forEachSample(view, probeSample);
+  }
+}
+
+EspNowAggregatorConfig probeAggregatorConfig;
+EspNowAggregator probeAggregator(probeAggregatorConfig, probeSend);
+
+void sizeProbeEspNowTelemetry()
+{
+  const uint8_t sample[4] = { 1, 2, 3, 4 };
+  probeAggregator.configure(probeAggregatorConfig);
+  probeAggregator.add(0, 0, sample, sizeof(sample));
+  probeAggregator.poll(100000);
+  probeAggregator.flush();
+}
@@ -0,0 +1,19 @@
+/**
+ * @file espnow_wire.cpp
+ * @brief size probe: writing and parsing one wire format frame
+ */
+
+#include <espnow_wire.h>
+#include "size_probes.h"
+
+void sizeProbeEspNowWire()
+{
+  uint8_t frame[ESPNOW_WIRE_MAX_FRAME_SIZE];
+  EspNowFrameWriter writer(frame, sizeof(frame));
+  uint8_t* payload = writer.begin(ESPNOW_FRAME_DATA, 1, 0);
+  const size_t length = writer.finish(EspNowDataView::write(payload, 1, 1, true));
+
+  EspNowFrameView view;
+  sizeProbeSink = EspNowFrameView::parse(frame, (int)length, view);
+  sizeProbeSink = view.sequence();
+}
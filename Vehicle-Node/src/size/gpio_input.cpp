@@ -0,0 +1,24 @@
+/**
+ * @file gpio_input.cpp
+ * @brief size probe: two debounced inputs, fed and serviced like the fault task does
+ */
+
+#include <gpio_input.h>
+#include "size_probes.h"
+
+GpioInputs probeInputs;
+
+void sizeProbeGpioInput()
+{
+  GpioInputConfig config;
+  config.pin = 32;
+  config.mode = GPIO_DEBOUNCE_LOCKOUT;
+  probeInputs.add(config);
+  config.pin = 33;
+  config.mode = GPIO_DEBOUNCE_SETTLE;
+  probeInputs.add(config);
+
+  probeInputs.onEdge(0, true, 0);
+  sizeProbeSink = probeInputs.service(10000);
+  sizeProbeSink = (uint32_t)probeInputs.nextDeadlineUs() + probeInputs.state(0).active;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file gpio_port.cpp
+ * @brief size probe: a four pin port written with run time and compile time levels
+ */
+
+#include <gpio_port.h>
+#include "size_probes.h"
+
+typedef GpioPort<32, 33, 25, 26> ProbePort;
+
+void sizeProbeGpioPort()
+{
+  ProbePort::write(sizeProbeSink);
+  ProbePort::write<0x5>();
+}
@@ -0,0 +1,17 @@
+/**
+ * @file instrumentation.cpp
+ * @brief size probe: a latency histogram and a period monitor
+ */
+
+#include <latency_histogram.h>
+#include "size_probes.h"
+
+LatencyHistogram probeLatency;
+PeriodMonitor probePeriod(1000);
+
+void sizeProbeInstrumentation()
+{
+  probeLatency.record(sizeProbeSink);
+  probePeriod.mark(1000);
+  sizeProbeSink = probeLatency.percentile(0.99f) + probePeriod.lateness().summary().max;
+}
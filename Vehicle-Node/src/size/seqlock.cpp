@@ -0,0 +1,24 @@
+/**
+ * @file seqlock.cpp
+ * @brief size probe: a SeqLock over a small state struct, like the vehicle node's
+ */
+
+#include <seqlock.h>
+#include "size_probes.h"
+
+struct ProbeState
+{
+  uint8_t payload[8];
+  uint32_t receivedAtUs;
+  uint32_t frames;
+};
+
+SeqLock<ProbeState> probeState;
+
+void sizeProbeSeqLock()
+{
+  ProbeState state = {};
+  state.frames = sizeProbeSink;
+  probeState.publish(state);
+  sizeProbeSink = probeState.read(state) + state.frames;
+}
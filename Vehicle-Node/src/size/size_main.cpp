@@ -0,0 +1,34 @@
+/**
+ * @file size_main.cpp
+ * @brief links every module probe into one program, run once so the linker keeps all of them
+ * @version 1.0
+ * @date 2026-10-17
+ */
+
+#include <stdio.h>
+#include "size_probes.h"
+
+volatile uint32_t sizeProbeSink = 0;
+
+int main()
+{
+  sizeProbeAdcStream();
+  sizeProbeBootSequencer();
+  sizeProbeCanService();
+  sizeProbeDeferredLog();
+  sizeProbeDsp();
+  sizeProbeEspNowLink();
+  sizeProbeEspNowMesh();
+  sizeProbeEspNowTelemetry();
+  sizeProbeEspNowWire();
+  sizeProbeGpioInput();
+  sizeProbeGpioPort();
+  sizeProbeInstrumentation();
+  sizeProbeSeqLock();
+  sizeProbeStaticMemory();
+  sizeProbeTelemetry();
+  sizeProbeTimerScheduler();
+
+  printf("all module probes ran, sizes are per object: see scripts/module_size.py\n");
+  return 0;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file size_probes.h
+ * @brief one probe per shared library, each in its own translation unit so its object is that module's size
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a probe uses its module the way the examples do: the objects a firmware would keep are
+ * globals in the probe's file (they land in its .data / .bss) and the calls a firmware would
+ * make are in its function (they land in its .text). results go to sizeProbeSink so nothing
+ * is optimised away. scripts/module_size.py runs `size` over the objects and prints the table.
+ *
+ * Hal is the board itself and has no probe.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+extern volatile uint32_t sizeProbeSink;
+
+void sizeProbeAdcStream();
+void sizeProbeBootSequencer();
+void sizeProbeCanService();
+void sizeProbeDeferredLog();
+void sizeProbeDsp();
+void sizeProbeEspNowLink();
+void sizeProbeEspNowMesh();
+void sizeProbeEspNowTelemetry();
+void sizeProbeEspNowWire();
+void sizeProbeGpioInput();
+void sizeProbeGpioPort();
+void sizeProbeInstrumentation();
+void sizeProbeSeqLock();
+void sizeProbeStaticMemory();
+void sizeProbeTelemetry();
+void sizeProbeTimerScheduler();
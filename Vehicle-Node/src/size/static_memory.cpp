@@ -0,0 +1,28 @@
+/**
+ * @file static_memory.cpp
+ * @brief size probe: a pool and an arena with their memory report rows
+ */
+
+#include <memory_report.h>
+#include "size_probes.h"
+
+struct ProbeFrame
+{
+  uint8_t data[250];
+  uint8_t length;
+};
+
+StaticPool<ProbeFrame, 8> probePool;
+StaticArena<1024> probeArena;
+
+void sizeProbeStaticMemory()
+{
+  ProbeFrame* frame = probePool.create();
+  probePool.destroy(frame);
+  sizeProbeSink = probeArena.createArray<uint16_t>(16) != NULL;
+  probeArena.seal();
+
+  const MemorySource source = { "probe pool", &probePool, NULL, NULL };
+  char row[MEMORY_REPORT_ROW_SIZE];
+  sizeProbeSink = formatMemoryRow(row, sizeof(row), source);
+}
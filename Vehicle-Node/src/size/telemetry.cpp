@@ -0,0 +1,17 @@
+/**
+ * @file telemetry.cpp
+ * @brief size probe: one binary telemetry channel encoding a sample
+ */
+
+#include <telemetry.h>
+#include "size_probes.h"
+
+const char* const probeFields[] = { "a", "b", "c", "d" };
+TelemetryChannel probeChannel(1, "probe", probeFields, 4);
+
+void sizeProbeTelemetry()
+{
+  const int32_t values[] = { 1, -2, 3, (int32_t)sizeProbeSink };
+  uint8_t frames[128];
+  sizeProbeSink = (uint32_t)probeChannel.encode(frames, sizeof(frames), 0, values);
+}
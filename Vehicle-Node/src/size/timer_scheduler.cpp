@@ -0,0 +1,31 @@
+/**
+ * @file timer_scheduler.cpp
+ * @brief size probe: a timer wheel of eight timers and a set of event counters
+ */
+
+#include <timer_wheel.h>
+#include <event_counters.h>
+#include "size_probes.h"
+
+static void probeCallback(void* context)
+{
+  sizeProbeSink++;
+}
+
+TimerWheel<8> probeWheel;
+EventCounters<4> probeEvents;
+
+void sizeProbeTimerScheduler()
+{
+  probeWheel.start(1, 1, probeCallback, NULL, TIMER_RUN_IN_ISR);
+  probeWheel.start(100, 100, probeCallback, NULL, TIMER_RUN_DEFERRED);
+  for (int i = 0; i < 100; i++) {
+    probeWheel.tick();
+  }
+  sizeProbeSink = probeWheel.runDeferred();
+
+  probeEvents.increment(0);
+  EventCounterSnapshot<4> counts;
+  probeEvents.snapshot(counts);
+  sizeProbeSink = counts.total();
+}
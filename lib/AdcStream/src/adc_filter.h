@@ -0,0 +1,289 @@
+/**
+ * @file adc_filter.h
+ * @brief fixed-point decimation filters for streamed ADC samples: CIC, FIR and min / max / mean windows
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * one channel's raw 12 bit conversions go through
+ *
+ *   CIC       ADC_FILTER_CIC_STAGES integrator / comb pairs decimating by 2^ADC_FILTER_CIC_RATE_BITS.
+ *             adds only, in 32 bit registers that are allowed to wrap: the comb differences
+ *             come out right as long as the true output fits, which 12 bits plus the CIC gain
+ *             (stages x rate bits) does
+ *   FIR       ADC_FILTER_FIR_TAPS Q14 taps decimating by ADC_FILTER_FIR_DECIMATION, only every
+ *             D-th output is computed. it takes out what the CIC's sinc^N droop lets through
+ *             near the new Nyquist, see adcFirLowpass
+ *   window    min, max and mean of the FIR outputs, closed every windowOutputs outputs. the
+ *             first ADC_FILTER_SETTLE_OUTPUTS still carry the start from zero and are left out
+ *
+ * values after the CIC carry ADC_FILTER_FRACTION_BITS fractional bits (12.4, 0 - 65520), so
+ * averaging away noise gains resolution instead of rounding it off. no floats, no division
+ * per sample and no allocation, the same code runs in the ADC task and in the host tools.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#define ADC_FILTER_IRAM                   IRAM_ATTR
+#else
+#define ADC_FILTER_IRAM
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ADC_FILTER_INPUT_BITS             12
+#define ADC_FILTER_FRACTION_BITS          4           // extra resolution kept after the CIC
+#define ADC_FILTER_CIC_STAGES             3
+#define ADC_FILTER_CIC_RATE_BITS          3           // CIC decimates by 8
+#define ADC_FILTER_FIR_TAPS               16
+#define ADC_FILTER_FIR_DECIMATION         2
+#define ADC_FILTER_FIR_COEFFICIENT_BITS   14          // Q14, the taps sum to 1 << 14
+#define ADC_FILTER_DECIMATION             ((1 << ADC_FILTER_CIC_RATE_BITS) * ADC_FILTER_FIR_DECIMATION)
+#define ADC_FILTER_SETTLE_OUTPUTS         ((ADC_FILTER_FIR_TAPS + ADC_FILTER_CIC_STAGES * ADC_FILTER_FIR_DECIMATION) / ADC_FILTER_FIR_DECIMATION)
+
+/**
+ * @brief 16 tap Hamming windowed sinc, cutoff 0.22 of the CIC output rate: flat to 0.1,
+ * -11 dB at the new Nyquist (0.25), below -45 dB from 0.38 on
+ *
+ * the absolute taps sum to 22152, so a 12.4 sample (< 2^16) times them stays below 2^31
+ */
+static const int16_t adcFirLowpass[ADC_FILTER_FIR_TAPS] = {
+  -45, 41, 214, -29, -871, -497, 2785, 6594, 6594, 2785, -497, -871, -29, 214, 41, -45,
+};
+
+
+/*
+===============================================================================================
+                                    CIC Decimator
+===============================================================================================
+*/
+
+template <int Stages, int RateBits>
+class CicDecimator
+{
+public:
+  static const int RATE = 1 << RateBits;
+  static const int GAIN_BITS = Stages * RateBits;
+
+  static_assert(Stages >= 1 && Stages <= 5, "1 to 5 stages");
+  static_assert(ADC_FILTER_INPUT_BITS + GAIN_BITS <= 32, "the output must fit the 32 bit registers");
+  static_assert(GAIN_BITS >= ADC_FILTER_FRACTION_BITS, "not enough gain for the fraction bits");
+
+  CicDecimator() { reset(); }
+
+  void reset()
+  {
+    memset(integrators_, 0, sizeof(integrators_));
+    memset(combs_, 0, sizeof(combs_));
+    phase_ = 0;
+  }
+
+  /**
+   * @brief feed one input sample
+   *
+   * @param output receives the next output, scaled to the input's units with
+   * ADC_FILTER_FRACTION_BITS fractional bits, when this returns true
+   * @return true once every RATE inputs
+   */
+  ADC_FILTER_IRAM bool push(uint32_t sample, uint32_t& output)
+  {
+    uint32_t value = sample;
+    for (int i = 0; i < Stages; i++) {
+      integrators_[i] += value;
+      value = integrators_[i];
+    }
+    if (++phase_ < RATE) {
+      return false;
+    }
+    phase_ = 0;
+
+    for (int i = 0; i < Stages; i++) {
+      const uint32_t difference = value - combs_[i];
+      combs_[i] = value;
+      value = difference;
+    }
+    output = value >> (GAIN_BITS - ADC_FILTER_FRACTION_BITS);
+    return true;
+  }
+
+private:
+  uint32_t integrators_[Stages];
+  uint32_t combs_[Stages];
+  int phase_;
+};
+
+
+/*
+===============================================================================================
+                                    FIR Decimator
+===============================================================================================
+*/
+
+template <int Taps, int Decimation>
+class FirDecimator
+{
+public:
+  static_assert(Taps >= 1 && Decimation >= 1, "at least one tap");
+
+  /**
+   * @param coefficients Taps Q14 taps, must outlive the filter
+   */
+  explicit FirDecimator(const int16_t* coefficients) : coefficients_(coefficients) { reset(); }
+
+  void reset()
+  {
+    memset(history_, 0, sizeof(history_));
+    position_ = 0;
+    phase_ = 0;
+  }
+
+  /**
+   * @brief feed one input, 12.4 fixed point
+   * @return true once every Decimation inputs, with the filtered value in output
+   */
+  ADC_FILTER_IRAM bool push(uint32_t sample, uint32_t& output)
+  {
+    // every sample is stored twice, so the newest Taps are always one contiguous run
+    history_[position_] = (int32_t)sample;
+    history_[position_ + Taps] = (int32_t)sample;
+    position_ = position_ + 1 < Taps ? position_ + 1 : 0;
+    if (++phase_ < Decimation) {
+      return false;
+    }
+    phase_ = 0;
+
+    const int32_t* window = &history_[position_];
+    int32_t sum = 1 << (ADC_FILTER_FIR_COEFFICIENT_BITS - 1);
+    for (int i = 0; i < Taps; i++) {
+      sum += window[i] * coefficients_[i];
+    }
+    sum >>= ADC_FILTER_FIR_COEFFICIENT_BITS;
+    // a step rings past both ends of the range, clamp so the 16 bit snapshot cannot wrap
+    const int32_t full = ((1 << ADC_FILTER_INPUT_BITS) - 1) << ADC_FILTER_FRACTION_BITS;
+    output = sum < 0 ? 0 : (uint32_t)(sum > full ? full : sum);
+    return true;
+  }
+
+private:
+  const int16_t* coefficients_;
+  int32_t history_[2 * Taps];
+  int position_;
+  int phase_;
+};
+
+
+/*
+===============================================================================================
+                                    Channel Pipeline
+===============================================================================================
+*/
+
+/**
+ * @brief a channel's filtered value and its last closed window, 12.4 fixed point
+ */
+struct AdcChannelSnapshot
+{
+  uint16_t value = 0;                 // newest filter output
+  uint16_t min = 0;                   // over the last window
+  uint16_t max = 0;
+  uint16_t mean = 0;
+  uint32_t outputs = 0;               // filter outputs so far, settling ones included
+  uint32_t windows = 0;               // windows closed so far
+  int64_t windowEndUs = 0;            // when the last window closed
+};
+
+/**
+ * @brief CIC, FIR and window for one channel
+ */
+class AdcChannelFilter
+{
+public:
+  explicit AdcChannelFilter(uint16_t windowOutputs = 64) : fir_(adcFirLowpass) { setWindow(windowOutputs); }
+
+  void setWindow(uint16_t windowOutputs)
+  {
+    windowOutputs_ = windowOutputs != 0 ? windowOutputs : 1;
+    reset();
+  }
+
+  void reset()
+  {
+    cic_.reset();
+    fir_.reset();
+    snapshot_ = AdcChannelSnapshot();
+    openWindow();
+  }
+
+  /**
+   * @brief feed one raw conversion
+   * @return true when it closed a window, snapshot() then has new min / max / mean
+   */
+  ADC_FILTER_IRAM bool push(uint16_t raw, int64_t nowUs)
+  {
+    uint32_t value;
+    if (!cic_.push(raw, value) || !fir_.push(value, value)) {
+      return false;
+    }
+
+    snapshot_.value = (uint16_t)value;
+    if (++snapshot_.outputs <= ADC_FILTER_SETTLE_OUTPUTS) {
+      return false;
+    }
+    windowMin_ = value < windowMin_ ? value : windowMin_;
+    windowMax_ = value > windowMax_ ? value : windowMax_;
+    windowSum_ += value;
+    if (++windowCount_ < windowOutputs_) {
+      return false;
+    }
+
+    snapshot_.min = (uint16_t)windowMin_;
+    snapshot_.max = (uint16_t)windowMax_;
+    snapshot_.mean = (uint16_t)((windowSum_ + windowCount_ / 2) / windowCount_);
+    snapshot_.windows++;
+    snapshot_.windowEndUs = nowUs;
+    openWindow();
+    return true;
+  }
+
+  const AdcChannelSnapshot& snapshot() const { return snapshot_; }
+  bool settled() const { return snapshot_.outputs > ADC_FILTER_SETTLE_OUTPUTS; }
+  uint16_t windowOutputs() const { return windowOutputs_; }
+
+  /**
+   * @brief 12.4 fixed point back to whole ADC counts, rounded
+   */
+  static uint16_t counts(uint16_t value) { return (uint16_t)((value + (1 << (ADC_FILTER_FRACTION_BITS - 1))) >> ADC_FILTER_FRACTION_BITS); }
+
+private:
+  void openWindow()
+  {
+    windowMin_ = UINT32_MAX;
+    windowMax_ = 0;
+    windowSum_ = 0;
+    windowCount_ = 0;
+  }
+
+  CicDecimator<ADC_FILTER_CIC_STAGES, ADC_FILTER_CIC_RATE_BITS> cic_;
+  FirDecimator<ADC_FILTER_FIR_TAPS, ADC_FILTER_FIR_DECIMATION> fir_;
+  AdcChannelSnapshot snapshot_;
+  uint16_t windowOutputs_ = 64;
+  uint32_t windowMin_ = 0;
+  uint32_t windowMax_ = 0;
+  uint32_t windowSum_ = 0;            // 65520 x 65535 outputs at most, fits
+  uint32_t windowCount_ = 0;
+};
@@ -0,0 +1,328 @@
+/**
+ * @file adc_stream.h
+ * @brief continuous multi-channel ADC1 sampling through DMA, filtered per channel and published lock-free
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the ADC's digital controller converts the added channels round robin at a fixed rate and
+ * the DMA delivers the results in frames of ADC_STREAM_FRAME_BYTES (ESP-IDF 4.4 continuous
+ * mode, adc_digi_*). a task blocks on the driver for each frame, splits it by channel and runs
+ * every conversion through its channel's AdcChannelFilter (adc_filter.h), then publishes each
+ * channel's snapshot through a SeqLock. readers, from any task or ISR, get the newest filtered
+ * value and the last window's min / max / mean without touching the ADC or waiting on it:
+ *
+ *   AdcStream adc;
+ *   const int pedal = adc.add(ADC1_CHANNEL_6);           // GPIO 34
+ *   adc.begin();
+ *   ...
+ *   AdcChannelSnapshot snapshot;
+ *   if (adc.read(pedal, snapshot)) { use(AdcChannelFilter::counts(snapshot.mean)); }
+ *
+ * stats() says how many conversions arrived per second and what share of the time the task
+ * spent filtering them. ESP32 continuous mode runs ADC1 only (GPIO 32 - 39) at 20 kHz to
+ * 2 MHz in total. on the host the task is a periodic esp_timer polling the simulated driver
+ * once per frame, FreeRTOS is not simulated.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "driver/adc.h"
+#include <esp_timer.h>
+#include <seqlock.h>
+#include "adc_filter.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ADC_STREAM_MAX_CHANNELS           8           // ADC1
+#define ADC_STREAM_RESULT_BYTES           2           // one conversion in the DMA output, type 1 format
+#define ADC_STREAM_FRAME_BYTES            256         // one DMA frame, 128 conversions
+#define ADC_STREAM_STORE_BYTES            2048        // driver ring buffer, 8 frames of slack for the task
+#define ADC_STREAM_MIN_SAMPLE_RATE        20000       // ESP32 continuous mode limits
+#define ADC_STREAM_MAX_SAMPLE_RATE        2000000
+#define ADC_STREAM_TASK_STACK_SIZE        4096        // in bytes
+#define ADC_STREAM_TASK_PRIORITY          5
+
+/**
+ * @brief sampling setup, the rate is shared by all channels
+ */
+struct AdcStreamConfig
+{
+  uint32_t sampleRateHz = ADC_STREAM_MIN_SAMPLE_RATE;
+  uint16_t windowOutputs = 64;        // filter outputs per min / max / mean window
+  adc_atten_t attenuation = ADC_ATTEN_DB_11;
+  uint32_t taskPriority = ADC_STREAM_TASK_PRIORITY;
+};
+
+/**
+ * @brief throughput and cost of the stream since begin()
+ */
+struct AdcStreamStats
+{
+  uint32_t samples = 0;               // conversions filtered
+  uint32_t frames = 0;                // reads from the driver
+  uint32_t unknown = 0;               // conversions of a channel that was not added
+  int64_t startUs = 0;
+  int64_t lastUs = 0;                 // end of the last frame's processing
+  int64_t busyUs = 0;                 // time spent splitting and filtering
+
+  float samplesPerSecond() const { return lastUs > startUs ? samples * 1e6f / (float)(lastUs - startUs) : 0; }
+  float load() const { return lastUs > startUs ? (float)busyUs / (float)(lastUs - startUs) : 0; }
+};
+
+
+/*
+===============================================================================================
+                                    ADC Stream
+===============================================================================================
+*/
+
+class AdcStream
+{
+public:
+  AdcStream()
+  {
+    for (int i = 0; i < ADC_STREAM_MAX_CHANNELS; i++) {
+      indexOf_[i] = -1;
+    }
+  }
+
+  /**
+   * @brief sample a channel, before begin()
+   * @return its index for read(), -1 if the channel is invalid or already added
+   */
+  int add(adc1_channel_t channel)
+  {
+    if (channel < 0 || channel >= ADC_STREAM_MAX_CHANNELS || indexOf_[channel] >= 0) {
+      return -1;
+    }
+    channels_[count_] = channel;
+    indexOf_[channel] = (int8_t)count_;
+    return count_++;
+  }
+
+  /**
+   * @brief configure and start the ADC, then the task that filters its frames
+   * @return the first error from the driver, the task or the host's poll timer, nothing is left running then
+   */
+  esp_err_t begin(const AdcStreamConfig& config = AdcStreamConfig())
+  {
+    if (count_ == 0 || config.sampleRateHz < ADC_STREAM_MIN_SAMPLE_RATE || config.sampleRateHz > ADC_STREAM_MAX_SAMPLE_RATE) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    config_ = config;
+
+    adc_digi_init_config_t init;
+    memset(&init, 0, sizeof(init));
+    init.max_store_buf_size = ADC_STREAM_STORE_BYTES;
+    init.conv_num_each_intr = ADC_STREAM_FRAME_BYTES;
+    adc_digi_pattern_config_t pattern[ADC_STREAM_MAX_CHANNELS];
+    memset(pattern, 0, sizeof(pattern));
+    for (int i = 0; i < count_; i++) {
+      init.adc1_chan_mask |= 1u << channels_[i];
+      pattern[i].atten = config.attenuation;
+      pattern[i].channel = channels_[i];
+      pattern[i].unit = 0;                                  // ADC1
+      pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+      filters_[i].setWindow(config.windowOutputs);
+      snapshots_[i].publish(AdcChannelSnapshot());
+    }
+    esp_err_t result = adc_digi_initialize(&init);
+    if (result != ESP_OK) {
+      return result;
+    }
+
+    adc_digi_configuration_t controller;
+    memset(&controller, 0, sizeof(controller));
+    controller.conv_limit_en = true;                        // the ESP32 needs the limit on
+    controller.conv_limit_num = 250;
+    controller.pattern_num = count_;
+    controller.adc_pattern = pattern;
+    controller.sample_freq_hz = config.sampleRateHz;
+    controller.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    controller.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    result = adc_digi_controller_configure(&controller);
+    if (result == ESP_OK) {
+      result = adc_digi_start();
+    }
+    if (result != ESP_OK) {
+      adc_digi_deinitialize();
+      return result;
+    }
+
+    stats_ = AdcStreamStats();
+    stats_.startUs = esp_timer_get_time();
+    stats_.lastUs = stats_.startUs;
+    publishedStats_.publish(stats_);
+
+#ifdef ESP_PLATFORM
+    if (xTaskCreate(task, "ADC-Stream", ADC_STREAM_TASK_STACK_SIZE, this, config.taskPriority, &task_) != pdPASS) {
+      end();
+      return ESP_ERR_NO_MEM;
+    }
+#else
+    // one poll per frame
+    const esp_timer_create_args_t timerArgs = {
+      .callback = &poll,
+      .arg = this,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "ADC Stream",
+      .skip_unhandled_events = false,
+    };
+    const uint64_t frameUs = (uint64_t)ADC_STREAM_FRAME_BYTES / ADC_STREAM_RESULT_BYTES * 1000000 / config.sampleRateHz;
+    timer_ = NULL;
+    result = esp_timer_create(&timerArgs, &timer_);
+    if (result != ESP_OK) {
+      timer_ = NULL;
+      end();
+      return result;
+    }
+    result = esp_timer_start_periodic(timer_, frameUs);
+    if (result != ESP_OK) {
+      end();
+      return result;
+    }
+#endif
+    return ESP_OK;
+  }
+
+  void end()
+  {
+#ifdef ESP_PLATFORM
+    if (task_ != NULL) {
+      vTaskDelete(task_);
+      task_ = NULL;
+    }
+#else
+    if (timer_ != NULL) {
+      esp_timer_stop(timer_);
+      esp_timer_delete(timer_);
+      timer_ = NULL;
+    }
+#endif
+    adc_digi_stop();
+    adc_digi_deinitialize();
+  }
+
+  /**
+   * @brief wait for one frame and filter it, what the task does in a loop
+   * @return conversions processed, 0 if nothing arrived within the timeout
+   */
+  uint32_t process(uint32_t timeoutMs)
+  {
+    uint32_t length = 0;
+    if (adc_digi_read_bytes(buffer_, sizeof(buffer_), &length, timeoutMs) != ESP_OK || length == 0) {
+      return 0;
+    }
+
+    const int64_t startUs = esp_timer_get_time();
+    uint32_t touched = 0;
+    uint32_t filtered = 0;
+    const uint32_t conversions = length / ADC_STREAM_RESULT_BYTES;
+    for (uint32_t i = 0; i < conversions; i++) {
+      adc_digi_output_data_t result;
+      memcpy(&result, &buffer_[i * ADC_STREAM_RESULT_BYTES], ADC_STREAM_RESULT_BYTES);
+      const int index = result.type1.channel < ADC_STREAM_MAX_CHANNELS ? indexOf_[result.type1.channel] : -1;
+      if (index < 0) {
+        stats_.unknown++;
+        continue;
+      }
+      filters_[index].push(result.type1.data, startUs);
+      touched |= 1u << index;
+      filtered++;
+    }
+
+    // readers see every channel's newest output once per frame
+    for (int i = 0; i < count_; i++) {
+      if (touched & (1u << i)) {
+        snapshots_[i].publish(filters_[i].snapshot());
+      }
+    }
+
+    const int64_t endUs = esp_timer_get_time();
+    stats_.samples += filtered;
+    stats_.frames++;
+    stats_.busyUs += endUs - startUs;
+    stats_.lastUs = endUs;
+    publishedStats_.publish(stats_);
+    return conversions;
+  }
+
+  /**
+   * @brief the channel's newest filtered value and last window, from any context
+   * @return false until its first window has closed
+   */
+  bool read(int index, AdcChannelSnapshot& snapshot) const
+  {
+    if (index < 0 || index >= count_) {
+      return false;
+    }
+    snapshots_[index].read(snapshot);
+    return snapshot.windows > 0;
+  }
+
+  AdcStreamStats stats() const
+  {
+    AdcStreamStats stats;
+    publishedStats_.read(stats);
+    return stats;
+  }
+
+  int size() const { return count_; }
+  adc1_channel_t channel(int index) const { return channels_[index]; }
+
+  /**
+   * @brief filter outputs per second of each channel
+   */
+  uint32_t outputRateHz() const { return count_ != 0 ? config_.sampleRateHz / count_ / ADC_FILTER_DECIMATION : 0; }
+
+private:
+#ifdef ESP_PLATFORM
+  static void task(void* arg)
+  {
+    AdcStream& stream = *(AdcStream*)arg;
+    for (;;) {
+      stream.process(ADC_MAX_DELAY);
+    }
+  }
+
+  TaskHandle_t task_ = NULL;
+#else
+  static void poll(void* arg)
+  {
+    AdcStream& stream = *(AdcStream*)arg;
+    while (stream.process(0) != 0) {
+    }
+  }
+
+  esp_timer_handle_t timer_ = NULL;
+#endif
+
+  AdcStreamConfig config_;
+  adc1_channel_t channels_[ADC_STREAM_MAX_CHANNELS];
+  int8_t indexOf_[ADC_STREAM_MAX_CHANNELS];             // ADC1 channel to index, -1 if not sampled
+  int count_ = 0;
+  AdcChannelFilter filters_[ADC_STREAM_MAX_CHANNELS];
+  SeqLock<AdcChannelSnapshot> snapshots_[ADC_STREAM_MAX_CHANNELS];
+  AdcStreamStats stats_;                                // task side
+  SeqLock<AdcStreamStats> publishedStats_;
+  uint8_t buffer_[ADC_STREAM_FRAME_BYTES];
+};
@@ -0,0 +1,441 @@
+/**
+ * @file boot_sequencer.h
+ * @brief staged boot: independent subsystems start concurrently, a stage waits only on its dependencies
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * setup() adds its bring-up steps as stages, each a function that returns whether it worked,
+ * with the stages it depends on, and run() starts them. a stage starts as soon as everything
+ * it depends on is done; when several are ready at once, helper tasks take the extra ones so
+ * the CAN driver, the GPIO and the timers come up side by side on both cores:
+ *
+ *   BootSequencer boot;
+ *   const int serial = boot.add("serial", beginSerial, NULL);
+ *   const int can = boot.add("can driver", beginCanDriver, NULL);
+ *   boot.add("can tasks", beginCanTasks, NULL, BOOT_AFTER(can));
+ *   boot.run();
+ *   ...
+ *   boot.mark("first can frame");                     // once, from wherever it happens
+ *
+ * a stage may only depend on stages added before it, so there are no cycles to find. when a
+ * stage fails, everything that depends on it is skipped and run() returns false, the rest
+ * still boots. stages run on different tasks, so they must not share unprotected state with
+ * each other, and should log through the deferred logger rather than wait on the UART.
+ * interrupts are allocated on the core that asks for them (timerAttachInterrupt(),
+ * can_driver_install()), so a stage that attaches one passes BOOT_ON_CALLER and only ever
+ * runs on the task that called run(), core 1 for setup().
+ *
+ * every stage's start and end are kept as esp_timer times, which count from early in the
+ * app's startup, together with up to BOOT_MAX_MARKS milestones after boot. printBootReport()
+ * prints that profile on demand. helper tasks are ordinary heap tasks that delete themselves
+ * once nothing is left for them, boot runs once and the memory is back when it is over. they
+ * may still be on their way out when run() returns, so the sequencer is a global.
+ *
+ * the fixed wait for a serial monitor is opt-in: build with -DBOOT_ATTACH_DELAY=5000 and
+ * bootAttachDelay() waits that many milliseconds, otherwise it returns straight away.
+ *
+ * there is no FreeRTOS on the host, there run() takes the stages one by one in order on the
+ * calling thread, with the same dependency and skip rules. tools/boot_sequencer_test builds
+ * the threaded path on the host against a FreeRTOS stand-in and checks it over many boots.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#define BOOT_LOCK(lock)                   portENTER_CRITICAL(lock)
+#define BOOT_UNLOCK(lock)                 portEXIT_CRITICAL(lock)
+#else
+#include <chrono>
+#define BOOT_LOCK(lock)                   (void)(lock)
+#define BOOT_UNLOCK(lock)                 (void)(lock)
+#endif
+
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#ifndef BOOT_ATTACH_DELAY
+#define BOOT_ATTACH_DELAY                 0           // in milliseconds, time to attach a serial monitor
+#endif
+
+#define BOOT_MAX_STAGES                   16
+#define BOOT_MAX_MARKS                    4
+#define BOOT_WORKERS                      3           // the calling task and up to two helpers
+#define BOOT_HELPER_STACK_SIZE            4096        // in bytes, from the heap for the length of boot
+#define BOOT_ROW_SIZE                     96
+
+#define BOOT_AFTER(stage)                 (1UL << (stage))
+#define BOOT_ON_CALLER                    true        // for add(), the stage runs on the task that called run()
+
+/**
+ * @brief brings one subsystem up
+ * @return false if it failed, its dependents are then skipped
+ */
+typedef bool (*BootStageFunction)(void* context);
+
+enum BootStageState
+{
+  BOOT_STAGE_PENDING = 0,
+  BOOT_STAGE_RUNNING,
+  BOOT_STAGE_DONE,
+  BOOT_STAGE_FAILED,
+  BOOT_STAGE_SKIPPED,             // a dependency failed or was skipped
+};
+
+/**
+ * @brief one stage and its place in the boot profile, times in microseconds of esp_timer
+ */
+struct BootStage
+{
+  const char* name = "";
+  BootStageFunction function = NULL;
+  void* context = NULL;
+  uint32_t dependsOn = 0;             // BOOT_AFTER() of each stage it needs
+  bool onCaller = false;              // never handed to a helper
+  BootStageState state = BOOT_STAGE_PENDING;
+  int worker = -1;                    // 0 is the task that called run()
+  int64_t startUs = 0;
+  int64_t endUs = 0;
+};
+
+/**
+ * @brief something worth timing after boot, the first frame out for example
+ */
+struct BootMark
+{
+  const char* name = "";
+  int64_t atUs = 0;
+};
+
+inline const char* bootStageStateName(BootStageState state)
+{
+  switch (state) {
+    case BOOT_STAGE_PENDING:  return "pending";
+    case BOOT_STAGE_RUNNING:  return "running";
+    case BOOT_STAGE_DONE:     return "done";
+    case BOOT_STAGE_FAILED:   return "failed";
+    case BOOT_STAGE_SKIPPED:  return "skipped";
+  }
+  return "?";
+}
+
+/**
+ * @brief waits BOOT_ATTACH_DELAY milliseconds for a serial monitor, nothing by default
+ */
+inline void bootAttachDelay()
+{
+#if defined(ESP_PLATFORM) && BOOT_ATTACH_DELAY > 0
+  vTaskDelay(pdMS_TO_TICKS(BOOT_ATTACH_DELAY));
+#endif
+}
+
+inline int64_t bootNowUs()
+{
+#ifdef ESP_PLATFORM
+  return esp_timer_get_time();
+#else
+  static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+#endif
+}
+
+
+/*
+===============================================================================================
+                                    Sequencer
+===============================================================================================
+*/
+
+class BootSequencer
+{
+public:
+  BootSequencer() = default;
+  BootSequencer(const BootSequencer&) = delete;
+  BootSequencer& operator=(const BootSequencer&) = delete;
+
+  /**
+   * @brief add a stage, before run()
+   * @param dependsOn BOOT_AFTER() of earlier stages, or'ed together, 0 for none
+   * @param onCaller BOOT_ON_CALLER to keep the stage on the task that calls run()
+   * @return the stage's index for BOOT_AFTER(), -1 if it cannot be added
+   */
+  int add(const char* name, BootStageFunction function, void* context, uint32_t dependsOn = 0, bool onCaller = false)
+  {
+    if (started_ || count_ >= BOOT_MAX_STAGES || function == NULL || (dependsOn >> count_) != 0) {
+      return -1;
+    }
+    BootStage& stage = stages_[count_];
+    stage.name = name;
+    stage.function = function;
+    stage.context = context;
+    stage.dependsOn = dependsOn;
+    stage.onCaller = onCaller;
+    return count_++;
+  }
+
+  /**
+   * @brief run every stage and return once all are done, failed or skipped
+   * @return true if every stage succeeded
+   */
+  bool run()
+  {
+    if (started_) {
+      return false;
+    }
+    started_ = true;
+    beginUs_ = bootNowUs();
+
+#ifdef ESP_PLATFORM
+    progress_ = xSemaphoreCreateBinaryStatic(&progressBuffer_);
+    helperPriority_ = uxTaskPriorityGet(NULL);
+#endif
+    BOOT_LOCK(&lock_);
+    active_ = 1;
+    BOOT_UNLOCK(&lock_);
+    work(true);
+    endUs_ = bootNowUs();
+    return succeeded();
+  }
+
+  /**
+   * @brief record a milestone the first time it is reached, later calls with the same name are ignored
+   */
+  void mark(const char* name)
+  {
+    const int64_t now = bootNowUs();
+    BOOT_LOCK(&lock_);
+    bool known = false;
+    for (int i = 0; i < markCount_; i++) {
+      known = known || marks_[i].name == name;
+    }
+    if (!known && markCount_ < BOOT_MAX_MARKS) {
+      marks_[markCount_].name = name;
+      marks_[markCount_].atUs = now;
+      markCount_++;
+    }
+    BOOT_UNLOCK(&lock_);
+  }
+
+  bool succeeded() const
+  {
+    for (int i = 0; i < count_; i++) {
+      if (stages_[i].state != BOOT_STAGE_DONE) {
+        return false;
+      }
+    }
+    return started_;
+  }
+
+  int stageCount() const { return count_; }
+  const BootStage& stage(int index) const { return stages_[index]; }
+  int markCount() const { return markCount_; }
+  const BootMark& markAt(int index) const { return marks_[index]; }
+  int64_t beginUs() const { return beginUs_; }
+  int64_t endUs() const { return endUs_; }
+  int workersUsed() const { return workersUsed_; }  // the caller and every helper started
+
+private:
+  /**
+   * @brief one worker: take ready stages until none is left to take
+   * the caller stays until every stage is over, woken by the helpers as they finish stages
+   */
+  void work(bool caller)
+  {
+    BOOT_LOCK(&lock_);
+    const int worker = workersUsed_++;
+    BOOT_UNLOCK(&lock_);
+
+    for (;;) {
+      BOOT_LOCK(&lock_);
+      int spare = 0;
+      const int next = claim(worker, caller, spare);
+      if (next < 0) {
+        const bool over = !caller || closed_ == count_;
+        if (over) {
+          active_--;
+        }
+        BOOT_UNLOCK(&lock_);
+        if (over) {
+          return;
+        }
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(progress_, portMAX_DELAY);
+#endif
+        continue;
+      }
+#ifdef ESP_PLATFORM
+      // more ready than this worker can take, hand them to helpers
+      int helpers = spare < BOOT_WORKERS - active_ ? spare : BOOT_WORKERS - active_;
+      active_ += helpers;
+      BOOT_UNLOCK(&lock_);
+      for (; helpers > 0; helpers--) {
+        if (xTaskCreate(helperTask, "Boot", BOOT_HELPER_STACK_SIZE, this, helperPriority_, NULL) != pdPASS) {
+          // whoever finishes a stage next takes it instead
+          BOOT_LOCK(&lock_);
+          active_--;
+          BOOT_UNLOCK(&lock_);
+        }
+      }
+#else
+      (void)spare;
+      BOOT_UNLOCK(&lock_);
+#endif
+
+      BootStage& stage = stages_[next];
+      stage.startUs = bootNowUs();
+      const bool ok = stage.function(stage.context);
+      const int64_t end = bootNowUs();
+
+      BOOT_LOCK(&lock_);
+      stage.endUs = end;
+      stage.state = ok ? BOOT_STAGE_DONE : BOOT_STAGE_FAILED;
+      closed_++;
+      BOOT_UNLOCK(&lock_);
+#ifdef ESP_PLATFORM
+      if (!caller) {
+        xSemaphoreGive(progress_);
+      }
+#endif
+    }
+  }
+
+  /**
+   * @brief with the lock held: skip what cannot run, mark the first ready stage this worker may take running
+   * @param spare set to how many more ready stages a helper could take
+   * @return the claimed stage, -1 if none is ready
+   */
+  int claim(int worker, bool caller, int& spare)
+  {
+    int next = -1;
+    spare = 0;
+    for (int i = 0; i < count_; i++) {
+      BootStage& stage = stages_[i];
+      if (stage.state != BOOT_STAGE_PENDING) {
+        continue;
+      }
+
+      // dependencies come earlier, so skips cascade within this one pass
+      bool blocked = false;
+      bool broken = false;
+      for (int j = 0; j < i; j++) {
+        if (stage.dependsOn & BOOT_AFTER(j)) {
+          blocked = blocked || stages_[j].state == BOOT_STAGE_PENDING || stages_[j].state == BOOT_STAGE_RUNNING;
+          broken = broken || stages_[j].state == BOOT_STAGE_FAILED || stages_[j].state == BOOT_STAGE_SKIPPED;
+        }
+      }
+      if (broken) {
+        stage.state = BOOT_STAGE_SKIPPED;
+        closed_++;
+      }
+      else if (!blocked && next < 0 && (caller || !stage.onCaller)) {
+        next = i;
+        stage.state = BOOT_STAGE_RUNNING;
+        stage.worker = worker;
+      }
+      else if (!blocked && !stage.onCaller) {
+        spare++;
+      }
+    }
+    return next;
+  }
+
+#ifdef ESP_PLATFORM
+  static void helperTask(void* arg)
+  {
+    ((BootSequencer*)arg)->work(false);
+    vTaskDelete(NULL);
+  }
+#endif
+
+  BootStage stages_[BOOT_MAX_STAGES];
+  int count_ = 0;
+  int closed_ = 0;
+  int active_ = 0;
+  int workersUsed_ = 0;
+  bool started_ = false;
+  int64_t beginUs_ = 0;
+  int64_t endUs_ = 0;
+  BootMark marks_[BOOT_MAX_MARKS];
+  int markCount_ = 0;
+#ifdef ESP_PLATFORM
+  mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+  StaticSemaphore_t progressBuffer_;
+  SemaphoreHandle_t progress_ = NULL;           // given by helpers after every stage
+  UBaseType_t helperPriority_ = 1;
+#else
+  mutable int lock_ = 0;
+#endif
+};
+
+
+/*
+===============================================================================================
+                                    Report
+===============================================================================================
+*/
+
+inline const char* bootReportHeader()
+{
+  return "stage                state    worker    start us      end us    took us";
+}
+
+/**
+ * @brief one stage as a report row, without the newline
+ */
+inline int formatBootRow(char* out, size_t size, const BootStage& stage)
+{
+  return snprintf(out, size, "%-20s %-8s %6d %11lld %11lld %10lld", stage.name, bootStageStateName(stage.state), stage.worker,
+    (long long)stage.startUs, (long long)stage.endUs, (long long)(stage.endUs - stage.startUs));
+}
+
+/**
+ * @brief one milestone as a report row, without the newline
+ */
+inline int formatBootMarkRow(char* out, size_t size, const BootMark& mark)
+{
+  return snprintf(out, size, "%-20s %-8s %6s %11lld", mark.name, "mark", "", (long long)mark.atUs);
+}
+
+#ifdef ARDUINO
+
+/**
+ * @brief the whole boot profile: setup's run, every stage and the milestones so far
+ */
+inline void printBootReport(Print& out, const BootSequencer& boot)
+{
+  out.printf("\nboot: stages from %lld to %lld us, %lld us on %d tasks, %s\n", (long long)boot.beginUs(), (long long)boot.endUs(),
+    (long long)(boot.endUs() - boot.beginUs()), boot.workersUsed(), boot.succeeded() ? "all done" : "INCOMPLETE");
+  out.printf("%s\n", bootReportHeader());
+  char row[BOOT_ROW_SIZE];
+  for (int i = 0; i < boot.stageCount(); i++) {
+    formatBootRow(row, sizeof(row), boot.stage(i));
+    out.printf("%s\n", row);
+  }
+  for (int i = 0; i < boot.markCount(); i++) {
+    formatBootMarkRow(row, sizeof(row), boot.markAt(i));
+    out.printf("%s\n", row);
+  }
+}
+
+#endif
@@ -0,0 +1,286 @@
+/**
+ * @file can_dispatch.h
+ * @brief table driven CAN message dispatch and acceptance filter generation
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * messages are described once in a table of { id, dlc, handler } entries. the table is
+ * compiled into a direct lookup over the whole 11 bit ID space, and the same table produces
+ * the tightest single or dual acceptance filter so the controller drops everything else in
+ * hardware. requires C++17 (see build_flags in platformio.ini).
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/can.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_STANDARD_ID_COUNT             2048        // size of the 11 bit ID space
+#define CAN_STANDARD_ID_MASK              0x7FF
+
+// acceptance register layout for standard frames (mask bits set to 1 are "don't care")
+#define CAN_FILTER_SINGLE_ID_SHIFT        21
+#define CAN_FILTER_SINGLE_UNUSED_MASK     0x001FFFFF  // RTR and data bytes
+#define CAN_FILTER_DUAL_ID1_SHIFT         21
+#define CAN_FILTER_DUAL_ID2_SHIFT         5
+#define CAN_FILTER_DUAL_UNUSED_MASK       0x001F001F  // RTR bits and data byte nibbles
+
+
+/**
+ * @brief called with every accepted frame that matches a table entry
+ */
+typedef void (*CanMessageHandler)(const can_message_t& message);
+
+/**
+ * @brief one row of the message table
+ */
+struct CanMessageEntry
+{
+  uint16_t id;                    // 11 bit standard ID
+  uint8_t dlc;                    // expected data length code
+  CanMessageHandler handler;
+};
+
+/**
+ * @brief outcome of dispatching a single frame
+ */
+enum CanDispatchResult
+{
+  CAN_DISPATCH_HANDLED,
+  CAN_DISPATCH_UNKNOWN_ID,        // not in the table (or an extended frame)
+  CAN_DISPATCH_BAD_DLC,           // in the table but the length did not match
+};
+
+
+/*
+===============================================================================================
+                                    Filter Math
+===============================================================================================
+*/
+
+/**
+ * @brief number of set bits, usable in constant expressions
+ */
+constexpr uint32_t canFilterPopCount(uint32_t value)
+{
+  uint32_t count = 0;
+  while (value) {
+    value &= value - 1;
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief acceptance code / don't care pair covering a group of IDs
+ */
+struct CanIdMatch
+{
+  uint16_t code;
+  uint16_t dontCare;
+
+  // number of IDs the pair lets through
+  constexpr uint32_t acceptedCount() const { return 1u << canFilterPopCount(dontCare); }
+};
+
+/**
+ * @brief smallest code / mask pair that matches every ID in the list
+ *
+ * @param ids the IDs to cover
+ * @param count number of entries in ids
+ * @param skipBit only use IDs whose bit skipBit equals skipValue, -1 to use all of them
+ * @param skipValue see skipBit
+ */
+constexpr CanIdMatch canFilterCover(const uint16_t* ids, size_t count, int skipBit = -1, uint16_t skipValue = 0)
+{
+  bool first = true;
+  CanIdMatch match = { 0, 0 };
+
+  for (size_t i = 0; i < count; i++) {
+    if (skipBit >= 0 && ((ids[i] >> skipBit) & 1) != skipValue) {
+      continue;
+    }
+
+    if (first) {
+      match.code = ids[i];
+      first = false;
+    }
+    else {
+      match.dontCare |= ids[i] ^ match.code;
+    }
+  }
+  match.code &= ~match.dontCare & CAN_STANDARD_ID_MASK;
+
+  return match;
+}
+
+/**
+ * @brief build the tightest acceptance filter for a list of standard IDs
+ * tries one filter over every ID and every way of splitting the IDs in two on a single
+ * ID bit, keeping whichever lets the fewest IDs through
+ *
+ * @param ids the IDs to accept
+ * @param count number of entries in ids, must be at least 1
+ */
+constexpr can_filter_config_t canFilterForIds(const uint16_t* ids, size_t count)
+{
+  const CanIdMatch single = canFilterCover(ids, count);
+
+  uint32_t bestCost = single.acceptedCount();
+  CanIdMatch bestFirst = single;
+  CanIdMatch bestSecond = single;
+  bool useSingle = true;
+
+  for (int bit = 0; bit < 11; bit++) {
+    // both halves need at least one ID for the split to mean anything
+    size_t ones = 0;
+    for (size_t i = 0; i < count; i++) {
+      ones += (ids[i] >> bit) & 1;
+    }
+    if (ones == 0 || ones == count) {
+      continue;
+    }
+
+    const CanIdMatch first = canFilterCover(ids, count, bit, 0);
+    const CanIdMatch second = canFilterCover(ids, count, bit, 1);
+    const uint32_t cost = first.acceptedCount() + second.acceptedCount();
+    if (cost < bestCost) {
+      bestCost = cost;
+      bestFirst = first;
+      bestSecond = second;
+      useSingle = false;
+    }
+  }
+
+  if (useSingle) {
+    return {
+      (uint32_t)single.code << CAN_FILTER_SINGLE_ID_SHIFT,
+      ((uint32_t)single.dontCare << CAN_FILTER_SINGLE_ID_SHIFT) | CAN_FILTER_SINGLE_UNUSED_MASK,
+      true
+    };
+  }
+
+  return {
+    ((uint32_t)bestFirst.code << CAN_FILTER_DUAL_ID1_SHIFT) | ((uint32_t)bestSecond.code << CAN_FILTER_DUAL_ID2_SHIFT),
+    ((uint32_t)bestFirst.dontCare << CAN_FILTER_DUAL_ID1_SHIFT) | ((uint32_t)bestSecond.dontCare << CAN_FILTER_DUAL_ID2_SHIFT) | CAN_FILTER_DUAL_UNUSED_MASK,
+    false
+  };
+}
+
+
+/*
+===============================================================================================
+                                    Dispatch Table
+===============================================================================================
+*/
+
+/**
+ * @brief not constexpr on purpose: reaching it while a constexpr table is built stops the
+ * compile, and the compiler's error names this function
+ */
+inline void canDispatchTableHasDuplicateId()
+{
+}
+
+/**
+ * @brief message table compiled into an O(1) lookup over the standard ID space
+ * costs one byte of flash per possible ID when declared constexpr. an ID listed twice fails
+ * the build of a constexpr table, a table built at run time keeps the first entry
+ *
+ * @tparam N number of messages in the table
+ */
+template <size_t N>
+class CanDispatchTable
+{
+  static_assert(N > 0 && N < 255, "table must have between 1 and 254 messages");
+
+public:
+  constexpr explicit CanDispatchTable(const CanMessageEntry (&entries)[N]) : entries_{}, ids_{}, lookup_{}
+  {
+    for (size_t i = 0; i < N; i++) {
+      entries_[i] = entries[i];
+      ids_[i] = entries[i].id & CAN_STANDARD_ID_MASK;
+      if (lookup_[ids_[i]] != 0) {
+        canDispatchTableHasDuplicateId();
+        continue;
+      }
+
+      // 0 marks an empty slot, so entries are stored one higher than their index
+      lookup_[ids_[i]] = (uint8_t)(i + 1);
+    }
+  }
+
+  /**
+   * @brief hand a frame to its handler
+   *
+   * @param message the received frame
+   */
+  CanDispatchResult dispatch(const can_message_t& message) const
+  {
+    if ((message.flags & CAN_MSG_FLAG_EXTD) || message.identifier > CAN_STANDARD_ID_MASK) {
+      return CAN_DISPATCH_UNKNOWN_ID;
+    }
+
+    const uint8_t slot = lookup_[message.identifier];
+    if (slot == 0) {
+      return CAN_DISPATCH_UNKNOWN_ID;
+    }
+
+    const CanMessageEntry& entry = entries_[slot - 1];
+    if (message.data_length_code != entry.dlc) {
+      return CAN_DISPATCH_BAD_DLC;
+    }
+
+    entry.handler(message);
+    return CAN_DISPATCH_HANDLED;
+  }
+
+  /**
+   * @brief hardware acceptance filter that lets through every ID in the table
+   */
+  constexpr can_filter_config_t filterConfig() const
+  {
+    return canFilterForIds(ids_, N);
+  }
+
+  /**
+   * @brief look up the table entry for an ID, NULL if there is none
+   */
+  constexpr const CanMessageEntry* find(uint16_t id) const
+  {
+    return (id <= CAN_STANDARD_ID_MASK && lookup_[id] != 0) ? &entries_[lookup_[id] - 1] : NULL;
+  }
+
+  static constexpr size_t size() { return N; }
+
+private:
+  CanMessageEntry entries_[N];
+  uint16_t ids_[N];
+  uint8_t lookup_[CAN_STANDARD_ID_COUNT];
+};
+
+
+/**
+ * @brief build a dispatch table from a message table, usually as a constexpr global
+ *
+ * @param entries the message table
+ */
+template <size_t N>
+constexpr CanDispatchTable<N> makeCanDispatchTable(const CanMessageEntry (&entries)[N])
+{
+  return CanDispatchTable<N>(entries);
+}
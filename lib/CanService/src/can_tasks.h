@@ -0,0 +1,131 @@
+/**
+ * @file can_tasks.h
+ * @brief the steps of a CAN node's write, read and process tasks, and bringing up its driver
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a node runs serviceCanTx() in its write task on every scheduler tick, readCanFrame() in its
+ * read task and dispatchCanFrame() in its process task, with its own message table. what a
+ * task does around its step (latency, notifications, logging) stays in the node. the
+ * simulations and tests run the same steps back to back from a tick timer.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/can.h"
+#include "spsc_ring.h"
+#include "can_dispatch.h"
+#include "can_tx_scheduler.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+/**
+ * @brief frames the process task could not hand to a handler
+ */
+struct CanRxErrors
+{
+  uint32_t unknownId = 0;
+  uint32_t badDlc = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Driver
+===============================================================================================
+*/
+
+/**
+ * @brief install and start the controller with every alert tracked
+ *
+ * @param filter usually the message table's filterConfig()
+ * @param failedStep set to "INIT", "STARTED" or "ALERTS" when that step fails, may be NULL
+ * @return ESP_OK once the driver is running, else the failed step's error
+ */
+inline esp_err_t startCanDriver(const can_general_config_t& general, const can_timing_config_t& timing,
+  const can_filter_config_t& filter, const char** failedStep = NULL)
+{
+  esp_err_t err = can_driver_install(&general, &timing, &filter);
+  const char* step = "INIT";
+  if (err == ESP_OK) {
+    err = can_start();
+    step = "STARTED";
+  }
+  if (err == ESP_OK) {
+    err = can_reconfigure_alerts(CAN_ALERT_ALL, NULL);
+    step = "ALERTS";
+  }
+
+  if (err != ESP_OK && failedStep != NULL) {
+    *failedStep = step;
+  }
+  return err;
+}
+
+
+/*
+===============================================================================================
+                                    Task Steps
+===============================================================================================
+*/
+
+/**
+ * @brief one pass of the write task: count bus errors and recover from bus-off, then send
+ * whatever is due, never blocks on the driver
+ */
+inline void serviceCanTx(CanTxScheduler& scheduler, int64_t nowUs)
+{
+  uint32_t alerts;
+  if (can_read_alerts(&alerts, 0) == ESP_OK) {
+    scheduler.handleAlerts(alerts);
+  }
+  scheduler.service(nowUs);
+}
+
+/**
+ * @brief one pass of the read task: take a frame off the driver's RX queue and hand it to the
+ * ring, a full ring is counted as an overflow, never waited on
+ *
+ * @return false if no frame came within the timeout, or the driver is not running
+ */
+template <size_t Capacity>
+inline bool readCanFrame(SpscRing<can_message_t, Capacity>& ring, TickType_t timeout)
+{
+  can_message_t message;
+  if (can_receive(&message, timeout) != ESP_OK) {
+    return false;
+  }
+  ring.push(message);
+  return true;
+}
+
+/**
+ * @brief one frame of the process task: hand it to its handler in the node's table, count it
+ * if there is none
+ */
+template <size_t N>
+inline CanDispatchResult dispatchCanFrame(const CanDispatchTable<N>& table, const can_message_t& message, CanRxErrors& errors)
+{
+  const CanDispatchResult result = table.dispatch(message);
+  if (result == CAN_DISPATCH_UNKNOWN_ID) {
+    errors.unknownId++;
+  }
+  else if (result == CAN_DISPATCH_BAD_DLC) {
+    errors.badDlc++;
+  }
+  return result;
+}
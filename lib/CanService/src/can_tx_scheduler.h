@@ -0,0 +1,278 @@
+/**
+ * @file can_tx_scheduler.h
+ * @brief non-blocking CAN transmit scheduler for periodic and on-change messages
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * service() is called from a single task on a fast tick. it never waits on the driver:
+ * every can_transmit() uses a timeout of 0, and a message the driver could not take stays
+ * in the retry set and goes out first (in priority order) on a later tick. a periodic
+ * message that is still waiting when its next period starts counts as a deadline miss.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "driver/can.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_TX_MAX_MESSAGES               32          // one bit per message in the retry set
+#define CAN_TX_INVALID_HANDLE             -1
+
+
+/**
+ * @brief called right before a periodic message is handed to the driver, fills in fresh data
+ */
+typedef void (*CanTxFillCallback)(can_message_t& message);
+
+/**
+ * @brief transmit and bus health counters, plain 32 bit words so other tasks may read them
+ */
+struct CanTxStats
+{
+  uint32_t sent = 0;                // frames accepted by the driver
+  uint32_t queueFull = 0;           // attempts rejected because the driver TX queue was full
+  uint32_t deadlineMisses = 0;      // periods that started before the previous frame went out
+  uint32_t errors = 0;              // frames dropped because the driver rejected them
+  uint32_t busOffEvents = 0;
+  uint32_t busRecoveries = 0;
+  uint32_t txFailed = 0;            // frames the controller gave up on
+  uint32_t arbitrationLost = 0;
+  uint32_t errorPassive = 0;
+  uint32_t rxQueueFull = 0;         // frames lost because the driver RX queue was full
+};
+
+
+/*
+===============================================================================================
+                                    Scheduler
+===============================================================================================
+*/
+
+class CanTxScheduler
+{
+public:
+  /**
+   * @brief add a message sent every periodUs microseconds
+   *
+   * @param message frame template, copied into the scheduler
+   * @param periodUs period in microseconds
+   * @param priority higher numbers go out first when several messages are due
+   * @param fill optional callback to refresh the payload before each send
+   * @return handle for the message, or CAN_TX_INVALID_HANDLE if the scheduler is full
+   */
+  int addPeriodic(const can_message_t& message, uint32_t periodUs, uint8_t priority, CanTxFillCallback fill = NULL)
+  {
+    int handle = add(message, priority);
+    if (handle != CAN_TX_INVALID_HANDLE) {
+      entries_[handle].periodUs = periodUs;
+      entries_[handle].fill = fill;
+    }
+    return handle;
+  }
+
+  /**
+   * @brief add a message that is only sent when update() or markChanged() is called
+   *
+   * @param message frame template, copied into the scheduler
+   * @param priority higher numbers go out first when several messages are due
+   * @return handle for the message, or CAN_TX_INVALID_HANDLE if the scheduler is full
+   */
+  int addOnChange(const can_message_t& message, uint8_t priority)
+  {
+    return add(message, priority);
+  }
+
+  /**
+   * @brief replace the payload of a message, on-change messages are queued if the data differs
+   *
+   * @param handle the message to update
+   * @param data new payload
+   * @param length payload length (becomes the DLC), at most 8
+   */
+  void update(int handle, const uint8_t* data, uint8_t length)
+  {
+    Entry& entry = entries_[handle];
+    if (length > 8) {
+      length = 8;
+    }
+
+    bool changed = length != entry.message.data_length_code || memcmp(entry.message.data, data, length) != 0;
+    memcpy(entry.message.data, data, length);
+    entry.message.data_length_code = length;
+
+    if (changed && entry.periodUs == 0) {
+      markChanged(handle);
+    }
+  }
+
+  /**
+   * @brief queue an on-change message for the next service() call
+   */
+  void markChanged(int handle)
+  {
+    pendingMask_ |= 1u << handle;
+  }
+
+  /**
+   * @brief queue due periodic messages and push as many pending frames as the driver will take
+   *
+   * @param nowUs current time in microseconds (esp_timer_get_time())
+   */
+  void service(int64_t nowUs)
+  {
+    // release periodic messages whose period has started
+    for (int i = 0; i < count_; i++) {
+      Entry& entry = entries_[i];
+      if (entry.periodUs != 0 && entry.nextDueUs == 0) {
+        // first tick since the message was added, send it right away
+        entry.nextDueUs = nowUs;
+      }
+      if (entry.periodUs == 0 || nowUs < entry.nextDueUs) {
+        continue;
+      }
+
+      const uint32_t bit = 1u << i;
+      if (pendingMask_ & bit) {
+        stats_.deadlineMisses++;
+      }
+      pendingMask_ |= bit;
+
+      // skip whole periods we slept through instead of bursting to catch up
+      entry.nextDueUs += entry.periodUs;
+      if (entry.nextDueUs <= nowUs) {
+        int64_t behind = (nowUs - entry.nextDueUs) / entry.periodUs + 1;
+        stats_.deadlineMisses += (uint32_t)behind;
+        entry.nextDueUs += behind * entry.periodUs;
+      }
+    }
+
+    // nothing can go out while the controller is recovering
+    if (busOff_) {
+      return;
+    }
+
+    // send in priority order until the driver queue is full
+    for (int i = 0; i < count_ && pendingMask_; i++) {
+      const int handle = order_[i];
+      const uint32_t bit = 1u << handle;
+      if (!(pendingMask_ & bit)) {
+        continue;
+      }
+
+      Entry& entry = entries_[handle];
+      if (entry.fill != NULL) {
+        entry.fill(entry.message);
+      }
+
+      esp_err_t result = can_transmit(&entry.message, 0);
+      if (result == ESP_OK) {
+        pendingMask_ &= ~bit;
+        stats_.sent++;
+      }
+      else if (result == ESP_ERR_TIMEOUT) {
+        // driver queue is full, leave everything else pending for the next tick
+        stats_.queueFull++;
+        break;
+      }
+      else if (result == ESP_ERR_INVALID_STATE) {
+        // driver is stopped or bus-off, the alerts will tell us when it is back
+        break;
+      }
+      else {
+        pendingMask_ &= ~bit;
+        stats_.errors++;
+      }
+    }
+  }
+
+  /**
+   * @brief count bus alerts and drive bus-off recovery
+   *
+   * @param alerts alert bits from can_read_alerts()
+   */
+  void handleAlerts(uint32_t alerts)
+  {
+    if (alerts & CAN_ALERT_BUS_OFF) {
+      stats_.busOffEvents++;
+      busOff_ = true;
+      can_initiate_recovery();
+    }
+    if (alerts & CAN_ALERT_BUS_RECOVERED) {
+      stats_.busRecoveries++;
+      if (can_start() == ESP_OK) {
+        busOff_ = false;
+      }
+    }
+    if (alerts & CAN_ALERT_TX_FAILED) {
+      stats_.txFailed++;
+    }
+    if (alerts & CAN_ALERT_ARB_LOST) {
+      stats_.arbitrationLost++;
+    }
+    if (alerts & CAN_ALERT_ERR_PASS) {
+      stats_.errorPassive++;
+    }
+    if (alerts & CAN_ALERT_RX_QUEUE_FULL) {
+      stats_.rxQueueFull++;
+    }
+  }
+
+  const CanTxStats& stats() const { return stats_; }
+  bool busOff() const { return busOff_; }
+  int size() const { return count_; }
+
+private:
+  struct Entry
+  {
+    can_message_t message;
+    uint32_t periodUs;              // 0 for on-change messages
+    int64_t nextDueUs;
+    uint8_t priority;
+    CanTxFillCallback fill;
+  };
+
+  /**
+   * @brief store a message and slot it into the priority order
+   */
+  int add(const can_message_t& message, uint8_t priority)
+  {
+    if (count_ >= CAN_TX_MAX_MESSAGES) {
+      return CAN_TX_INVALID_HANDLE;
+    }
+
+    const int handle = count_++;
+    entries_[handle] = { message, 0, 0, priority, NULL };
+
+    // insertion sort, highest priority first, equal priorities keep insertion order
+    int position = handle;
+    while (position > 0 && entries_[order_[position - 1]].priority < priority) {
+      order_[position] = order_[position - 1];
+      position--;
+    }
+    order_[position] = (uint8_t)handle;
+
+    return handle;
+  }
+
+  Entry entries_[CAN_TX_MAX_MESSAGES];
+  uint8_t order_[CAN_TX_MAX_MESSAGES];          // handles sorted by priority
+  int count_ = 0;
+  uint32_t pendingMask_ = 0;                    // retry set, one bit per handle
+  bool busOff_ = false;
+  CanTxStats stats_;
+};
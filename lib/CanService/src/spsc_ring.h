@@ -0,0 +1,129 @@
+/**
+ * @file spsc_ring.h
+ * @brief lock-free single-producer / single-consumer ring buffer
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * exactly one task may call push() and exactly one task may call pop(), the two
+ * may run on different cores. the head and tail indices live on their own cache
+ * lines so the producer and consumer do not fight over the same line.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#ifndef SPSC_CACHE_LINE_SIZE
+#define SPSC_CACHE_LINE_SIZE              64          // in bytes
+#endif
+
+
+/*
+===============================================================================================
+                                    Ring Buffer
+===============================================================================================
+*/
+
+/**
+ * @brief fixed capacity ring of T, capacity must be a power of two
+ *
+ * @tparam T element type, copied in and out by value
+ * @tparam Capacity number of slots
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  /**
+   * @brief copy an element into the ring, never blocks
+   *
+   * @param item the element to copy
+   * @return true if stored, false if the ring was full (the overflow counter is bumped)
+   */
+  bool push(const T& item)
+  {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    const uint32_t used = head - tail;
+
+    if (used >= Capacity) {
+      overflowCount_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    slots_[head & (Capacity - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+
+    // only the producer writes the high water mark
+    if (used + 1 > highWaterMark_.load(std::memory_order_relaxed)) {
+      highWaterMark_.store(used + 1, std::memory_order_relaxed);
+    }
+    pushCount_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * @brief copy the oldest element out of the ring, never blocks
+   *
+   * @param item where to copy the element
+   * @return true if an element was returned, false if the ring was empty
+   */
+  bool pop(T& item)
+  {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+
+    if (head == tail) {
+      return false;
+    }
+
+    item = slots_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief number of elements waiting, exact only when called from the producer or consumer
+   */
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return Capacity; }
+
+  // statistics, safe to read from any task
+  uint32_t pushCount() const { return pushCount_.load(std::memory_order_relaxed); }
+  uint32_t overflowCount() const { return overflowCount_.load(std::memory_order_relaxed); }
+  uint32_t highWaterMark() const { return highWaterMark_.load(std::memory_order_relaxed); }
+
+private:
+  // producer owned
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> pushCount_{0};
+  std::atomic<uint32_t> overflowCount_{0};
+  std::atomic<uint32_t> highWaterMark_{0};
+
+  // consumer owned
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> tail_{0};
+
+  alignas(SPSC_CACHE_LINE_SIZE) T slots_[Capacity];
+};
@@ -0,0 +1,635 @@
+/**
+ * @file deferred_log.h
+ * @brief non-blocking logger: callers queue binary records, a low priority task formats them
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * LOG_PRINTF() costs the caller a format pointer, a timestamp and a copy of the raw arguments
+ * into a lock-free multi-producer ring. nothing is formatted and the UART is never touched,
+ * so it is safe from tasks, Wi-Fi callbacks and ISRs. when the ring is full the record is
+ * dropped and counted, the caller never waits.
+ *
+ * a low priority drain task pops the records, formats them and writes them out no faster
+ * than the configured baud rate and never more than the UART buffer has room for, so it
+ * never blocks either. drops are reported in the output stream. tools/deferred_log_bench
+ * measures what a call costs the caller next to Serial.printf.
+ *
+ * arguments are stored as 32 bit words: integers up to 32 bits, pointers, and float / double
+ * (as float). string arguments are copied into the record (up to DEFERRED_LOG_TEXT_SIZE bytes
+ * in total), so they may point at stack buffers. 64 bit integers do not compile.
+ *
+ * binary mode (DEFERRED_LOG_BINARY) skips formatting on the device and sends the records as a
+ * self-describing stream instead, see tools/log_decoder for the host side:
+ *
+ *   format definition   0xA5 'F' id:u16 length:u16 text
+ *   record              0xA5 'R' id:u16 timestampUs:u32 argc:u8 types:u16 args...
+ *                       (word and float args are 4 bytes, strings are length:u8 + bytes)
+ *   drops               0xA5 'D' total:u32
+ *
+ * all multi-byte fields are little endian. format IDs are assigned in order of first use and
+ * every definition is sent again after DEFERRED_LOG_REDEFINE_INTERVAL records, so a decoder
+ * that attaches late catches up.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#define DEFERRED_LOG_IRAM                 IRAM_ATTR
+#else
+#define DEFERRED_LOG_IRAM
+#endif
+
+#ifdef ARDUINO
+#include <HardwareSerial.h>
+#include <static_task.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#ifndef DEFERRED_LOG_CAPACITY
+#define DEFERRED_LOG_CAPACITY             64          // records, power of two
+#endif
+
+#ifndef DEFERRED_LOG_STACK_SIZE
+#define DEFERRED_LOG_STACK_SIZE           4096        // drain task, in bytes, static
+#endif
+
+#define DEFERRED_LOG_MAX_ARGS             6
+#define DEFERRED_LOG_TEXT_SIZE            24          // bytes shared by all string arguments of one record
+#define DEFERRED_LOG_LINE_SIZE            160         // longest formatted message or format definition
+#define DEFERRED_LOG_MAX_FORMATS          64          // format IDs tracked in binary mode
+#define DEFERRED_LOG_REDEFINE_INTERVAL    1000        // records between full resends of the format table
+
+#define DEFERRED_LOG_SYNC                 0xA5
+#define DEFERRED_LOG_FRAME_FORMAT         'F'
+#define DEFERRED_LOG_FRAME_RECORD         'R'
+#define DEFERRED_LOG_FRAME_DROPS          'D'
+
+
+/**
+ * @brief how a stored argument is formatted
+ */
+enum DeferredLogArgType : uint8_t
+{
+  DEFERRED_LOG_ARG_WORD = 0,      // integer, char, bool or pointer
+  DEFERRED_LOG_ARG_FLOAT = 1,     // float bits
+  DEFERRED_LOG_ARG_STRING = 2,    // offset into the record's text
+};
+
+/**
+ * @brief what the drain task writes
+ */
+enum DeferredLogMode : uint8_t
+{
+  DEFERRED_LOG_TEXT,              // formatted text, same as Serial.printf would have printed
+  DEFERRED_LOG_BINARY,            // self-describing binary records for tools/log_decoder
+};
+
+/**
+ * @brief one queued log call
+ */
+struct DeferredLogRecord
+{
+  const char* format;             // must be a string literal, its address is its ID
+  uint32_t timestampUs;
+  uint8_t argc;
+  uint8_t textUsed;
+  uint16_t types;                 // 2 bits per argument, DeferredLogArgType
+  uint32_t args[DEFERRED_LOG_MAX_ARGS];
+  char text[DEFERRED_LOG_TEXT_SIZE];
+
+  DeferredLogArgType type(int index) const { return (DeferredLogArgType)((types >> (index * 2)) & 0x3); }
+  const char* string(int index) const { return text + args[index]; }
+};
+
+
+/*
+===============================================================================================
+                                    Argument Capture
+===============================================================================================
+*/
+
+namespace deferred_log_detail {
+
+inline void setType(DeferredLogRecord& record, DeferredLogArgType type)
+{
+  record.types |= (uint16_t)(type << (record.argc * 2));
+}
+
+inline DEFERRED_LOG_IRAM void addString(DeferredLogRecord& record, const char* value)
+{
+  // copy as much as fits, an empty string if nothing does
+  const uint8_t offset = record.textUsed < DEFERRED_LOG_TEXT_SIZE ? record.textUsed : DEFERRED_LOG_TEXT_SIZE - 1;
+  size_t room = DEFERRED_LOG_TEXT_SIZE - offset - 1;
+  size_t length = 0;
+  if (value == NULL) {
+    value = "(null)";
+  }
+  while (length < room && value[length] != '\0') {
+    record.text[offset + length] = value[length];
+    length++;
+  }
+  record.text[offset + length] = '\0';
+  record.textUsed = (uint8_t)(offset + length + 1);
+
+  setType(record, DEFERRED_LOG_ARG_STRING);
+  record.args[record.argc++] = offset;
+}
+
+template <typename T>
+typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4>::type
+addArg(DeferredLogRecord& record, T value)
+{
+  setType(record, DEFERRED_LOG_ARG_WORD);
+  record.args[record.argc++] = (uint32_t)value;
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+addArg(DeferredLogRecord& record, T value)
+{
+  float f = (float)value;
+  setType(record, DEFERRED_LOG_ARG_FLOAT);
+  memcpy(&record.args[record.argc++], &f, sizeof(f));
+}
+
+inline void addArg(DeferredLogRecord& record, const char* value) { addString(record, value); }
+inline void addArg(DeferredLogRecord& record, char* value) { addString(record, value); }
+
+inline void addArg(DeferredLogRecord& record, const void* value)
+{
+  setType(record, DEFERRED_LOG_ARG_WORD);
+  record.args[record.argc++] = (uint32_t)(uintptr_t)value;
+}
+
+inline void addArgs(DeferredLogRecord&) {}
+
+template <typename T, typename... Rest>
+void addArgs(DeferredLogRecord& record, T value, Rest... rest)
+{
+  addArg(record, value);
+  addArgs(record, rest...);
+}
+
+} // namespace deferred_log_detail
+
+
+/*
+===============================================================================================
+                                    Formatter
+===============================================================================================
+*/
+
+/**
+ * @brief printf a record's format with its stored arguments
+ * used by the drain task and by the host decoder. length modifiers (l, h, z) are ignored since
+ * every argument is 32 bits, a conversion that does not match its argument prints as '?'
+ *
+ * @return length of the formatted text, truncated to size - 1
+ */
+inline size_t deferredLogFormat(char* out, size_t size, const char* format, const uint32_t* args, const DeferredLogArgType* types, const char* const* strings, int argc)
+{
+  size_t used = 0;
+  int arg = 0;
+
+  const auto append = [&](const char* text, size_t length) {
+    while (length-- > 0 && used + 1 < size) {
+      out[used++] = *text++;
+    }
+  };
+
+  while (*format != '\0') {
+    if (*format != '%') {
+      append(format++, 1);
+      continue;
+    }
+    if (format[1] == '%') {
+      append("%", 1);
+      format += 2;
+      continue;
+    }
+
+    // copy the conversion spec without length modifiers
+    char spec[16];
+    size_t specLength = 0;
+    spec[specLength++] = *format++;
+    while (*format != '\0' && strchr("-+ #0123456789.*", *format) != NULL && specLength < sizeof(spec) - 3) {
+      spec[specLength++] = *format++;
+    }
+    while (*format != '\0' && strchr("hlzjtL", *format) != NULL) {
+      format++;
+    }
+    const char conversion = *format;
+    if (conversion == '\0') {
+      break;
+    }
+    format++;
+    spec[specLength++] = conversion;
+    spec[specLength] = '\0';
+
+    char piece[48];
+    int length = -1;
+    if (arg < argc) {
+      const DeferredLogArgType type = types[arg];
+      const uint32_t value = args[arg];
+      if (strchr("diouxXc", conversion) != NULL && type == DEFERRED_LOG_ARG_WORD) {
+        length = snprintf(piece, sizeof(piece), spec, (unsigned)value);
+      }
+      else if (strchr("fFeEgGaA", conversion) != NULL && type == DEFERRED_LOG_ARG_FLOAT) {
+        float f;
+        memcpy(&f, &value, sizeof(f));
+        length = snprintf(piece, sizeof(piece), spec, (double)f);
+      }
+      else if (conversion == 's' && type == DEFERRED_LOG_ARG_STRING) {
+        length = snprintf(piece, sizeof(piece), spec, strings[arg]);
+      }
+      else if (conversion == 'p' && type == DEFERRED_LOG_ARG_WORD) {
+        length = snprintf(piece, sizeof(piece), "0x%08x", (unsigned)value);
+      }
+      arg++;
+    }
+
+    if (length < 0) {
+      append("?", 1);
+    }
+    else {
+      append(piece, (size_t)length < sizeof(piece) ? (size_t)length : sizeof(piece) - 1);
+    }
+  }
+
+  if (size > 0) {
+    out[used] = '\0';
+  }
+  return used;
+}
+
+/**
+ * @brief format a queued record
+ */
+inline size_t deferredLogFormat(char* out, size_t size, const DeferredLogRecord& record)
+{
+  DeferredLogArgType types[DEFERRED_LOG_MAX_ARGS];
+  const char* strings[DEFERRED_LOG_MAX_ARGS];
+  for (int i = 0; i < record.argc; i++) {
+    types[i] = record.type(i);
+    strings[i] = types[i] == DEFERRED_LOG_ARG_STRING ? record.string(i) : NULL;
+  }
+  return deferredLogFormat(out, size, record.format, record.args, types, strings, record.argc);
+}
+
+
+/*
+===============================================================================================
+                                    Logger
+===============================================================================================
+*/
+
+/**
+ * @brief receives drained output, e.g. a UART write
+ */
+typedef void (*DeferredLogSink)(const uint8_t* data, size_t length, void* context);
+
+/**
+ * @brief drain task settings
+ */
+struct DeferredLogConfig
+{
+  uint32_t baudRate = 115200;     // output is throttled to this rate (10 bits per byte)
+  DeferredLogMode mode = DEFERRED_LOG_TEXT;
+  uint32_t drainIntervalMs = 10;  // how often the drain task wakes
+  uint8_t priority = 1;           // below every real task
+  int8_t core = 0;                // away from the CAN / timer tasks on core 1
+};
+
+/**
+ * @brief bounded multi-producer / single-consumer record ring plus the drain logic
+ * the ring is a Vyukov bounded queue: producers claim a cell with one compare-and-swap and
+ * publish it with a sequence store, the single consumer never writes the producers' index
+ */
+class DeferredLog
+{
+  static_assert(DEFERRED_LOG_CAPACITY >= 2 && (DEFERRED_LOG_CAPACITY & (DEFERRED_LOG_CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+  DeferredLog()
+  {
+    for (uint32_t i = 0; i < DEFERRED_LOG_CAPACITY; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief queue a log call, never blocks
+   *
+   * @param format a string literal, read later by the drain task
+   * @param args up to DEFERRED_LOG_MAX_ARGS arguments
+   * @return false if the ring was full and the record was dropped
+   */
+  template <typename... Args>
+  bool write(const char* format, Args... args)
+  {
+    static_assert(sizeof...(Args) <= DEFERRED_LOG_MAX_ARGS, "too many log arguments");
+    return writeAt(now(), format, args...);
+  }
+
+  /**
+   * @brief queue a log call with an explicit timestamp
+   */
+  template <typename... Args>
+  DEFERRED_LOG_IRAM bool writeAt(uint32_t timestampUs, const char* format, Args... args)
+  {
+    static_assert(sizeof...(Args) <= DEFERRED_LOG_MAX_ARGS, "too many log arguments");
+
+    // claim a cell
+    uint32_t position = enqueuePosition_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[position & (DEFERRED_LOG_CAPACITY - 1)];
+      const int32_t difference = (int32_t)(cell->sequence.load(std::memory_order_acquire) - position);
+      if (difference == 0) {
+        if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (difference < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else {
+        position = enqueuePosition_.load(std::memory_order_relaxed);
+      }
+    }
+
+    // fill and publish it
+    DeferredLogRecord& record = cell->record;
+    record.format = format;
+    record.timestampUs = timestampUs;
+    record.argc = 0;
+    record.textUsed = 0;
+    record.types = 0;
+    deferred_log_detail::addArgs(record, args...);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief take the oldest record, single consumer only
+   */
+  bool pop(DeferredLogRecord& record)
+  {
+    Cell& cell = cells_[dequeuePosition_ & (DEFERRED_LOG_CAPACITY - 1)];
+    if ((int32_t)(cell.sequence.load(std::memory_order_acquire) - (dequeuePosition_ + 1)) < 0) {
+      return false;
+    }
+    record = cell.record;
+    cell.sequence.store(dequeuePosition_ + DEFERRED_LOG_CAPACITY, std::memory_order_release);
+    dequeuePosition_++;
+    return true;
+  }
+
+  /**
+   * @brief format queued records and hand up to byteBudget bytes to the sink
+   * output that does not fit is kept and sent first next time, single consumer only
+   *
+   * @return bytes handed to the sink
+   */
+  size_t drain(DeferredLogMode mode, size_t byteBudget, DeferredLogSink sink, void* context)
+  {
+    size_t sent = 0;
+    for (;;) {
+      // finish what is already formatted
+      if (pendingSent_ < pendingLength_) {
+        size_t chunk = pendingLength_ - pendingSent_;
+        chunk = chunk < byteBudget - sent ? chunk : byteBudget - sent;
+        if (chunk == 0) {
+          break;
+        }
+        sink(pending_ + pendingSent_, chunk, context);
+        pendingSent_ += chunk;
+        sent += chunk;
+        continue;
+      }
+      pendingSent_ = pendingLength_ = 0;
+
+      // report drops before the records that follow them
+      const uint32_t dropped = dropped_.load(std::memory_order_relaxed);
+      if (dropped != reportedDrops_) {
+        reportedDrops_ = dropped;
+        queueDrops(mode, dropped);
+        continue;
+      }
+
+      DeferredLogRecord record;
+      if (!pop(record)) {
+        break;
+      }
+      drained_++;
+      if (mode == DEFERRED_LOG_TEXT) {
+        pendingLength_ = deferredLogFormat((char*)pending_, sizeof(pending_), record);
+      }
+      else {
+        queueBinary(record);
+      }
+    }
+    return sent;
+  }
+
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t drained() const { return drained_; }
+
+#ifdef ARDUINO
+  /**
+   * @brief start the drain task
+   *
+   * @param output where the logs go, usually Serial
+   * @param config throttle and task settings
+   */
+  bool begin(HardwareSerial& output, const DeferredLogConfig& config = DeferredLogConfig())
+  {
+    output_ = &output;
+    config_ = config;
+    return task_.start(drainTask, "Deferred Log", this, config.priority, config.core);
+  }
+
+  /**
+   * @brief the drain task, for memory reports
+   */
+  StaticTaskBase& task() { return task_; }
+#endif
+
+private:
+  struct Cell
+  {
+    std::atomic<uint32_t> sequence;
+    DeferredLogRecord record;
+  };
+
+  static uint32_t now()
+  {
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_timer_get_time();
+#else
+    return 0;
+#endif
+  }
+
+  void queueDrops(DeferredLogMode mode, uint32_t total)
+  {
+    if (mode == DEFERRED_LOG_TEXT) {
+      pendingLength_ = (size_t)snprintf((char*)pending_, sizeof(pending_), "\n[log] %u records dropped\n", (unsigned)total);
+      return;
+    }
+    pending_[0] = DEFERRED_LOG_SYNC;
+    pending_[1] = DEFERRED_LOG_FRAME_DROPS;
+    putU32(pending_ + 2, total);
+    pendingLength_ = 6;
+  }
+
+  /**
+   * @brief encode a record, with its format definition first if the decoder has not seen it
+   */
+  void queueBinary(const DeferredLogRecord& record)
+  {
+    if (++sinceRedefine_ >= DEFERRED_LOG_REDEFINE_INTERVAL) {
+      sinceRedefine_ = 0;
+      formatCount_ = 0;
+    }
+
+    int id = -1;
+    for (int i = 0; i < formatCount_; i++) {
+      if (formats_[i] == record.format) {
+        id = i;
+        break;
+      }
+    }
+    if (id < 0) {
+      if (formatCount_ >= DEFERRED_LOG_MAX_FORMATS) {
+        formatCount_ = 0;
+      }
+      id = formatCount_++;
+      formats_[id] = record.format;
+
+      size_t length = strlen(record.format);
+      length = length < DEFERRED_LOG_LINE_SIZE ? length : DEFERRED_LOG_LINE_SIZE;
+      pending_[pendingLength_++] = DEFERRED_LOG_SYNC;
+      pending_[pendingLength_++] = DEFERRED_LOG_FRAME_FORMAT;
+      putU16(pending_ + pendingLength_, (uint16_t)id);
+      putU16(pending_ + pendingLength_ + 2, (uint16_t)length);
+      memcpy(pending_ + pendingLength_ + 4, record.format, length);
+      pendingLength_ += 4 + length;
+    }
+
+    uint8_t* out = pending_ + pendingLength_;
+    *out++ = DEFERRED_LOG_SYNC;
+    *out++ = DEFERRED_LOG_FRAME_RECORD;
+    putU16(out, (uint16_t)id);
+    putU32(out + 2, record.timestampUs);
+    out[6] = record.argc;
+    putU16(out + 7, record.types);
+    out += 9;
+    for (int i = 0; i < record.argc; i++) {
+      if (record.type(i) == DEFERRED_LOG_ARG_STRING) {
+        const char* text = record.string(i);
+        const uint8_t length = (uint8_t)strlen(text);
+        *out++ = length;
+        memcpy(out, text, length);
+        out += length;
+      }
+      else {
+        putU32(out, record.args[i]);
+        out += 4;
+      }
+    }
+    pendingLength_ = (size_t)(out - pending_);
+  }
+
+  static void putU16(uint8_t* out, uint16_t value)
+  {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+  }
+
+  static void putU32(uint8_t* out, uint32_t value)
+  {
+    putU16(out, (uint16_t)value);
+    putU16(out + 2, (uint16_t)(value >> 16));
+  }
+
+#ifdef ARDUINO
+  static void writeSerial(const uint8_t* data, size_t length, void* context)
+  {
+    ((HardwareSerial*)context)->write(data, length);
+  }
+
+  /**
+   * @brief drains the ring at the configured baud rate, never waits on the UART
+   */
+  static void drainTask(void* arg)
+  {
+    DeferredLog* log = (DeferredLog*)arg;
+    const size_t bytesPerInterval = (size_t)((uint64_t)log->config_.baudRate / 10 * log->config_.drainIntervalMs / 1000) + 1;
+
+    for (;;) {
+      const int room = log->output_->availableForWrite();
+      size_t budget = room > 0 ? (size_t)room : 0;
+      budget = budget < bytesPerInterval ? budget : bytesPerInterval;
+      if (budget > 0) {
+        log->drain(log->config_.mode, budget, writeSerial, log->output_);
+      }
+      vTaskDelay(pdMS_TO_TICKS(log->config_.drainIntervalMs));
+    }
+  }
+
+  HardwareSerial* output_ = NULL;
+  DeferredLogConfig config_;
+  StaticTask<DEFERRED_LOG_STACK_SIZE> task_;
+#endif
+
+  Cell cells_[DEFERRED_LOG_CAPACITY];
+  std::atomic<uint32_t> enqueuePosition_{0};
+  uint32_t dequeuePosition_ = 0;
+  std::atomic<uint32_t> dropped_{0};
+
+  // consumer side only, pending_ holds one format definition plus the largest record
+  uint8_t pending_[DEFERRED_LOG_LINE_SIZE + 6 + 11 + DEFERRED_LOG_MAX_ARGS * 4 + DEFERRED_LOG_TEXT_SIZE + DEFERRED_LOG_MAX_ARGS];
+  size_t pendingLength_ = 0;
+  size_t pendingSent_ = 0;
+  uint32_t reportedDrops_ = 0;
+  uint32_t drained_ = 0;
+  const char* formats_[DEFERRED_LOG_MAX_FORMATS];
+  int formatCount_ = 0;
+  uint32_t sinceRedefine_ = 0;
+};
+
+
+/**
+ * @brief the program wide logger, touch it in setup() (e.g. begin()) before logging from an ISR
+ */
+inline DeferredLog& deferredLog()
+{
+  static DeferredLog log;
+  return log;
+}
+
+#define LOG_PRINTF(...)                   deferredLog().write(__VA_ARGS__)
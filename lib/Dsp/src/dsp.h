@@ -0,0 +1,489 @@
+/**
+ * @file dsp.h
+ * @brief fixed-point signal kernels: Q15 / Q31 biquads, running averages, median-of-N and hysteresis
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every kernel is a small value type configured by template arguments and constexpr
+ * constructors, so each channel's filter is fixed at compile time and lives wherever its
+ * owner does (a global, a struct member, the stack). nothing allocates, nothing uses floating
+ * point per sample, and a kernel never waits, so they run in tasks and ISRs alike:
+ *
+ *   DspBiquad<DspQ15>       direct form I biquad, Q14 coefficients, 32 bit accumulator
+ *   DspBiquad<DspQ31>       the same with Q30 coefficients and a 64 bit accumulator
+ *   DspMovingAverage<T, N>  mean of the last N samples, running sum
+ *   DspExpAverage<T, S>     exponential average with weight 2^-S, S extra bits of state
+ *   DspMedian<T, N>         median of the last N samples (N odd), sorted window
+ *   DspHysteresis<T, L, H>  comparator, on at H and off below L
+ *   DspBands<T, H, ...>     value to band index over ascending thresholds, H wide hysteresis
+ *
+ * biquad coefficients come from the constexpr designs below (audio EQ cookbook lowpass /
+ * highpass), quantized at compile time:
+ *
+ *   constexpr DspBiquadDesign pedalLowpass = dspLowpass(10, 1250, DSP_BUTTERWORTH_Q);
+ *   DspBiquad<DspQ15> pedal(pedalLowpass);
+ *   int16_t smooth = pedal.process(sample);
+ *
+ * the biquads accumulate with wrapping unsigned arithmetic: partial sums may overflow, the
+ * result is right as long as the true output fits, and the output then saturates. the part
+ * of each sum that the shift back to the sample format drops is fed into the next sum (first
+ * order error feedback), so a constant input settles on the exact DC value instead of a
+ * rounding offset. Q14 coefficients place poles no finer than the cookbook designs need for
+ * corners down to about 1/250 of the sample rate, below that DspQ31 is the format to use.
+ * tools/dsp_bench checks every kernel against a floating point reference.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#define DSP_IRAM                          IRAM_ATTR
+#else
+#define DSP_IRAM
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define DSP_PI                            3.14159265358979323846
+#define DSP_BUTTERWORTH_Q                 0.70710678118654752440
+#define DSP_MAX_MEDIAN                    31
+
+/**
+ * @brief Q15 samples (-1 to 1 - 2^-15) in int16_t, Q14 coefficients so |a1| up to 2 fits
+ */
+struct DspQ15
+{
+  typedef int16_t Sample;
+  typedef int16_t Coefficient;
+  typedef int32_t Accumulator;
+  typedef uint32_t Wrapping;
+  static const int COEFFICIENT_BITS = 14;
+  static const int32_t MIN = INT16_MIN;
+  static const int32_t MAX = INT16_MAX;
+};
+
+/**
+ * @brief Q31 samples in int32_t, Q30 coefficients, for low cutoffs where Q15 poles are too coarse
+ */
+struct DspQ31
+{
+  typedef int32_t Sample;
+  typedef int32_t Coefficient;
+  typedef int64_t Accumulator;
+  typedef uint64_t Wrapping;
+  static const int COEFFICIENT_BITS = 30;
+  static const int64_t MIN = INT32_MIN;
+  static const int64_t MAX = INT32_MAX;
+};
+
+
+/*
+===============================================================================================
+                                    Compile-Time Math
+===============================================================================================
+*/
+
+// Taylor series, exact to double precision for |x| <= pi, which is all a design needs
+constexpr double dspSinSeries(double x2, double term, int n, double sum)
+{
+  return n > 14 ? sum : dspSinSeries(x2, -term * x2 / ((2.0 * n) * (2.0 * n + 1)), n + 1, sum + term);
+}
+
+constexpr double dspCosSeries(double x2, double term, int n, double sum)
+{
+  return n > 14 ? sum : dspCosSeries(x2, -term * x2 / ((2.0 * n - 1) * (2.0 * n)), n + 1, sum + term);
+}
+
+constexpr double dspSin(double x) { return dspSinSeries(x * x, x, 1, 0); }
+constexpr double dspCos(double x) { return dspCosSeries(x * x, 1, 1, 0); }
+
+/**
+ * @brief real number to a fixed-point integer with the given fraction bits, rounded and clamped
+ */
+constexpr int64_t dspFixed(double value, int fractionBits, int64_t min, int64_t max)
+{
+  return value * (double)(1ll << fractionBits) >= (double)max ? max :
+    (value * (double)(1ll << fractionBits) <= (double)min ? min :
+    (int64_t)(value * (double)(1ll << fractionBits) + (value >= 0 ? 0.5 : -0.5)));
+}
+
+constexpr int16_t dspQ15(double value) { return (int16_t)dspFixed(value, 15, INT16_MIN, INT16_MAX); }
+constexpr int32_t dspQ31(double value) { return (int32_t)dspFixed(value, 31, INT32_MIN, INT32_MAX); }
+
+
+/*
+===============================================================================================
+                                    Biquad
+===============================================================================================
+*/
+
+/**
+ * @brief biquad coefficients as real numbers, normalized so a0 is 1:
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ */
+struct DspBiquadDesign
+{
+  double b0;
+  double b1;
+  double b2;
+  double a1;
+  double a2;
+};
+
+constexpr DspBiquadDesign dspLowpassFrom(double cosine, double alpha)
+{
+  return DspBiquadDesign{ (1 - cosine) / 2 / (1 + alpha), (1 - cosine) / (1 + alpha), (1 - cosine) / 2 / (1 + alpha),
+    -2 * cosine / (1 + alpha), (1 - alpha) / (1 + alpha) };
+}
+
+constexpr DspBiquadDesign dspHighpassFrom(double cosine, double alpha)
+{
+  return DspBiquadDesign{ (1 + cosine) / 2 / (1 + alpha), -(1 + cosine) / (1 + alpha), (1 + cosine) / 2 / (1 + alpha),
+    -2 * cosine / (1 + alpha), (1 - alpha) / (1 + alpha) };
+}
+
+/**
+ * @brief second order lowpass, q = DSP_BUTTERWORTH_Q for the flattest passband
+ */
+constexpr DspBiquadDesign dspLowpass(double cutoffHz, double sampleHz, double q)
+{
+  return dspLowpassFrom(dspCos(2 * DSP_PI * cutoffHz / sampleHz), dspSin(2 * DSP_PI * cutoffHz / sampleHz) / (2 * q));
+}
+
+constexpr DspBiquadDesign dspHighpass(double cutoffHz, double sampleHz, double q)
+{
+  return dspHighpassFrom(dspCos(2 * DSP_PI * cutoffHz / sampleHz), dspSin(2 * DSP_PI * cutoffHz / sampleHz) / (2 * q));
+}
+
+
+template <typename Format>
+class DspBiquad
+{
+public:
+  typedef typename Format::Sample Sample;
+  typedef typename Format::Coefficient Coefficient;
+  typedef typename Format::Accumulator Accumulator;
+  typedef typename Format::Wrapping Wrapping;
+
+  constexpr explicit DspBiquad(const DspBiquadDesign& design) :
+    b0_(quantize(design.b0)), b1_(balance(design)), b2_(quantize(design.b2)), a1_(quantize(design.a1)),
+    a2_(quantize(design.a2)), x1_(0), x2_(0), y1_(0), y2_(0), error_(0) {}
+
+  /**
+   * @brief start from a steady input, no step response from zero
+   */
+  void reset(Sample steady = 0)
+  {
+    x1_ = x2_ = y1_ = y2_ = steady;
+    error_ = 0;
+  }
+
+  DSP_IRAM Sample process(Sample x)
+  {
+    // wraps freely, only the final sum has to fit
+    const Wrapping sum = (Wrapping)error_ + (Wrapping)((Accumulator)b0_ * x) + (Wrapping)((Accumulator)b1_ * x1_) +
+      (Wrapping)((Accumulator)b2_ * x2_) - (Wrapping)((Accumulator)a1_ * y1_) - (Wrapping)((Accumulator)a2_ * y2_);
+    const Accumulator value = (Accumulator)sum;
+    error_ = value & (((Accumulator)1 << Format::COEFFICIENT_BITS) - 1);
+    Accumulator y = value >> Format::COEFFICIENT_BITS;
+    y = y > (Accumulator)Format::MAX ? (Accumulator)Format::MAX : (y < (Accumulator)Format::MIN ? (Accumulator)Format::MIN : y);
+
+    x2_ = x1_;
+    x1_ = x;
+    y2_ = y1_;
+    y1_ = (Sample)y;
+    return (Sample)y;
+  }
+
+  void process(const Sample* input, Sample* output, size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      output[i] = process(input[i]);
+    }
+  }
+
+  constexpr Coefficient b0() const { return b0_; }
+  constexpr Coefficient a1() const { return a1_; }
+  constexpr Coefficient a2() const { return a2_; }
+
+private:
+  static constexpr Coefficient quantize(double value)
+  {
+    return (Coefficient)dspFixed(value, Format::COEFFICIENT_BITS, Format::MIN, Format::MAX);
+  }
+
+  static constexpr double dcGain(const DspBiquadDesign& design)
+  {
+    return (design.b0 + design.b1 + design.b2) / (1 + design.a1 + design.a2);
+  }
+
+  /**
+   * @brief b1 rounded so the quantized filter keeps the design's DC gain exactly. with poles
+   * close to 1 the denominator 1 + a1 + a2 is tiny and a numerator rounded tap by tap leaks
+   * DC through a huge gain: a highpass passes an offset, a lowpass misses its level
+   */
+  static constexpr Coefficient balance(const DspBiquadDesign& design)
+  {
+    return 1 + design.a1 + design.a2 == 0 ? quantize(design.b1) :
+      (Coefficient)(dspFixed(dcGain(design) * (1 + (double)quantize(design.a1) / (1ll << Format::COEFFICIENT_BITS) +
+      (double)quantize(design.a2) / (1ll << Format::COEFFICIENT_BITS)), Format::COEFFICIENT_BITS, Format::MIN * 4, Format::MAX * 4) -
+      quantize(design.b0) - quantize(design.b2));
+  }
+
+  Coefficient b0_;
+  Coefficient b1_;
+  Coefficient b2_;
+  Coefficient a1_;
+  Coefficient a2_;
+  Sample x1_;
+  Sample x2_;
+  Sample y1_;
+  Sample y2_;
+  Accumulator error_;               // fraction bits dropped by the last output
+};
+
+
+/*
+===============================================================================================
+                                    Running Averages
+===============================================================================================
+*/
+
+/**
+ * @brief mean of the last N samples, one add and one subtract per sample
+ * Sum must hold N times the largest sample
+ */
+template <typename T, int N, typename Sum = int32_t>
+class DspMovingAverage
+{
+public:
+  static_assert(N >= 1, "at least one sample");
+
+  DspMovingAverage() { reset(); }
+
+  void reset(T steady = 0)
+  {
+    for (int i = 0; i < N; i++) {
+      window_[i] = steady;
+    }
+    sum_ = (Sum)steady * N;
+    position_ = 0;
+  }
+
+  DSP_IRAM T process(T x)
+  {
+    sum_ += (Sum)x - (Sum)window_[position_];
+    window_[position_] = x;
+    position_ = position_ + 1 < N ? position_ + 1 : 0;
+    return (T)((sum_ >= 0 ? sum_ + N / 2 : sum_ - N / 2) / N);       // N is a constant, no division instruction
+  }
+
+  void process(const T* input, T* output, size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      output[i] = process(input[i]);
+    }
+  }
+
+private:
+  T window_[N];
+  Sum sum_;
+  int position_;
+};
+
+
+/**
+ * @brief y += (x - y) / 2^Shift, with Shift extra bits of state so small steps are not lost
+ * State must hold a sample shifted left by Shift
+ */
+template <typename T, int Shift, typename State = int32_t>
+class DspExpAverage
+{
+public:
+  static_assert(Shift >= 1 && Shift < 24, "weight 2^-1 to 2^-23");
+
+  constexpr DspExpAverage() : state_(0) {}
+
+  void reset(T steady = 0) { state_ = (State)steady * ((State)1 << Shift); }
+
+  DSP_IRAM T process(T x)
+  {
+    state_ += (State)x - output();
+    return output();
+  }
+
+  void process(const T* input, T* output, size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      output[i] = process(input[i]);
+    }
+  }
+
+  T output() const { return (T)((state_ + ((State)1 << (Shift - 1))) >> Shift); }
+
+private:
+  State state_;
+};
+
+
+/*
+===============================================================================================
+                                    Median
+===============================================================================================
+*/
+
+/**
+ * @brief median of the last N samples, the window is kept sorted: one search, one shift per sample
+ */
+template <typename T, int N>
+class DspMedian
+{
+public:
+  static_assert(N >= 1 && N % 2 == 1 && N <= DSP_MAX_MEDIAN, "N odd, 1 to 31");
+
+  DspMedian() { reset(); }
+
+  void reset(T steady = 0)
+  {
+    for (int i = 0; i < N; i++) {
+      window_[i] = steady;
+      sorted_[i] = steady;
+    }
+    position_ = 0;
+  }
+
+  DSP_IRAM T process(T x)
+  {
+    const T oldest = window_[position_];
+    window_[position_] = x;
+    position_ = position_ + 1 < N ? position_ + 1 : 0;
+
+    // take the oldest out of the sorted window and slide the new sample into its place
+    int i = 0;
+    while (sorted_[i] != oldest) {
+      i++;
+    }
+    while (i > 0 && sorted_[i - 1] > x) {
+      sorted_[i] = sorted_[i - 1];
+      i--;
+    }
+    while (i < N - 1 && sorted_[i + 1] < x) {
+      sorted_[i] = sorted_[i + 1];
+      i++;
+    }
+    sorted_[i] = x;
+    return sorted_[N / 2];
+  }
+
+  void process(const T* input, T* output, size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      output[i] = process(input[i]);
+    }
+  }
+
+private:
+  T window_[N];                     // arrival order
+  T sorted_[N];
+  int position_;
+};
+
+
+/*
+===============================================================================================
+                                    Hysteresis
+===============================================================================================
+*/
+
+/**
+ * @brief on once the input reaches High, off again once it drops below Low
+ */
+template <typename T, T Low, T High>
+class DspHysteresis
+{
+public:
+  static_assert(Low < High, "Low must be below High");
+
+  constexpr DspHysteresis() : on_(false) {}
+
+  DSP_IRAM bool process(T x)
+  {
+    on_ = on_ ? x >= Low : x >= High;
+    return on_;
+  }
+
+  bool on() const { return on_; }
+  void reset(bool on = false) { on_ = on; }
+
+private:
+  bool on_;
+};
+
+
+/**
+ * @brief compile-time list of values
+ */
+template <typename T, T... Values>
+struct DspPack
+{
+  static constexpr int size() { return 0; }
+  static constexpr T at(int) { return T(); }
+  static constexpr bool ascending() { return true; }
+};
+
+template <typename T, T First, T... Rest>
+struct DspPack<T, First, Rest...>
+{
+  static constexpr int size() { return 1 + (int)sizeof...(Rest); }
+  static constexpr T at(int index) { return index == 0 ? First : DspPack<T, Rest...>::at(index - 1); }
+  static constexpr bool ascending() { return (sizeof...(Rest) == 0 || First < DspPack<T, Rest...>::at(0)) && DspPack<T, Rest...>::ascending(); }
+};
+
+/**
+ * @brief which band a value is in, 0 below the first threshold up to sizeof...(Thresholds)
+ * above the last. a band is entered upwards at its threshold and left downwards only below
+ * threshold - Hysteresis, so a value resting on a threshold does not flicker between bands
+ */
+template <typename T, T Hysteresis, T... Thresholds>
+class DspBands
+{
+public:
+  typedef DspPack<T, Thresholds...> Pack;
+  static const int BANDS = sizeof...(Thresholds) + 1;
+
+  static_assert(sizeof...(Thresholds) >= 1, "at least one threshold");
+  static_assert(Pack::ascending(), "thresholds must be strictly ascending");
+
+  constexpr DspBands() : band_(0) {}
+
+  DSP_IRAM int process(T x)
+  {
+    while (band_ < BANDS - 1 && x >= Pack::at(band_)) {
+      band_++;
+    }
+    while (band_ > 0 && x < Pack::at(band_ - 1) - Hysteresis) {
+      band_--;
+    }
+    return band_;
+  }
+
+  int band() const { return band_; }
+  static constexpr T threshold(int index) { return Pack::at(index); }
+
+private:
+  int band_;
+};
@@ -0,0 +1,423 @@
+/**
+ * @file espnow_link.h
+ * @brief ESP-NOW send completion tracking and adaptive rate control
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every frame sent through EspNowLink is remembered until ESP-NOW reports its outcome in the
+ * send callback. ESP-NOW completes sends to a peer in the order they were made, so the oldest
+ * in-flight frame for that peer is the one being reported. the time between esp_now_send()
+ * and the callback is the link latency (transmit + MAC layer ACK, including retries).
+ *
+ * each peer has an EspNowRateController that turns the ACK / NACK stream into a send interval:
+ * the interval doubles when the smoothed delivery ratio drops below target and shrinks by a
+ * fixed step while it is above target (AIMD). after a back-off it holds for one smoothing
+ * window, since the ratio lags the losses that caused it and would otherwise keep doubling
+ * long after the slower rate has fixed them. the controller is plain arithmetic with no
+ * platform calls so it can be driven by a simulated link on the host.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <espnow_wire.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_now.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ESPNOW_LINK_MAX_PEERS             8
+#define ESPNOW_LINK_MAX_IN_FLIGHT         8           // per peer, older frames are assumed lost
+#define ESPNOW_LINK_INVALID_PEER          -1
+
+
+/**
+ * @brief tuning for the rate controller
+ */
+struct EspNowRateConfig
+{
+  float targetDelivery = 0.95f;       // delivery ratio to hold
+  float smoothing = 0.02f;            // weight of each new outcome in the delivery ratio (~50 frame window)
+  uint16_t adjustEvery = 10;          // outcomes between interval changes
+  uint32_t minIntervalUs = 10000;     // fastest allowed send interval
+  uint32_t maxIntervalUs = 1000000;   // slowest allowed send interval
+  uint32_t stepUs = 5000;             // additive speed-up while above target
+};
+
+
+/*
+===============================================================================================
+                                    Rate Controller
+===============================================================================================
+*/
+
+/**
+ * @brief AIMD controller from delivery outcomes to a send interval
+ */
+class EspNowRateController
+{
+public:
+  explicit EspNowRateController(const EspNowRateConfig& config = EspNowRateConfig()) { configure(config); }
+
+  /**
+   * @brief reset the controller with new tuning, starting at the slowest interval
+   */
+  void configure(const EspNowRateConfig& config)
+  {
+    config_ = config;
+    delivery_ = 1.0f;
+    intervalUs_ = config.maxIntervalUs;
+    outcomes_ = 0;
+    holdOutcomes_ = 0;
+  }
+
+  /**
+   * @brief feed one send outcome
+   *
+   * @param delivered true if the frame was acknowledged
+   * @return true if the interval changed
+   */
+  bool record(bool delivered)
+  {
+    delivery_ += config_.smoothing * ((delivered ? 1.0f : 0.0f) - delivery_);
+
+    // the ratio still remembers the losses that caused the last back-off, let it see the new rate first
+    if (holdOutcomes_ > 0) {
+      holdOutcomes_--;
+      return false;
+    }
+    if (++outcomes_ < config_.adjustEvery) {
+      return false;
+    }
+    outcomes_ = 0;
+
+    const uint32_t previous = intervalUs_;
+    if (delivery_ < config_.targetDelivery) {
+      // back off hard
+      intervalUs_ = intervalUs_ > config_.maxIntervalUs / 2 ? config_.maxIntervalUs : intervalUs_ * 2;
+      holdOutcomes_ = intervalUs_ != previous ? (uint16_t)(1.0f / config_.smoothing) : 0;
+    }
+    else {
+      // probe for more throughput gently
+      intervalUs_ = intervalUs_ > config_.minIntervalUs + config_.stepUs ? intervalUs_ - config_.stepUs : config_.minIntervalUs;
+    }
+    return intervalUs_ != previous;
+  }
+
+  uint32_t intervalUs() const { return intervalUs_; }
+  float delivery() const { return delivery_; }
+  const EspNowRateConfig& config() const { return config_; }
+
+private:
+  EspNowRateConfig config_;
+  float delivery_;
+  uint32_t intervalUs_;
+  uint16_t outcomes_;
+  uint16_t holdOutcomes_;             // outcomes left before the interval may change again after a back-off
+};
+
+
+/*
+===============================================================================================
+                                    Link Tracker
+===============================================================================================
+*/
+
+/**
+ * @brief per-peer delivery statistics
+ */
+struct EspNowPeerStats
+{
+  uint32_t sent = 0;                  // frames accepted by esp_now_send()
+  uint32_t acked = 0;
+  uint32_t nacked = 0;
+  uint32_t rejected = 0;              // frames esp_now_send() refused outright
+  uint32_t lost = 0;                  // frames whose callback never came (in-flight overflow)
+  uint32_t lastLatencyUs = 0;
+  uint32_t maxLatencyUs = 0;
+  uint32_t averageLatencyUs = 0;      // smoothed, 1/8 weight per sample
+  uint16_t lastAckedSequence = 0;
+};
+
+/**
+ * @brief matches send completions to sends and runs one rate controller per peer
+ * not locked: EspNowLink wraps it with a spinlock on the ESP32
+ */
+class EspNowLinkTracker
+{
+public:
+  /**
+   * @brief add a peer (or find it if it is already known)
+   *
+   * @return peer index, or ESPNOW_LINK_INVALID_PEER if the table is full
+   */
+  int addPeer(const uint8_t* mac, const EspNowRateConfig& config = EspNowRateConfig())
+  {
+    int index = findPeer(mac);
+    if (index != ESPNOW_LINK_INVALID_PEER) {
+      return index;
+    }
+    if (peerCount_ >= ESPNOW_LINK_MAX_PEERS) {
+      return ESPNOW_LINK_INVALID_PEER;
+    }
+
+    Peer& peer = peers_[peerCount_];
+    memcpy(peer.mac, mac, 6);
+    peer.stats = EspNowPeerStats();
+    peer.controller.configure(config);
+    peer.head = 0;
+    peer.count = 0;
+    return peerCount_++;
+  }
+
+  int findPeer(const uint8_t* mac) const
+  {
+    for (int i = 0; i < peerCount_; i++) {
+      if (memcmp(peers_[i].mac, mac, 6) == 0) {
+        return i;
+      }
+    }
+    return ESPNOW_LINK_INVALID_PEER;
+  }
+
+  /**
+   * @brief remember a frame that esp_now_send() accepted
+   */
+  void onSent(int index, uint16_t sequence, uint32_t nowUs)
+  {
+    Peer& peer = peers_[index];
+    peer.stats.sent++;
+
+    // the callback for the oldest frame never came, count it as lost and reuse its slot
+    if (peer.count == ESPNOW_LINK_MAX_IN_FLIGHT) {
+      peer.head = (peer.head + 1) % ESPNOW_LINK_MAX_IN_FLIGHT;
+      peer.count--;
+      peer.stats.lost++;
+      peer.controller.record(false);
+    }
+
+    InFlight& slot = peer.inFlight[(peer.head + peer.count) % ESPNOW_LINK_MAX_IN_FLIGHT];
+    slot.sequence = sequence;
+    slot.sentAtUs = nowUs;
+    peer.count++;
+  }
+
+  /**
+   * @brief undo the last onSent() for a frame that esp_now_send() refused
+   */
+  void onRejected(int index)
+  {
+    Peer& peer = peers_[index];
+    if (peer.count > 0) {
+      peer.count--;
+      peer.stats.sent--;
+    }
+    peer.stats.rejected++;
+    peer.controller.record(false);
+  }
+
+  /**
+   * @brief match a send callback to the oldest in-flight frame of that peer
+   *
+   * @return true if the peer's send interval changed
+   */
+  bool onComplete(const uint8_t* mac, bool delivered, uint32_t nowUs)
+  {
+    const int index = findPeer(mac);
+    if (index == ESPNOW_LINK_INVALID_PEER || peers_[index].count == 0) {
+      return false;
+    }
+
+    Peer& peer = peers_[index];
+    const InFlight& slot = peer.inFlight[peer.head];
+    peer.head = (peer.head + 1) % ESPNOW_LINK_MAX_IN_FLIGHT;
+    peer.count--;
+
+    const uint32_t latencyUs = nowUs - slot.sentAtUs;
+    EspNowPeerStats& stats = peer.stats;
+    stats.lastLatencyUs = latencyUs;
+    if (latencyUs > stats.maxLatencyUs) {
+      stats.maxLatencyUs = latencyUs;
+    }
+    stats.averageLatencyUs = stats.averageLatencyUs == 0 ? latencyUs : stats.averageLatencyUs + ((int32_t)(latencyUs - stats.averageLatencyUs) >> 3);
+
+    if (delivered) {
+      stats.acked++;
+      stats.lastAckedSequence = slot.sequence;
+    }
+    else {
+      stats.nacked++;
+    }
+
+    return peer.controller.record(delivered);
+  }
+
+  const EspNowPeerStats& stats(int index) const { return peers_[index].stats; }
+  const EspNowRateController& controller(int index) const { return peers_[index].controller; }
+  const uint8_t* mac(int index) const { return peers_[index].mac; }
+  int peerCount() const { return peerCount_; }
+
+private:
+  struct InFlight
+  {
+    uint16_t sequence;
+    uint32_t sentAtUs;
+  };
+
+  struct Peer
+  {
+    uint8_t mac[6];
+    EspNowPeerStats stats;
+    EspNowRateController controller;
+    InFlight inFlight[ESPNOW_LINK_MAX_IN_FLIGHT];
+    uint8_t head;
+    uint8_t count;
+  };
+
+  Peer peers_[ESPNOW_LINK_MAX_PEERS];
+  int peerCount_ = 0;
+};
+
+
+/*
+===============================================================================================
+                                    ESP-NOW Glue
+===============================================================================================
+*/
+
+#ifdef ESP_PLATFORM
+
+/**
+ * @brief ESP-NOW send path with delivery tracking, one instance per program
+ * the send callback has no context pointer, so the instance registered by begin() is global
+ */
+class EspNowLink
+{
+public:
+  /**
+   * @brief register the send callback, call after esp_now_init()
+   */
+  esp_err_t begin()
+  {
+    instance() = this;
+    return esp_now_register_send_cb(onSendComplete);
+  }
+
+  /**
+   * @brief start tracking a peer, the peer still has to be added with esp_now_add_peer()
+   */
+  int addPeer(const uint8_t* mac, const EspNowRateConfig& config = EspNowRateConfig())
+  {
+    portENTER_CRITICAL(&lock_);
+    int index = tracker_.addPeer(mac, config);
+    portEXIT_CRITICAL(&lock_);
+    return index;
+  }
+
+  int findPeer(const uint8_t* mac)
+  {
+    portENTER_CRITICAL(&lock_);
+    int index = tracker_.findPeer(mac);
+    portEXIT_CRITICAL(&lock_);
+    return index;
+  }
+
+  int peerCount() const { return tracker_.peerCount(); }
+
+  /**
+   * @brief send a wire format frame and track its delivery
+   *
+   * @param index peer returned by addPeer()
+   * @param frame the frame, its sequence number is recorded for the stats
+   * @param length frame size in bytes
+   */
+  esp_err_t send(int index, const uint8_t* frame, size_t length)
+  {
+    const uint16_t sequence = length >= ESPNOW_WIRE_HEADER_SIZE ? espNowReadU16(frame + ESPNOW_WIRE_SEQUENCE_OFFSET) : 0;
+
+    // record before sending, the callback can fire before esp_now_send() returns
+    portENTER_CRITICAL(&lock_);
+    tracker_.onSent(index, sequence, (uint32_t)esp_timer_get_time());
+    portEXIT_CRITICAL(&lock_);
+
+    esp_err_t result = esp_now_send(tracker_.mac(index), frame, length);
+    if (result != ESP_OK) {
+      portENTER_CRITICAL(&lock_);
+      tracker_.onRejected(index);
+      portEXIT_CRITICAL(&lock_);
+    }
+    return result;
+  }
+
+  /**
+   * @brief consistent copy of a peer's statistics
+   */
+  EspNowPeerStats stats(int index)
+  {
+    portENTER_CRITICAL(&lock_);
+    EspNowPeerStats copy = tracker_.stats(index);
+    portEXIT_CRITICAL(&lock_);
+    return copy;
+  }
+
+  /**
+   * @brief send interval the rate controller currently allows for a peer
+   */
+  uint32_t intervalUs(int index)
+  {
+    portENTER_CRITICAL(&lock_);
+    uint32_t interval = tracker_.controller(index).intervalUs();
+    portEXIT_CRITICAL(&lock_);
+    return interval;
+  }
+
+  float delivery(int index)
+  {
+    portENTER_CRITICAL(&lock_);
+    float delivery = tracker_.controller(index).delivery();
+    portEXIT_CRITICAL(&lock_);
+    return delivery;
+  }
+
+private:
+  static void onSendComplete(const uint8_t* mac, esp_now_send_status_t status)
+  {
+    EspNowLink* link = instance();
+    if (link == NULL || mac == NULL) {
+      return;
+    }
+
+    portENTER_CRITICAL(&link->lock_);
+    link->tracker_.onComplete(mac, status == ESP_NOW_SEND_SUCCESS, (uint32_t)esp_timer_get_time());
+    portEXIT_CRITICAL(&link->lock_);
+  }
+
+  // function local static so the header needs no separate definition
+  static EspNowLink*& instance()
+  {
+    static EspNowLink* link = NULL;
+    return link;
+  }
+
+  EspNowLinkTracker tracker_;
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif
@@ -0,0 +1,464 @@
+/**
+ * @file espnow_mesh.h
+ * @brief multi-hop ESP-NOW relay: fixed peer table, TTL flooding and duplicate suppression
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every node runs the same image with the same list of node addresses. a node that has
+ * something to say wraps a complete wire format frame in an ESPNOW_FRAME_MESH frame and
+ * unicasts it to every peer (unicast so the MAC layer ACKs and retries each hop). a node that
+ * receives a mesh frame it has not seen before delivers the inner frame locally and, while
+ * the TTL allows, sends it on to every peer except the one it came from and the origin.
+ *
+ * duplicates are recognised by (origin, origin sequence). each origin keeps a 32 frame
+ * sliding window like an anti-replay window, and the cache holds a fixed number of origins,
+ * evicting the least recently heard one. nothing here allocates.
+ *
+ * mesh payload layout (little endian):
+ *
+ *   offset  size  field
+ *   0       6     origin MAC address
+ *   6       2     origin sequence number
+ *   8       1     TTL, hops the frame may still take
+ *   9       1     hops taken so far
+ *   10      ...   inner frame, a complete wire format frame
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <espnow_wire.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ESPNOW_MESH_MAX_PEERS             16          // ESP-NOW allows 20 unencrypted peers
+#define ESPNOW_MESH_MAX_ORIGINS           16
+#define ESPNOW_MESH_WINDOW_SIZE           32          // sequence numbers remembered per origin
+#define ESPNOW_MESH_RESTART_GAP           1024        // a sequence this far behind means the origin rebooted
+#define ESPNOW_MESH_DEFAULT_TTL           3
+#define ESPNOW_MESH_INVALID_PEER          -1
+
+#define ESPNOW_MESH_ORIGIN_OFFSET         0
+#define ESPNOW_MESH_SEQUENCE_OFFSET       6
+#define ESPNOW_MESH_TTL_OFFSET            8
+#define ESPNOW_MESH_HOPS_OFFSET           9
+#define ESPNOW_MESH_HEADER_SIZE           10
+#define ESPNOW_MESH_MAX_INNER_SIZE        (ESPNOW_WIRE_MAX_PAYLOAD_SIZE - ESPNOW_MESH_HEADER_SIZE)
+
+
+/**
+ * @brief relay counters, plain 32 bit words so other tasks may read them
+ */
+struct EspNowMeshStats
+{
+  uint32_t originated = 0;          // messages this node started
+  uint32_t received = 0;            // mesh frames heard from peers
+  uint32_t delivered = 0;           // new messages handed to the application
+  uint32_t duplicates = 0;          // copies already seen, dropped
+  uint32_t stale = 0;               // older than the duplicate window, dropped
+  uint32_t forwarded = 0;           // frames sent on behalf of other nodes
+  uint32_t ttlExpired = 0;          // new messages that were delivered but not relayed
+  uint32_t malformed = 0;           // bad mesh header or inner frame
+  uint32_t sendFailures = 0;        // sends the send function refused
+  uint32_t evictions = 0;           // origins pushed out of the duplicate cache
+};
+
+/**
+ * @brief one message delivered by the mesh
+ */
+struct EspNowMeshMessage
+{
+  const uint8_t* origin;            // MAC address of the node that sent it
+  uint16_t sequence;                // origin sequence number
+  uint8_t hops;                     // 1 when heard straight from the origin
+  EspNowFrameView frame;            // validated inner frame, only valid during the callback
+};
+
+
+/*
+===============================================================================================
+                                    Peer Table
+===============================================================================================
+*/
+
+/**
+ * @brief a neighbour this node sends to
+ */
+struct EspNowMeshPeer
+{
+  uint8_t mac[6];
+  uint32_t framesHeard;             // mesh frames received straight from this peer
+  uint32_t lastHeardUs;
+};
+
+/**
+ * @brief fixed size table of peers
+ */
+class EspNowMeshPeerTable
+{
+public:
+  /**
+   * @brief add a peer (or find it if it is already known)
+   *
+   * @return peer index, or ESPNOW_MESH_INVALID_PEER if the table is full
+   */
+  int add(const uint8_t* mac)
+  {
+    int index = find(mac);
+    if (index != ESPNOW_MESH_INVALID_PEER) {
+      return index;
+    }
+    if (count_ >= ESPNOW_MESH_MAX_PEERS) {
+      return ESPNOW_MESH_INVALID_PEER;
+    }
+
+    EspNowMeshPeer& peer = peers_[count_];
+    memcpy(peer.mac, mac, 6);
+    peer.framesHeard = 0;
+    peer.lastHeardUs = 0;
+    return count_++;
+  }
+
+  int find(const uint8_t* mac) const
+  {
+    for (int i = 0; i < count_; i++) {
+      if (memcmp(peers_[i].mac, mac, 6) == 0) {
+        return i;
+      }
+    }
+    return ESPNOW_MESH_INVALID_PEER;
+  }
+
+  EspNowMeshPeer& operator[](int index) { return peers_[index]; }
+  const EspNowMeshPeer& operator[](int index) const { return peers_[index]; }
+  int size() const { return count_; }
+
+private:
+  EspNowMeshPeer peers_[ESPNOW_MESH_MAX_PEERS];
+  int count_ = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Duplicate Cache
+===============================================================================================
+*/
+
+/**
+ * @brief what the duplicate cache made of a sequence number
+ */
+enum EspNowMeshSeen
+{
+  ESPNOW_MESH_NEW,
+  ESPNOW_MESH_DUPLICATE,
+  ESPNOW_MESH_STALE,                // behind the window, can no longer tell
+};
+
+/**
+ * @brief bounded per-origin sequence window
+ */
+class EspNowMeshDuplicateCache
+{
+public:
+  /**
+   * @brief check a message and remember it
+   *
+   * @param origin MAC address of the node that sent the message
+   * @param sequence the origin's sequence number
+   */
+  EspNowMeshSeen check(const uint8_t* origin, uint16_t sequence)
+  {
+    Entry& entry = lookup(origin);
+    entry.lastUse = ++useCounter_;
+
+    if (!entry.valid) {
+      entry.valid = true;
+      entry.highest = sequence;
+      entry.window = 1;
+      return ESPNOW_MESH_NEW;
+    }
+
+    const int16_t ahead = (int16_t)(sequence - entry.highest);
+    if (ahead > 0) {
+      // slide the window forward, bit 0 is always the highest sequence seen
+      entry.window = ahead >= ESPNOW_MESH_WINDOW_SIZE ? 0 : entry.window << ahead;
+      entry.window |= 1;
+      entry.highest = sequence;
+      return ESPNOW_MESH_NEW;
+    }
+
+    const int behind = -ahead;
+    if (behind >= ESPNOW_MESH_RESTART_GAP) {
+      // the origin started counting again, forget what it sent before
+      entry.highest = sequence;
+      entry.window = 1;
+      return ESPNOW_MESH_NEW;
+    }
+    if (behind >= ESPNOW_MESH_WINDOW_SIZE) {
+      return ESPNOW_MESH_STALE;
+    }
+
+    const uint32_t bit = 1u << behind;
+    if (entry.window & bit) {
+      return ESPNOW_MESH_DUPLICATE;
+    }
+    entry.window |= bit;
+    return ESPNOW_MESH_NEW;
+  }
+
+  uint32_t evictions() const { return evictions_; }
+
+private:
+  struct Entry
+  {
+    uint8_t origin[6];
+    bool valid;
+    uint16_t highest;
+    uint32_t window;
+    uint32_t lastUse;
+  };
+
+  /**
+   * @brief the entry for an origin, taking over the least recently used one if it is new
+   */
+  Entry& lookup(const uint8_t* origin)
+  {
+    Entry* oldest = &entries_[0];
+    for (int i = 0; i < ESPNOW_MESH_MAX_ORIGINS; i++) {
+      Entry& entry = entries_[i];
+      if (entry.valid && memcmp(entry.origin, origin, 6) == 0) {
+        return entry;
+      }
+      if (!entry.valid || (oldest->valid && entry.lastUse < oldest->lastUse)) {
+        oldest = &entry;
+      }
+    }
+
+    if (oldest->valid) {
+      evictions_++;
+    }
+    memcpy(oldest->origin, origin, 6);
+    oldest->valid = false;
+    return *oldest;
+  }
+
+  Entry entries_[ESPNOW_MESH_MAX_ORIGINS] = {};
+  uint32_t useCounter_ = 0;
+  uint32_t evictions_ = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Mesh
+===============================================================================================
+*/
+
+/**
+ * @brief TTL flooding relay, not thread safe: call send() and onReceive() from one task
+ */
+class EspNowMesh
+{
+public:
+  /**
+   * @brief sends one frame to one peer, typically wraps esp_now_send()
+   * @return true if the frame was accepted
+   */
+  typedef bool (*SendFunction)(const uint8_t* mac, const uint8_t* frame, size_t length, void* context);
+
+  /**
+   * @brief receives every new message addressed to the mesh, including the hop count
+   */
+  typedef void (*DeliverFunction)(const EspNowMeshMessage& message, void* context);
+
+  /**
+   * @param send how frames reach a peer
+   * @param deliver where new messages go
+   * @param context passed through to send and deliver
+   */
+  EspNowMesh(SendFunction send, DeliverFunction deliver, void* context = NULL)
+    : send_(send), deliver_(deliver), context_(context) {}
+
+  /**
+   * @brief set this node's address, call once the radio is up and before addPeer()
+   *
+   * @param self this node's MAC address, frames from it are never delivered or relayed
+   */
+  void begin(const uint8_t* self)
+  {
+    memcpy(self_, self, 6);
+  }
+
+  /**
+   * @brief add a node to send to, this node's own address is skipped so every node can be given the same list
+   *
+   * @return peer index, or ESPNOW_MESH_INVALID_PEER if the address is this node or the table is full
+   */
+  int addPeer(const uint8_t* mac)
+  {
+    if (memcmp(mac, self_, 6) == 0) {
+      return ESPNOW_MESH_INVALID_PEER;
+    }
+    return peers_.add(mac);
+  }
+
+  /**
+   * @brief flood a wire format frame to the whole mesh
+   *
+   * @param frame a complete frame, at most ESPNOW_MESH_MAX_INNER_SIZE bytes
+   * @param length frame size in bytes
+   * @param ttl how many hops the frame may take, 1 reaches direct peers only
+   * @return number of peers the frame was sent to
+   */
+  int send(const uint8_t* frame, size_t length, uint8_t ttl = ESPNOW_MESH_DEFAULT_TTL)
+  {
+    if (length > ESPNOW_MESH_MAX_INNER_SIZE || ttl == 0) {
+      return 0;
+    }
+
+    // remember our own message so echoes from peers are dropped
+    const uint16_t sequence = sequence_++;
+    duplicates_.check(self_, sequence);
+    stats_.originated++;
+
+    const size_t frameSize = wrap(self_, sequence, ttl, 1, frame, length);
+    return flood(frameSize, NULL, NULL);
+  }
+
+  /**
+   * @brief handle a received frame, delivers and relays mesh frames, ignores everything else
+   *
+   * @param mac address of the peer that sent it
+   * @param data the received bytes
+   * @param length number of received bytes
+   * @param nowUs current time in microseconds, for the peer table
+   * @return false if the frame is not a mesh frame, so the caller can handle it directly
+   */
+  bool onReceive(const uint8_t* mac, const uint8_t* data, int length, uint32_t nowUs)
+  {
+    EspNowFrameView outer;
+    if (EspNowFrameView::parse(data, length, outer) != ESPNOW_PARSE_OK || outer.type() != ESPNOW_FRAME_MESH) {
+      return false;
+    }
+    stats_.received++;
+
+    const int peer = peers_.find(mac);
+    if (peer != ESPNOW_MESH_INVALID_PEER) {
+      peers_[peer].framesHeard++;
+      peers_[peer].lastHeardUs = nowUs;
+    }
+
+    EspNowMeshMessage message;
+    const uint8_t* payload = outer.payload();
+    if (outer.payloadLength() < ESPNOW_MESH_HEADER_SIZE ||
+        EspNowFrameView::parse(payload + ESPNOW_MESH_HEADER_SIZE, outer.payloadLength() - ESPNOW_MESH_HEADER_SIZE, message.frame) != ESPNOW_PARSE_OK) {
+      stats_.malformed++;
+      return true;
+    }
+
+    message.origin = payload + ESPNOW_MESH_ORIGIN_OFFSET;
+    message.sequence = espNowReadU16(payload + ESPNOW_MESH_SEQUENCE_OFFSET);
+    message.hops = payload[ESPNOW_MESH_HOPS_OFFSET];
+    const uint8_t ttl = payload[ESPNOW_MESH_TTL_OFFSET];
+
+    // our own message coming back, or one we already handled
+    if (memcmp(message.origin, self_, 6) == 0) {
+      stats_.duplicates++;
+      return true;
+    }
+    const EspNowMeshSeen seen = duplicates_.check(message.origin, message.sequence);
+    if (seen != ESPNOW_MESH_NEW) {
+      (seen == ESPNOW_MESH_DUPLICATE ? stats_.duplicates : stats_.stale)++;
+      return true;
+    }
+
+    stats_.delivered++;
+    deliver_(message, context_);
+
+    // pass it on with one hop less
+    if (ttl <= 1) {
+      stats_.ttlExpired++;
+      return true;
+    }
+    const size_t frameSize = wrap(message.origin, message.sequence, ttl - 1, message.hops + 1, message.frame.data(), message.frame.size());
+    stats_.forwarded += flood(frameSize, mac, message.origin);
+    return true;
+  }
+
+  EspNowMeshStats stats() const
+  {
+    EspNowMeshStats copy = stats_;
+    copy.evictions = duplicates_.evictions();
+    return copy;
+  }
+
+  const EspNowMeshPeerTable& peers() const { return peers_; }
+  const uint8_t* self() const { return self_; }
+
+private:
+  /**
+   * @brief build a mesh frame around an inner frame in the transmit buffer
+   * @return mesh frame size
+   */
+  size_t wrap(const uint8_t* origin, uint16_t sequence, uint8_t ttl, uint8_t hops, const uint8_t* inner, size_t innerLength)
+  {
+    EspNowFrameWriter writer(txFrame_, sizeof(txFrame_));
+    uint8_t* payload = writer.begin(ESPNOW_FRAME_MESH, txSequence_++, 0);
+
+    // the inner frame may live in the caller's receive buffer, which never overlaps txFrame_
+    memcpy(payload + ESPNOW_MESH_ORIGIN_OFFSET, origin, 6);
+    espNowWriteU16(payload + ESPNOW_MESH_SEQUENCE_OFFSET, sequence);
+    payload[ESPNOW_MESH_TTL_OFFSET] = ttl;
+    payload[ESPNOW_MESH_HOPS_OFFSET] = hops;
+    memcpy(payload + ESPNOW_MESH_HEADER_SIZE, inner, innerLength);
+    return writer.finish((uint16_t)(ESPNOW_MESH_HEADER_SIZE + innerLength));
+  }
+
+  /**
+   * @brief send the transmit buffer to every peer except the given two
+   * @return number of peers that accepted it
+   */
+  int flood(size_t frameSize, const uint8_t* from, const uint8_t* origin)
+  {
+    int sent = 0;
+    for (int i = 0; i < peers_.size(); i++) {
+      const uint8_t* mac = peers_[i].mac;
+      if ((from != NULL && memcmp(mac, from, 6) == 0) || (origin != NULL && memcmp(mac, origin, 6) == 0)) {
+        continue;
+      }
+      if (send_(mac, txFrame_, frameSize, context_)) {
+        sent++;
+      }
+      else {
+        stats_.sendFailures++;
+      }
+    }
+    return sent;
+  }
+
+  uint8_t self_[6] = {};
+  SendFunction send_;
+  DeliverFunction deliver_;
+  void* context_;
+
+  EspNowMeshPeerTable peers_;
+  EspNowMeshDuplicateCache duplicates_;
+  uint8_t txFrame_[ESPNOW_WIRE_MAX_FRAME_SIZE];
+  uint16_t sequence_ = 0;                     // origin sequence for messages we start
+  uint16_t txSequence_ = 0;                   // outer frame sequence, one per hop
+  EspNowMeshStats stats_;
+};
@@ -0,0 +1,328 @@
+/**
+ * @file espnow_aggregator.h
+ * @brief batches telemetry samples from several producers into full size ESP-NOW frames
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * sending one small struct per packet wastes most of the air time on per-packet overhead.
+ * the aggregator packs samples into a single ESPNOW_FRAME_BATCH frame and sends it when the
+ * next sample would not fit, when the batch reaches the size threshold, or when the oldest
+ * sample has waited for the latency budget. a latency budget of 0 sends every sample on its
+ * own, which is the old behavior.
+ *
+ * batch payload layout (little endian):
+ *
+ *   offset  size  field
+ *   0       4     base timestamp in microseconds
+ *   4       1     record count
+ *   5       ...   records
+ *
+ * record layout:
+ *
+ *   0       1     producer ID
+ *   1       3     signed timestamp offset from the base in microseconds
+ *   4       1     data length
+ *   5       ...   data
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <espnow_wire.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ESPNOW_BATCH_BASE_TIMESTAMP_OFFSET    0
+#define ESPNOW_BATCH_COUNT_OFFSET             4
+#define ESPNOW_BATCH_HEADER_SIZE              5
+#define ESPNOW_BATCH_RECORD_HEADER_SIZE       5
+#define ESPNOW_BATCH_MAX_TIME_OFFSET          0x7FFFFF    // ~8.4 seconds either side of the base, in microseconds
+#define ESPNOW_BATCH_MAX_RECORDS              ((ESPNOW_WIRE_MAX_PAYLOAD_SIZE - ESPNOW_BATCH_HEADER_SIZE) / ESPNOW_BATCH_RECORD_HEADER_SIZE)
+#define ESPNOW_BATCH_MAX_SAMPLE_SIZE          (ESPNOW_WIRE_MAX_PAYLOAD_SIZE - ESPNOW_BATCH_HEADER_SIZE - ESPNOW_BATCH_RECORD_HEADER_SIZE)
+
+
+/**
+ * @brief when a batch is sent
+ */
+struct EspNowAggregatorConfig
+{
+  uint32_t latencyBudgetUs = 20000;                           // longest a sample may wait, 0 sends every sample immediately
+  uint16_t flushSizeBytes = ESPNOW_WIRE_MAX_PAYLOAD_SIZE;     // send once the payload reaches this size
+};
+
+/**
+ * @brief counters for judging how well batching is working
+ */
+struct EspNowAggregatorStats
+{
+  uint32_t samples = 0;           // samples accepted
+  uint32_t frames = 0;            // frames handed to the send function
+  uint32_t sampleBytes = 0;       // sample data bytes sent, excluding all headers
+  uint32_t frameBytes = 0;        // total bytes sent, including all headers
+  uint32_t dropped = 0;           // samples too large to ever fit in a frame
+  uint32_t sizeFlushes = 0;       // frames sent because they were full
+  uint32_t ageFlushes = 0;        // frames sent because the latency budget ran out
+};
+
+
+/*
+===============================================================================================
+                                    Aggregator
+===============================================================================================
+*/
+
+/**
+ * @brief packs samples into batch frames, not thread safe: use it from one task
+ */
+class EspNowAggregator
+{
+public:
+  /**
+   * @brief called with every finished frame, typically wraps esp_now_send()
+   */
+  typedef void (*SendFunction)(const uint8_t* frame, size_t length, void* context);
+
+  /**
+   * @param config flush thresholds
+   * @param send where finished frames go
+   * @param context passed through to send
+   */
+  EspNowAggregator(const EspNowAggregatorConfig& config, SendFunction send, void* context = NULL)
+    : config_(config), send_(send), context_(context), writer_(frame_, sizeof(frame_)) {}
+
+  /**
+   * @brief queue one sample, may send the current batch first to make room
+   *
+   * @param producerId who produced the sample, passed through to the receiver
+   * @param timestampUs when the sample was taken, in microseconds
+   * @param data sample bytes
+   * @param length number of sample bytes, at most ESPNOW_BATCH_MAX_SAMPLE_SIZE
+   * @return false if the sample can never fit in a frame and was dropped
+   */
+  bool add(uint8_t producerId, uint32_t timestampUs, const uint8_t* data, uint8_t length)
+  {
+    if (length > ESPNOW_BATCH_MAX_SAMPLE_SIZE) {
+      stats_.dropped++;
+      return false;
+    }
+
+    // start a new batch if this sample does not fit in time or space
+    if (count_ > 0) {
+      const int32_t offset = (int32_t)(timestampUs - baseTimestampUs_);
+      const bool fits = used_ + ESPNOW_BATCH_RECORD_HEADER_SIZE + length <= config_.flushSizeBytes &&
+                        used_ + ESPNOW_BATCH_RECORD_HEADER_SIZE + length <= ESPNOW_WIRE_MAX_PAYLOAD_SIZE;
+      if (!fits || offset > ESPNOW_BATCH_MAX_TIME_OFFSET || offset < -ESPNOW_BATCH_MAX_TIME_OFFSET) {
+        stats_.sizeFlushes += fits ? 0 : 1;
+        flush();
+      }
+    }
+    if (count_ == 0) {
+      begin(timestampUs);
+    }
+
+    // append the record
+    uint8_t* record = payload_ + used_;
+    const uint32_t offset = timestampUs - baseTimestampUs_;     // two's complement, truncated to 24 bits
+    record[0] = producerId;
+    record[1] = (uint8_t)offset;
+    record[2] = (uint8_t)(offset >> 8);
+    record[3] = (uint8_t)(offset >> 16);
+    record[4] = length;
+    memcpy(record + ESPNOW_BATCH_RECORD_HEADER_SIZE, data, length);
+
+    used_ += ESPNOW_BATCH_RECORD_HEADER_SIZE + length;
+    count_++;
+    if ((int32_t)(timestampUs - oldestTimestampUs_) < 0) {
+      oldestTimestampUs_ = timestampUs;
+    }
+    stats_.samples++;
+    stats_.sampleBytes += length;
+
+    // send right away when batching is off or nothing else would fit
+    if (config_.latencyBudgetUs == 0) {
+      flush();
+    }
+    else if (used_ + ESPNOW_BATCH_RECORD_HEADER_SIZE >= config_.flushSizeBytes) {
+      stats_.sizeFlushes++;
+      flush();
+    }
+    return true;
+  }
+
+  /**
+   * @brief send the batch if its oldest sample has used up the latency budget, call this often
+   *
+   * @param nowUs current time in microseconds
+   */
+  void poll(uint32_t nowUs)
+  {
+    if (count_ > 0 && (int32_t)(nowUs - oldestTimestampUs_) >= (int32_t)config_.latencyBudgetUs) {
+      stats_.ageFlushes++;
+      flush();
+    }
+  }
+
+  /**
+   * @brief send whatever is batched now
+   */
+  void flush()
+  {
+    if (count_ == 0) {
+      return;
+    }
+
+    payload_[ESPNOW_BATCH_COUNT_OFFSET] = count_;
+    const size_t frameSize = writer_.finish(used_);
+    send_(frame_, frameSize, context_);
+
+    stats_.frames++;
+    stats_.frameBytes += frameSize;
+    count_ = 0;
+    used_ = 0;
+  }
+
+  /**
+   * @brief change the flush thresholds, takes effect from the next sample
+   */
+  void configure(const EspNowAggregatorConfig& config) { config_ = config; }
+
+  const EspNowAggregatorConfig& config() const { return config_; }
+  const EspNowAggregatorStats& stats() const { return stats_; }
+  uint8_t pendingSamples() const { return count_; }
+
+private:
+  void begin(uint32_t timestampUs)
+  {
+    payload_ = writer_.begin(ESPNOW_FRAME_BATCH, sequence_++, timestampUs / 1000);
+    espNowWriteU32(payload_ + ESPNOW_BATCH_BASE_TIMESTAMP_OFFSET, timestampUs);
+    baseTimestampUs_ = timestampUs;
+    oldestTimestampUs_ = timestampUs;
+    used_ = ESPNOW_BATCH_HEADER_SIZE;
+  }
+
+  EspNowAggregatorConfig config_;
+  SendFunction send_;
+  void* context_;
+
+  uint8_t frame_[ESPNOW_WIRE_MAX_FRAME_SIZE];
+  EspNowFrameWriter writer_;
+  uint8_t* payload_ = NULL;
+  uint16_t used_ = 0;
+  uint8_t count_ = 0;
+  uint16_t sequence_ = 0;
+  uint32_t baseTimestampUs_ = 0;
+  uint32_t oldestTimestampUs_ = 0;
+  EspNowAggregatorStats stats_;
+};
+
+
+/*
+===============================================================================================
+                                    Batch Reader
+===============================================================================================
+*/
+
+/**
+ * @brief one unbatched sample, data points into the received frame
+ */
+struct EspNowSample
+{
+  uint8_t producerId;
+  uint32_t timestampUs;           // sender clock
+  const uint8_t* data;
+  uint8_t length;
+};
+
+/**
+ * @brief splits a batch frame back into samples
+ */
+class EspNowBatchReader
+{
+public:
+  /**
+   * @brief called once per sample, in timestamp order
+   */
+  typedef void (*SampleFunction)(const EspNowSample& sample, void* context);
+
+  /**
+   * @brief walk every sample of a batch frame in timestamp order
+   * samples are appended in the order they were added, so this is usually a single pass,
+   * producers that hand in samples late are put back in order here
+   *
+   * @param frame a validated frame
+   * @param callback receives each sample
+   * @param context passed through to callback
+   * @return number of samples delivered, -1 if the frame is not a well formed batch
+   */
+  static int forEachSample(const EspNowFrameView& frame, SampleFunction callback, void* context = NULL)
+  {
+    if (frame.type() != ESPNOW_FRAME_BATCH || frame.payloadLength() < ESPNOW_BATCH_HEADER_SIZE) {
+      return -1;
+    }
+
+    const uint8_t* payload = frame.payload();
+    const uint16_t payloadLength = frame.payloadLength();
+    const uint8_t count = payload[ESPNOW_BATCH_COUNT_OFFSET];
+    if (count > ESPNOW_BATCH_MAX_RECORDS) {
+      return -1;
+    }
+
+    // index every record, rejecting the frame if any record runs off the end
+    uint16_t offsets[ESPNOW_BATCH_MAX_RECORDS];
+    uint16_t position = ESPNOW_BATCH_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++) {
+      if (position + ESPNOW_BATCH_RECORD_HEADER_SIZE > payloadLength) {
+        return -1;
+      }
+      const uint8_t length = payload[position + 4];
+      if (position + ESPNOW_BATCH_RECORD_HEADER_SIZE + length > payloadLength) {
+        return -1;
+      }
+
+      // insertion sort on the time offset, stable for equal timestamps
+      int slot = i;
+      while (slot > 0 && timeOffset(payload + offsets[slot - 1]) > timeOffset(payload + position)) {
+        offsets[slot] = offsets[slot - 1];
+        slot--;
+      }
+      offsets[slot] = position;
+
+      position += ESPNOW_BATCH_RECORD_HEADER_SIZE + length;
+    }
+
+    // hand the samples out
+    const uint32_t baseTimestampUs = espNowReadU32(payload + ESPNOW_BATCH_BASE_TIMESTAMP_OFFSET);
+    for (uint8_t i = 0; i < count; i++) {
+      const uint8_t* record = payload + offsets[i];
+      EspNowSample sample = {
+        record[0],
+        baseTimestampUs + (uint32_t)timeOffset(record),
+        record + ESPNOW_BATCH_RECORD_HEADER_SIZE,
+        record[4],
+      };
+      callback(sample, context);
+    }
+    return count;
+  }
+
+private:
+  // sign extended 24 bit offset
+  static int32_t timeOffset(const uint8_t* record)
+  {
+    const uint32_t raw = (uint32_t)record[1] | ((uint32_t)record[2] << 8) | ((uint32_t)record[3] << 16);
+    return (int32_t)(raw << 8) >> 8;
+  }
+};
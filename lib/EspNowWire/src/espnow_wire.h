@@ -0,0 +1,347 @@
+/**
+ * @file espnow_wire.h
+ * @brief versioned, little endian ESP-NOW frame format shared by every ESP-NOW project
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every ESP-NOW packet starts with a fixed 14 byte header followed by the payload:
+ *
+ *   offset  size  field
+ *   0       1     magic (ESPNOW_WIRE_MAGIC)
+ *   1       1     version (ESPNOW_WIRE_VERSION)
+ *   2       1     frame type (EspNowFrameType)
+ *   3       1     flags, reserved, sent as 0
+ *   4       2     sequence number
+ *   6       4     sender timestamp in milliseconds
+ *   10      2     payload length in bytes
+ *   12      2     CRC-16/CCITT-FALSE over bytes 0-11 and the payload
+ *
+ * all multi-byte fields are little endian. frames are never cast to structs: views read the
+ * fields straight out of the receive buffer and writers build them straight into the send
+ * buffer, so nothing depends on struct padding and nothing is copied.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define ESPNOW_WIRE_MAGIC                 0xAE
+#define ESPNOW_WIRE_VERSION               1
+#define ESPNOW_WIRE_HEADER_SIZE           14
+#define ESPNOW_WIRE_MAX_FRAME_SIZE        250         // ESP_NOW_MAX_DATA_LEN
+#define ESPNOW_WIRE_MAX_PAYLOAD_SIZE      (ESPNOW_WIRE_MAX_FRAME_SIZE - ESPNOW_WIRE_HEADER_SIZE)
+
+// header field offsets
+#define ESPNOW_WIRE_MAGIC_OFFSET          0
+#define ESPNOW_WIRE_VERSION_OFFSET        1
+#define ESPNOW_WIRE_TYPE_OFFSET           2
+#define ESPNOW_WIRE_FLAGS_OFFSET          3
+#define ESPNOW_WIRE_SEQUENCE_OFFSET       4
+#define ESPNOW_WIRE_TIMESTAMP_OFFSET      6
+#define ESPNOW_WIRE_LENGTH_OFFSET         10
+#define ESPNOW_WIRE_CRC_OFFSET            12
+
+/**
+ * @brief what the payload of a frame contains
+ */
+enum EspNowFrameType : uint8_t
+{
+  ESPNOW_FRAME_DATA = 1,          // EspNowDataView payload
+  ESPNOW_FRAME_BATCH = 2,         // batched telemetry samples, see espnow_aggregator.h
+  ESPNOW_FRAME_MESH = 3,          // relayed frame with origin and TTL, see espnow_mesh.h
+};
+
+/**
+ * @brief result of validating a received frame
+ */
+enum EspNowParseResult
+{
+  ESPNOW_PARSE_OK,
+  ESPNOW_PARSE_TRUNCATED,         // shorter than the header, or than the length it claims
+  ESPNOW_PARSE_BAD_MAGIC,         // not one of our frames
+  ESPNOW_PARSE_BAD_VERSION,       // sent by firmware with a different wire version
+  ESPNOW_PARSE_BAD_LENGTH,        // payload length larger than a frame can hold
+  ESPNOW_PARSE_BAD_CRC,
+};
+
+
+/*
+===============================================================================================
+                                    Byte Helpers
+===============================================================================================
+*/
+
+inline uint16_t espNowReadU16(const uint8_t* data)
+{
+  return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+inline uint32_t espNowReadU32(const uint8_t* data)
+{
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+inline void espNowWriteU16(uint8_t* data, uint16_t value)
+{
+  data[0] = (uint8_t)value;
+  data[1] = (uint8_t)(value >> 8);
+}
+
+inline void espNowWriteU32(uint8_t* data, uint32_t value)
+{
+  data[0] = (uint8_t)value;
+  data[1] = (uint8_t)(value >> 8);
+  data[2] = (uint8_t)(value >> 16);
+  data[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021), one nibble at a time to keep the table at 32 bytes
+ *
+ * @param crc running crc, start with 0xFFFF
+ * @param data bytes to add
+ * @param length number of bytes
+ */
+inline uint16_t espNowCrc16(uint16_t crc, const uint8_t* data, size_t length)
+{
+  static const uint16_t nibbleTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  };
+
+  for (size_t i = 0; i < length; i++) {
+    crc = (uint16_t)((crc << 4) ^ nibbleTable[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ nibbleTable[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+/**
+ * @brief CRC of a frame, skipping the CRC field itself
+ */
+inline uint16_t espNowFrameCrc(const uint8_t* frame, uint16_t payloadLength)
+{
+  uint16_t crc = espNowCrc16(0xFFFF, frame, ESPNOW_WIRE_CRC_OFFSET);
+  return espNowCrc16(crc, frame + ESPNOW_WIRE_HEADER_SIZE, payloadLength);
+}
+
+
+/*
+===============================================================================================
+                                    Frame View
+===============================================================================================
+*/
+
+/**
+ * @brief read-only view of a validated frame, points into the caller's buffer
+ * the buffer must outlive the view (for receive callbacks: only use it inside the callback)
+ */
+class EspNowFrameView
+{
+public:
+  /**
+   * @brief validate a received buffer and point a view at it
+   *
+   * @param data the received bytes
+   * @param length number of received bytes
+   * @param view set to the frame when the result is ESPNOW_PARSE_OK
+   */
+  static EspNowParseResult parse(const uint8_t* data, int length, EspNowFrameView& view)
+  {
+    if (data == NULL || length < ESPNOW_WIRE_HEADER_SIZE) {
+      return ESPNOW_PARSE_TRUNCATED;
+    }
+    if (data[ESPNOW_WIRE_MAGIC_OFFSET] != ESPNOW_WIRE_MAGIC) {
+      return ESPNOW_PARSE_BAD_MAGIC;
+    }
+    if (data[ESPNOW_WIRE_VERSION_OFFSET] != ESPNOW_WIRE_VERSION) {
+      return ESPNOW_PARSE_BAD_VERSION;
+    }
+
+    const uint16_t payloadLength = espNowReadU16(data + ESPNOW_WIRE_LENGTH_OFFSET);
+    if (payloadLength > ESPNOW_WIRE_MAX_PAYLOAD_SIZE) {
+      return ESPNOW_PARSE_BAD_LENGTH;
+    }
+    if (length < ESPNOW_WIRE_HEADER_SIZE + payloadLength) {
+      return ESPNOW_PARSE_TRUNCATED;
+    }
+    if (espNowReadU16(data + ESPNOW_WIRE_CRC_OFFSET) != espNowFrameCrc(data, payloadLength)) {
+      return ESPNOW_PARSE_BAD_CRC;
+    }
+
+    view.data_ = data;
+    return ESPNOW_PARSE_OK;
+  }
+
+  uint8_t version() const { return data_[ESPNOW_WIRE_VERSION_OFFSET]; }
+  uint8_t type() const { return data_[ESPNOW_WIRE_TYPE_OFFSET]; }
+  uint16_t sequence() const { return espNowReadU16(data_ + ESPNOW_WIRE_SEQUENCE_OFFSET); }
+  uint32_t timestamp() const { return espNowReadU32(data_ + ESPNOW_WIRE_TIMESTAMP_OFFSET); }
+  uint16_t payloadLength() const { return espNowReadU16(data_ + ESPNOW_WIRE_LENGTH_OFFSET); }
+  const uint8_t* payload() const { return data_ + ESPNOW_WIRE_HEADER_SIZE; }
+  size_t size() const { return ESPNOW_WIRE_HEADER_SIZE + payloadLength(); }
+  const uint8_t* data() const { return data_; }
+
+private:
+  const uint8_t* data_ = NULL;
+};
+
+
+/*
+===============================================================================================
+                                    Frame Writer
+===============================================================================================
+*/
+
+/**
+ * @brief builds a frame in place in a caller owned buffer
+ *
+ * usage: payload = writer.begin(...); fill payload; size = writer.finish(payloadLength);
+ */
+class EspNowFrameWriter
+{
+public:
+  /**
+   * @param buffer where the frame is built, at least ESPNOW_WIRE_HEADER_SIZE bytes
+   * @param capacity size of buffer in bytes
+   */
+  EspNowFrameWriter(uint8_t* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+  /**
+   * @brief write the header fields that are known up front
+   *
+   * @return where the payload goes
+   */
+  uint8_t* begin(EspNowFrameType type, uint16_t sequence, uint32_t timestamp)
+  {
+    buffer_[ESPNOW_WIRE_MAGIC_OFFSET] = ESPNOW_WIRE_MAGIC;
+    buffer_[ESPNOW_WIRE_VERSION_OFFSET] = ESPNOW_WIRE_VERSION;
+    buffer_[ESPNOW_WIRE_TYPE_OFFSET] = type;
+    buffer_[ESPNOW_WIRE_FLAGS_OFFSET] = 0;
+    espNowWriteU16(buffer_ + ESPNOW_WIRE_SEQUENCE_OFFSET, sequence);
+    espNowWriteU32(buffer_ + ESPNOW_WIRE_TIMESTAMP_OFFSET, timestamp);
+    return buffer_ + ESPNOW_WIRE_HEADER_SIZE;
+  }
+
+  /**
+   * @brief bytes of payload that fit in the buffer
+   */
+  size_t payloadCapacity() const
+  {
+    size_t capacity = capacity_ < ESPNOW_WIRE_MAX_FRAME_SIZE ? capacity_ : ESPNOW_WIRE_MAX_FRAME_SIZE;
+    return capacity - ESPNOW_WIRE_HEADER_SIZE;
+  }
+
+  /**
+   * @brief seal the frame with its length and CRC
+   *
+   * @param payloadLength bytes written after begin(), at most payloadCapacity()
+   * @return total frame size to pass to esp_now_send(), 0 if the payload did not fit
+   */
+  size_t finish(uint16_t payloadLength)
+  {
+    if (payloadLength > payloadCapacity()) {
+      return 0;
+    }
+
+    espNowWriteU16(buffer_ + ESPNOW_WIRE_LENGTH_OFFSET, payloadLength);
+    espNowWriteU16(buffer_ + ESPNOW_WIRE_CRC_OFFSET, espNowFrameCrc(buffer_, payloadLength));
+    return ESPNOW_WIRE_HEADER_SIZE + payloadLength;
+  }
+
+private:
+  uint8_t* buffer_;
+  size_t capacity_;
+};
+
+
+/*
+===============================================================================================
+                                    Payloads
+===============================================================================================
+*/
+
+// ESPNOW_FRAME_DATA payload layout
+#define ESPNOW_DATA_TIMER_COUNTER_OFFSET  0           // uint32
+#define ESPNOW_DATA_LOOP_COUNTER_OFFSET   4           // uint32
+#define ESPNOW_DATA_BUTTON_STATE_OFFSET   8           // uint8, 0 or 1
+#define ESPNOW_DATA_PAYLOAD_SIZE          9
+
+// producer IDs for the ESPNOW_FRAME_BATCH samples sent by the examples
+#define ESPNOW_PRODUCER_COUNTERS          0           // uint32 timer counter, uint32 loop counter
+#define ESPNOW_PRODUCER_BUTTON            1           // uint8 button state
+#define ESPNOW_PRODUCER_NODE_STATUS       2           // the vehicle node's NODE_STATUS CAN payload, see dbc/vehicle.dbc
+#define ESPNOW_PRODUCER_BUS_STATUS        3           // the last TEST_STATUS payload the vehicle node heard on the CAN bus
+
+/**
+ * @brief in place view of an ESPNOW_FRAME_DATA payload
+ */
+class EspNowDataView
+{
+public:
+  /**
+   * @brief point a view at a frame's payload
+   *
+   * @return false if the frame is not a data frame or its payload is too short
+   */
+  static bool from(const EspNowFrameView& frame, EspNowDataView& view)
+  {
+    if (frame.type() != ESPNOW_FRAME_DATA || frame.payloadLength() < ESPNOW_DATA_PAYLOAD_SIZE) {
+      return false;
+    }
+
+    view.payload_ = frame.payload();
+    return true;
+  }
+
+  uint32_t counterTimer0() const { return espNowReadU32(payload_ + ESPNOW_DATA_TIMER_COUNTER_OFFSET); }
+  uint32_t counterLoop() const { return espNowReadU32(payload_ + ESPNOW_DATA_LOOP_COUNTER_OFFSET); }
+  bool buttonState() const { return payload_[ESPNOW_DATA_BUTTON_STATE_OFFSET] != 0; }
+
+  /**
+   * @brief write a data payload
+   *
+   * @return number of payload bytes written
+   */
+  static uint16_t write(uint8_t* payload, uint32_t counterTimer0, uint32_t counterLoop, bool buttonState)
+  {
+    espNowWriteU32(payload + ESPNOW_DATA_TIMER_COUNTER_OFFSET, counterTimer0);
+    espNowWriteU32(payload + ESPNOW_DATA_LOOP_COUNTER_OFFSET, counterLoop);
+    payload[ESPNOW_DATA_BUTTON_STATE_OFFSET] = buttonState ? 1 : 0;
+    return ESPNOW_DATA_PAYLOAD_SIZE;
+  }
+
+private:
+  const uint8_t* payload_ = NULL;
+};
+
+
+/**
+ * @brief short name for a parse result, for logging
+ */
+inline const char* espNowParseResultName(EspNowParseResult result)
+{
+  switch (result) {
+    case ESPNOW_PARSE_OK:           return "OK";
+    case ESPNOW_PARSE_TRUNCATED:    return "TRUNCATED";
+    case ESPNOW_PARSE_BAD_MAGIC:    return "BAD MAGIC";
+    case ESPNOW_PARSE_BAD_VERSION:  return "BAD VERSION";
+    case ESPNOW_PARSE_BAD_LENGTH:   return "BAD LENGTH";
+    case ESPNOW_PARSE_BAD_CRC:      return "BAD CRC";
+  }
+  return "UNKNOWN";
+}
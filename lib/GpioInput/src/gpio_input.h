@@ -0,0 +1,439 @@
+/**
+ * @file gpio_input.h
+ * @brief edge interrupt driven, debounced digital inputs with timestamped changes
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every edge on an input runs a GPIO ISR (gpio_install_isr_service) that timestamps it with
+ * esp_timer_get_time() and feeds the pin's debounce state machine, then calls a notify hook,
+ * normally a task notification, so the consumer wakes on the change instead of finding it on
+ * its next poll. each pin debounces one of two ways:
+ *
+ *   SETTLE    a change is accepted once the line has been quiet for debounceUs. nothing
+ *             reaches the consumer until then, and a burst that settles back where it
+ *             started is counted as a glitch. for buttons and slow, noisy lines.
+ *   LOCKOUT   the first edge away from the stable level is accepted in the ISR itself, then
+ *             the pin ignores edges for debounceUs and checks where the line ended up. the
+ *             reaction costs only the interrupt latency, for safety faults.
+ *
+ * each accepted change carries the time of the edge that started it and the time it was
+ * accepted. the consumer calls service() whenever it wakes: it settles the pins that are due,
+ * returns the mask of inputs that changed since the last call, and nextDeadlineUs() says when
+ * to call it again even if no edge arrives.
+ *
+ * pause() and resume() switch the pins' interrupts off and on, for when something else drives
+ * the lines on purpose (a loopback test); a level that moved in the meantime is caught up on
+ * resume as one edge.
+ *
+ * GpioInputs is plain state and arithmetic behind a lock, so a host harness can feed it edges
+ * directly (onEdge) or through the simulated GPIO and its ISR shim.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+#include <esp_timer.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <soc/gpio_struct.h>
+#include <esp_attr.h>
+#define GPIO_INPUT_IRAM                   IRAM_ATTR
+#define GPIO_INPUT_LOCK(lock)             portENTER_CRITICAL_SAFE(lock)
+#define GPIO_INPUT_UNLOCK(lock)           portEXIT_CRITICAL_SAFE(lock)
+#define GPIO_INPUT_ISR_FLAGS              ESP_INTR_FLAG_IRAM
+#else
+#define GPIO_INPUT_IRAM
+#define GPIO_INPUT_LOCK(lock)             (void)(lock)
+#define GPIO_INPUT_UNLOCK(lock)           (void)(lock)
+#define GPIO_INPUT_ISR_FLAGS              0
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define GPIO_INPUT_MAX_PINS               8
+#define GPIO_INPUT_NO_DEADLINE            INT64_MAX
+
+/**
+ * @brief how a pin turns edges into accepted changes, see the file comment
+ */
+enum GpioDebounceMode
+{
+  GPIO_DEBOUNCE_SETTLE,
+  GPIO_DEBOUNCE_LOCKOUT,
+};
+
+/**
+ * @brief called from the ISR after an edge, must be IRAM safe on the target
+ *
+ * @param bits input bits that changed or need service() later
+ * @param context what was given to setNotify()
+ * @return true if a higher priority task was woken (the ISR then yields)
+ */
+typedef bool (*GpioInputNotify)(uint32_t bits, void* context);
+
+/**
+ * @brief one input
+ */
+struct GpioInputConfig
+{
+  uint8_t pin = 0;
+  GpioDebounceMode mode = GPIO_DEBOUNCE_SETTLE;
+  uint32_t debounceUs = 20000;
+  bool activeLow = false;             // active() is true while the pin is low
+  gpio_pull_mode_t pull = GPIO_FLOATING;
+  bool loopback = false;              // the pin is also an output, watch what it drives
+};
+
+/**
+ * @brief an input's last accepted change and its counters
+ */
+struct GpioInputState
+{
+  bool active = false;
+  int64_t edgeUs = 0;                 // first edge of the change, from the ISR
+  int64_t acceptedUs = 0;             // when the debouncer accepted it
+  uint16_t bounces = 0;               // extra edges in the burst that made the change
+  uint32_t edges = 0;                 // every interrupt seen
+  uint32_t changes = 0;               // accepted changes
+  uint32_t glitches = 0;              // bursts that settled back to the stable level
+};
+
+
+/*
+===============================================================================================
+                                    Debounced Inputs
+===============================================================================================
+*/
+
+class GpioInputs
+{
+public:
+  /**
+   * @brief add an input before begin()
+   * @return its index (bit in the change mask), -1 if full
+   */
+  int add(const GpioInputConfig& config)
+  {
+    if (count_ >= GPIO_INPUT_MAX_PINS) {
+      return -1;
+    }
+    Input& input = inputs_[count_];
+    input.config = config;
+    input.owner = this;
+    input.index = (uint8_t)count_;
+    return count_++;
+  }
+
+  /**
+   * @brief hook the ISR calls after an edge, set before begin()
+   */
+  void setNotify(GpioInputNotify notify, void* context)
+  {
+    notify_ = notify;
+    notifyContext_ = context;
+  }
+
+  /**
+   * @brief configure the pins as inputs, take their current levels as stable and attach the
+   * ISR to both edges, the ISR service is installed if no one has yet
+   */
+  esp_err_t begin()
+  {
+    esp_err_t result = gpio_install_isr_service(GPIO_INPUT_ISR_FLAGS);
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE) {
+      return result;
+    }
+
+    const int64_t nowUs = esp_timer_get_time();
+    for (int i = 0; i < count_; i++) {
+      Input& input = inputs_[i];
+      const gpio_num_t pin = (gpio_num_t)input.config.pin;
+      result = gpio_set_direction(pin, input.config.loopback ? GPIO_MODE_INPUT_OUTPUT : GPIO_MODE_INPUT);
+      if (result == ESP_OK) {
+        result = gpio_set_pull_mode(pin, input.config.pull);
+      }
+      if (result == ESP_OK) {
+        result = gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+      }
+      if (result != ESP_OK) {
+        return result;
+      }
+
+      GPIO_INPUT_LOCK(&lock_);
+      input.raw = readLevel(input.config.pin);
+      input.stable = input.raw;
+      input.pending = false;
+      input.state.active = input.stable != input.config.activeLow;
+      input.state.acceptedUs = nowUs;
+      GPIO_INPUT_UNLOCK(&lock_);
+
+      result = gpio_isr_handler_add(pin, onInterrupt, &input);
+      if (result != ESP_OK) {
+        return result;
+      }
+    }
+    return ESP_OK;
+  }
+
+  void end()
+  {
+    for (int i = 0; i < count_; i++) {
+      gpio_isr_handler_remove((gpio_num_t)inputs_[i].config.pin);
+    }
+  }
+
+  /**
+   * @brief stop taking edges, e.g. while the pins are driven for a test, until resume()
+   */
+  esp_err_t pause()
+  {
+    for (int i = 0; i < count_; i++) {
+      const esp_err_t result = gpio_intr_disable((gpio_num_t)inputs_[i].config.pin);
+      if (result != ESP_OK) {
+        return result;
+      }
+    }
+    return ESP_OK;
+  }
+
+  /**
+   * @brief take edges again, a pin that is not where it was when paused counts as one edge now
+   * the interrupt is enabled before the pin is read, so an edge in between is not lost
+   */
+  esp_err_t resume()
+  {
+    uint32_t bits = 0;
+    const int64_t nowUs = esp_timer_get_time();
+    for (int i = 0; i < count_; i++) {
+      const esp_err_t result = gpio_intr_enable((gpio_num_t)inputs_[i].config.pin);
+      if (result != ESP_OK) {
+        return result;
+      }
+      GPIO_INPUT_LOCK(&lock_);
+      const bool level = readLevel(inputs_[i].config.pin);
+      const bool moved = level != inputs_[i].raw;
+      GPIO_INPUT_UNLOCK(&lock_);
+      // the level that was read, raw may already be the ISR's by now
+      if (moved) {
+        bits |= onEdge(i, level, nowUs);
+      }
+    }
+    // the hook runs in the caller's task here, not in the ISR
+    if (bits != 0 && notify_ != NULL && notify_(bits, notifyContext_)) {
+#ifdef ESP_PLATFORM
+      taskYIELD();
+#endif
+    }
+    return ESP_OK;
+  }
+
+  // --------------------------------- ISR side --------------------------------- //
+
+  /**
+   * @brief feed one edge to an input's debouncer, what the ISR does with the level it read
+   * @return bits of inputs that changed or now need service()
+   */
+  GPIO_INPUT_IRAM uint32_t onEdge(int index, bool level, int64_t nowUs)
+  {
+    Input& input = inputs_[index];
+    const uint32_t bit = 1u << index;
+    uint32_t bits = 0;
+
+    GPIO_INPUT_LOCK(&lock_);
+    input.state.edges++;
+    input.raw = level;
+    input.lastEdgeUs = nowUs;
+
+    if (input.config.mode == GPIO_DEBOUNCE_LOCKOUT && nowUs >= input.lockoutUntilUs) {
+      // outside the lockout the first edge away from the stable level is the change, a
+      // lockout service() has not looked at yet is settled by this edge too
+      input.pending = false;
+      if (level != input.stable) {
+        accept(input, nowUs, nowUs);
+        changed_ |= bit;
+        bits = bit;
+      }
+    }
+    else {
+      if (!input.pending) {
+        input.pending = true;
+        input.burstStartUs = nowUs;
+        input.burstEdges = 0;
+      }
+      else {
+        input.burstEdges++;
+      }
+      bits = bit;
+    }
+    GPIO_INPUT_UNLOCK(&lock_);
+    return bits;
+  }
+
+  // -------------------------------- task side --------------------------------- //
+
+  /**
+   * @brief settle the inputs that are due
+   * @return bits of inputs whose accepted state changed since the last call
+   */
+  uint32_t service(int64_t nowUs)
+  {
+    GPIO_INPUT_LOCK(&lock_);
+    for (int i = 0; i < count_; i++) {
+      Input& input = inputs_[i];
+      if (!input.pending || nowUs < dueUs(input)) {
+        continue;
+      }
+
+      input.pending = false;
+      if (input.raw == input.stable) {
+        // a lockout normally ends where it started, only a settle burst can be a glitch
+        if (input.config.mode == GPIO_DEBOUNCE_SETTLE) {
+          input.state.glitches++;
+        }
+      }
+      else if (input.config.mode == GPIO_DEBOUNCE_LOCKOUT) {
+        // the line moved again during the lockout and stayed there
+        accept(input, input.lastEdgeUs, nowUs);
+        changed_ |= 1u << i;
+      }
+      else {
+        accept(input, input.burstStartUs, nowUs);
+        changed_ |= 1u << i;
+      }
+    }
+    const uint32_t changed = changed_;
+    changed_ = 0;
+    GPIO_INPUT_UNLOCK(&lock_);
+    return changed;
+  }
+
+  /**
+   * @brief when service() next has work without a new edge, GPIO_INPUT_NO_DEADLINE if never
+   */
+  int64_t nextDeadlineUs()
+  {
+    int64_t deadline = GPIO_INPUT_NO_DEADLINE;
+    GPIO_INPUT_LOCK(&lock_);
+    for (int i = 0; i < count_; i++) {
+      if (inputs_[i].pending && dueUs(inputs_[i]) < deadline) {
+        deadline = dueUs(inputs_[i]);
+      }
+    }
+    GPIO_INPUT_UNLOCK(&lock_);
+    return deadline;
+  }
+
+  /**
+   * @brief consistent copy of an input's last change and counters
+   */
+  GpioInputState state(int index)
+  {
+    GPIO_INPUT_LOCK(&lock_);
+    GpioInputState copy = inputs_[index].state;
+    GPIO_INPUT_UNLOCK(&lock_);
+    return copy;
+  }
+
+  bool active(int index) { return state(index).active; }
+  int size() const { return count_; }
+  uint8_t pin(int index) const { return inputs_[index].config.pin; }
+
+#ifdef ESP_PLATFORM
+  /**
+   * @brief notify hook that sets the bits in a task's notification value, context is the TaskHandle_t
+   */
+  static GPIO_INPUT_IRAM bool notifyTask(uint32_t bits, void* context)
+  {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyFromISR((TaskHandle_t)context, bits, eSetBits, &higherPriorityTaskWoken);
+    return higherPriorityTaskWoken == pdTRUE;
+  }
+#endif
+
+private:
+  struct Input
+  {
+    GpioInputConfig config;
+    GpioInputs* owner = NULL;
+    uint8_t index = 0;
+
+    bool stable = false;              // debounced level
+    bool raw = false;                 // level at the last edge
+    bool pending = false;             // service() has to look at it
+    int64_t lastEdgeUs = 0;
+    int64_t burstStartUs = 0;
+    int64_t lockoutUntilUs = 0;
+    uint16_t burstEdges = 0;
+
+    GpioInputState state;
+  };
+
+  static int64_t dueUs(const Input& input)
+  {
+    return input.config.mode == GPIO_DEBOUNCE_LOCKOUT ? input.lockoutUntilUs : input.lastEdgeUs + input.config.debounceUs;
+  }
+
+  static GPIO_INPUT_IRAM void accept(Input& input, int64_t edgeUs, int64_t nowUs)
+  {
+    input.stable = input.raw;
+    input.state.active = input.stable != input.config.activeLow;
+    input.state.edgeUs = edgeUs;
+    input.state.acceptedUs = nowUs;
+    input.state.bounces = input.burstEdges;
+    input.state.changes++;
+    input.burstEdges = 0;
+    if (input.config.mode == GPIO_DEBOUNCE_LOCKOUT) {
+      input.lockoutUntilUs = nowUs + input.config.debounceUs;
+      input.pending = true;           // look at the line again when the lockout ends
+      input.burstStartUs = nowUs;
+    }
+  }
+
+  static GPIO_INPUT_IRAM bool readLevel(uint8_t pin)
+  {
+#ifdef ESP_PLATFORM
+    // the register, gpio_get_level() is not in IRAM
+    return pin < 32 ? (GPIO.in >> pin) & 1 : (GPIO.in1.data >> (pin - 32)) & 1;
+#else
+    return gpio_get_level((gpio_num_t)pin) != 0;
+#endif
+  }
+
+  static GPIO_INPUT_IRAM void onInterrupt(void* arg)
+  {
+    Input& input = *(Input*)arg;
+    GpioInputs& inputs = *input.owner;
+    const uint32_t bits = inputs.onEdge(input.index, readLevel(input.config.pin), esp_timer_get_time());
+    if (bits != 0 && inputs.notify_ != NULL && inputs.notify_(bits, inputs.notifyContext_)) {
+#ifdef ESP_PLATFORM
+      portYIELD_FROM_ISR();
+#endif
+    }
+  }
+
+  Input inputs_[GPIO_INPUT_MAX_PINS];
+  int count_ = 0;
+  uint32_t changed_ = 0;
+  GpioInputNotify notify_ = NULL;
+  void* notifyContext_ = NULL;
+#ifdef ESP_PLATFORM
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+  int lock_ = 0;
+#endif
+};
@@ -0,0 +1,147 @@
+/**
+ * @file gpio_port.h
+ * @brief a fixed set of output pins written together through the GPIO set / clear registers
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the pin map is a template argument list, so the set and clear masks for a given set of
+ * levels are worked out at compile time (or in a few instructions for levels only known at
+ * run time). a write is one store to out_w1tc and one to out_w1ts per bank: pins 0 - 31 sit
+ * in GPIO.out, 32 - 39 in GPIO.out1, and a port that only uses one bank never touches the
+ * other. all the falling pins of a bank change on one store and all the rising pins on the
+ * next, instead of one driver call per pin a few hundred nanoseconds apart, and pins the port
+ * does not own are never read or rewritten, so it is safe next to other code (and ISRs)
+ * driving the rest of the bank.
+ *
+ * the pins must already be outputs (pinMode or gpio_set_direction). on the host the masks go
+ * to halSim().gpio, which applies them all in the same instant.
+ *
+ *   typedef GpioPort<32, 33, 25, 26> FaultOutputs;     // bit 0 is pin 32, bit 1 pin 33, ...
+ *   FaultOutputs::write(0x5);                          // 32 and 25 high, 33 and 26 low
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <soc/gpio_struct.h>
+#include <esp_attr.h>
+#define GPIO_PORT_IRAM                    IRAM_ATTR
+#else
+#include <hal_sim.h>
+#define GPIO_PORT_IRAM
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define GPIO_PORT_FIRST_INPUT_ONLY        34          // GPIO 34 - 39 have no output driver
+#define GPIO_PORT_MAX_PINS                32          // one bit of the level word per pin
+
+
+/*
+===============================================================================================
+                                    Pin Map
+===============================================================================================
+*/
+
+/**
+ * @brief compile-time masks over a pin list, level bit i belongs to the i-th pin
+ */
+template <uint8_t... Pins>
+struct GpioPinMap
+{
+  static constexpr uint64_t all() { return 0; }
+  static constexpr uint64_t high(uint32_t, int) { return 0; }
+};
+
+template <uint8_t Pin, uint8_t... Rest>
+struct GpioPinMap<Pin, Rest...>
+{
+  static_assert(Pin < GPIO_PORT_FIRST_INPUT_ONLY, "GPIO 34 - 39 are input only");
+
+  static constexpr uint64_t all() { return 1ull << Pin | GpioPinMap<Rest...>::all(); }
+
+  static constexpr uint64_t high(uint32_t levels, int index)
+  {
+    return ((levels >> index) & 1 ? 1ull << Pin : 0) | GpioPinMap<Rest...>::high(levels, index + 1);
+  }
+};
+
+
+/*
+===============================================================================================
+                                    Port
+===============================================================================================
+*/
+
+template <uint8_t... Pins>
+class GpioPort
+{
+public:
+  typedef GpioPinMap<Pins...> Map;
+
+  static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= GPIO_PORT_MAX_PINS, "a port has 1 to 32 pins");
+  static_assert(__builtin_popcountll(Map::all()) == sizeof...(Pins), "a pin is listed twice");
+
+  static constexpr uint64_t pins() { return Map::all(); }
+
+  /**
+   * @brief pins to set for the given levels, bit i of levels is the i-th pin in the list
+   */
+  static constexpr uint64_t setMask(uint32_t levels) { return Map::high(levels, 0); }
+
+  /**
+   * @brief pins to clear for the given levels
+   */
+  static constexpr uint64_t clearMask(uint32_t levels) { return Map::all() & ~Map::high(levels, 0); }
+
+  /**
+   * @brief drive every pin of the port, bit i of levels is the i-th pin in the list
+   */
+  static GPIO_PORT_IRAM void write(uint32_t levels) { apply(setMask(levels), clearMask(levels)); }
+
+  /**
+   * @brief write levels known at compile time, the masks are constants
+   */
+  template <uint32_t Levels>
+  static GPIO_PORT_IRAM void write()
+  {
+    constexpr uint64_t set = setMask(Levels);
+    constexpr uint64_t clear = clearMask(Levels);
+    apply(set, clear);
+  }
+
+  /**
+   * @brief store the masks, clear before set in each bank
+   */
+  static GPIO_PORT_IRAM void apply(uint64_t set, uint64_t clear)
+  {
+#ifdef ESP_PLATFORM
+    if (usesLowBank()) {
+      GPIO.out_w1tc = (uint32_t)clear;
+      GPIO.out_w1ts = (uint32_t)set;
+    }
+    if (usesHighBank()) {
+      GPIO.out1_w1tc.val = (uint32_t)(clear >> 32);
+      GPIO.out1_w1ts.val = (uint32_t)(set >> 32);
+    }
+#else
+    halSim().gpio.writeMasks(set, clear);
+#endif
+  }
+
+  static constexpr bool usesLowBank() { return (Map::all() & 0xFFFFFFFFull) != 0; }
+  static constexpr bool usesHighBank() { return (Map::all() >> 32) != 0; }
+};
@@ -0,0 +1,205 @@
+/**
+ * @file Arduino.h
+ * @brief host stand-in for the Arduino core on the simulated board, native builds only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * covers what the plain sketches use: pins, analogRead, delays, millis / micros and Serial.
+ * delay() moves the virtual clock, so a sketch that waits a second per loop runs an hour of
+ * virtual time in a blink. Serial models the UART at the baud rate given to begin(): bytes
+ * drain at baud / 10 per second through a hardware FIFO, and a write that overflows the FIFO
+ * blocks (moves the clock) until there is room, like the real HardwareSerial.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <hal_sim.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define LOW                               0
+#define HIGH                              1
+
+#define INPUT                             0x01
+#define OUTPUT                            0x03
+#define INPUT_PULLUP                      0x05
+#define INPUT_PULLDOWN                    0x09
+
+#define IRAM_ATTR
+
+#define SIM_SERIAL_FIFO_SIZE              128         // ESP32 UART hardware TX FIFO
+#define SIM_SERIAL_PRINTF_SIZE            256
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+
+/*
+===============================================================================================
+                                    Pins and Time
+===============================================================================================
+*/
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  HalPinMode halMode = HAL_PIN_INPUT;
+  switch (mode) {
+    case OUTPUT:          halMode = HAL_PIN_OUTPUT;             break;
+    case INPUT_PULLUP:    halMode = HAL_PIN_INPUT_PULLUP;       break;
+    case INPUT_PULLDOWN:  halMode = HAL_PIN_INPUT_PULLDOWN;     break;
+    default:                                                    break;
+  }
+  halSim().gpio.setMode(pin, halMode);
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level) { halSim().gpio.write(pin, level != LOW); }
+inline int digitalRead(uint8_t pin) { return halSim().gpio.read(pin) ? HIGH : LOW; }
+inline uint16_t analogRead(uint8_t pin) { return halSim().adc.read(pin); }
+
+inline unsigned long micros() { return (unsigned long)halSim().clock.nowUs(); }
+inline unsigned long millis() { return (unsigned long)(halSim().clock.nowUs() / 1000); }
+inline void delayMicroseconds(uint32_t us) { halSim().clock.advance(us); }
+inline void delay(uint32_t ms) { halSim().clock.advance((int64_t)ms * 1000); }
+
+
+/*
+===============================================================================================
+                                    Serial
+===============================================================================================
+*/
+
+/**
+ * @brief UART with a timed TX FIFO, output goes to halSim().log and input comes from halSim().serialInput
+ */
+class SimSerial
+{
+public:
+  void begin(unsigned long baud)
+  {
+    byteNs_ = baud != 0 ? 10000000000ll / (int64_t)baud : 0;     // start + 8 data + stop bits
+    drainedAtNs_ = 0;
+  }
+
+  void end() { byteNs_ = 0; }
+
+  size_t write(const uint8_t* data, size_t length)
+  {
+    if (byteNs_ != 0) {
+      const int64_t nowNs = halSim().clock.nowUs() * 1000;
+      drainedAtNs_ = (drainedAtNs_ > nowNs ? drainedAtNs_ : nowNs) + (int64_t)length * byteNs_;
+
+      // the writer waits while the FIFO holds more than it can
+      const int64_t overflowNs = drainedAtNs_ - nowNs - SIM_SERIAL_FIFO_SIZE * byteNs_;
+      if (overflowNs > 0) {
+        blockedUs_ += (overflowNs + 999) / 1000;
+        halSim().clock.advance((overflowNs + 999) / 1000);
+      }
+    }
+    return halSim().log.write(data, length);
+  }
+
+  size_t write(uint8_t value) { return write(&value, 1); }
+  size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(char value) { return write((uint8_t)value); }
+  size_t print(int value) { return printf("%d", value); }
+  size_t print(unsigned int value) { return printf("%u", value); }
+  size_t print(long value) { return printf("%ld", value); }
+  size_t print(unsigned long value) { return printf("%lu", value); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+
+  __attribute__((format(printf, 2, 3))) size_t printf(const char* format, ...)
+  {
+    char buffer[SIM_SERIAL_PRINTF_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+      return 0;
+    }
+    return write((const uint8_t*)buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+  }
+
+  int available() { return (int)(halSim().serialInput.size() - readPosition_); }
+
+  int read()
+  {
+    if (available() <= 0) {
+      return -1;
+    }
+    return (uint8_t)halSim().serialInput[readPosition_++];
+  }
+
+  int availableForWrite()
+  {
+    if (byteNs_ == 0) {
+      return SIM_SERIAL_FIFO_SIZE;
+    }
+    const int64_t backlogNs = drainedAtNs_ - halSim().clock.nowUs() * 1000;
+    const int64_t queued = backlogNs > 0 ? (backlogNs + byteNs_ - 1) / byteNs_ : 0;
+    return queued >= SIM_SERIAL_FIFO_SIZE ? 0 : (int)(SIM_SERIAL_FIFO_SIZE - queued);
+  }
+
+  /**
+   * @brief wait until everything written has left the UART
+   */
+  void flush()
+  {
+    const int64_t backlogNs = drainedAtNs_ - halSim().clock.nowUs() * 1000;
+    if (backlogNs > 0) {
+      halSim().clock.advance((backlogNs + 999) / 1000);
+    }
+  }
+
+  /**
+   * @brief virtual time writers spent waiting for FIFO space
+   */
+  uint64_t blockedUs() const { return blockedUs_; }
+
+private:
+  int64_t byteNs_ = 0;                // 0 until begin(), writes then cost no time
+  int64_t drainedAtNs_ = 0;           // when the last queued byte is out
+  size_t readPosition_ = 0;
+  uint64_t blockedUs_ = 0;
+};
+
+inline SimSerial Serial;
+
+
+/*
+===============================================================================================
+                                    Sketch Runner
+===============================================================================================
+*/
+
+/**
+ * @brief run setup() once, then loop() until durationUs of virtual time has passed
+ *
+ * @param loopCostUs virtual time charged per loop() pass on top of its own delays, keeps a
+ * sketch with no delay() in its loop from spinning without time moving
+ */
+inline void halSimRunSketch(void (*setupFunction)(), void (*loopFunction)(), int64_t durationUs, uint32_t loopCostUs)
+{
+  SimClock& clock = halSim().clock;
+  const int64_t endUs = clock.nowUs() + durationUs;
+  setupFunction();
+  while (clock.nowUs() < endUs) {
+    loopFunction();
+    clock.advance(loopCostUs);
+  }
+}
@@ -0,0 +1,266 @@
+/**
+ * @file adc.h
+ * @brief host stand-in for ESP-IDF 4.4's continuous (DMA) mode of driver/adc.h on the simulated ADC
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * conversions happen on the virtual clock at sample_freq_hz, cycling through the pattern, and
+ * reach the driver's store in whole DMA frames of conv_num_each_intr bytes. each one is taken
+ * from halSim().adc at the moment it was converted, by ADC1 channel's GPIO (ESP32 pin map).
+ * like the real ring buffer, frames that do not fit the store are dropped, counted in
+ * simAdcDigi().dropped. adc_digi_read_bytes never blocks: with nothing stored it returns
+ * ESP_ERR_TIMEOUT whatever the timeout. ADC1 only, as on the ESP32. native builds only.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include "esp_err.h"
+#include <hal_sim.h>
+
+
+/*
+===============================================================================================
+                                    Types
+===============================================================================================
+*/
+
+#define ADC_MAX_DELAY                     UINT32_MAX
+#define SOC_ADC_PATT_LEN_MAX              16
+#define SOC_ADC_DIGI_MAX_BITWIDTH         12
+#define SOC_ADC_CHANNEL_NUM(unit)         8
+#define SOC_ADC_DIGI_RESULT_BYTES         2
+
+typedef enum {
+  ADC1_CHANNEL_0,
+  ADC1_CHANNEL_1,
+  ADC1_CHANNEL_2,
+  ADC1_CHANNEL_3,
+  ADC1_CHANNEL_4,
+  ADC1_CHANNEL_5,
+  ADC1_CHANNEL_6,
+  ADC1_CHANNEL_7,
+  ADC1_CHANNEL_MAX,
+} adc1_channel_t;
+
+typedef enum {
+  ADC_ATTEN_DB_0,
+  ADC_ATTEN_DB_2_5,
+  ADC_ATTEN_DB_6,
+  ADC_ATTEN_DB_11,
+} adc_atten_t;
+
+typedef enum {
+  ADC_CONV_SINGLE_UNIT_1 = 1,
+  ADC_CONV_SINGLE_UNIT_2 = 2,
+  ADC_CONV_BOTH_UNIT,
+  ADC_CONV_ALTER_UNIT,
+} adc_digi_convert_mode_t;
+
+typedef enum {
+  ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+  ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+} adc_digi_output_format_t;
+
+typedef struct {
+  uint32_t max_store_buf_size;
+  uint32_t conv_num_each_intr;
+  uint32_t adc1_chan_mask;
+  uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+  uint8_t atten;
+  uint8_t channel;
+  uint8_t unit;
+  uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+  bool conv_limit_en;
+  uint32_t conv_limit_num;
+  uint32_t pattern_num;
+  adc_digi_pattern_config_t* adc_pattern;
+  uint32_t sample_freq_hz;
+  adc_digi_convert_mode_t conv_mode;
+  adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+  union {
+    struct {
+      uint16_t data : 12;
+      uint16_t channel : 4;
+    } type1;
+    uint16_t val;
+  };
+} adc_digi_output_data_t;
+
+
+/*
+===============================================================================================
+                                    Driver State
+===============================================================================================
+*/
+
+static const uint8_t simAdc1ChannelPins[ADC1_CHANNEL_MAX] = { 36, 37, 38, 39, 32, 33, 34, 35 };
+
+struct SimAdcDigi
+{
+  bool initialized = false;
+  bool started = false;
+  uint32_t storeBytes = 0;
+  uint32_t frameBytes = 0;
+  uint32_t sampleFreqHz = 0;
+  uint32_t patternLength = 0;
+  adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX] = {};
+  int64_t startUs = 0;
+  uint64_t frames = 0;                // frames the DMA has finished, stored or dropped
+  std::deque<uint64_t> store;         // first conversion of each stored frame, oldest first
+  uint32_t readOffset = 0;            // conversions already read from the oldest frame
+  uint64_t dropped = 0;               // conversions lost to a full store
+
+  uint32_t frameConversions() const { return frameBytes / SOC_ADC_DIGI_RESULT_BYTES; }
+  uint64_t stored() const { return store.size() * frameConversions() - readOffset; }
+};
+
+inline SimAdcDigi& simAdcDigi()
+{
+  static SimAdcDigi digi;
+  return digi;
+}
+
+/**
+ * @brief move the frames the DMA has finished by now into the store, dropping what does not fit
+ */
+inline void simAdcDigiUpdate()
+{
+  SimAdcDigi& digi = simAdcDigi();
+  const uint32_t frameConversions = digi.frameConversions();
+  const uint64_t converted = (uint64_t)(halSim().clock.nowUs() - digi.startUs) * digi.sampleFreqHz / 1000000;
+  const uint64_t capacity = digi.storeBytes / SOC_ADC_DIGI_RESULT_BYTES;
+  for (; digi.frames < converted / frameConversions; digi.frames++) {
+    if (digi.stored() + frameConversions <= capacity) {
+      digi.store.push_back(digi.frames * frameConversions);
+    }
+    else {
+      // the ring buffer keeps what it has, the new frame is lost
+      digi.dropped += frameConversions;
+    }
+  }
+}
+
+
+/*
+===============================================================================================
+                                    Continuous Mode
+===============================================================================================
+*/
+
+inline esp_err_t adc_digi_initialize(const adc_digi_init_config_t* config)
+{
+  SimAdcDigi& digi = simAdcDigi();
+  if (config == NULL || config->conv_num_each_intr == 0 || config->conv_num_each_intr % SOC_ADC_DIGI_RESULT_BYTES != 0 ||
+    config->max_store_buf_size < config->conv_num_each_intr || config->adc2_chan_mask != 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (digi.initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  digi.dropped = 0;
+  digi.initialized = true;
+  digi.storeBytes = config->max_store_buf_size;
+  digi.frameBytes = config->conv_num_each_intr;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config)
+{
+  SimAdcDigi& digi = simAdcDigi();
+  if (!digi.initialized) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (config == NULL || config->sample_freq_hz == 0 || config->pattern_num == 0 || config->pattern_num > SOC_ADC_PATT_LEN_MAX ||
+    config->conv_mode != ADC_CONV_SINGLE_UNIT_1 || config->format != ADC_DIGI_OUTPUT_FORMAT_TYPE1) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (uint32_t i = 0; i < config->pattern_num; i++) {
+    if (config->adc_pattern[i].channel >= ADC1_CHANNEL_MAX || config->adc_pattern[i].unit != 0) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    digi.pattern[i] = config->adc_pattern[i];
+  }
+  digi.patternLength = config->pattern_num;
+  digi.sampleFreqHz = config->sample_freq_hz;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_digi_start()
+{
+  SimAdcDigi& digi = simAdcDigi();
+  if (!digi.initialized || digi.patternLength == 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  digi.started = true;
+  digi.startUs = halSim().clock.nowUs();
+  digi.frames = 0;
+  digi.store.clear();
+  digi.readOffset = 0;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_digi_stop()
+{
+  simAdcDigi().started = false;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_digi_deinitialize()
+{
+  SimAdcDigi& digi = simAdcDigi();
+  digi.initialized = false;
+  digi.started = false;
+  digi.patternLength = 0;
+  digi.store.clear();
+  digi.readOffset = 0;
+  return ESP_OK;
+}
+
+/**
+ * @brief copy stored conversions out, whole results only, oldest first
+ */
+inline esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms)
+{
+  (void)timeout_ms;
+  SimAdcDigi& digi = simAdcDigi();
+  *out_length = 0;
+  if (!digi.started) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  simAdcDigiUpdate();
+  if (digi.store.empty()) {
+    return ESP_ERR_TIMEOUT;
+  }
+
+  uint32_t count = 0;
+  while (count < length_max / SOC_ADC_DIGI_RESULT_BYTES && !digi.store.empty()) {
+    const uint64_t conversion = digi.store.front() + digi.readOffset;
+    const adc_digi_pattern_config_t& entry = digi.pattern[conversion % digi.patternLength];
+    const int64_t atUs = digi.startUs + (int64_t)(conversion * 1000000 / digi.sampleFreqHz);
+    adc_digi_output_data_t result;
+    result.val = 0;
+    result.type1.channel = entry.channel;
+    result.type1.data = halSim().adc.readAt(simAdc1ChannelPins[entry.channel], atUs);
+    memcpy(buf + count * SOC_ADC_DIGI_RESULT_BYTES, &result, SOC_ADC_DIGI_RESULT_BYTES);
+    count++;
+
+    if (++digi.readOffset == digi.frameConversions()) {
+      digi.store.pop_front();
+      digi.readOffset = 0;
+    }
+  }
+  *out_length = count * SOC_ADC_DIGI_RESULT_BYTES;
+  return ESP_OK;
+}
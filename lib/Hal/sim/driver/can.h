@@ -0,0 +1,270 @@
+/**
+ * @file can.h
+ * @brief host stand-in for ESP-IDF's legacy driver/can.h (TWAI) on the simulated controller
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the functions talk to halSim().currentCan(), so one process can run several nodes by
+ * selecting each node's controller before running its code. calls never block: an empty RX
+ * queue, a full TX queue or no pending alerts return ESP_ERR_TIMEOUT whatever the tick count.
+ * native builds only.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include <hal_sim.h>
+
+
+/*
+===============================================================================================
+                                    Types
+===============================================================================================
+*/
+
+typedef uint32_t TickType_t;
+
+typedef enum {
+  CAN_MODE_NORMAL,
+  CAN_MODE_NO_ACK,
+  CAN_MODE_LISTEN_ONLY,
+} can_mode_t;
+
+typedef enum {
+  CAN_STATE_STOPPED,
+  CAN_STATE_RUNNING,
+  CAN_STATE_BUS_OFF,
+  CAN_STATE_RECOVERING,
+} can_state_t;
+
+typedef struct {
+  can_mode_t mode;
+  gpio_num_t tx_io;
+  gpio_num_t rx_io;
+  gpio_num_t clkout_io;
+  gpio_num_t bus_off_io;
+  uint32_t tx_queue_len;
+  uint32_t rx_queue_len;
+  uint32_t alerts_enabled;
+  uint32_t clkout_divider;
+  int intr_flags;
+} can_general_config_t;
+
+typedef struct {
+  uint32_t brp;
+  uint8_t tseg_1;
+  uint8_t tseg_2;
+  uint8_t sjw;
+  bool triple_sampling;
+} can_timing_config_t;
+
+typedef struct {
+  uint32_t acceptance_code;
+  uint32_t acceptance_mask;
+  bool single_filter;
+} can_filter_config_t;
+
+typedef struct {
+  can_state_t state;
+  uint32_t msgs_to_tx;
+  uint32_t msgs_to_rx;
+  uint32_t tx_error_counter;
+  uint32_t rx_error_counter;
+  uint32_t tx_failed_count;
+  uint32_t rx_missed_count;
+  uint32_t arb_lost_count;
+  uint32_t bus_error_count;
+} can_status_info_t;
+
+typedef struct {
+  uint32_t flags;
+  uint32_t identifier;
+  uint8_t data_length_code;
+  uint8_t data[8];
+} can_message_t;
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_MSG_FLAG_NONE                 0x00
+#define CAN_MSG_FLAG_EXTD                 0x01
+#define CAN_MSG_FLAG_RTR                  0x02
+#define CAN_MSG_FLAG_SS                   0x04
+#define CAN_MSG_FLAG_SELF                 0x08
+
+#define CAN_ALERT_NONE                    0x0000
+#define CAN_ALERT_TX_IDLE                 HAL_CAN_ALERT_TX_IDLE
+#define CAN_ALERT_TX_SUCCESS              HAL_CAN_ALERT_TX_SUCCESS
+#define CAN_ALERT_BELOW_ERR_WARN          0x0004
+#define CAN_ALERT_ERR_ACTIVE              0x0008
+#define CAN_ALERT_RECOVERY_IN_PROGRESS    0x0010
+#define CAN_ALERT_BUS_RECOVERED           HAL_CAN_ALERT_BUS_RECOVERED
+#define CAN_ALERT_ARB_LOST                HAL_CAN_ALERT_ARB_LOST
+#define CAN_ALERT_ABOVE_ERR_WARN          0x0080
+#define CAN_ALERT_BUS_ERROR               HAL_CAN_ALERT_BUS_ERROR
+#define CAN_ALERT_TX_FAILED               HAL_CAN_ALERT_TX_FAILED
+#define CAN_ALERT_RX_QUEUE_FULL           HAL_CAN_ALERT_RX_QUEUE_FULL
+#define CAN_ALERT_ERR_PASS                HAL_CAN_ALERT_ERR_PASS
+#define CAN_ALERT_BUS_OFF                 HAL_CAN_ALERT_BUS_OFF
+#define CAN_ALERT_ALL                     0x3FFF
+
+#define CAN_IO_UNUSED                     ((gpio_num_t)-1)
+
+#define CAN_GENERAL_CONFIG_DEFAULT(tx_io_num, rx_io_num, op_mode) \
+  { op_mode, tx_io_num, rx_io_num, CAN_IO_UNUSED, CAN_IO_UNUSED, 5, 5, CAN_ALERT_NONE, 0, 0 }
+
+// 80 MHz APB clock / brp / (1 + tseg_1 + tseg_2)
+#define CAN_TIMING_CONFIG_125KBITS()      { 32, 15, 4, 3, false }
+#define CAN_TIMING_CONFIG_250KBITS()      { 16, 15, 4, 3, false }
+#define CAN_TIMING_CONFIG_500KBITS()      { 8, 15, 4, 3, false }
+#define CAN_TIMING_CONFIG_1MBITS()        { 4, 15, 4, 3, false }
+
+#define CAN_FILTER_CONFIG_ACCEPT_ALL()    { 0, 0xFFFFFFFF, true }
+
+
+/*
+===============================================================================================
+                                    Driver
+===============================================================================================
+*/
+
+inline esp_err_t simCanResult(HalCanResult result)
+{
+  switch (result) {
+    case HAL_CAN_OK:              return ESP_OK;
+    case HAL_CAN_TIMEOUT:         return ESP_ERR_TIMEOUT;
+    case HAL_CAN_NOT_RUNNING:     return ESP_ERR_INVALID_STATE;
+    default:                      return ESP_ERR_INVALID_ARG;
+  }
+}
+
+inline esp_err_t can_driver_install(const can_general_config_t* general, const can_timing_config_t* timing, const can_filter_config_t* filter)
+{
+  if (general == NULL || timing == NULL || filter == NULL || timing->brp == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  SimCanFilter simFilter;
+  simFilter.code = filter->acceptance_code;
+  simFilter.mask = filter->acceptance_mask;
+  simFilter.single = filter->single_filter;
+
+  const uint32_t bitrate = 80000000 / timing->brp / (1 + timing->tseg_1 + timing->tseg_2);
+  SimCan& can = halSim().currentCan();
+  can.configure(general->tx_queue_len, general->rx_queue_len, simFilter, general->mode == CAN_MODE_NO_ACK,
+    general->mode == CAN_MODE_LISTEN_ONLY, bitrate);
+  can.enableAlerts(general->alerts_enabled);
+  can.setInstalled(true);
+  return ESP_OK;
+}
+
+inline esp_err_t can_driver_uninstall()
+{
+  halSim().currentCan().stop();
+  halSim().currentCan().setInstalled(false);
+  return ESP_OK;
+}
+
+inline esp_err_t can_start()
+{
+  SimCan& can = halSim().currentCan();
+  if (!can.installed() || can.running()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  return can.start() ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+inline esp_err_t can_stop()
+{
+  SimCan& can = halSim().currentCan();
+  if (!can.running()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  can.stop();
+  return ESP_OK;
+}
+
+inline esp_err_t can_transmit(const can_message_t* message, TickType_t ticks)
+{
+  HalCanFrame frame;
+  frame.id = message->identifier;
+  frame.length = message->data_length_code;
+  frame.extended = (message->flags & CAN_MSG_FLAG_EXTD) != 0;
+  frame.remote = (message->flags & CAN_MSG_FLAG_RTR) != 0;
+  frame.self = (message->flags & CAN_MSG_FLAG_SELF) != 0;
+  memcpy(frame.data, message->data, sizeof(frame.data));
+  return simCanResult(halSim().currentCan().transmit(frame, ticks));
+}
+
+inline esp_err_t can_receive(can_message_t* message, TickType_t ticks)
+{
+  HalCanFrame frame;
+  const HalCanResult result = halSim().currentCan().receive(frame, ticks);
+  if (result == HAL_CAN_OK) {
+    message->identifier = frame.id;
+    message->data_length_code = frame.length;
+    message->flags = (frame.extended ? CAN_MSG_FLAG_EXTD : 0) | (frame.remote ? CAN_MSG_FLAG_RTR : 0) | (frame.self ? CAN_MSG_FLAG_SELF : 0);
+    memcpy(message->data, frame.data, sizeof(message->data));
+  }
+  return simCanResult(result);
+}
+
+inline esp_err_t can_read_alerts(uint32_t* alerts, TickType_t ticks)
+{
+  SimCan& can = halSim().currentCan();
+  if (!can.alertsPending()) {
+    *alerts = 0;
+    return ESP_ERR_TIMEOUT;
+  }
+  *alerts = can.readAlerts(ticks);
+  return ESP_OK;
+}
+
+inline esp_err_t can_reconfigure_alerts(uint32_t alerts, uint32_t* previous)
+{
+  SimCan& can = halSim().currentCan();
+  if (previous != NULL) {
+    *previous = can.enabledAlerts();
+  }
+  can.enableAlerts(alerts);
+  return ESP_OK;
+}
+
+inline esp_err_t can_initiate_recovery()
+{
+  return halSim().currentCan().initiateRecovery() ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+inline esp_err_t can_get_status_info(can_status_info_t* status)
+{
+  SimCan& can = halSim().currentCan();
+  memset(status, 0, sizeof(*status));
+  status->state = can.busOff() ? CAN_STATE_BUS_OFF : (can.running() ? CAN_STATE_RUNNING : CAN_STATE_STOPPED);
+  status->msgs_to_tx = (uint32_t)can.txPending();
+  status->msgs_to_rx = (uint32_t)can.rxPending();
+  status->tx_error_counter = can.txErrors();
+  status->rx_error_counter = can.rxErrors();
+  status->tx_failed_count = can.txFailed();
+  status->rx_missed_count = can.rxMissed();
+  status->arb_lost_count = can.arbitrationLosses();
+  status->bus_error_count = can.busErrors();
+  return ESP_OK;
+}
+
+inline esp_err_t can_clear_transmit_queue()
+{
+  halSim().currentCan().clearTransmitQueue();
+  return ESP_OK;
+}
+
+inline esp_err_t can_clear_receive_queue()
+{
+  halSim().currentCan().clearReceiveQueue();
+  return ESP_OK;
+}
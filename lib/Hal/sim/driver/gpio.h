@@ -0,0 +1,193 @@
+/**
+ * @file gpio.h
+ * @brief host stand-in for ESP-IDF's driver/gpio.h on the simulated GPIO, native builds only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * edge interrupts go through SimGpio::setInterrupt and run the moment the level changes,
+ * level triggered interrupts are not simulated.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include <hal_sim.h>
+
+typedef int gpio_num_t;
+
+typedef enum {
+  GPIO_MODE_DISABLE,
+  GPIO_MODE_INPUT,
+  GPIO_MODE_OUTPUT,
+  GPIO_MODE_OUTPUT_OD,
+  GPIO_MODE_INPUT_OUTPUT_OD,
+  GPIO_MODE_INPUT_OUTPUT,
+} gpio_mode_t;
+
+typedef enum {
+  GPIO_PULLUP_ONLY,
+  GPIO_PULLDOWN_ONLY,
+  GPIO_PULLUP_PULLDOWN,
+  GPIO_FLOATING,
+} gpio_pull_mode_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL,
+  GPIO_INTR_HIGH_LEVEL,
+} gpio_int_type_t;
+
+typedef void (*gpio_isr_t)(void* arg);
+
+#define ESP_INTR_FLAG_IRAM                (1 << 10)
+
+inline esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const bool output = mode == GPIO_MODE_OUTPUT || mode == GPIO_MODE_OUTPUT_OD || mode == GPIO_MODE_INPUT_OUTPUT || mode == GPIO_MODE_INPUT_OUTPUT_OD;
+  halSim().gpio.setMode((uint8_t)pin, output ? HAL_PIN_OUTPUT : HAL_PIN_INPUT);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_set_pull_mode(gpio_num_t pin, gpio_pull_mode_t pull)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (halSim().gpio.mode((uint8_t)pin) != HAL_PIN_OUTPUT) {
+    halSim().gpio.setMode((uint8_t)pin, pull == GPIO_PULLUP_ONLY ? HAL_PIN_INPUT_PULLUP : (pull == GPIO_PULLDOWN_ONLY ? HAL_PIN_INPUT_PULLDOWN : HAL_PIN_INPUT));
+  }
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  halSim().gpio.write((uint8_t)pin, level != 0);
+  return ESP_OK;
+}
+
+inline int gpio_get_level(gpio_num_t pin)
+{
+  return pin >= 0 && pin < SIM_GPIO_PINS && halSim().gpio.read((uint8_t)pin) ? 1 : 0;
+}
+
+
+/*
+===============================================================================================
+                                    Interrupts
+===============================================================================================
+*/
+
+/**
+ * @brief the ISR service's per pin state, pushed to SimGpio whenever it changes
+ */
+struct SimGpioIsr
+{
+  bool installed;
+  gpio_int_type_t type[SIM_GPIO_PINS];
+  bool enabled[SIM_GPIO_PINS];
+  gpio_isr_t handler[SIM_GPIO_PINS];
+  void* arg[SIM_GPIO_PINS];
+};
+
+inline SimGpioIsr& simGpioIsr()
+{
+  static SimGpioIsr isr = {};
+  return isr;
+}
+
+inline void simGpioIsrUpdate(gpio_num_t pin)
+{
+  SimGpioIsr& isr = simGpioIsr();
+  uint8_t edges = 0;
+  if (isr.installed && isr.enabled[pin] && isr.handler[pin] != NULL) {
+    edges = isr.type[pin] == GPIO_INTR_POSEDGE ? SIM_GPIO_RISING : (isr.type[pin] == GPIO_INTR_NEGEDGE ? SIM_GPIO_FALLING :
+      (isr.type[pin] == GPIO_INTR_ANYEDGE ? SIM_GPIO_RISING | SIM_GPIO_FALLING : 0));
+  }
+  halSim().gpio.setInterrupt((uint8_t)pin, edges, isr.handler[pin], isr.arg[pin]);
+}
+
+inline esp_err_t gpio_install_isr_service(int flags)
+{
+  (void)flags;
+  if (simGpioIsr().installed) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  simGpioIsr().installed = true;
+  return ESP_OK;
+}
+
+inline void gpio_uninstall_isr_service()
+{
+  simGpioIsr().installed = false;
+  for (int pin = 0; pin < SIM_GPIO_PINS; pin++) {
+    simGpioIsrUpdate((gpio_num_t)pin);
+  }
+}
+
+inline esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  simGpioIsr().type[pin] = type;
+  simGpioIsrUpdate(pin);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_intr_enable(gpio_num_t pin)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  simGpioIsr().enabled[pin] = true;
+  simGpioIsrUpdate(pin);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_intr_disable(gpio_num_t pin)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  simGpioIsr().enabled[pin] = false;
+  simGpioIsrUpdate(pin);
+  return ESP_OK;
+}
+
+/**
+ * @brief like IDF, adding a handler also enables the pin's interrupt
+ */
+inline esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!simGpioIsr().installed) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  simGpioIsr().handler[pin] = handler;
+  simGpioIsr().arg[pin] = arg;
+  simGpioIsr().enabled[pin] = true;
+  simGpioIsrUpdate(pin);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_isr_handler_remove(gpio_num_t pin)
+{
+  if (pin < 0 || pin >= SIM_GPIO_PINS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  simGpioIsr().handler[pin] = NULL;
+  simGpioIsrUpdate(pin);
+  return ESP_OK;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file esp_timer.h
+ * @brief host stand-in for ESP-IDF's esp_timer.h on the simulated clock, native builds only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * callbacks run from SimClock::advance(), in deadline order, like the esp_timer task would.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include <hal_sim.h>
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+  ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+/**
+ * @brief a SimTimer plus the callback it was created with, lives until esp_timer_delete
+ */
+struct SimEspTimer
+{
+  SimTimer timer;
+  esp_timer_cb_t callback;
+  void* arg;
+
+  explicit SimEspTimer(const esp_timer_create_args_t& args) : timer(halSim().clock), callback(args.callback), arg(args.arg) {}
+
+  static void fire(void* context)
+  {
+    SimEspTimer* self = (SimEspTimer*)context;
+    self->callback(self->arg);
+  }
+};
+
+typedef SimEspTimer* esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time() { return halSim().clock.nowUs(); }
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle)
+{
+  if (args == NULL || args->callback == NULL || handle == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *handle = new SimEspTimer(*args);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t handle, uint64_t period)
+{
+  return handle->timer.start((uint32_t)period, &SimEspTimer::fire, handle) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/**
+ * @brief like IDF, a timer that is still running has to be stopped first
+ */
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t handle, uint64_t timeout_us)
+{
+  if (handle->timer.running()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  handle->timer.startOnce((uint32_t)timeout_us, &SimEspTimer::fire, handle);
+  return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t handle) { return handle->timer.running(); }
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t handle)
+{
+  handle->timer.stop();
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t handle)
+{
+  delete handle;
+  return ESP_OK;
+}
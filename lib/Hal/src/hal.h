@@ -0,0 +1,80 @@
+/**
+ * @file hal.h
+ * @brief the types the simulated board shares with the compatibility headers: CAN frames and
+ * alerts, pin modes and the timer and radio callbacks
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the examples call the ESP-IDF / Arduino APIs directly (gpio_*, can_*, esp_now_*, Serial),
+ * and those calls are the abstraction: on the board they are the real drivers, on the host
+ * the compatibility headers in lib/Hal/sim (Arduino.h, driver/can.h, driver/gpio.h,
+ * esp_timer.h, esp_err.h) forward them to the simulated board in hal_sim.h. the
+ * [env:native] environments put those headers on the include path, so the same sources build
+ * for both without an interface layer in between.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define HAL_MAC_SIZE                      6
+#define HAL_CAN_MAX_DATA                  8
+
+// alert bits returned by SimCan::readAlerts(), same values as the ESP-IDF CAN_ALERT_* bits
+#define HAL_CAN_ALERT_TX_IDLE             0x0001
+#define HAL_CAN_ALERT_TX_SUCCESS          0x0002
+#define HAL_CAN_ALERT_BUS_RECOVERED       0x0020
+#define HAL_CAN_ALERT_ARB_LOST            0x0040
+#define HAL_CAN_ALERT_BUS_ERROR           0x0100
+#define HAL_CAN_ALERT_TX_FAILED           0x0200
+#define HAL_CAN_ALERT_RX_QUEUE_FULL       0x0400
+#define HAL_CAN_ALERT_ERR_PASS            0x0800
+#define HAL_CAN_ALERT_BUS_OFF             0x1000
+
+
+enum HalPinMode : uint8_t
+{
+  HAL_PIN_INPUT,
+  HAL_PIN_INPUT_PULLUP,
+  HAL_PIN_INPUT_PULLDOWN,
+  HAL_PIN_OUTPUT,
+};
+
+enum HalCanResult : uint8_t
+{
+  HAL_CAN_OK,
+  HAL_CAN_TIMEOUT,                // queue full (transmit) or empty (receive) when the timeout ran out
+  HAL_CAN_NOT_RUNNING,            // stopped or bus-off
+  HAL_CAN_ERROR,                  // rejected, e.g. a bad frame
+};
+
+/**
+ * @brief one classic CAN frame
+ */
+struct HalCanFrame
+{
+  uint32_t id = 0;
+  uint8_t length = 0;
+  uint8_t data[HAL_CAN_MAX_DATA] = {};
+  bool extended = false;
+  bool remote = false;
+  bool self = false;              // also deliver to our own receive queue (self test)
+};
+
+typedef void (*HalTimerCallback)(void* context);
+typedef void (*HalRadioReceiveCallback)(const uint8_t* mac, const uint8_t* data, size_t length, void* context);
+typedef void (*HalRadioSentCallback)(const uint8_t* mac, bool delivered, void* context);
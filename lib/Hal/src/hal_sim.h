@@ -0,0 +1,1117 @@
+/**
+ * @file hal_sim.h
+ * @brief deterministic host simulation of the board behind the compatibility headers in lib/Hal/sim
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * everything runs in virtual time on one thread. time only moves when something calls
+ * SimClock::advance() or delayUs(), and timers fire in deadline order while it does, so a run
+ * is exactly repeatable: same inputs, same outputs, on any machine. random effects (radio
+ * loss) come from a seeded generator.
+ *
+ * blocking calls cannot block here: CAN receive and transmit return immediately with a
+ * timeout when the queue is empty / full, whatever the timeout. the simulation is for the
+ * native environments and is host only (it uses the standard library containers). the CAN
+ * queues are sized once when the driver is installed, like the real ones, so a test can
+ * count the allocations of the code under it.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "hal.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define SIM_GPIO_PINS                     40
+#define SIM_GPIO_RISING                   0x1         // SimGpio::setInterrupt edges
+#define SIM_GPIO_FALLING                  0x2
+#define SIM_CAN_DEFAULT_QUEUE_LENGTH      5           // same as CAN_GENERAL_CONFIG_DEFAULT
+#define SIM_CAN_ERROR_PASSIVE_LIMIT       127         // TEC or REC above this is error passive
+#define SIM_CAN_BUS_OFF_LIMIT             256         // TEC at or above this is bus-off
+#define SIM_RADIO_MAX_PAYLOAD             250
+
+
+/*
+===============================================================================================
+                                    Clock and Timers
+===============================================================================================
+*/
+
+class SimTimer;
+
+/**
+ * @brief virtual microsecond clock, runs the timers attached to it as it advances
+ */
+class SimClock
+{
+public:
+  int64_t nowUs() { return nowUs_; }
+  void delayUs(uint32_t us) { advance(us); }
+
+  /**
+   * @brief move time forward, firing every timer that comes due on the way in deadline order
+   */
+  inline void advance(int64_t us);
+
+  /**
+   * @brief move time to the next timer deadline (or by maxUs if none is sooner)
+   */
+  inline void advanceToNext(int64_t maxUs);
+
+  void attach(SimTimer* timer) { timers_.push_back(timer); }
+
+  void detach(SimTimer* timer)
+  {
+    for (size_t i = 0; i < timers_.size(); i++) {
+      if (timers_[i] == timer) {
+        timers_.erase(timers_.begin() + i);
+        return;
+      }
+    }
+  }
+
+private:
+  inline SimTimer* nextDue(int64_t limitUs);
+
+  int64_t nowUs_ = 0;
+  std::vector<SimTimer*> timers_;
+};
+
+/**
+ * @brief periodic or one-shot timer on a SimClock, fires exactly on time
+ */
+class SimTimer
+{
+public:
+  explicit SimTimer(SimClock& clock) : clock_(clock) {}
+  ~SimTimer() { stop(); }
+
+  bool start(uint32_t periodUs, HalTimerCallback callback, void* context)
+  {
+    stop();
+    if (periodUs == 0) {
+      return false;
+    }
+    periodUs_ = periodUs;
+    callback_ = callback;
+    context_ = context;
+    nextUs_ = clock_.nowUs() + periodUs;
+    running_ = true;
+    clock_.attach(this);
+    return true;
+  }
+
+  /**
+   * @brief fire once after delayUs (0 fires on the clock's next advance), replaces any running schedule
+   */
+  void startOnce(uint32_t delayUs, HalTimerCallback callback, void* context)
+  {
+    stop();
+    periodUs_ = 0;
+    callback_ = callback;
+    context_ = context;
+    nextUs_ = clock_.nowUs() + delayUs;
+    running_ = true;
+    clock_.attach(this);
+  }
+
+  void stop()
+  {
+    if (running_) {
+      running_ = false;
+      clock_.detach(this);
+    }
+  }
+
+  bool running() const { return running_; }
+  int64_t nextUs() const { return nextUs_; }
+  uint32_t fired() const { return fired_; }
+
+private:
+  friend class SimClock;
+
+  void fire()
+  {
+    fired_++;
+    if (periodUs_ == 0) {
+      stop();                       // before the callback, so it may start the timer again
+    }
+    else {
+      nextUs_ += periodUs_;
+    }
+    callback_(context_);
+  }
+
+  SimClock& clock_;
+  uint32_t periodUs_ = 0;
+  int64_t nextUs_ = 0;
+  HalTimerCallback callback_ = NULL;
+  void* context_ = NULL;
+  bool running_ = false;
+  uint32_t fired_ = 0;
+};
+
+inline SimTimer* SimClock::nextDue(int64_t limitUs)
+{
+  SimTimer* next = NULL;
+  for (size_t i = 0; i < timers_.size(); i++) {
+    if (timers_[i]->nextUs_ <= limitUs && (next == NULL || timers_[i]->nextUs_ < next->nextUs_)) {
+      next = timers_[i];
+    }
+  }
+  return next;
+}
+
+inline void SimClock::advance(int64_t us)
+{
+  const int64_t targetUs = nowUs_ + us;
+  SimTimer* timer;
+  while ((timer = nextDue(targetUs)) != NULL) {
+    nowUs_ = timer->nextUs_;
+    timer->fire();                  // may start, stop or delay, a delay moves time past its own deadlines
+  }
+  if (targetUs > nowUs_) {
+    nowUs_ = targetUs;
+  }
+}
+
+inline void SimClock::advanceToNext(int64_t maxUs)
+{
+  SimTimer* timer = nextDue(nowUs_ + maxUs);
+  advance(timer != NULL ? timer->nextUs_ - nowUs_ : maxUs);
+}
+
+
+/*
+===============================================================================================
+                                    GPIO and ADC
+===============================================================================================
+*/
+
+typedef void (*SimGpioInterrupt)(void* context);
+
+/**
+ * @brief pin levels: outputs hold what was written, inputs what the test drives (or their pull)
+ */
+class SimGpio
+{
+public:
+  SimGpio()
+  {
+    for (int i = 0; i < SIM_GPIO_PINS; i++) {
+      modes_[i] = HAL_PIN_INPUT;
+      output_[i] = false;
+      input_[i] = -1;
+      writes_[i] = 0;
+      edges_[i] = 0;
+      interruptEdges_[i] = 0;
+      interrupts_[i] = NULL;
+      interruptContexts_[i] = NULL;
+    }
+  }
+
+  void setMode(uint8_t pin, HalPinMode mode)
+  {
+    if (pin < SIM_GPIO_PINS) {
+      const bool before = read(pin);
+      modes_[pin] = mode;
+      levelChanged(pin, before);
+    }
+  }
+
+  void write(uint8_t pin, bool level)
+  {
+    if (pin >= SIM_GPIO_PINS) {
+      return;
+    }
+    const bool before = read(pin);
+    writes_[pin]++;
+    if (output_[pin] != level) {
+      edges_[pin]++;
+    }
+    output_[pin] = level;
+    levelChanged(pin, before);
+  }
+
+  bool read(uint8_t pin)
+  {
+    if (pin >= SIM_GPIO_PINS) {
+      return false;
+    }
+    if (modes_[pin] == HAL_PIN_OUTPUT) {
+      return output_[pin];
+    }
+    if (input_[pin] >= 0) {
+      return input_[pin] != 0;
+    }
+    return modes_[pin] == HAL_PIN_INPUT_PULLUP;
+  }
+
+  /**
+   * @brief the out_w1ts / out_w1tc registers: every pin in set goes high and every pin in
+   * clear goes low in the same instant, one register write
+   */
+  void writeMasks(uint64_t set, uint64_t clear)
+  {
+    maskWrites_++;
+    for (int pin = 0; pin < SIM_GPIO_PINS; pin++) {
+      if ((set >> pin) & 1) {
+        write((uint8_t)pin, true);
+      }
+      else if ((clear >> pin) & 1) {
+        write((uint8_t)pin, false);
+      }
+    }
+  }
+
+  /**
+   * @brief drive an input from outside, -1 releases it to its pull
+   */
+  void setInput(uint8_t pin, int level)
+  {
+    if (pin >= SIM_GPIO_PINS) {
+      return;
+    }
+    const bool before = read(pin);
+    input_[pin] = (int8_t)level;
+    levelChanged(pin, before);
+  }
+
+  /**
+   * @brief edge interrupt: handler runs the moment the pin's level changes in one of the
+   * edge directions (SIM_GPIO_RISING / SIM_GPIO_FALLING, 0 disables), with no latency
+   */
+  void setInterrupt(uint8_t pin, uint8_t edges, SimGpioInterrupt handler, void* context)
+  {
+    if (pin < SIM_GPIO_PINS) {
+      interruptEdges_[pin] = handler != NULL ? edges : 0;
+      interrupts_[pin] = handler;
+      interruptContexts_[pin] = context;
+    }
+  }
+
+  bool output(uint8_t pin) const { return output_[pin]; }
+  HalPinMode mode(uint8_t pin) const { return modes_[pin]; }
+  uint32_t writes(uint8_t pin) const { return writes_[pin]; }
+  uint32_t edges(uint8_t pin) const { return edges_[pin]; }
+  uint32_t maskWrites() const { return maskWrites_; }
+
+private:
+  HalPinMode modes_[SIM_GPIO_PINS];
+  bool output_[SIM_GPIO_PINS];
+  int8_t input_[SIM_GPIO_PINS];
+  uint32_t writes_[SIM_GPIO_PINS];
+  uint32_t edges_[SIM_GPIO_PINS];
+  uint32_t maskWrites_ = 0;
+  uint8_t interruptEdges_[SIM_GPIO_PINS];
+  SimGpioInterrupt interrupts_[SIM_GPIO_PINS];
+  void* interruptContexts_[SIM_GPIO_PINS];
+
+  void levelChanged(uint8_t pin, bool before)
+  {
+    const bool after = read(pin);
+    if (after != before && (interruptEdges_[pin] & (after ? SIM_GPIO_RISING : SIM_GPIO_FALLING))) {
+      interrupts_[pin](interruptContexts_[pin]);
+    }
+  }
+};
+
+typedef uint16_t (*SimAdcSource)(uint8_t pin, int64_t nowUs, void* context);
+
+/**
+ * @brief 12 bit ADC, each pin reads a fixed value or a function of virtual time
+ */
+class SimAdc
+{
+public:
+  explicit SimAdc(SimClock& clock) : clock_(clock)
+  {
+    memset(values_, 0, sizeof(values_));
+  }
+
+  uint16_t read(uint8_t pin) { return readAt(pin, clock_.nowUs()); }
+
+  /**
+   * @brief a conversion that happened at atUs, for DMA samples delivered after the fact
+   */
+  uint16_t readAt(uint8_t pin, int64_t atUs)
+  {
+    if (pin >= SIM_GPIO_PINS) {
+      return 0;
+    }
+    reads_++;
+    const uint16_t value = source_ != NULL ? source_(pin, atUs, context_) : values_[pin];
+    return value > 4095 ? 4095 : value;
+  }
+
+  uint8_t resolutionBits() const { return 12; }
+
+  void set(uint8_t pin, uint16_t value) { values_[pin] = value; }
+
+  /**
+   * @brief compute every read from a function instead of the fixed values
+   */
+  void setSource(SimAdcSource source, void* context)
+  {
+    source_ = source;
+    context_ = context;
+  }
+
+  uint32_t reads() const { return reads_; }
+
+private:
+  SimClock& clock_;
+  uint16_t values_[SIM_GPIO_PINS];
+  SimAdcSource source_ = NULL;
+  void* context_ = NULL;
+  uint32_t reads_ = 0;
+};
+
+
+/*
+===============================================================================================
+                                    CAN
+===============================================================================================
+*/
+
+/**
+ * @brief standard / extended acceptance filter, same register layout as the TWAI controller
+ * (dual mode with extended frames is not modelled and accepts everything)
+ */
+struct SimCanFilter
+{
+  uint32_t code = 0;
+  uint32_t mask = 0xFFFFFFFF;     // bits set to 1 are "don't care"
+  bool single = true;
+
+  bool accepts(const HalCanFrame& frame) const
+  {
+    if (frame.extended) {
+      const uint32_t value = (frame.id << 3) | (frame.remote ? 0x4 : 0);
+      return single ? ((value ^ code) & ~mask) == 0 : true;
+    }
+    const uint32_t value = (frame.id << 21) | (frame.remote ? (1u << 20) : 0) |
+      (frame.length > 0 ? (uint32_t)frame.data[0] << 8 : 0) | (frame.length > 1 ? frame.data[1] : 0);
+    if (single) {
+      return ((value ^ code) & ~mask) == 0;
+    }
+    // dual filter: filter 1 matches ID, RTR and the first data byte's high nibble, filter 2 ID and RTR
+    const uint32_t high = ((frame.id << 5) | (frame.remote ? 0x10 : 0) | (frame.length > 0 ? frame.data[0] >> 4 : 0)) & 0xFFFF;
+    const uint32_t idOnly = ((frame.id << 5) | (frame.remote ? 0x10 : 0)) & 0xFFF0;
+    const bool first = ((high ^ (code >> 16)) & ~(mask >> 16) & 0xFFFF) == 0;
+    const bool second = ((idOnly ^ (code & 0xFFF0)) & ~(mask & 0xFFFF) & 0xFFF0) == 0;
+    return first || second;
+  }
+};
+
+/**
+ * @brief fixed length FIFO, like the driver's FreeRTOS queues: the slots are allocated when the
+ * length is set (at driver install) and nothing is allocated while frames flow
+ */
+template <typename T>
+class SimQueue
+{
+public:
+  void setLength(size_t length)
+  {
+    slots_.assign(length, T());
+    clear();
+  }
+
+  void push_back(const T& item)
+  {
+    slots_[(head_ + size_) % slots_.size()] = item;
+    size_++;
+  }
+
+  void pop_front()
+  {
+    head_ = (head_ + 1) % slots_.size();
+    size_--;
+  }
+
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  T& front() { return slots_[head_]; }
+  const T& front() const { return slots_[head_]; }
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+private:
+  std::vector<T> slots_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+class SimCan;
+
+/**
+ * @brief connects SimCan controllers, frames are delivered the moment they are transmitted
+ * (see sim_can_bus.h for a bus with bit timing, arbitration and errors)
+ */
+class SimCanBus
+{
+public:
+  virtual ~SimCanBus() {}
+  void attach(SimCan* node) { nodes_.push_back(node); }
+
+  /**
+   * @brief a controller has a new frame in its TX queue, the instant bus sends it right away
+   */
+  inline virtual void queued(SimCan& sender);
+
+  /**
+   * @brief bus time stamped on queued frames, the instant bus has none
+   */
+  virtual int64_t nowUs() const { return 0; }
+
+  /**
+   * @brief called by a controller's flush() for every frame it sends
+   * @return false if the frame could not be sent (e.g. no one acknowledged it)
+   */
+  virtual bool transmit(SimCan& sender, const HalCanFrame& frame);
+
+  uint32_t frames() const { return frames_; }
+
+protected:
+  std::vector<SimCan*> nodes_;
+  uint32_t frames_ = 0;
+};
+
+/**
+ * @brief one CAN controller with the TWAI driver's queues, filter and alerts
+ */
+class SimCan
+{
+public:
+  explicit SimCan(SimCanBus& bus) : bus_(bus)
+  {
+    txQueue_.setLength(txQueueLength_);
+    rxQueue_.setLength(rxQueueLength_);
+    bus.attach(this);
+  }
+
+  /**
+   * @brief mirrors can_driver_install
+   *
+   * @param selfTest true for CAN_MODE_NO_ACK, a lone node's frames still count as sent
+   * @param listenOnly true for CAN_MODE_LISTEN_ONLY, transmit is refused
+   * @param bitrate bits per second, used by timed buses
+   */
+  void configure(size_t txQueueLength, size_t rxQueueLength, const SimCanFilter& filter, bool selfTest, bool listenOnly, uint32_t bitrate)
+  {
+    txQueueLength_ = txQueueLength;
+    rxQueueLength_ = rxQueueLength;
+    txQueue_.setLength(txQueueLength);
+    rxQueue_.setLength(rxQueueLength);
+    filter_ = filter;
+    selfTest_ = selfTest;
+    listenOnly_ = listenOnly;
+    bitrate_ = bitrate;
+  }
+
+  bool start()
+  {
+    if (busOff_) {
+      return false;
+    }
+    running_ = true;
+    return true;
+  }
+
+  void stop() { running_ = false; }
+
+  HalCanResult transmit(const HalCanFrame& frame, uint32_t timeoutMs)
+  {
+    (void)timeoutMs;
+    if (!running_ || busOff_) {
+      return HAL_CAN_NOT_RUNNING;
+    }
+    if (listenOnly_ || frame.length > HAL_CAN_MAX_DATA || frame.id > (frame.extended ? 0x1FFFFFFFu : 0x7FFu)) {
+      return HAL_CAN_ERROR;
+    }
+    if (txQueue_.size() >= txQueueLength_) {
+      txRejected_++;
+      return HAL_CAN_TIMEOUT;
+    }
+    SimCanPending pending;
+    pending.frame = frame;
+    pending.queuedUs = bus_.nowUs();
+    txQueue_.push_back(pending);
+    bus_.queued(*this);
+    return HAL_CAN_OK;
+  }
+
+  HalCanResult receive(HalCanFrame& frame, uint32_t timeoutMs)
+  {
+    (void)timeoutMs;
+    if (rxQueue_.empty()) {
+      return running_ ? HAL_CAN_TIMEOUT : HAL_CAN_NOT_RUNNING;
+    }
+    frame = rxQueue_.front();
+    rxQueue_.pop_front();
+    return HAL_CAN_OK;
+  }
+
+  uint32_t readAlerts(uint32_t timeoutMs)
+  {
+    (void)timeoutMs;
+    const uint32_t alerts = alerts_ & enabledAlerts_;
+    alerts_ = 0;
+    return alerts;
+  }
+
+  /**
+   * @brief recovery completes at once in the simulation (no 128 x 11 recessive bits), the
+   * controller comes back error active and stays stopped until start()
+   */
+  bool initiateRecovery()
+  {
+    if (!busOff_) {
+      return false;
+    }
+    busOff_ = false;
+    running_ = false;
+    txErrors_ = 0;
+    rxErrors_ = 0;
+    raise(HAL_CAN_ALERT_BUS_RECOVERED);
+    return true;
+  }
+
+  /**
+   * @brief take a frame off the bus, applies the filter and the RX queue limit
+   */
+  void deliver(const HalCanFrame& frame)
+  {
+    if (!running_ || !filter_.accepts(frame)) {
+      return;
+    }
+    if (rxQueue_.size() >= rxQueueLength_) {
+      rxMissed_++;
+      raise(HAL_CAN_ALERT_RX_QUEUE_FULL);
+      return;
+    }
+    rxQueue_.push_back(frame);
+  }
+
+  /**
+   * @brief put the controller into bus-off, as if the transmit error counter passed 255,
+   * whatever was still queued is abandoned
+   */
+  void forceBusOff()
+  {
+    busOff_ = true;
+    running_ = false;
+    txErrors_ = SIM_CAN_BUS_OFF_LIMIT;
+    txAbandoned_ += (uint32_t)txQueue_.size();
+    txQueue_.clear();
+    raise(HAL_CAN_ALERT_BUS_OFF);
+  }
+
+  // ---------------------------- fault confinement ----------------------------- //
+
+  /**
+   * @brief a frame this controller was sending hit an error, TEC += 8
+   */
+  void transmitError()
+  {
+    busErrors_++;
+    raise(HAL_CAN_ALERT_BUS_ERROR);
+    const bool wasPassive = errorPassive();
+    txErrors_ += 8;
+    if (txErrors_ >= SIM_CAN_BUS_OFF_LIMIT) {
+      forceBusOff();
+    }
+    else if (!wasPassive && errorPassive()) {
+      raise(HAL_CAN_ALERT_ERR_PASS);
+    }
+  }
+
+  /**
+   * @brief no one acknowledged a frame this controller sent, a transmit error except that an
+   * error passive transmitter's TEC stays put, so a lone node never goes bus-off
+   */
+  void acknowledgementError()
+  {
+    if (errorPassive()) {
+      busErrors_++;
+      raise(HAL_CAN_ALERT_BUS_ERROR);
+      return;
+    }
+    transmitError();
+  }
+
+  /**
+   * @brief a frame this controller was receiving hit an error, REC += 1
+   */
+  void receiveError()
+  {
+    busErrors_++;
+    raise(HAL_CAN_ALERT_BUS_ERROR);
+    const bool wasPassive = errorPassive();
+    if (rxErrors_ <= SIM_CAN_ERROR_PASSIVE_LIMIT) {
+      rxErrors_++;
+    }
+    if (!wasPassive && errorPassive()) {
+      raise(HAL_CAN_ALERT_ERR_PASS);
+    }
+  }
+
+  /**
+   * @brief a frame was received without error, REC -= 1
+   */
+  void receiveSucceeded()
+  {
+    if (rxErrors_ > 0) {
+      rxErrors_--;
+    }
+  }
+
+  /**
+   * @brief this controller lost arbitration, it retries once the bus is idle
+   */
+  void arbitrationLost()
+  {
+    arbitrationLost_++;
+    raise(HAL_CAN_ALERT_ARB_LOST);
+  }
+
+  bool errorPassive() const { return txErrors_ > SIM_CAN_ERROR_PASSIVE_LIMIT || rxErrors_ > SIM_CAN_ERROR_PASSIVE_LIMIT; }
+
+  void raise(uint32_t alerts) { alerts_ |= alerts; }
+  void enableAlerts(uint32_t alerts) { enabledAlerts_ = alerts; }
+  uint32_t enabledAlerts() const { return enabledAlerts_; }
+  bool alertsPending() const { return (alerts_ & enabledAlerts_) != 0; }
+
+  void clearTransmitQueue() { txQueue_.clear(); }
+  void clearReceiveQueue() { rxQueue_.clear(); }
+
+  /**
+   * @brief hand every queued frame to the bus at once, what the instant bus does on queued()
+   */
+  void flush()
+  {
+    while (!txQueue_.empty()) {
+      txComplete(bus_.transmit(*this, txQueue_.front().frame));
+    }
+  }
+
+  // --------------------------- timed bus interface ---------------------------- //
+
+  /**
+   * @brief the frame at the head of the TX queue, NULL if there is none
+   */
+  const HalCanFrame* txPeek() const { return txQueue_.empty() ? NULL : &txQueue_.front().frame; }
+
+  /**
+   * @brief bus time the head frame was queued at
+   */
+  int64_t txQueuedUs() const { return txQueue_.empty() ? 0 : txQueue_.front().queuedUs; }
+
+  /**
+   * @brief the head frame is done with, sent (TEC -= 1) or given up on
+   */
+  void txComplete(bool success)
+  {
+    txQueue_.pop_front();
+    if (success) {
+      sent_++;
+      if (txErrors_ > 0) {
+        txErrors_--;
+      }
+      raise(HAL_CAN_ALERT_TX_SUCCESS);
+    }
+    else {
+      txFailed_++;
+      raise(HAL_CAN_ALERT_TX_FAILED);
+    }
+    if (txQueue_.empty()) {
+      raise(HAL_CAN_ALERT_TX_IDLE);
+    }
+  }
+
+  void setInstalled(bool installed) { installed_ = installed; }
+
+  bool installed() const { return installed_; }
+  bool running() const { return running_; }
+  bool busOff() const { return busOff_; }
+  bool selfTest() const { return selfTest_; }
+  bool listenOnly() const { return listenOnly_; }
+  uint32_t bitrate() const { return bitrate_; }
+  size_t txPending() const { return txQueue_.size(); }
+  size_t rxPending() const { return rxQueue_.size(); }
+  uint32_t txErrors() const { return txErrors_; }
+  uint32_t rxErrors() const { return rxErrors_; }
+  uint32_t sent() const { return sent_; }
+  uint32_t txFailed() const { return txFailed_; }
+  uint32_t txRejected() const { return txRejected_; }
+  uint32_t txAbandoned() const { return txAbandoned_; }
+  uint32_t rxMissed() const { return rxMissed_; }
+  uint32_t arbitrationLosses() const { return arbitrationLost_; }
+  uint32_t busErrors() const { return busErrors_; }
+
+private:
+  struct SimCanPending
+  {
+    HalCanFrame frame;
+    int64_t queuedUs = 0;
+  };
+
+  SimCanBus& bus_;
+  SimQueue<SimCanPending> txQueue_;
+  SimQueue<HalCanFrame> rxQueue_;
+  size_t txQueueLength_ = SIM_CAN_DEFAULT_QUEUE_LENGTH;
+  size_t rxQueueLength_ = SIM_CAN_DEFAULT_QUEUE_LENGTH;
+  SimCanFilter filter_;
+  bool selfTest_ = false;
+  bool listenOnly_ = false;
+  uint32_t bitrate_ = 500000;
+  bool installed_ = false;
+  bool running_ = false;
+  bool busOff_ = false;
+  uint32_t alerts_ = 0;
+  uint32_t enabledAlerts_ = 0xFFFFFFFF;
+  uint32_t txErrors_ = 0;             // TEC
+  uint32_t rxErrors_ = 0;             // REC
+  uint32_t sent_ = 0;
+  uint32_t txFailed_ = 0;
+  uint32_t txRejected_ = 0;           // transmit() found the TX queue full
+  uint32_t txAbandoned_ = 0;          // still queued when the controller went bus-off
+  uint32_t rxMissed_ = 0;
+  uint32_t arbitrationLost_ = 0;
+  uint32_t busErrors_ = 0;
+};
+
+inline void SimCanBus::queued(SimCan& sender)
+{
+  sender.flush();
+}
+
+inline bool SimCanBus::transmit(SimCan& sender, const HalCanFrame& frame)
+{
+  bool acknowledged = false;
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    if (nodes_[i] != &sender && nodes_[i]->running()) {
+      nodes_[i]->deliver(frame);
+      acknowledged = true;
+    }
+  }
+  if (frame.self) {
+    sender.deliver(frame);
+  }
+  if (acknowledged || sender.selfTest()) {
+    frames_++;
+    return true;
+  }
+  return false;
+}
+
+
+/*
+===============================================================================================
+                                    Radio
+===============================================================================================
+*/
+
+class SimRadio;
+
+/**
+ * @brief the air between SimRadios: seeded random loss, deliveries wait for run()
+ */
+class SimRadioMedium
+{
+public:
+  /**
+   * @param lossPercent chance (0 - 100) that a unicast or broadcast copy is lost
+   * @param seed any non-zero value, the same seed loses the same frames
+   */
+  explicit SimRadioMedium(uint8_t lossPercent = 0, uint32_t seed = 1) : lossPercent_(lossPercent), random_(seed != 0 ? seed : 1) {}
+
+  void attach(SimRadio* radio) { radios_.push_back(radio); }
+  void setLoss(uint8_t lossPercent) { lossPercent_ = lossPercent; }
+
+  /**
+   * @brief queue a frame from one radio, see SimRadio::send
+   */
+  inline void send(SimRadio& sender, const uint8_t* mac, const uint8_t* data, size_t length);
+
+  /**
+   * @brief deliver everything sent so far (and anything sent by the callbacks meanwhile)
+   * @return frames delivered
+   */
+  inline size_t run();
+
+  uint32_t lost() const { return lost_; }
+
+private:
+  struct Transmission
+  {
+    SimRadio* sender;
+    uint8_t mac[HAL_MAC_SIZE];
+    std::vector<uint8_t> data;
+  };
+
+  bool lose()
+  {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return random_ % 100 < lossPercent_;
+  }
+
+  std::vector<SimRadio*> radios_;
+  std::deque<Transmission> pending_;
+  uint8_t lossPercent_;
+  uint32_t random_;
+  uint32_t lost_ = 0;
+};
+
+/**
+ * @brief one ESP-NOW station on a SimRadioMedium
+ */
+class SimRadio
+{
+public:
+  SimRadio(SimRadioMedium& medium, const uint8_t* mac) : medium_(medium)
+  {
+    memcpy(mac_, mac, HAL_MAC_SIZE);
+    medium.attach(this);
+  }
+
+  bool begin()
+  {
+    started_ = true;
+    return true;
+  }
+
+  void macAddress(uint8_t* mac) { memcpy(mac, mac_, HAL_MAC_SIZE); }
+
+  bool addPeer(const uint8_t* mac)
+  {
+    if (peers_.size() >= 20) {
+      return false;
+    }
+    peers_.push_back(std::vector<uint8_t>(mac, mac + HAL_MAC_SIZE));
+    return true;
+  }
+
+  bool send(const uint8_t* mac, const uint8_t* data, size_t length)
+  {
+    if (!started_ || length > SIM_RADIO_MAX_PAYLOAD || !isPeer(mac)) {
+      return false;
+    }
+    medium_.send(*this, mac, data, length);
+    return true;
+  }
+
+  void onReceive(HalRadioReceiveCallback callback, void* context)
+  {
+    receiveCallback_ = callback;
+    receiveContext_ = context;
+  }
+
+  void onSent(HalRadioSentCallback callback, void* context)
+  {
+    sentCallback_ = callback;
+    sentContext_ = context;
+  }
+
+  const uint8_t* mac() const { return mac_; }
+  bool started() const { return started_; }
+
+private:
+  friend class SimRadioMedium;
+
+  bool isPeer(const uint8_t* mac) const
+  {
+    for (size_t i = 0; i < peers_.size(); i++) {
+      if (memcmp(peers_[i].data(), mac, HAL_MAC_SIZE) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void received(const uint8_t* mac, const uint8_t* data, size_t length)
+  {
+    if (receiveCallback_ != NULL) {
+      receiveCallback_(mac, data, length, receiveContext_);
+    }
+  }
+
+  void sent(const uint8_t* mac, bool delivered)
+  {
+    if (sentCallback_ != NULL) {
+      sentCallback_(mac, delivered, sentContext_);
+    }
+  }
+
+  SimRadioMedium& medium_;
+  uint8_t mac_[HAL_MAC_SIZE];
+  std::vector<std::vector<uint8_t>> peers_;
+  bool started_ = false;
+  HalRadioReceiveCallback receiveCallback_ = NULL;
+  void* receiveContext_ = NULL;
+  HalRadioSentCallback sentCallback_ = NULL;
+  void* sentContext_ = NULL;
+};
+
+inline void SimRadioMedium::send(SimRadio& sender, const uint8_t* mac, const uint8_t* data, size_t length)
+{
+  Transmission transmission;
+  transmission.sender = &sender;
+  memcpy(transmission.mac, mac, HAL_MAC_SIZE);
+  transmission.data.assign(data, data + length);
+  pending_.push_back(transmission);
+}
+
+inline size_t SimRadioMedium::run()
+{
+  static const uint8_t broadcast[HAL_MAC_SIZE] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+  size_t delivered = 0;
+  while (!pending_.empty()) {
+    Transmission transmission = pending_.front();
+    pending_.pop_front();
+
+    const bool isBroadcast = memcmp(transmission.mac, broadcast, HAL_MAC_SIZE) == 0;
+    bool acknowledged = false;
+    for (size_t i = 0; i < radios_.size(); i++) {
+      SimRadio* radio = radios_[i];
+      if (radio == transmission.sender || !radio->started()) {
+        continue;
+      }
+      if (!isBroadcast && memcmp(radio->mac(), transmission.mac, HAL_MAC_SIZE) != 0) {
+        continue;
+      }
+      if (lose()) {
+        lost_++;
+        continue;
+      }
+      radio->received(transmission.sender->mac(), transmission.data.data(), transmission.data.size());
+      acknowledged = true;
+      delivered++;
+    }
+
+    // like ESP-NOW, a broadcast always reports success
+    transmission.sender->sent(transmission.mac, isBroadcast || acknowledged);
+  }
+  return delivered;
+}
+
+
+/*
+===============================================================================================
+                                    Log Sink
+===============================================================================================
+*/
+
+/**
+ * @brief collects output, and echoes it to a stream (stdout by default) if one is set
+ */
+class SimLogSink
+{
+public:
+  explicit SimLogSink(FILE* echo = stdout) : echo_(echo) {}
+
+  size_t write(const uint8_t* data, size_t length)
+  {
+    if (capture_) {
+      text_.append((const char*)data, length);
+    }
+    if (echo_ != NULL) {
+      fwrite(data, 1, length, echo_);
+    }
+    bytes_ += length;
+    return length;
+  }
+
+  size_t writable() { return 4096; }
+
+  void setEcho(FILE* echo) { echo_ = echo; }
+  void setCapture(bool capture) { capture_ = capture; }
+  const std::string& text() const { return text_; }
+  void clear() { text_.clear(); }
+  uint64_t bytes() const { return bytes_; }
+
+private:
+  FILE* echo_;
+  bool capture_ = false;
+  std::string text_;
+  uint64_t bytes_ = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Simulated Board
+===============================================================================================
+*/
+
+/**
+ * @brief one simulated board: clock, GPIO, ADC, a CAN controller on its own bus, a radio and a log
+ */
+class HalSim
+{
+public:
+  HalSim() : adc(clock), can(canBus), radio(radioMedium, defaultMac()), can_(&can) {}
+
+  /**
+   * @brief which controller the driver/can.h compatibility functions talk to
+   */
+  void selectCan(SimCan* controller) { can_ = controller; }
+  SimCan& currentCan() { return *can_; }
+
+  /**
+   * @brief bytes the sketch will read from Serial
+   */
+  void typeSerial(const char* text) { serialInput.append(text); }
+
+  SimClock clock;
+  SimGpio gpio;
+  SimAdc adc;
+  SimCanBus canBus;
+  SimCan can;
+  SimRadioMedium radioMedium;
+  SimRadio radio;
+  SimLogSink log;
+  std::string serialInput;
+
+private:
+  static const uint8_t* defaultMac()
+  {
+    static const uint8_t mac[HAL_MAC_SIZE] = { 0x24, 0x6F, 0x28, 0x00, 0x00, 0x01 };
+    return mac;
+  }
+
+  SimCan* can_;
+};
+
+/**
+ * @brief the board the compatibility headers (Arduino.h, driver/can.h, esp_timer.h) run on
+ */
+inline HalSim& halSim()
+{
+  static HalSim sim;
+  return sim;
+}
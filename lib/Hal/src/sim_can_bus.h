@@ -0,0 +1,538 @@
+/**
+ * @file sim_can_bus.h
+ * @brief CAN bus simulation with bit timing, arbitration, error frames and fault confinement
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a drop-in for SimCanBus: SimCan controllers attached to a TimedCanBus no longer send the
+ * moment they queue a frame. the bus is idle or carrying exactly one frame; when it goes
+ * idle every running controller with a queued frame starts together and the lowest
+ * arbitration field wins bit by bit, the others raise ARB_LOST and wait for the next idle.
+ * a frame takes its exact length on the wire: the CRC-15 is computed and stuff bits counted
+ * from SOF to the end of the CRC, then delimiters, ACK, EOF and the 3 bit intermission.
+ *
+ * errors follow ISO 11898-1 fault confinement: an error frame costs the bits sent so far
+ * plus 14 bits of flag and delimiter, the transmitter's TEC goes up by 8 and every receiver's
+ * REC by 1, the frame is retried, and a TEC of 256 takes the controller bus-off (SimCan keeps
+ * the counters). errors come from
+ *   - no acknowledgement: no other running controller at the bus bitrate, outside NO_ACK mode
+ *   - two controllers sending the same arbitration field with different data
+ *   - a controller at the wrong bitrate, which destroys every frame while error active
+ *   - a per-controller injected error rate (a bad transceiver or stub), from a seeded generator
+ *
+ * time is kept in nanoseconds on the bus and events fire on the SimClock at the next whole
+ * microsecond after the intermission, which is when receivers get the frame. the bus records
+ * utilization, per-ID latency from can_transmit() to the end of the frame, error frames and
+ * per-controller counters for a report. host only.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+#include "hal_sim.h"
+#include <latency_histogram.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define CAN_BUS_CRC_POLYNOMIAL            0x4599      // CRC-15 CAN, x^15 + x^14 + x^10 + x^8 + x^7 + x^4 + x^3 + 1
+#define CAN_BUS_TAIL_BITS                 10          // CRC delimiter, ACK slot, ACK delimiter, 7 EOF
+#define CAN_BUS_ACK_SLOT_FROM_END         9           // ACK slot position counted back from the end of EOF
+#define CAN_BUS_EOF_BITS                  7
+#define CAN_BUS_INTERMISSION_BITS         3
+#define CAN_BUS_ERROR_FRAME_BITS          14          // 6 bit error flag + 8 bit delimiter
+#define CAN_BUS_SUSPEND_BITS              8           // extra wait for an error passive transmitter
+#define CAN_BUS_EXTENDED_KEY              0x80000000  // marks extended IDs in per-ID statistics
+
+
+/*
+===============================================================================================
+                                    Frame Bits
+===============================================================================================
+*/
+
+/**
+ * @brief exact length of a frame on the wire from SOF to the end of EOF, stuff bits included,
+ * without the intermission
+ */
+inline uint32_t canFrameBits(const HalCanFrame& frame)
+{
+  // the stuffed part: SOF, arbitration, control, data and CRC, most significant bit first
+  uint8_t bits[128];
+  uint32_t count = 0;
+  auto put = [&](uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+      bits[count++] = (uint8_t)((value >> i) & 1);
+    }
+  };
+
+  const uint8_t length = frame.length > HAL_CAN_MAX_DATA ? HAL_CAN_MAX_DATA : frame.length;
+  put(0, 1);                                            // SOF
+  if (frame.extended) {
+    put(frame.id >> 18, 11);
+    put(1, 1);                                          // SRR
+    put(1, 1);                                          // IDE
+    put(frame.id & 0x3FFFF, 18);
+    put(frame.remote ? 1 : 0, 1);                       // RTR
+    put(0, 2);                                          // r1, r0
+  }
+  else {
+    put(frame.id & 0x7FF, 11);
+    put(frame.remote ? 1 : 0, 1);                       // RTR
+    put(0, 2);                                          // IDE, r0
+  }
+  put(frame.length & 0xF, 4);                           // DLC as sent, the data stops at 8 bytes
+  if (!frame.remote) {
+    for (uint8_t i = 0; i < length; i++) {
+      put(frame.data[i], 8);
+    }
+  }
+
+  uint16_t crc = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const bool feedback = (bits[i] ^ (crc >> 14)) & 1;
+    crc = (uint16_t)((crc << 1) & 0x7FFF);
+    if (feedback) {
+      crc ^= CAN_BUS_CRC_POLYNOMIAL;
+    }
+  }
+  put(crc, 15);
+
+  // a complementary stuff bit follows every 5 equal bits and starts the next run itself
+  uint32_t stuffed = 0;
+  uint32_t run = 0;
+  uint8_t last = 2;
+  for (uint32_t i = 0; i < count; i++) {
+    if (bits[i] == last) {
+      run++;
+    }
+    else {
+      last = bits[i];
+      run = 1;
+    }
+    if (run == 5) {
+      stuffed++;
+      last = !last;
+      run = 1;
+    }
+  }
+
+  return count + stuffed + CAN_BUS_TAIL_BITS;
+}
+
+/**
+ * @brief the arbitration field as a number, lower wins
+ *
+ * standard: ID, RTR, IDE(0). extended: base ID, SRR(1), IDE(1), ID extension, RTR. a standard
+ * data frame beats a standard remote frame with the same ID, which beats any extended frame
+ * with the same base ID.
+ */
+inline uint32_t canArbitrationKey(const HalCanFrame& frame)
+{
+  if (frame.extended) {
+    return ((frame.id >> 18) & 0x7FF) << 21 | 1u << 20 | 1u << 19 | (frame.id & 0x3FFFF) << 1 | (frame.remote ? 1 : 0);
+  }
+  return (frame.id & 0x7FF) << 21 | (frame.remote ? 1u : 0) << 20;
+}
+
+/**
+ * @brief bits from SOF through the control field, where two senders of the same ID first
+ * see a difference in their DLC or data
+ */
+inline uint32_t canHeaderBits(const HalCanFrame& frame)
+{
+  return frame.extended ? 39 : 19;
+}
+
+
+/*
+===============================================================================================
+                                    Timed Bus
+===============================================================================================
+*/
+
+/**
+ * @brief per-ID statistics in a TimedCanBus report
+ */
+struct CanIdStats
+{
+  LatencyHistogram latencyUs;           // can_transmit() to the end of the frame
+  uint32_t frames = 0;
+  uint64_t bits = 0;
+  uint32_t errors = 0;                  // error frames while this ID was being sent
+};
+
+/**
+ * @brief per-controller counters for the current statistics window
+ */
+struct CanNodeStats
+{
+  const char* name = "node";
+  uint16_t errorPermille = 0;           // injected transmit error rate
+  uint32_t framesSent = 0;
+  uint32_t errorFrames = 0;             // error frames raised while it was sending
+  uint32_t arbitrationLost = 0;
+  uint32_t busOffEvents = 0;
+
+  // SimCan's lifetime drop counters when the window opened
+  uint32_t rejectedBase = 0;
+  uint32_t abandonedBase = 0;
+  uint32_t missedBase = 0;
+};
+
+/**
+ * @brief SimCanBus with bit timing, arbitration and fault confinement, see the file comment
+ */
+class TimedCanBus : public SimCanBus
+{
+public:
+  /**
+   * @param bitrate the bus bitrate, controllers configured for another rate are faulty nodes
+   * @param seed any non-zero value, drives the injected errors
+   */
+  TimedCanBus(SimClock& clock, uint32_t bitrate = 500000, uint32_t seed = 1)
+    : clock_(clock), event_(clock), bitrate_(bitrate), bitNs_(1000000000ll / bitrate), random_(seed != 0 ? seed : 1)
+  {
+  }
+
+  /**
+   * @brief a controller queued a frame: start arbitration at the end of this microsecond if
+   * the bus is idle, so every controller queueing in the same instant takes part
+   */
+  void queued(SimCan& sender) override
+  {
+    (void)sender;
+    if (!busy_ && !event_.running()) {
+      event_.startOnce(0, onEvent, this);
+    }
+  }
+
+  int64_t nowUs() const override { return clock_.nowUs(); }
+
+  // ------------------------------ configuration ------------------------------- //
+
+  void setName(SimCan& node, const char* name) { stats(node).name = name; }
+
+  /**
+   * @brief chance in 1/1000 that a frame this controller sends is destroyed by an error
+   */
+  void setErrorRate(SimCan& node, uint16_t permille) { stats(node).errorPermille = permille; }
+
+  /**
+   * @brief open a new statistics window: utilization, per-ID and per-controller counters
+   */
+  void resetStats()
+  {
+    ids_.clear();
+    frames_ = 0;
+    windowStartNs_ = clock_.nowUs() * 1000;
+    busyNs_ = 0;
+    errorFrames_ = 0;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      CanNodeStats& node = stats(*nodes_[i]);
+      node.framesSent = 0;
+      node.errorFrames = 0;
+      node.arbitrationLost = 0;
+      node.busOffEvents = 0;
+      node.rejectedBase = nodes_[i]->txRejected();
+      node.abandonedBase = nodes_[i]->txAbandoned();
+      node.missedBase = nodes_[i]->rxMissed();
+    }
+  }
+
+  // ------------------------------- statistics --------------------------------- //
+
+  uint32_t bitrate() const { return bitrate_; }
+  uint32_t errorFrames() const { return errorFrames_; }
+
+  /**
+   * @brief share of the window the bus carried frames, error frames or intermission, 0 - 1
+   */
+  double utilization() const
+  {
+    const int64_t windowNs = clock_.nowUs() * 1000 - windowStartNs_;
+    return windowNs > 0 ? (double)(busyNs_ < windowNs ? busyNs_ : windowNs) / windowNs : 0.0;
+  }
+
+  const std::map<uint32_t, CanIdStats>& idStats() const { return ids_; }
+
+  /**
+   * @brief utilization, per-ID latency and per-controller counters for the current window
+   */
+  void report(FILE* out)
+  {
+    const double windowS = (clock_.nowUs() * 1000 - windowStartNs_) / 1e9;
+    fprintf(out, "bus: %u bit/s | %.1f s | utilization %.1f%% | %u frames | %u error frames\n",
+      bitrate_, windowS, utilization() * 100.0, frames_, errorFrames_);
+
+    fprintf(out, "  %-10s %7s %6s %7s %9s %9s %9s %9s\n", "id", "frames", "bits", "errors", "p50 us", "p90 us", "p99 us", "max us");
+    for (auto it = ids_.begin(); it != ids_.end(); ++it) {
+      const CanIdStats& id = it->second;
+      const LatencySummary latency = id.latencyUs.summary();
+      char name[16];
+      snprintf(name, sizeof(name), (it->first & CAN_BUS_EXTENDED_KEY) ? "0x%08X" : "0x%03X", it->first & ~CAN_BUS_EXTENDED_KEY);
+      fprintf(out, "  %-10s %7u %6u %7u %9u %9u %9u %9u\n", name, id.frames,
+        id.frames != 0 ? (uint32_t)(id.bits / id.frames) : 0, id.errors, latency.p50, latency.p90, latency.p99, latency.max);
+    }
+
+    fprintf(out, "  %-10s %7s %6s %6s %7s %8s %8s %9s %9s %8s %s\n", "node", "sent", "TEC", "REC", "errors", "arb lost",
+      "bus-off", "rejected", "abandoned", "rx miss", "state");
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      const SimCan& can = *nodes_[i];
+      const CanNodeStats& node = stats(can);
+      const char* state = can.busOff() ? "bus-off" : (!can.running() ? "stopped" : (can.errorPassive() ? "error passive" : "error active"));
+      fprintf(out, "  %-10s %7u %6u %6u %7u %8u %8u %9u %9u %8u %s%s\n", node.name, node.framesSent, can.txErrors(), can.rxErrors(),
+        node.errorFrames, node.arbitrationLost, node.busOffEvents, can.txRejected() - node.rejectedBase,
+        can.txAbandoned() - node.abandonedBase, can.rxMissed() - node.missedBase, state, can.bitrate() != bitrate_ ? " (wrong bitrate)" : "");
+    }
+  }
+
+private:
+  struct Contender
+  {
+    SimCan* node;
+    uint32_t key;
+  };
+
+  static void onEvent(void* context) { ((TimedCanBus*)context)->event(); }
+
+  // stats_ is indexed like nodes_ and grows as controllers attach
+  CanNodeStats& stats(const SimCan& node)
+  {
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      if (nodes_[i] == &node) {
+        if (nodeStats_.size() <= i) {
+          nodeStats_.resize(nodes_.size());
+        }
+        return nodeStats_[i];
+      }
+    }
+    static CanNodeStats unattached;
+    return unattached;
+  }
+
+  uint32_t randomBelow(uint32_t limit)
+  {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return limit != 0 ? random_ % limit : 0;
+  }
+
+  bool lose(uint16_t permille) { return permille != 0 && randomBelow(1000) < permille; }
+
+  bool onBus(const SimCan& node) const { return node.running() && !node.busOff(); }
+
+  /**
+   * @brief end of the frame on the wire (if any), then arbitration for the next one
+   */
+  void event()
+  {
+    if (busy_) {
+      finish();
+      busy_ = false;
+    }
+    arbitrate();
+  }
+
+  /**
+   * @brief every controller with a queued frame starts at once, the lowest key wins
+   */
+  void arbitrate()
+  {
+    std::vector<Contender>& contenders = contenders_;
+    contenders.clear();
+    uint32_t lowest = 0xFFFFFFFF;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      const HalCanFrame* frame = nodes_[i]->txPeek();
+      if (frame != NULL && onBus(*nodes_[i])) {
+        Contender contender = { nodes_[i], canArbitrationKey(*frame) };
+        contenders.push_back(contender);
+        lowest = contender.key < lowest ? contender.key : lowest;
+      }
+    }
+    if (contenders.empty()) {
+      return;
+    }
+
+    winners_.clear();
+    for (size_t i = 0; i < contenders.size(); i++) {
+      if (contenders[i].key == lowest) {
+        winners_.push_back(contenders[i].node);
+      }
+      else {
+        contenders[i].node->arbitrationLost();
+        stats(*contenders[i].node).arbitrationLost++;
+      }
+    }
+
+    // the frame starts when the bus went idle, or now if it has been idle for a while
+    const int64_t nowNs = clock_.nowUs() * 1000;
+    startNs_ = freeAtNs_ > nowNs ? freeAtNs_ : nowNs;
+    frame_ = *winners_[0]->txPeek();
+    const uint32_t bits = canFrameBits(frame_);
+    errorAtBit_ = 0;
+    ackError_ = false;
+
+    // senders of the same ID fall out of step at the first differing DLC or data bit
+    for (size_t i = 1; i < winners_.size(); i++) {
+      const HalCanFrame& other = *winners_[i]->txPeek();
+      if (other.length != frame_.length || memcmp(other.data, frame_.data, HAL_CAN_MAX_DATA) != 0) {
+        errorAtBit_ = canHeaderBits(frame_);
+      }
+    }
+
+    // a controller at the wrong bitrate sees garbage and, while error active, says so
+    bool acknowledged = false;
+    for (size_t i = 0; i < nodes_.size() && errorAtBit_ == 0; i++) {
+      const SimCan& node = *nodes_[i];
+      if (!onBus(node) || isWinner(node)) {
+        continue;
+      }
+      if (node.bitrate() != bitrate_) {
+        if (!node.errorPassive()) {
+          errorAtBit_ = 1 + randomBelow(bits - CAN_BUS_EOF_BITS);
+        }
+      }
+      else if (!node.listenOnly()) {
+        acknowledged = true;
+      }
+    }
+    for (size_t i = 0; i < winners_.size() && errorAtBit_ == 0; i++) {
+      if (winners_[i]->bitrate() != bitrate_ || lose(stats(*winners_[i]).errorPermille)) {
+        errorAtBit_ = 1 + randomBelow(bits - CAN_BUS_EOF_BITS);
+      }
+    }
+    if (errorAtBit_ == 0 && !acknowledged && !winners_[0]->selfTest()) {
+      errorAtBit_ = bits - CAN_BUS_ACK_SLOT_FROM_END;
+      ackError_ = true;
+    }
+
+    // on the wire until the end of EOF or of the error frame, then the intermission
+    uint32_t wireBits = bits;
+    if (errorAtBit_ != 0) {
+      wireBits = errorAtBit_ + CAN_BUS_ERROR_FRAME_BITS;
+      for (size_t i = 0; i < winners_.size(); i++) {
+        if (winners_[i]->errorPassive()) {
+          wireBits += CAN_BUS_SUSPEND_BITS;
+          break;
+        }
+      }
+    }
+    endNs_ = startNs_ + (int64_t)wireBits * bitNs_;
+    freeAtNs_ = endNs_ + CAN_BUS_INTERMISSION_BITS * bitNs_;
+    busyNs_ += freeAtNs_ - startNs_;
+    frameBits_ = bits;
+
+    busy_ = true;
+    const int64_t eventUs = (freeAtNs_ + 999) / 1000;
+    event_.startOnce((uint32_t)(eventUs - clock_.nowUs()), onEvent, this);
+  }
+
+  bool isWinner(const SimCan& node) const
+  {
+    for (size_t i = 0; i < winners_.size(); i++) {
+      if (winners_[i] == &node) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief the frame on the wire is over, hand it out or count the error
+   */
+  void finish()
+  {
+    const uint32_t key = frame_.id | (frame_.extended ? CAN_BUS_EXTENDED_KEY : 0);
+    CanIdStats& id = ids_[key];
+
+    if (errorAtBit_ != 0) {
+      errorFrames_++;
+      id.errors++;
+      for (size_t i = 0; i < winners_.size(); i++) {
+        SimCan& sender = *winners_[i];
+        CanNodeStats& node = stats(sender);
+        node.errorFrames++;
+        if (ackError_) {
+          sender.acknowledgementError();
+        }
+        else {
+          sender.transmitError();
+        }
+        if (sender.busOff()) {
+          node.busOffEvents++;
+        }
+      }
+      if (!ackError_) {
+        for (size_t i = 0; i < nodes_.size(); i++) {
+          if (onBus(*nodes_[i]) && !isWinner(*nodes_[i])) {
+            nodes_[i]->receiveError();
+          }
+        }
+      }
+      return;
+    }
+
+    frames_++;
+    id.frames++;
+    id.bits += frameBits_ + CAN_BUS_INTERMISSION_BITS;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      SimCan& node = *nodes_[i];
+      if (onBus(node) && !isWinner(node) && node.bitrate() == bitrate_) {
+        node.deliver(frame_);
+        node.receiveSucceeded();
+      }
+    }
+    for (size_t i = 0; i < winners_.size(); i++) {
+      SimCan& sender = *winners_[i];
+      if (sender.txPeek() == NULL) {
+        continue;                       // its queue was cleared while the frame was on the wire
+      }
+      id.latencyUs.record((uint32_t)((endNs_ + 999) / 1000 - sender.txQueuedUs()));
+      stats(sender).framesSent++;
+      sender.txComplete(true);
+      if (frame_.self) {
+        sender.deliver(frame_);
+      }
+    }
+  }
+
+  SimClock& clock_;
+  SimTimer event_;                      // end of the current frame, or arbitration on an idle bus
+  uint32_t bitrate_;
+  int64_t bitNs_;
+  uint32_t random_;
+
+  // the frame on the wire
+  bool busy_ = false;
+  HalCanFrame frame_;
+  std::vector<SimCan*> winners_;
+  std::vector<Contender> contenders_;
+  int64_t startNs_ = 0;
+  int64_t endNs_ = 0;
+  int64_t freeAtNs_ = 0;
+  uint32_t frameBits_ = 0;
+  uint32_t errorAtBit_ = 0;             // 0 for a clean frame
+  bool ackError_ = false;
+
+  // statistics window
+  std::map<uint32_t, CanIdStats> ids_;
+  std::vector<CanNodeStats> nodeStats_;
+  int64_t windowStartNs_ = 0;
+  int64_t busyNs_ = 0;
+  uint32_t errorFrames_ = 0;
+};
@@ -0,0 +1,170 @@
+/**
+ * @file sim_socketcan.h
+ * @brief bridges a simulated CAN bus to a Linux SocketCAN interface (vcan or a real adapter)
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the bridge is one more SimCan on the bus. frames read from the interface are queued on it
+ * and arbitrate like any other node's, frames the simulated nodes send are written to the
+ * interface, so candump, cansend or a second process can watch and join the simulation:
+ *
+ *   sudo modprobe vcan && sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+ *
+ * the simulation has to run in real time for this to make sense, see the CAN-Test runner's
+ * --vcan option. Linux host builds only, elsewhere open() always fails.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <string.h>
+#include "hal_sim.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define SIM_SOCKETCAN_QUEUE_LENGTH        64          // frames from the interface waiting for the bus
+
+
+/*
+===============================================================================================
+                                    Bridge
+===============================================================================================
+*/
+
+class SimSocketCanBridge
+{
+public:
+  explicit SimSocketCanBridge(SimCanBus& bus) : can_(bus)
+  {
+    can_.configure(SIM_SOCKETCAN_QUEUE_LENGTH, SIM_SOCKETCAN_QUEUE_LENGTH, SimCanFilter(), false, false, 500000);
+  }
+
+  ~SimSocketCanBridge() { close(); }
+
+  /**
+   * @brief open and bind a raw CAN socket on the interface and join the bus
+   *
+   * @param bitrate what the bridge's controller runs at, the bus bitrate unless testing a mismatch
+   * @return false if the interface does not exist or is down
+   */
+  bool open(const char* interfaceName, uint32_t bitrate)
+  {
+#ifdef __linux__
+    socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (socket_ < 0) {
+      return false;
+    }
+
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, interfaceName, IFNAMSIZ - 1);
+    struct sockaddr_can address;
+    memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    if (ioctl(socket_, SIOCGIFINDEX, &request) < 0) {
+      close();
+      return false;
+    }
+    address.can_ifindex = request.ifr_ifindex;
+    if (bind(socket_, (struct sockaddr*)&address, sizeof(address)) < 0) {
+      close();
+      return false;
+    }
+    fcntl(socket_, F_SETFL, fcntl(socket_, F_GETFL, 0) | O_NONBLOCK);
+
+    can_.configure(SIM_SOCKETCAN_QUEUE_LENGTH, SIM_SOCKETCAN_QUEUE_LENGTH, SimCanFilter(), false, false, bitrate);
+    can_.setInstalled(true);
+    can_.start();
+    return true;
+#else
+    (void)interfaceName;
+    (void)bitrate;
+    return false;
+#endif
+  }
+
+  void close()
+  {
+#ifdef __linux__
+    if (socket_ >= 0) {
+      ::close(socket_);
+      socket_ = -1;
+    }
+#endif
+    can_.stop();
+  }
+
+  /**
+   * @brief move frames both ways, call at least once per millisecond of simulated time
+   */
+  void poll()
+  {
+#ifdef __linux__
+    if (socket_ < 0) {
+      return;
+    }
+
+    // interface -> bus, a frame the TX queue cannot take is dropped
+    struct can_frame raw;
+    while (read(socket_, &raw, sizeof(raw)) == (ssize_t)sizeof(raw)) {
+      HalCanFrame frame;
+      frame.extended = (raw.can_id & CAN_EFF_FLAG) != 0;
+      frame.remote = (raw.can_id & CAN_RTR_FLAG) != 0;
+      frame.id = raw.can_id & (frame.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+      frame.length = raw.can_dlc > HAL_CAN_MAX_DATA ? HAL_CAN_MAX_DATA : raw.can_dlc;
+      memcpy(frame.data, raw.data, HAL_CAN_MAX_DATA);
+      if (can_.transmit(frame, 0) == HAL_CAN_OK) {
+        fromInterface_++;
+      }
+    }
+
+    // bus -> interface
+    HalCanFrame frame;
+    while (can_.receive(frame, 0) == HAL_CAN_OK) {
+      memset(&raw, 0, sizeof(raw));
+      raw.can_id = frame.id | (frame.extended ? CAN_EFF_FLAG : 0) | (frame.remote ? CAN_RTR_FLAG : 0);
+      raw.can_dlc = frame.length;
+      memcpy(raw.data, frame.data, HAL_CAN_MAX_DATA);
+      if (write(socket_, &raw, sizeof(raw)) == (ssize_t)sizeof(raw)) {
+        toInterface_++;
+      }
+      else {
+        writeFailed_++;
+      }
+    }
+#endif
+  }
+
+  bool isOpen() const { return socket_ >= 0; }
+  SimCan& can() { return can_; }
+  uint32_t fromInterface() const { return fromInterface_; }
+  uint32_t toInterface() const { return toInterface_; }
+  uint32_t writeFailed() const { return writeFailed_; }
+
+private:
+  SimCan can_;
+  int socket_ = -1;
+  uint32_t fromInterface_ = 0;
+  uint32_t toInterface_ = 0;
+  uint32_t writeFailed_ = 0;            // interface TX queue full or down
+};
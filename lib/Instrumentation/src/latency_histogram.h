@@ -0,0 +1,305 @@
+/**
+ * @file latency_histogram.h
+ * @brief fixed bucket log-linear latency histograms and period monitors
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * values (microseconds) below 16 get a bucket each. above that every power of two range is
+ * split into 16 equal sub-buckets, so a bucket is never wider than 1/16 of its lower bound
+ * and any reported percentile is within 6.25% of the true value. the full 32 bit range takes
+ * 464 buckets. recording is one relaxed atomic add plus a max update, with no locks and no
+ * allocation, so it is safe from ISRs and from both cores at once.
+ *
+ * PeriodMonitor wraps a histogram for a periodic callback: it works out when each call was
+ * supposed to happen (phase locked to the earliest call seen, like esp_timer and the hardware
+ * timer alarms) and records how late the actual call was. its phase and counters belong to
+ * mark(), so reset() from another task only asks for a reset and the next mark() does it.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#define LATENCY_IRAM                      IRAM_ATTR
+#else
+#define LATENCY_IRAM
+#endif
+
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define LATENCY_SUB_BUCKET_BITS           4
+#define LATENCY_SUB_BUCKETS               (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS                   (LATENCY_SUB_BUCKETS + (32 - LATENCY_SUB_BUCKET_BITS) * LATENCY_SUB_BUCKETS)
+
+
+/**
+ * @brief percentiles of one histogram, in microseconds
+ */
+struct LatencySummary
+{
+  uint32_t count = 0;
+  uint32_t p50 = 0;
+  uint32_t p90 = 0;
+  uint32_t p99 = 0;
+  uint32_t max = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Histogram
+===============================================================================================
+*/
+
+class LatencyHistogram
+{
+public:
+  /**
+   * @brief bucket a value falls in
+   */
+  static LATENCY_IRAM int bucketOf(uint32_t value)
+  {
+    if (value < LATENCY_SUB_BUCKETS) {
+      return (int)value;
+    }
+    const int msb = 31 - __builtin_clz(value);
+    const int shift = msb - LATENCY_SUB_BUCKET_BITS;
+    return LATENCY_SUB_BUCKETS + shift * LATENCY_SUB_BUCKETS + (int)((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+  }
+
+  /**
+   * @brief largest value that falls in a bucket
+   */
+  static uint32_t bucketUpperBound(int bucket)
+  {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+      return (uint32_t)bucket;
+    }
+    const int shift = (bucket - LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS;
+    const uint32_t sub = (uint32_t)((bucket - LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS);
+    const uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKETS + sub) << shift;
+    return (uint32_t)(lower + (1ull << shift) - 1);
+  }
+
+  /**
+   * @brief count one value, safe from ISRs and any core
+   */
+  LATENCY_IRAM void record(uint32_t value)
+  {
+    counts_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief value at or below which the given fraction of recorded values fall
+   *
+   * @param fraction 0.0 to 1.0, e.g. 0.99 for p99
+   * @return upper bound of the bucket holding that value, never more than the true maximum
+   */
+  uint32_t percentile(float fraction) const
+  {
+    const uint32_t total = count_.load(std::memory_order_relaxed);
+    if (total == 0) {
+      return 0;
+    }
+
+    uint32_t rank = (uint32_t)(fraction * total + 0.5f);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+
+    const uint32_t max = max_.load(std::memory_order_relaxed);
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+      seen += counts_[i].load(std::memory_order_relaxed);
+      if (seen >= rank) {
+        const uint32_t upper = bucketUpperBound(i);
+        return upper < max ? upper : max;
+      }
+    }
+    return max;
+  }
+
+  LatencySummary summary() const
+  {
+    LatencySummary summary;
+    summary.count = count_.load(std::memory_order_relaxed);
+    summary.p50 = percentile(0.50f);
+    summary.p90 = percentile(0.90f);
+    summary.p99 = percentile(0.99f);
+    summary.max = max_.load(std::memory_order_relaxed);
+    return summary;
+  }
+
+  /**
+   * @brief clear every bucket, values recorded during the reset may be lost
+   */
+  void reset()
+  {
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+      counts_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint32_t> counts_[LATENCY_BUCKETS] = {};
+  std::atomic<uint32_t> count_{0};
+  std::atomic<uint32_t> max_{0};
+};
+
+
+/*
+===============================================================================================
+                                    Period Monitor
+===============================================================================================
+*/
+
+/**
+ * @brief measures how late each call of a periodic callback is
+ * call mark() from one context only (the callback itself), reset() from any
+ */
+class PeriodMonitor
+{
+public:
+  /**
+   * @param periodUs the period the callback was started with, in microseconds
+   */
+  explicit PeriodMonitor(uint32_t periodUs) : periodUs_(periodUs) {}
+
+  /**
+   * @brief record one call
+   *
+   * @param nowUs esp_timer_get_time() at the start of the callback
+   */
+  LATENCY_IRAM void mark(int64_t nowUs)
+  {
+    // a reset asked for since the last call, done here so nothing else writes the phase
+    if (resetPending_.exchange(0, std::memory_order_acquire) != 0) {
+      expectedUs_ = 0;
+      missed_ = 0;
+      early_ = 0;
+    }
+
+    if (expectedUs_ == 0) {
+      // the first call sets the phase
+      expectedUs_ = nowUs + periodUs_;
+      return;
+    }
+
+    // an early call means the first one was late and set the phase wrong, take the earlier phase
+    int64_t latenessUs = nowUs - expectedUs_;
+    if (latenessUs < 0) {
+      early_++;
+      expectedUs_ = nowUs;
+      latenessUs = 0;
+    }
+    lateness_.record(latenessUs > UINT32_MAX ? UINT32_MAX : (uint32_t)latenessUs);
+
+    // a call more than a whole period late means calls were skipped, re-align to the next one
+    expectedUs_ += periodUs_;
+    if (nowUs >= expectedUs_) {
+      const int64_t behind = (nowUs - expectedUs_) / periodUs_ + 1;
+      missed_ += (uint32_t)behind;
+      expectedUs_ += behind * periodUs_;
+    }
+  }
+
+  /**
+   * @brief clear the histogram and have the next mark() start over, safe while mark() runs
+   * (the counters read 0 until then)
+   */
+  void reset()
+  {
+    lateness_.reset();
+    resetPending_.store(1, std::memory_order_release);
+  }
+
+  const LatencyHistogram& lateness() const { return lateness_; }
+  uint32_t periodUs() const { return periodUs_; }
+  uint32_t missed() const { return resetPending_.load(std::memory_order_relaxed) != 0 ? 0 : missed_; }
+  uint32_t early() const { return resetPending_.load(std::memory_order_relaxed) != 0 ? 0 : early_; }
+
+private:
+  LatencyHistogram lateness_;
+  uint32_t periodUs_;
+  int64_t expectedUs_ = 0;
+  volatile uint32_t missed_ = 0;            // whole periods with no call
+  volatile uint32_t early_ = 0;             // calls before their expected time, the phase moves to them
+  std::atomic<uint32_t> resetPending_{0};   // set by reset(), cleared by mark()
+};
+
+
+/*
+===============================================================================================
+                                    Report
+===============================================================================================
+*/
+
+/**
+ * @brief a named histogram for reports, histogram or monitor must be set
+ */
+struct LatencySource
+{
+  const char* name;
+  LatencyHistogram* histogram;
+  PeriodMonitor* monitor;
+};
+
+#ifdef ARDUINO
+
+/**
+ * @brief print p50 / p90 / p99 / max for each source
+ */
+inline void printLatencyReport(Print& out, const LatencySource* sources, size_t count)
+{
+  out.printf("\n%-20s %10s %8s %8s %8s %8s %8s\n", "source", "count", "p50 us", "p90 us", "p99 us", "max us", "missed");
+  for (size_t i = 0; i < count; i++) {
+    const LatencyHistogram& histogram = sources[i].monitor != NULL ? sources[i].monitor->lateness() : *sources[i].histogram;
+    const LatencySummary summary = histogram.summary();
+    out.printf("%-20s %10u %8u %8u %8u %8u %8u\n", sources[i].name, summary.count, summary.p50, summary.p90, summary.p99, summary.max,
+      sources[i].monitor != NULL ? sources[i].monitor->missed() : 0);
+  }
+}
+
+/**
+ * @brief clear every source
+ */
+inline void resetLatencyReport(const LatencySource* sources, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    if (sources[i].monitor != NULL) {
+      sources[i].monitor->reset();
+    }
+    else {
+      sources[i].histogram->reset();
+    }
+  }
+}
+
+#endif
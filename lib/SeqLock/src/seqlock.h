@@ -0,0 +1,134 @@
+/**
+ * @file seqlock.h
+ * @brief single writer sequence lock for sharing a small struct between a callback and a task
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the writer never waits: publish() bumps the sequence to odd, copies the value in and bumps
+ * it back to even, all in constant time with no lock, so it is safe in the Wi-Fi task callbacks
+ * and in ISRs. readers copy the value out and retry if the sequence was odd or changed while
+ * they were copying, so every copy they return was written by exactly one publish().
+ *
+ * the value is stored as relaxed 32 bit atomics rather than a plain T, so the concurrent copy
+ * in and out is not a data race and the compiler cannot tear or cache it. T must be trivially
+ * copyable. there must only ever be one writer at a time.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+
+/*
+===============================================================================================
+                                    Sequence Lock
+===============================================================================================
+*/
+
+template <typename T>
+class SeqLock
+{
+public:
+  SeqLock()
+  {
+    T value = T();
+    store(value);
+  }
+
+  /**
+   * @brief publish a new value, constant time and never blocks
+   * only one context may publish, e.g. the ESP-NOW receive callback
+   *
+   * @param value the value readers will see next
+   */
+  void publish(const T& value)
+  {
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    store(value);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief try once to take a consistent copy
+   *
+   * @param value receives the copy, only valid if this returns true
+   * @return false if a publish() was in progress or happened during the copy
+   */
+  bool tryRead(T& value) const
+  {
+    const uint32_t before = sequence_.load(std::memory_order_acquire);
+    if (before & 1) {
+      return false;
+    }
+
+    load(value);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence_.load(std::memory_order_relaxed) == before;
+  }
+
+  /**
+   * @brief take a consistent copy, retrying until no publish() overlaps it
+   * a publish is only a few word copies, so this retries at most a handful of times
+   *
+   * @return sequence number of the copy, compare it with sequence() to detect new data
+   */
+  uint32_t read(T& value) const
+  {
+    for (;;) {
+      const uint32_t before = sequence_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+
+      load(value);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before) {
+        return before;
+      }
+    }
+  }
+
+  /**
+   * @brief even number that increases by 2 with every publish()
+   */
+  uint32_t sequence() const { return sequence_.load(std::memory_order_acquire) & ~1u; }
+
+private:
+  static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  void store(const T& value)
+  {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < WORDS; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  void load(T& value) const
+  {
+    uint32_t words[WORDS];
+    for (size_t i = 0; i < WORDS; i++) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    memcpy(&value, words, sizeof(T));
+  }
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint32_t> words_[WORDS];
+};
@@ -0,0 +1,215 @@
+/**
+ * @file memory_report.h
+ * @brief heap and static memory report: free heap, its low-water mark, fragmentation, task stacks, pools, arenas
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the heap line comes from heap_caps (8 bit capable memory, what malloc and new use): free
+ * bytes now, the least that was ever free, and the largest single block, which is what the
+ * next big allocation actually gets. a largest block far below the free total is
+ * fragmentation.
+ *
+ * everything else is a list of named sources, like the latency report: static tasks with
+ * their stack size and the most of it they ever used, pools with their peak objects out,
+ * arenas with their fill. the bytes column is the static memory each one pins, so the total
+ * is the firmware's fixed budget, and a failures column above zero means a pool or arena was
+ * sized too small:
+ *
+ *   MemorySource memorySources[] = {
+ *     { "can read task", NULL, NULL, &canReadTask },
+ *     { "rx frames", &rxFrames, NULL, NULL },
+ *   };
+ *   printMemoryReport(Serial, memorySources, 2);
+ *
+ * formatMemoryRow() is the same row as text, for the host runners that print with printf.
+ * tasks and the heap exist on the ESP32 only.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "static_pool.h"
+#include "static_arena.h"
+#include "static_task.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#else
+class StaticTaskBase;
+#endif
+
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define MEMORY_REPORT_ROW_SIZE            96
+
+/**
+ * @brief a named pool, arena or task for reports, exactly one must be set
+ */
+struct MemorySource
+{
+  const char* name;
+  StaticPoolBase* pool;
+  StaticArenaBase* arena;
+  StaticTaskBase* task;
+};
+
+/**
+ * @brief one source's line of the report, stacks and arenas in bytes and pools in objects
+ */
+struct MemorySourceUsage
+{
+  const char* kind = "";
+  uint32_t bytes = 0;                 // static memory it occupies
+  uint32_t capacity = 0;
+  uint32_t used = 0;
+  uint32_t peak = 0;
+  uint32_t failures = 0;
+};
+
+/**
+ * @brief heap_caps figures for 8 bit capable memory, all zero on the host
+ */
+struct MemoryHeapStats
+{
+  uint32_t totalBytes = 0;
+  uint32_t freeBytes = 0;
+  uint32_t minFreeBytes = 0;          // low-water mark since boot
+  uint32_t largestFreeBlock = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Collection
+===============================================================================================
+*/
+
+inline MemoryHeapStats readMemoryHeap()
+{
+  MemoryHeapStats stats;
+#ifdef ESP_PLATFORM
+  stats.totalBytes = (uint32_t)heap_caps_get_total_size(MALLOC_CAP_8BIT);
+  stats.freeBytes = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  stats.minFreeBytes = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  stats.largestFreeBlock = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#endif
+  return stats;
+}
+
+inline MemorySourceUsage readMemorySource(const MemorySource& source)
+{
+  MemorySourceUsage result;
+  if (source.pool != NULL) {
+    const StaticMemoryUsage usage = source.pool->usage();
+    result.kind = "pool";
+    result.bytes = usage.capacity * usage.unitBytes;
+    result.capacity = usage.capacity;
+    result.used = usage.used;
+    result.peak = usage.peak;
+    result.failures = usage.failures;
+  }
+  else if (source.arena != NULL) {
+    const StaticMemoryUsage usage = source.arena->usage();
+    result.kind = "arena";
+    result.bytes = usage.capacity;
+    result.capacity = usage.capacity;
+    result.used = usage.used;
+    result.peak = usage.peak;
+    result.failures = usage.failures;
+  }
+#ifdef ESP_PLATFORM
+  else if (source.task != NULL) {
+    // a task's use is its stack's high-water mark, there is no cheap "now"
+    result.kind = "stack";
+    result.bytes = source.task->stackBytes();
+    result.capacity = source.task->stackBytes();
+    result.peak = source.task->handle() != NULL ? source.task->stackBytes() - source.task->freeStackBytes() : 0;
+    result.used = result.peak;
+  }
+#endif
+  return result;
+}
+
+/**
+ * @brief one source as a report row, without the newline
+ */
+inline int formatMemoryRow(char* out, size_t size, const MemorySource& source)
+{
+  const MemorySourceUsage usage = readMemorySource(source);
+  return snprintf(out, size, "%-20s %-6s %8u %8u %8u %8u %8u", source.name, usage.kind, usage.bytes, usage.capacity,
+    usage.used, usage.peak, usage.failures);
+}
+
+inline const char* memoryReportHeader()
+{
+  return "source               kind      bytes capacity     used     peak failures";
+}
+
+/**
+ * @brief static bytes pinned by all sources together
+ */
+inline uint32_t memoryReportTotalBytes(const MemorySource* sources, size_t count)
+{
+  uint32_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    total += readMemorySource(sources[i]).bytes;
+  }
+  return total;
+}
+
+
+/*
+===============================================================================================
+                                    Report
+===============================================================================================
+*/
+
+#ifdef ARDUINO
+
+/**
+ * @brief the heap line, then one row per source and their static total
+ */
+inline void printMemoryReport(Print& out, const MemorySource* sources, size_t count)
+{
+  const MemoryHeapStats heap = readMemoryHeap();
+  out.printf("\nheap: %u of %u bytes free, %u at the least, largest block %u\n", heap.freeBytes, heap.totalBytes,
+    heap.minFreeBytes, heap.largestFreeBlock);
+  out.printf("%s\n", memoryReportHeader());
+  char row[MEMORY_REPORT_ROW_SIZE];
+  for (size_t i = 0; i < count; i++) {
+    formatMemoryRow(row, sizeof(row), sources[i]);
+    out.printf("%s\n", row);
+  }
+  out.printf("static total %u bytes\n", memoryReportTotalBytes(sources, count));
+}
+
+/**
+ * @brief restart the pools' peaks and failure counts, arenas and stacks cannot be reset
+ */
+inline void resetMemoryReport(const MemorySource* sources, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    if (sources[i].pool != NULL) {
+      sources[i].pool->resetPeak();
+    }
+  }
+}
+
+#endif
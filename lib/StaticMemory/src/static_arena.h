@@ -0,0 +1,153 @@
+/**
+ * @file static_arena.h
+ * @brief bump allocator over static storage for structures built once at startup
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * StaticArena<Bytes> hands out aligned pieces of one static buffer, front to back, and never
+ * takes them back. that fits what setup() builds and keeps forever: per-node objects, tables
+ * whose size is only known once the configuration is read, buffers for drivers. once startup
+ * is over, seal() the arena and any later allocation fails and is counted, so a stray runtime
+ * allocation shows up in the memory report instead of slowly eating the buffer:
+ *
+ *   StaticArena<4096> startupArena;
+ *   EspNowMesh* mesh = startupArena.create<EspNowMesh>(sendFrame, onMessage);
+ *   int16_t* history = startupArena.createArray<int16_t>(channels * 64);
+ *   startupArena.seal();
+ *
+ * objects from the arena are never destroyed, their destructors do not run. allocation takes
+ * a short critical section, but belongs in setup() and not in ISRs.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include "static_pool.h"
+
+
+/*
+===============================================================================================
+                                    Arena
+===============================================================================================
+*/
+
+/**
+ * @brief the bookkeeping every arena shares, so reports can take any arena without its size
+ */
+class StaticArenaBase
+{
+public:
+  /**
+   * @brief the next size bytes aligned to align (a power of two)
+   * @return NULL if they do not fit or the arena is sealed
+   */
+  void* allocate(size_t size, size_t align = alignof(max_align_t))
+  {
+    void* piece = NULL;
+    STATIC_POOL_LOCK(&lock_);
+    const size_t start = (used_ + align - 1) & ~(align - 1);
+    if (!sealed_ && start <= capacity_ && size <= capacity_ - start) {
+      piece = buffer_ + start;
+      used_ = start + size;
+      usage_.used = (uint32_t)used_;
+      usage_.peak = usage_.used;
+    }
+    else {
+      usage_.failures++;
+    }
+    STATIC_POOL_UNLOCK(&lock_);
+    return piece;
+  }
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args)
+  {
+    void* piece = allocate(sizeof(T), alignof(T));
+    return piece != NULL ? new (piece) T(std::forward<Args>(args)...) : NULL;
+  }
+
+  /**
+   * @brief count value-initialized objects in one piece
+   */
+  template <typename T>
+  T* createArray(size_t count)
+  {
+    if (count == 0 || count > capacity_ / sizeof(T)) {
+      STATIC_POOL_LOCK(&lock_);
+      usage_.failures++;
+      STATIC_POOL_UNLOCK(&lock_);
+      return NULL;
+    }
+    T* array = (T*)allocate(sizeof(T) * count, alignof(T));
+    for (size_t i = 0; array != NULL && i < count; i++) {
+      new (&array[i]) T();
+    }
+    return array;
+  }
+
+  /**
+   * @brief startup is over, every allocation from now on fails
+   */
+  void seal()
+  {
+    STATIC_POOL_LOCK(&lock_);
+    sealed_ = true;
+    STATIC_POOL_UNLOCK(&lock_);
+  }
+
+  bool sealed() const { return sealed_; }
+  size_t remaining() const { return capacity_ - used_; }
+
+  StaticMemoryUsage usage() const
+  {
+    StaticMemoryUsage usage;
+    STATIC_POOL_LOCK(&lock_);
+    usage = usage_;
+    STATIC_POOL_UNLOCK(&lock_);
+    return usage;
+  }
+
+protected:
+  StaticArenaBase(uint8_t* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity)
+  {
+    usage_.capacity = (uint32_t)capacity;
+    usage_.unitBytes = 1;
+  }
+
+  StaticArenaBase(const StaticArenaBase&) = delete;
+  StaticArenaBase& operator=(const StaticArenaBase&) = delete;
+
+private:
+  uint8_t* buffer_;
+  size_t capacity_;
+  size_t used_ = 0;
+  bool sealed_ = false;
+  StaticMemoryUsage usage_;           // used and peak are equal, nothing is ever freed
+#ifdef ESP_PLATFORM
+  mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+  mutable int lock_ = 0;
+#endif
+};
+
+
+template <size_t Bytes>
+class StaticArena : public StaticArenaBase
+{
+public:
+  static_assert(Bytes >= 1, "at least one byte");
+
+  StaticArena() : StaticArenaBase(storage_, Bytes) {}
+
+private:
+  alignas(max_align_t) uint8_t storage_[Bytes];
+};
@@ -0,0 +1,202 @@
+/**
+ * @file static_pool.h
+ * @brief fixed-size object pool in static storage, for messages and records handed between tasks
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * StaticPool<T, N> holds room for N objects of T inside itself, so a global pool is sized and
+ * placed by the linker and never touches the heap. create() takes a free slot, constructs the
+ * object in it and returns a pointer, destroy() runs the destructor and gives the slot back.
+ * both are O(1), a short critical section around a free list of slot indices, so a producer
+ * in an ISR or a Wi-Fi callback and a consumer task can share a pool:
+ *
+ *   StaticPool<MeshRxFrame, 8> rxFrames;
+ *   MeshRxFrame* frame = rxFrames.create();            // NULL when all 8 are out
+ *   ...
+ *   rxFrames.destroy(frame);
+ *
+ * an empty pool is not an error the pool can fix: create() returns NULL and counts it in
+ * usage().failures, the caller drops whatever it wanted to store. usage() also keeps the peak
+ * number of objects out at once, which is what sizes N (see memory_report.h).
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <esp_attr.h>
+#define STATIC_POOL_IRAM                  IRAM_ATTR
+#define STATIC_POOL_LOCK(lock)            portENTER_CRITICAL_SAFE(lock)
+#define STATIC_POOL_UNLOCK(lock)          portEXIT_CRITICAL_SAFE(lock)
+#else
+#define STATIC_POOL_IRAM
+#define STATIC_POOL_LOCK(lock)            (void)(lock)
+#define STATIC_POOL_UNLOCK(lock)          (void)(lock)
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define STATIC_POOL_MAX_OBJECTS           UINT16_MAX
+
+/**
+ * @brief fill level of a pool or an arena, in objects for pools and bytes for arenas
+ */
+struct StaticMemoryUsage
+{
+  uint32_t capacity = 0;
+  uint32_t used = 0;                  // out right now
+  uint32_t peak = 0;                  // most out at once since begin / resetPeak
+  uint32_t failures = 0;              // requests that found no room
+  uint32_t unitBytes = 0;             // bytes per object, 1 for arenas
+};
+
+
+/*
+===============================================================================================
+                                    Pool
+===============================================================================================
+*/
+
+/**
+ * @brief the bookkeeping every pool shares, so reports can take any pool without its type
+ */
+class StaticPoolBase
+{
+public:
+  StaticMemoryUsage usage() const
+  {
+    StaticMemoryUsage usage;
+    STATIC_POOL_LOCK(&lock_);
+    usage = usage_;
+    STATIC_POOL_UNLOCK(&lock_);
+    return usage;
+  }
+
+  void resetPeak()
+  {
+    STATIC_POOL_LOCK(&lock_);
+    usage_.peak = usage_.used;
+    usage_.failures = 0;
+    STATIC_POOL_UNLOCK(&lock_);
+  }
+
+protected:
+  StaticPoolBase(uint32_t capacity, uint32_t unitBytes)
+  {
+    usage_.capacity = capacity;
+    usage_.unitBytes = unitBytes;
+  }
+
+  StaticMemoryUsage usage_;
+#ifdef ESP_PLATFORM
+  mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+  mutable int lock_ = 0;
+#endif
+};
+
+
+template <typename T, int N>
+class StaticPool : public StaticPoolBase
+{
+public:
+  static_assert(N >= 1 && N <= STATIC_POOL_MAX_OBJECTS, "1 to 65535 objects");
+
+  StaticPool() : StaticPoolBase(N, sizeof(T))
+  {
+    for (int i = 0; i < N; i++) {
+      free_[i] = (uint16_t)(N - 1 - i);
+    }
+    freeCount_ = N;
+  }
+
+  StaticPool(const StaticPool&) = delete;
+  StaticPool& operator=(const StaticPool&) = delete;
+
+  /**
+   * @brief construct an object in a free slot
+   * @return NULL if every slot is taken
+   */
+  template <typename... Args>
+  STATIC_POOL_IRAM T* create(Args&&... args)
+  {
+    void* slot = take();
+    return slot != NULL ? new (slot) T(std::forward<Args>(args)...) : NULL;
+  }
+
+  /**
+   * @brief destroy an object from create() and free its slot, NULL is ignored
+   */
+  STATIC_POOL_IRAM void destroy(T* object)
+  {
+    if (object == NULL) {
+      return;
+    }
+    object->~T();
+    give(object);
+  }
+
+  /**
+   * @return true if the pointer is one of this pool's slots
+   */
+  bool owns(const T* object) const
+  {
+    const uint8_t* address = (const uint8_t*)object;
+    return address >= (const uint8_t*)slots_ && address < (const uint8_t*)(slots_ + N) &&
+      (size_t)(address - (const uint8_t*)slots_) % sizeof(Slot) == 0;
+  }
+
+  static constexpr int capacity() { return N; }
+  static constexpr size_t storageBytes() { return sizeof(Slot) * N + sizeof(uint16_t) * N; }
+
+private:
+  union Slot
+  {
+    alignas(T) uint8_t bytes[sizeof(T)];
+  };
+
+  STATIC_POOL_IRAM void* take()
+  {
+    void* slot = NULL;
+    STATIC_POOL_LOCK(&lock_);
+    if (freeCount_ > 0) {
+      slot = slots_[free_[--freeCount_]].bytes;
+      usage_.used++;
+      usage_.peak = usage_.used > usage_.peak ? usage_.used : usage_.peak;
+    }
+    else {
+      usage_.failures++;
+    }
+    STATIC_POOL_UNLOCK(&lock_);
+    return slot;
+  }
+
+  STATIC_POOL_IRAM void give(T* object)
+  {
+    const uint16_t index = (uint16_t)(((uint8_t*)object - (uint8_t*)slots_) / sizeof(Slot));
+    STATIC_POOL_LOCK(&lock_);
+    free_[freeCount_++] = index;
+    usage_.used--;
+    STATIC_POOL_UNLOCK(&lock_);
+  }
+
+  Slot slots_[N];
+  uint16_t free_[N];                  // stack of free slot indices
+  int freeCount_;
+};
@@ -0,0 +1,147 @@
+/**
+ * @file static_task.h
+ * @brief FreeRTOS tasks and queues whose stacks and storage are static, not taken from the heap
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * xTaskCreate() takes the task's stack and control block from the heap, and so does
+ * xQueueCreate() for the queue storage. StaticTask<StackBytes> and StaticQueue<T, N> carry
+ * that memory inside themselves and create through the *Static variants instead, so a global
+ * one is sized and placed by the linker and cannot fail for want of heap:
+ *
+ *   StaticTask<4096> canReadTask;
+ *   canReadTask.start(CANReadTask, "CAN-Read", NULL, CAN_READ_TASK_PRIORITY, CAN_TASK_CORE);
+ *
+ *   StaticQueue<MeshRxFrame*, 8> rxQueue;
+ *   rxQueue.begin();
+ *   xQueueSend(rxQueue.handle(), &frame, 0);
+ *
+ * a static task is started once and lives for the whole program; its memory cannot be reused
+ * safely after vTaskDelete() until the idle task has cleaned up, so there is no restart.
+ * freeStackBytes() is the stack high-water mark, the least free stack the task ever had,
+ * which is what memory_report.h prints. stack sizes are in bytes, as everywhere in ESP-IDF.
+ *
+ * FreeRTOS is not simulated, on the host this header is empty.
+ */
+
+#pragma once
+
+#ifdef ESP_PLATFORM
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+
+/*
+===============================================================================================
+                                    Task
+===============================================================================================
+*/
+
+/**
+ * @brief what reports need of any static task, whatever its stack size
+ */
+class StaticTaskBase
+{
+public:
+  /**
+   * @brief create the task on its static stack, once
+   * @param core tskNO_AFFINITY or the core to pin the task to
+   * @return false if it was started before
+   */
+  bool start(TaskFunction_t function, const char* name, void* arg, UBaseType_t priority, BaseType_t core = tskNO_AFFINITY)
+  {
+    if (handle_ != NULL) {
+      return false;
+    }
+    name_ = name;
+    handle_ = xTaskCreateStaticPinnedToCore(function, name, stackBytes_, arg, priority, stack_, &control_, core);
+    return handle_ != NULL;
+  }
+
+  TaskHandle_t handle() const { return handle_; }
+  const char* name() const { return name_; }
+  uint32_t stackBytes() const { return stackBytes_; }
+
+  /**
+   * @brief the least free stack the task has had so far, 0 before start()
+   */
+  uint32_t freeStackBytes() const { return handle_ != NULL ? (uint32_t)uxTaskGetStackHighWaterMark(handle_) : 0; }
+
+protected:
+  StaticTaskBase(StackType_t* stack, uint32_t stackBytes) : stack_(stack), stackBytes_(stackBytes) {}
+
+  StaticTaskBase(const StaticTaskBase&) = delete;
+  StaticTaskBase& operator=(const StaticTaskBase&) = delete;
+
+private:
+  StackType_t* stack_;
+  uint32_t stackBytes_;
+  StaticTask_t control_;
+  TaskHandle_t handle_ = NULL;
+  const char* name_ = "";
+};
+
+
+template <uint32_t StackBytes>
+class StaticTask : public StaticTaskBase
+{
+public:
+  static_assert(StackBytes >= configMINIMAL_STACK_SIZE, "stack below the FreeRTOS minimum");
+
+  StaticTask() : StaticTaskBase(stack_, StackBytes) {}
+
+private:
+  StackType_t stack_[StackBytes / sizeof(StackType_t)];
+};
+
+
+/*
+===============================================================================================
+                                    Queue
+===============================================================================================
+*/
+
+/**
+ * @brief a FreeRTOS queue of N items of T in static storage, used through handle()
+ */
+template <typename T, int N>
+class StaticQueue
+{
+public:
+  static_assert(N >= 1, "at least one item");
+
+  StaticQueue() = default;
+  StaticQueue(const StaticQueue&) = delete;
+  StaticQueue& operator=(const StaticQueue&) = delete;
+
+  /**
+   * @brief create the queue, once, before anyone sends to it
+   */
+  QueueHandle_t begin()
+  {
+    if (handle_ == NULL) {
+      handle_ = xQueueCreateStatic(N, sizeof(T), storage_, &control_);
+    }
+    return handle_;
+  }
+
+  QueueHandle_t handle() const { return handle_; }
+  static constexpr int capacity() { return N; }
+
+private:
+  uint8_t storage_[N * sizeof(T)];
+  StaticQueue_t control_;
+  QueueHandle_t handle_ = NULL;
+};
+
+#endif
@@ -0,0 +1,381 @@
+/**
+ * @file telemetry.h
+ * @brief compact framed binary telemetry: COBS framing, varint fields, channel IDs, CRC-16
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * each frame is one COBS encoded payload followed by a 0x00 delimiter, so a decoder that
+ * starts mid-stream (or sees text logs on the same UART) resynchronises at the next zero and
+ * drops anything whose CRC does not match. payloads before framing:
+ *
+ *   sample   kind=1 channel:varint sequence:u8 timestampUs:varint values:zigzag varint...
+ *   schema   kind=0 channel:varint fieldCount:u8 name fieldName... (strings are length:u8 + bytes)
+ *
+ * followed by a CRC-16/CCITT-FALSE of everything before it, little endian. a sample of five
+ * small values with a microsecond timestamp is 16 bytes on the wire, the equivalent printf
+ * line is 45.
+ * channels resend their schema every TELEMETRY_SCHEMA_INTERVAL samples so a decoder attached
+ * late learns the column names. tools/telemetry_decoder turns a capture into CSV or columnar
+ * files, tools/telemetry_bench measures records/s encoded and decoded.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define TELEMETRY_MAX_FIELDS              8
+#define TELEMETRY_MAX_PAYLOAD             128         // bytes before COBS framing
+#define TELEMETRY_MAX_FRAME               (TELEMETRY_MAX_PAYLOAD + TELEMETRY_MAX_PAYLOAD / 254 + 2)
+#define TELEMETRY_SCHEMA_INTERVAL         100         // samples between schema resends
+
+#define TELEMETRY_KIND_SCHEMA             0
+#define TELEMETRY_KIND_SAMPLE             1
+
+
+/*
+===============================================================================================
+                                    Encoding
+===============================================================================================
+*/
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+inline uint16_t telemetryCrc16(const uint8_t* data, size_t length)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)(data[i] << 8);
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+inline uint32_t telemetryZigZag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+inline int32_t telemetryUnZigZag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+/**
+ * @brief COBS encode a payload and append the 0x00 delimiter
+ *
+ * @return frame length including the delimiter, 0 if it does not fit
+ */
+inline size_t telemetryCobsEncode(const uint8_t* payload, size_t length, uint8_t* frame, size_t size)
+{
+  if (size < length + length / 254 + 2) {
+    return 0;
+  }
+
+  size_t code = 0;      // where the current block's length byte goes
+  size_t out = 1;
+  uint8_t run = 1;
+  for (size_t i = 0; i < length; i++) {
+    if (payload[i] != 0) {
+      frame[out++] = payload[i];
+      run++;
+    }
+    if (payload[i] == 0 || run == 0xFF) {
+      frame[code] = run;
+      code = out++;
+      run = 1;
+    }
+  }
+  frame[code] = run;
+  frame[out++] = 0;
+  return out;
+}
+
+/**
+ * @brief decode one COBS frame without its delimiter
+ *
+ * @return payload length, 0 if the frame is malformed
+ */
+inline size_t telemetryCobsDecode(const uint8_t* frame, size_t length, uint8_t* payload, size_t size)
+{
+  size_t in = 0;
+  size_t out = 0;
+  while (in < length) {
+    const uint8_t code = frame[in++];
+    if (code == 0 || in + code - 1 > length) {
+      return 0;
+    }
+    for (uint8_t i = 1; i < code; i++) {
+      if (out >= size) {
+        return 0;
+      }
+      payload[out++] = frame[in++];
+    }
+    // a block shorter than 254 stands for a zero, except at the very end
+    if (code != 0xFF && in < length) {
+      if (out >= size) {
+        return 0;
+      }
+      payload[out++] = 0;
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief appends fields to a payload, stops writing (and reports failure) once it is full
+ */
+class TelemetryWriter
+{
+public:
+  TelemetryWriter(uint8_t* buffer, size_t size) : buffer_(buffer), size_(size) {}
+
+  void byte(uint8_t value)
+  {
+    if (length_ < size_) {
+      buffer_[length_++] = value;
+    }
+    else {
+      overflow_ = true;
+    }
+  }
+
+  void varint(uint32_t value)
+  {
+    while (value >= 0x80) {
+      byte((uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    byte((uint8_t)value);
+  }
+
+  void signedVarint(int32_t value) { varint(telemetryZigZag(value)); }
+
+  void string(const char* value)
+  {
+    size_t length = strlen(value);
+    length = length < 0xFF ? length : 0xFF;
+    byte((uint8_t)length);
+    for (size_t i = 0; i < length; i++) {
+      byte((uint8_t)value[i]);
+    }
+  }
+
+  /**
+   * @brief append the CRC and COBS frame the payload
+   *
+   * @return frame length including the delimiter, 0 on overflow
+   */
+  size_t finish(uint8_t* frame, size_t size)
+  {
+    const uint16_t crc = telemetryCrc16(buffer_, length_);
+    byte((uint8_t)crc);
+    byte((uint8_t)(crc >> 8));
+    return overflow_ ? 0 : telemetryCobsEncode(buffer_, length_, frame, size);
+  }
+
+  size_t length() const { return length_; }
+
+private:
+  uint8_t* buffer_;
+  size_t size_;
+  size_t length_ = 0;
+  bool overflow_ = false;
+};
+
+/**
+ * @brief reads fields back out of a decoded payload
+ */
+class TelemetryReader
+{
+public:
+  TelemetryReader(const uint8_t* buffer, size_t length) : buffer_(buffer), length_(length) {}
+
+  bool byte(uint8_t& value)
+  {
+    if (position_ >= length_) {
+      return false;
+    }
+    value = buffer_[position_++];
+    return true;
+  }
+
+  bool varint(uint32_t& value)
+  {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b;
+      if (!byte(b)) {
+        return false;
+      }
+      value |= (uint32_t)(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool signedVarint(int32_t& value)
+  {
+    uint32_t raw;
+    if (!varint(raw)) {
+      return false;
+    }
+    value = telemetryUnZigZag(raw);
+    return true;
+  }
+
+  /**
+   * @brief read a length prefixed string, not terminated
+   */
+  bool string(const char*& value, uint8_t& length)
+  {
+    if (!byte(length) || position_ + length > length_) {
+      return false;
+    }
+    value = (const char*)buffer_ + position_;
+    position_ += length;
+    return true;
+  }
+
+  size_t remaining() const { return length_ - position_; }
+
+private:
+  const uint8_t* buffer_;
+  size_t length_;
+  size_t position_ = 0;
+};
+
+/**
+ * @brief COBS decode a frame and check its CRC
+ *
+ * @return payload length without the CRC, 0 if the frame is damaged
+ */
+inline size_t telemetryDecodeFrame(const uint8_t* frame, size_t length, uint8_t* payload, size_t size)
+{
+  const size_t decoded = telemetryCobsDecode(frame, length, payload, size);
+  if (decoded < 3) {
+    return 0;
+  }
+  const uint16_t crc = (uint16_t)(payload[decoded - 2] | (payload[decoded - 1] << 8));
+  return telemetryCrc16(payload, decoded - 2) == crc ? decoded - 2 : 0;
+}
+
+
+/*
+===============================================================================================
+                                    Channel
+===============================================================================================
+*/
+
+/**
+ * @brief one stream of samples with a fixed set of named fields
+ * sample from one task only, the sequence number and schema countdown are not shared
+ */
+class TelemetryChannel
+{
+public:
+  /**
+   * @param id channel ID, unique per device
+   * @param name channel name, becomes the decoder's file name
+   * @param fields one name per value in every sample
+   * @param fieldCount up to TELEMETRY_MAX_FIELDS
+   */
+  TelemetryChannel(uint8_t id, const char* name, const char* const* fields, uint8_t fieldCount)
+    : id_(id), name_(name), fields_(fields), fieldCount_(fieldCount > TELEMETRY_MAX_FIELDS ? TELEMETRY_MAX_FIELDS : fieldCount) {}
+
+  /**
+   * @brief frame one sample, preceded by the schema frame when one is due
+   *
+   * @param frames receives the frames, TELEMETRY_MAX_FRAME * 2 bytes always fits both
+   * @param values fieldCount values
+   * @return bytes written, 0 if they did not fit
+   */
+  size_t encode(uint8_t* frames, size_t size, uint32_t timestampUs, const int32_t* values)
+  {
+    size_t used = 0;
+    if (samplesSinceSchema_ == 0) {
+      used = encodeSchema(frames, size);
+      if (used == 0) {
+        return 0;
+      }
+    }
+
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    TelemetryWriter writer(payload, sizeof(payload));
+    writer.byte(TELEMETRY_KIND_SAMPLE);
+    writer.varint(id_);
+    writer.byte(sequence_);
+    writer.varint(timestampUs);
+    for (uint8_t i = 0; i < fieldCount_; i++) {
+      writer.signedVarint(values[i]);
+    }
+    const size_t length = writer.finish(frames + used, size - used);
+    if (length == 0) {
+      return 0;
+    }
+
+    sequence_++;
+    samplesSinceSchema_ = (samplesSinceSchema_ + 1) % TELEMETRY_SCHEMA_INTERVAL;
+    return used + length;
+  }
+
+  /**
+   * @brief frame the channel's schema
+   */
+  size_t encodeSchema(uint8_t* frame, size_t size) const
+  {
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    TelemetryWriter writer(payload, sizeof(payload));
+    writer.byte(TELEMETRY_KIND_SCHEMA);
+    writer.varint(id_);
+    writer.byte(fieldCount_);
+    writer.string(name_);
+    for (uint8_t i = 0; i < fieldCount_; i++) {
+      writer.string(fields_[i]);
+    }
+    return writer.finish(frame, size);
+  }
+
+#ifdef ARDUINO
+  /**
+   * @brief frame a sample and write it in one call, so it is never split by other output
+   * a leading zero ends any text written since the last frame, so the frame decodes cleanly
+   */
+  void write(Print& out, uint32_t timestampUs, const int32_t* values)
+  {
+    uint8_t frames[TELEMETRY_MAX_FRAME * 2 + 1];
+    frames[0] = 0;
+    const size_t length = encode(frames + 1, sizeof(frames) - 1, timestampUs, values);
+    if (length > 0) {
+      out.write(frames, length + 1);
+    }
+  }
+#endif
+
+  uint8_t id() const { return id_; }
+  uint8_t fieldCount() const { return fieldCount_; }
+
+private:
+  uint8_t id_;
+  const char* name_;
+  const char* const* fields_;
+  uint8_t fieldCount_;
+  uint8_t sequence_ = 0;
+  uint32_t samplesSinceSchema_ = 0;
+};
@@ -0,0 +1,170 @@
+/**
+ * @file event_counters.h
+ * @brief lock-free per-source event counters
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * each source (an ISR, a timer callback, a task) bumps its own counter with a relaxed atomic
+ * add, so sources never wait on each other or on a shared spinlock. every counter sits on
+ * its own cache line so two cores counting different sources do not bounce a line between
+ * them. readers take a snapshot: all counters are read twice and the copy is only reported
+ * as consistent if nothing moved in between, i.e. it matches one real moment in time.
+ *
+ * tools/event_counters_bench compares them with counters behind one shared spinlock.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#define EVENT_COUNTER_IRAM                IRAM_ATTR
+#else
+#define EVENT_COUNTER_IRAM
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#ifndef EVENT_COUNTER_CACHE_LINE_SIZE
+#define EVENT_COUNTER_CACHE_LINE_SIZE     64          // in bytes
+#endif
+
+#define EVENT_COUNTER_SNAPSHOT_ATTEMPTS   4
+
+
+/**
+ * @brief copy of every counter at one point in time
+ */
+template <size_t Sources>
+struct EventCounterSnapshot
+{
+  uint32_t counts[Sources] = {};
+
+  /**
+   * @brief events per source between an older snapshot and this one, wrap safe
+   */
+  EventCounterSnapshot since(const EventCounterSnapshot& older) const
+  {
+    EventCounterSnapshot delta;
+    for (size_t i = 0; i < Sources; i++) {
+      delta.counts[i] = counts[i] - older.counts[i];
+    }
+    return delta;
+  }
+
+  uint32_t total() const
+  {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < Sources; i++) {
+      sum += counts[i];
+    }
+    return sum;
+  }
+};
+
+
+/*
+===============================================================================================
+                                    Event Counters
+===============================================================================================
+*/
+
+/**
+ * @brief one 32 bit counter per source, safe from any task, core or ISR
+ *
+ * @tparam Sources number of counters
+ */
+template <size_t Sources>
+class EventCounters
+{
+public:
+  /**
+   * @brief count one event (or several) for a source, never blocks
+   */
+  EVENT_COUNTER_IRAM void increment(size_t source, uint32_t count = 1)
+  {
+    counters_[source].value.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief current value of one counter
+   */
+  uint32_t read(size_t source) const
+  {
+    return counters_[source].value.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief copy every counter
+   *
+   * @param snapshot receives the counters
+   * @param attempts how many times to retry while counters are moving
+   * @return true if the copy is consistent, false if events kept arriving and the copy
+   *         may mix counters from slightly different moments (each counter is still exact)
+   */
+  bool snapshot(EventCounterSnapshot<Sources>& snapshot, int attempts = EVENT_COUNTER_SNAPSHOT_ATTEMPTS) const
+  {
+    copy(snapshot);
+    for (int i = 0; i < attempts; i++) {
+      EventCounterSnapshot<Sources> again;
+      copy(again);
+      if (same(snapshot, again)) {
+        return true;
+      }
+      snapshot = again;
+    }
+    return false;
+  }
+
+  /**
+   * @brief zero every counter, events counted during the reset may be lost
+   */
+  void reset()
+  {
+    for (size_t i = 0; i < Sources; i++) {
+      counters_[i].value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static size_t size() { return Sources; }
+
+private:
+  struct alignas(EVENT_COUNTER_CACHE_LINE_SIZE) Counter
+  {
+    std::atomic<uint32_t> value{0};
+  };
+
+  // sequentially consistent loads so two equal passes really bracket one moment, only readers pay for it
+  void copy(EventCounterSnapshot<Sources>& snapshot) const
+  {
+    for (size_t i = 0; i < Sources; i++) {
+      snapshot.counts[i] = counters_[i].value.load();
+    }
+  }
+
+  static bool same(const EventCounterSnapshot<Sources>& a, const EventCounterSnapshot<Sources>& b)
+  {
+    for (size_t i = 0; i < Sources; i++) {
+      if (a.counts[i] != b.counts[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Counter counters_[Sources];
+};
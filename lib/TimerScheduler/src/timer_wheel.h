@@ -0,0 +1,408 @@
+/**
+ * @file timer_wheel.h
+ * @brief hierarchical timer wheel, many software timers on one hardware timer
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * tick() is called once per tick (1 ms in the examples) from a single hardware timer ISR.
+ * the wheel has TIMER_WHEEL_LEVELS levels of 64 slots: level 0 holds timers due in the next
+ * 64 ticks, level 1 the next 4096 and so on. when the low level wraps, the matching slot of
+ * the level above is cascaded down, so each timer moves at most once per level.
+ *
+ * timers live in a fixed pool and are linked into their slot through indices stored in the
+ * timer itself, so start() and cancel() are O(1) and nothing allocates. a callback runs
+ * either in the ISR (keep it tiny) or is queued and run later by runDeferred() from a task.
+ */
+
+#pragma once
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#define TIMER_WHEEL_IRAM                  IRAM_ATTR
+#define TIMER_WHEEL_LOCK(lock)            portENTER_CRITICAL_SAFE(lock)
+#define TIMER_WHEEL_UNLOCK(lock)          portEXIT_CRITICAL_SAFE(lock)
+#else
+#define TIMER_WHEEL_IRAM
+#define TIMER_WHEEL_LOCK(lock)            (void)(lock)
+#define TIMER_WHEEL_UNLOCK(lock)          (void)(lock)
+#endif
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define TIMER_WHEEL_LEVELS                4
+#define TIMER_WHEEL_SLOT_BITS             6
+#define TIMER_WHEEL_SLOTS                 (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK             (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELAY             ((1ul << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)    // ~4.6 hours at 1 ms
+#define TIMER_WHEEL_NONE                  0xFFFF      // end of a slot list
+#define TIMER_WHEEL_INVALID_ID            0
+
+
+/**
+ * @brief identifies a started timer, stays invalid after the timer is cancelled or reused
+ */
+typedef uint32_t TimerId;
+
+/**
+ * @brief what a timer runs when it expires
+ */
+typedef void (*TimerCallback)(void* context);
+
+/**
+ * @brief where a timer callback runs
+ */
+enum TimerMode : uint8_t
+{
+  TIMER_RUN_IN_ISR,               // straight from tick(), must be short and ISR safe
+  TIMER_RUN_DEFERRED,             // queued by tick(), run by runDeferred() in a task
+};
+
+/**
+ * @brief counters, plain 32 bit words so other tasks may read them
+ */
+struct TimerWheelStats
+{
+  uint32_t ticks = 0;
+  uint32_t expired = 0;           // callbacks run in the ISR or queued
+  uint32_t deferredRun = 0;       // deferred callbacks run by runDeferred()
+  uint32_t deferredDropped = 0;   // expiries lost because the deferred queue was full
+  uint32_t overruns = 0;          // periods skipped because a timer was started in the past
+  uint32_t cascades = 0;          // timers moved down a level
+  uint32_t poolExhausted = 0;     // start() calls that found no free timer
+};
+
+
+/*
+===============================================================================================
+                                    Timer Wheel
+===============================================================================================
+*/
+
+/**
+ * @brief timer wheel with a fixed pool of timers
+ *
+ * @tparam PoolSize most timers that can run at once, also the depth of the deferred queue
+ */
+template <size_t PoolSize>
+class TimerWheel
+{
+  static_assert(PoolSize > 0 && PoolSize < TIMER_WHEEL_NONE, "pool is indexed with 16 bits");
+
+public:
+  TimerWheel()
+  {
+    for (int i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++) {
+      slots_[i] = TIMER_WHEEL_NONE;
+    }
+    for (size_t i = 0; i < PoolSize; i++) {
+      timers_[i].next = i + 1 < PoolSize ? (uint16_t)(i + 1) : TIMER_WHEEL_NONE;
+      timers_[i].generation = 1;
+      timers_[i].active = false;
+    }
+    free_ = 0;
+  }
+
+  /**
+   * @brief start a one shot or periodic timer, safe from tasks and ISRs
+   *
+   * @param delayTicks ticks until the first expiry, at least 1
+   * @param periodTicks ticks between later expiries, 0 for a one shot timer
+   * @param callback what to run
+   * @param context passed through to callback
+   * @param mode run the callback in the ISR or in runDeferred()
+   * @return id for cancel(), TIMER_WHEEL_INVALID_ID if the pool is empty
+   */
+  TimerId start(uint32_t delayTicks, uint32_t periodTicks, TimerCallback callback, void* context, TimerMode mode)
+  {
+    TIMER_WHEEL_LOCK(&lock_);
+    if (free_ == TIMER_WHEEL_NONE) {
+      stats_.poolExhausted++;
+      TIMER_WHEEL_UNLOCK(&lock_);
+      return TIMER_WHEEL_INVALID_ID;
+    }
+
+    const uint16_t index = free_;
+    Timer& timer = timers_[index];
+    free_ = timer.next;
+
+    timer.expires = now_ + clampDelay(delayTicks);
+    timer.period = periodTicks;
+    timer.callback = callback;
+    timer.context = context;
+    timer.mode = mode;
+    timer.active = true;
+    insert(index);
+
+    const TimerId id = makeId(index, timer.generation);
+    TIMER_WHEEL_UNLOCK(&lock_);
+    return id;
+  }
+
+  /**
+   * @brief stop a timer, safe from tasks and ISRs
+   * a deferred callback that was already queued still runs once
+   *
+   * @return false if the timer already expired (one shot) or was cancelled
+   */
+  bool cancel(TimerId id)
+  {
+    const uint16_t index = (uint16_t)(id & 0xFFFF);
+    if (index >= PoolSize) {
+      return false;
+    }
+
+    TIMER_WHEEL_LOCK(&lock_);
+    Timer& timer = timers_[index];
+    const bool valid = timer.active && timer.generation == (uint16_t)(id >> 16);
+    if (valid) {
+      unlink(index);
+      release(index);
+    }
+    TIMER_WHEEL_UNLOCK(&lock_);
+    return valid;
+  }
+
+  /**
+   * @brief advance the wheel one tick and expire due timers, call from the timer ISR
+   *
+   * @return number of callbacks queued for runDeferred(), notify the deferred task if non zero
+   */
+  TIMER_WHEEL_IRAM uint32_t tick()
+  {
+    uint32_t queued = 0;
+
+    TIMER_WHEEL_LOCK(&lock_);
+    now_++;
+    stats_.ticks++;
+
+    // pull timers down from the upper levels, top first so nothing is cascaded twice
+    for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+      if ((now_ & ((1ul << (level * TIMER_WHEEL_SLOT_BITS)) - 1)) == 0) {
+        cascade(level, (now_ >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK);
+      }
+    }
+
+    // everything in the current slot is due now. timers are taken off the live list one at a
+    // time because an ISR callback runs unlocked and may cancel the others. re-armed and newly
+    // started timers are always at least one tick out, so they never land in this slot
+    const uint16_t current = now_ & TIMER_WHEEL_SLOT_MASK;
+    uint16_t index;
+    while ((index = slots_[current]) != TIMER_WHEEL_NONE) {
+      unlink(index);
+      Timer& timer = timers_[index];
+      const TimerCallback callback = timer.callback;
+      void* const context = timer.context;
+      const TimerMode mode = timer.mode;
+      stats_.expired++;
+
+      // re-arm periodic timers on their original phase so they never drift
+      if (timer.period != 0) {
+        timer.expires += timer.period;
+        if ((int32_t)(timer.expires - now_) <= 0) {
+          const uint32_t behind = (now_ - timer.expires) / timer.period + 1;
+          stats_.overruns += behind;
+          timer.expires += behind * timer.period;
+        }
+        insert(index);
+      }
+      else {
+        release(index);
+      }
+
+      if (mode == TIMER_RUN_DEFERRED) {
+        queued += enqueue(callback, context) ? 1 : 0;
+      }
+      else {
+        // the lock is dropped so the callback may start or cancel timers
+        TIMER_WHEEL_UNLOCK(&lock_);
+        callback(context);
+        TIMER_WHEEL_LOCK(&lock_);
+      }
+    }
+    TIMER_WHEEL_UNLOCK(&lock_);
+
+    return queued;
+  }
+
+  /**
+   * @brief run the deferred callbacks queued by tick(), call from one task
+   *
+   * @return number of callbacks run
+   */
+  uint32_t runDeferred()
+  {
+    uint32_t count = 0;
+    for (;;) {
+      TIMER_WHEEL_LOCK(&lock_);
+      if (queueHead_ == queueTail_) {
+        TIMER_WHEEL_UNLOCK(&lock_);
+        break;
+      }
+      const Deferred item = queue_[queueTail_];
+      queueTail_ = (queueTail_ + 1) % (PoolSize + 1);
+      stats_.deferredRun++;
+      TIMER_WHEEL_UNLOCK(&lock_);
+
+      item.callback(item.context);
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * @brief ticks since the wheel was created
+   */
+  uint32_t now() const { return now_; }
+
+  const TimerWheelStats& stats() const { return stats_; }
+
+private:
+  struct Timer
+  {
+    uint32_t expires;             // absolute tick
+    uint32_t period;              // 0 for one shot
+    TimerCallback callback;
+    void* context;
+    uint16_t next;                // slot list, or free list while unused
+    uint16_t prev;
+    uint16_t slot;                // index into slots_ while linked
+    uint16_t generation;          // bumped on release so stale ids never match
+    TimerMode mode;
+    bool active;
+  };
+
+  struct Deferred
+  {
+    TimerCallback callback;
+    void* context;
+  };
+
+  static uint32_t clampDelay(uint32_t delayTicks)
+  {
+    if (delayTicks == 0) {
+      return 1;
+    }
+    return delayTicks > TIMER_WHEEL_MAX_DELAY ? TIMER_WHEEL_MAX_DELAY : delayTicks;
+  }
+
+  static TimerId makeId(uint16_t index, uint16_t generation)
+  {
+    return ((uint32_t)generation << 16) | index;
+  }
+
+  /**
+   * @brief link a timer into the slot for its expiry, relative to now
+   */
+  TIMER_WHEEL_IRAM void insert(uint16_t index)
+  {
+    Timer& timer = timers_[index];
+    uint32_t delta = timer.expires - now_;
+    if (delta > TIMER_WHEEL_MAX_DELAY) {
+      // further out than the wheel reaches, park it in the top level and let it cascade again
+      delta = TIMER_WHEEL_MAX_DELAY;
+      timer.expires = now_ + delta;
+    }
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ul << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) {
+      level++;
+    }
+    const uint16_t slot = (uint16_t)(level * TIMER_WHEEL_SLOTS + ((timer.expires >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK));
+
+    timer.slot = slot;
+    timer.prev = TIMER_WHEEL_NONE;
+    timer.next = slots_[slot];
+    if (timer.next != TIMER_WHEEL_NONE) {
+      timers_[timer.next].prev = index;
+    }
+    slots_[slot] = index;
+  }
+
+  /**
+   * @brief take a timer out of its slot
+   */
+  TIMER_WHEEL_IRAM void unlink(uint16_t index)
+  {
+    Timer& timer = timers_[index];
+    if (timer.prev != TIMER_WHEEL_NONE) {
+      timers_[timer.prev].next = timer.next;
+    }
+    else {
+      slots_[timer.slot] = timer.next;
+    }
+    if (timer.next != TIMER_WHEEL_NONE) {
+      timers_[timer.next].prev = timer.prev;
+    }
+  }
+
+  /**
+   * @brief return a timer that is not linked into any slot to the free list
+   */
+  TIMER_WHEEL_IRAM void release(uint16_t index)
+  {
+    Timer& timer = timers_[index];
+    timer.active = false;
+    timer.generation = timer.generation == 0xFFFF ? 1 : timer.generation + 1;
+    timer.next = free_;
+    free_ = index;
+  }
+
+  /**
+   * @brief re-insert every timer of an upper level slot, they land on lower levels
+   */
+  TIMER_WHEEL_IRAM void cascade(int level, uint32_t slot)
+  {
+    uint16_t index = slots_[level * TIMER_WHEEL_SLOTS + slot];
+    slots_[level * TIMER_WHEEL_SLOTS + slot] = TIMER_WHEEL_NONE;
+
+    while (index != TIMER_WHEEL_NONE) {
+      const uint16_t next = timers_[index].next;
+      insert(index);
+      stats_.cascades++;
+      index = next;
+    }
+  }
+
+  TIMER_WHEEL_IRAM bool enqueue(TimerCallback callback, void* context)
+  {
+    const size_t head = (queueHead_ + 1) % (PoolSize + 1);
+    if (head == queueTail_) {
+      stats_.deferredDropped++;
+      return false;
+    }
+    queue_[queueHead_].callback = callback;
+    queue_[queueHead_].context = context;
+    queueHead_ = head;
+    return true;
+  }
+
+  Timer timers_[PoolSize];
+  uint16_t slots_[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+  uint16_t free_;
+  volatile uint32_t now_ = 0;
+
+  Deferred queue_[PoolSize + 1];            // one spare slot tells full from empty
+  size_t queueHead_ = 0;
+  size_t queueTail_ = 0;
+
+  TimerWheelStats stats_;
+#ifdef ESP_PLATFORM
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+  int lock_ = 0;
+#endif
+};
@@ -0,0 +1,268 @@
+/**
+ * @file adc_filter_bench.cpp
+ * @brief runs adc_filter.h's CIC / FIR / window pipeline over recorded ADC samples and times it
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the sample file is text, one line per round of conversions and one column per channel (raw
+ * 12 bit counts, separated by commas, tabs or spaces), lines starting with # are skipped. each
+ * column goes through its own AdcChannelFilter exactly as AdcStream runs it on the device, and
+ * the last window and the range of every channel's filtered output are printed.
+ *
+ * the benchmark then runs the whole file through fresh filters until at least
+ * BENCH_MIN_SECONDS have passed and reports conversions per second and nanoseconds per
+ * conversion on this machine, plus the share of one core the given sample rate would take
+ * here. the device's own figure is AdcStream::stats().load().
+ *
+ * build:   g++ -std=c++11 -O2 -I../../lib/AdcStream/src adc_filter_bench.cpp -o adc_filter_bench
+ * usage:   adc_filter_bench [--rate <conversions/s per channel>] [--window <outputs>] [--csv <output file>] <sample file>
+ *          adc_filter_bench [--rate ...] --synthetic <seconds> [--record <sample file>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "adc_filter.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_MIN_SECONDS                 0.5
+#define BENCH_DEFAULT_RATE                10000       // per channel, AdcStream's 20 kHz over two channels
+#define BENCH_MAX_CHANNELS                8
+#define SYNTHETIC_CHANNELS                2
+
+
+/*
+===============================================================================================
+                                    Samples
+===============================================================================================
+*/
+
+/**
+ * @brief one vector per channel, all the same length
+ */
+typedef std::vector<std::vector<uint16_t>> Recording;
+
+/**
+ * @brief read a sample file, the first data line sets the channel count
+ * @return false if the file cannot be read or has no data
+ */
+bool readRecording(const char* path, Recording& recording)
+{
+  FILE* input = fopen(path, "r");
+  if (input == NULL) {
+    perror(path);
+    return false;
+  }
+
+  char line[512];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), input) != NULL) {
+    lineNumber++;
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+      continue;
+    }
+
+    uint16_t values[BENCH_MAX_CHANNELS];
+    size_t count = 0;
+    for (char* token = strtok(line, ", \t\r\n"); token != NULL && count < BENCH_MAX_CHANNELS; token = strtok(NULL, ", \t\r\n")) {
+      const long value = strtol(token, NULL, 10);
+      values[count++] = (uint16_t)(value < 0 ? 0 : (value > 4095 ? 4095 : value));
+    }
+    if (recording.empty()) {
+      recording.resize(count);
+    }
+    if (count != recording.size()) {
+      fprintf(stderr, "%s:%d: %zu columns, expected %zu, line skipped\n", path, lineNumber, count, recording.size());
+      continue;
+    }
+    for (size_t channel = 0; channel < count; channel++) {
+      recording[channel].push_back(values[channel]);
+    }
+  }
+  fclose(input);
+  return !recording.empty() && !recording[0].empty();
+}
+
+
+/**
+ * @brief pedal-like test signal: a slow sweep, 50 Hz hum, white noise and the odd spike
+ */
+void synthesize(Recording& recording, double seconds, uint32_t rate)
+{
+  const size_t length = (size_t)(seconds * rate);
+  uint32_t random = 12345;
+  recording.assign(SYNTHETIC_CHANNELS, std::vector<uint16_t>(length));
+  for (size_t channel = 0; channel < SYNTHETIC_CHANNELS; channel++) {
+    for (size_t i = 0; i < length; i++) {
+      const double t = (double)i / rate;
+      random = random * 1664525u + 1013904223u;
+      const double noise = ((random >> 16) & 0xFF) / 255.0 * 40 - 20;
+      const double spike = (random >> 8) % 5000 == 0 ? 800 : 0;
+      const double value = 2048 + 1500 * sin(2 * M_PI * (0.5 + channel) * t) + 30 * sin(2 * M_PI * 50 * t) + noise + spike;
+      recording[channel][i] = (uint16_t)(value < 0 ? 0 : (value > 4095 ? 4095 : value));
+    }
+  }
+}
+
+
+bool writeRecording(const char* path, const Recording& recording)
+{
+  FILE* output = fopen(path, "w");
+  if (output == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(output, "# %zu channels, raw 12 bit conversions\n", recording.size());
+  for (size_t i = 0; i < recording[0].size(); i++) {
+    for (size_t channel = 0; channel < recording.size(); channel++) {
+      fprintf(output, channel == 0 ? "%u" : ",%u", recording[channel][i]);
+    }
+    fputc('\n', output);
+  }
+  fclose(output);
+  return true;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  uint32_t rate = BENCH_DEFAULT_RATE;
+  uint16_t windowOutputs = 64;
+  double syntheticSeconds = 0;
+  const char* csvPath = NULL;
+  const char* recordPath = NULL;
+  const char* samplePath = NULL;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--rate") == 0 && arg + 1 < argc) {
+      rate = (uint32_t)atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--window") == 0 && arg + 1 < argc) {
+      windowOutputs = (uint16_t)atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--csv") == 0 && arg + 1 < argc) {
+      csvPath = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "--synthetic") == 0 && arg + 1 < argc) {
+      syntheticSeconds = atof(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--record") == 0 && arg + 1 < argc) {
+      recordPath = argv[++arg];
+    }
+    else if (argv[arg][0] != '-' && samplePath == NULL) {
+      samplePath = argv[arg];
+    }
+    else {
+      samplePath = NULL;
+      syntheticSeconds = 0;
+      break;
+    }
+  }
+  if ((samplePath == NULL) == (syntheticSeconds <= 0) || rate == 0) {
+    fprintf(stderr, "usage: %s [--rate <conversions/s per channel>] [--window <outputs>] [--csv <output file>] <sample file>\n"
+      "       %s [--rate ...] --synthetic <seconds> [--record <sample file>]\n", argv[0], argv[0]);
+    return 1;
+  }
+
+  Recording recording;
+  if (samplePath != NULL) {
+    if (!readRecording(samplePath, recording)) {
+      fprintf(stderr, "%s: no samples\n", samplePath);
+      return 1;
+    }
+  }
+  else {
+    synthesize(recording, syntheticSeconds, rate);
+    if (recordPath != NULL && !writeRecording(recordPath, recording)) {
+      return 1;
+    }
+  }
+  const size_t channels = recording.size();
+  const size_t length = recording[0].size();
+  printf("%zu channels x %zu conversions, %.2f s at %u/s per channel, output every %d conversions (%.1f Hz)\n",
+    channels, length, (double)length / rate, rate, ADC_FILTER_DECIMATION, (double)rate / ADC_FILTER_DECIMATION);
+
+  // one pass for the results
+  FILE* csv = csvPath != NULL ? fopen(csvPath, "w") : NULL;
+  if (csvPath != NULL && csv == NULL) {
+    perror(csvPath);
+    return 1;
+  }
+  if (csv != NULL) {
+    fprintf(csv, "channel,output,counts\n");
+  }
+  for (size_t channel = 0; channel < channels; channel++) {
+    AdcChannelFilter filter(windowOutputs);
+    uint16_t lowest = UINT16_MAX;
+    uint16_t highest = 0;
+    uint32_t outputs = 0;
+    for (size_t i = 0; i < length; i++) {
+      filter.push(recording[channel][i], (int64_t)i * 1000000 / rate);
+      const AdcChannelSnapshot& snapshot = filter.snapshot();
+      if (snapshot.outputs == outputs) {
+        continue;
+      }
+      outputs = snapshot.outputs;
+      if (!filter.settled()) {
+        continue;
+      }
+      lowest = snapshot.value < lowest ? snapshot.value : lowest;
+      highest = snapshot.value > highest ? snapshot.value : highest;
+      if (csv != NULL) {
+        fprintf(csv, "%zu,%u,%.4f\n", channel, outputs, snapshot.value / (double)(1 << ADC_FILTER_FRACTION_BITS));
+      }
+    }
+
+    const AdcChannelSnapshot& snapshot = filter.snapshot();
+    printf("channel %zu: %u outputs, %u windows | output range %u - %u | last window min %u mean %u max %u (counts)\n",
+      channel, snapshot.outputs, snapshot.windows, AdcChannelFilter::counts(lowest), AdcChannelFilter::counts(highest),
+      AdcChannelFilter::counts(snapshot.min), AdcChannelFilter::counts(snapshot.mean), AdcChannelFilter::counts(snapshot.max));
+  }
+  if (csv != NULL) {
+    fclose(csv);
+  }
+
+  // the benchmark, round robin over the channels like the DMA frames
+  uint64_t conversions = 0;
+  uint32_t checksum = 0;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+  while (elapsed < BENCH_MIN_SECONDS) {
+    std::vector<AdcChannelFilter> filters(channels, AdcChannelFilter(windowOutputs));
+    for (size_t i = 0; i < length; i++) {
+      for (size_t channel = 0; channel < channels; channel++) {
+        checksum += filters[channel].push(recording[channel][i], 0);
+      }
+    }
+    conversions += (uint64_t)length * channels;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  const double nsPerConversion = elapsed * 1e9 / conversions;
+  printf("benchmark: %.1f M conversions/s, %.2f ns per conversion (%u windows)\n", conversions / elapsed / 1e6, nsPerConversion, checksum);
+  printf("load at %u conversions/s on this machine: %.3f%% of a core\n", (uint32_t)(rate * channels),
+    rate * channels * nsPerConversion / 1e9 * 100);
+  return 0;
+}
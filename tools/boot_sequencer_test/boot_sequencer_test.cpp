@@ -0,0 +1,309 @@
+/**
+ * @file boot_sequencer_test.cpp
+ * @brief BootSequencer's threaded path on the host: dependency order, skip cascade and
+ * BOOT_ON_CALLER placement over many randomized boots
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the native envs build boot_sequencer.h without ESP_PLATFORM, where run() takes the stages one
+ * by one on the calling thread. this builds it with ESP_PLATFORM against the FreeRTOS stand-in
+ * next to it (freertos/, esp_timer.h), so helpers are real threads and stages overlap like
+ * they do on the two cores. every boot runs CAN-Test's stage graph with random stage lengths,
+ * now and then one failing stage, and now and then helper tasks that cannot be created.
+ *
+ * every boot checks that:
+ *   - a stage started only after each stage it depends on had ended
+ *   - a failed stage's dependents, and theirs, were skipped without running, everything else ran once
+ *   - run() returned false exactly when a stage failed
+ *   - BOOT_ON_CALLER stages ran on the thread that called run(), as worker 0
+ *   - no more than BOOT_WORKERS stages ran at once, and every helper task deleted itself
+ * and over all boots that stages did run side by side. the exit code is 1 if any check failed.
+ *
+ * build:   g++ -std=gnu++17 -O2 -pthread -DESP_PLATFORM -I. -I../../lib/BootSequencer/src boot_sequencer_test.cpp -o boot_sequencer_test
+ * usage:   boot_sequencer_test [--boots <count>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "boot_sequencer.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define TEST_DEFAULT_BOOTS                300
+#define TEST_STAGE_MAX_US                 2000        // longest random stage
+#define TEST_FAIL_EVERY                   4           // about one boot in this many has a failing stage
+#define TEST_REFUSE_EVERY                 8           // about one boot in this many cannot create helpers
+#define TEST_HELPER_EXIT_MS               1000        // time for helpers to delete themselves after run()
+
+/**
+ * @brief one stage of the graph, as CAN-Test adds them
+ */
+struct TestStage
+{
+  const char* name;
+  uint32_t dependsOn;                 // BOOT_AFTER() of stages earlier in the table
+  bool onCaller;
+};
+
+enum
+{
+  STAGE_SERIAL = 0,
+  STAGE_CAN_DRIVER,
+  STAGE_TX_SCHEDULE,
+  STAGE_GPIO,
+  STAGE_WIFI,
+  STAGE_CAN_TASKS,
+  STAGE_CAN_TIMER,
+  STAGE_MESH,
+  STAGE_COUNT,
+};
+
+static const TestStage testStages[STAGE_COUNT] = {
+  { "serial", 0, BOOT_ON_CALLER },
+  { "can driver", 0, BOOT_ON_CALLER },
+  { "tx schedule", 0, false },
+  { "gpio", 0, false },
+  { "wifi", BOOT_AFTER(STAGE_SERIAL), false },
+  { "can tasks", BOOT_AFTER(STAGE_CAN_DRIVER) | BOOT_AFTER(STAGE_TX_SCHEDULE), false },
+  { "can timer", BOOT_AFTER(STAGE_CAN_TASKS) | BOOT_AFTER(STAGE_GPIO), BOOT_ON_CALLER },
+  { "mesh", BOOT_AFTER(STAGE_WIFI), false },
+};
+
+/**
+ * @brief what one stage saw when it ran, the context of its stage function
+ */
+struct StageProbe
+{
+  uint32_t lengthUs = 0;
+  bool fails = false;
+  int calls = 0;
+  bool onCallerThread = false;
+  uint32_t startOrder = 0;            // from one counter shared by every start and end
+  uint32_t endOrder = 0;
+};
+
+static std::thread::id callerThread;
+static std::atomic<uint32_t> order(0);
+static std::atomic<int> running(0);
+static std::atomic<int> mostRunning(0);
+
+static uint32_t randomState = 1;
+
+static uint32_t nextRandom()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+static bool runStage(void* context)
+{
+  StageProbe* probe = (StageProbe*)context;
+  probe->calls++;
+  probe->onCallerThread = std::this_thread::get_id() == callerThread;
+  probe->startOrder = order++;
+  const int now = ++running;
+  int most = mostRunning.load();
+  while (now > most && !mostRunning.compare_exchange_weak(most, now)) {
+  }
+
+  std::this_thread::sleep_for(std::chrono::microseconds(probe->lengthUs));
+
+  running--;
+  probe->endOrder = order++;
+  return !probe->fails;
+}
+
+
+/*
+===============================================================================================
+                                    Checks
+===============================================================================================
+*/
+
+/**
+ * @brief the state a stage has to end in when the stage failing fails, -1 for none
+ */
+static BootStageState expectedState(int index, int failing)
+{
+  if (index == failing) {
+    return BOOT_STAGE_FAILED;
+  }
+  for (int j = 0; j < index; j++) {
+    if ((testStages[index].dependsOn & BOOT_AFTER(j)) && expectedState(j, failing) != BOOT_STAGE_DONE) {
+      return BOOT_STAGE_SKIPPED;
+    }
+  }
+  return BOOT_STAGE_DONE;
+}
+
+/**
+ * @brief check one finished boot, print what is wrong
+ * @return the number of problems
+ */
+static int checkBoot(int boot, const BootSequencer& sequencer, const StageProbe* probes, int failing, bool result)
+{
+  int problems = 0;
+  if (result != (failing < 0)) {
+    printf("  boot %d: run() returned %s with %s\n", boot, result ? "true" : "false", failing < 0 ? "no failing stage" : "a failing stage");
+    problems++;
+  }
+
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    const BootStage& stage = sequencer.stage(i);
+    const StageProbe& probe = probes[i];
+    const BootStageState expected = expectedState(i, failing);
+    if (stage.state != expected || probe.calls != (expected == BOOT_STAGE_SKIPPED ? 0 : 1)) {
+      printf("  boot %d: %s is %s after %d calls, should be %s\n", boot, stage.name, bootStageStateName(stage.state), probe.calls,
+        bootStageStateName(expected));
+      problems++;
+    }
+    if (probe.calls == 0) {
+      continue;
+    }
+
+    for (int j = 0; j < i; j++) {
+      if ((stage.dependsOn & BOOT_AFTER(j)) && (probes[j].calls != 1 || probes[j].endOrder > probe.startOrder)) {
+        printf("  boot %d: %s started before %s had ended\n", boot, stage.name, sequencer.stage(j).name);
+        problems++;
+      }
+    }
+    if (stage.onCaller && (!probe.onCallerThread || stage.worker != 0)) {
+      printf("  boot %d: %s ran on worker %d, not on the caller\n", boot, stage.name, stage.worker);
+      problems++;
+    }
+    if (stage.startUs > stage.endUs || stage.startUs < sequencer.beginUs() || stage.endUs > sequencer.endUs()) {
+      printf("  boot %d: %s took %lld to %lld us, outside of run()\n", boot, stage.name, (long long)stage.startUs, (long long)stage.endUs);
+      problems++;
+    }
+  }
+  return problems;
+}
+
+/**
+ * @brief wait for every helper task to delete itself
+ * @return false if some are still there after TEST_HELPER_EXIT_MS
+ */
+static bool waitForHelpers()
+{
+  const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TEST_HELPER_EXIT_MS);
+  while (simTasksAlive.load() != 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  int boots = TEST_DEFAULT_BOOTS;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--boots") == 0 && arg + 1 < argc) {
+      boots = atoi(argv[++arg]);
+    }
+    else {
+      boots = 0;
+      break;
+    }
+  }
+  if (boots <= 0) {
+    fprintf(stderr, "usage: %s [--boots <count>]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%d boots of CAN-Test's %d stages, up to %d us each, %d workers\n\n", boots, STAGE_COUNT, TEST_STAGE_MAX_US, BOOT_WORKERS);
+  callerThread = std::this_thread::get_id();
+  int problems = 0;
+  int failedBoots = 0;
+  int refusedBoots = 0;
+  int skipped = 0;
+  int mostWorkers = 0;
+
+  for (int boot = 0; boot < boots; boot++) {
+    StageProbe probes[STAGE_COUNT];
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      probes[i].lengthUs = nextRandom() % (TEST_STAGE_MAX_US + 1);
+    }
+    const int failing = nextRandom() % TEST_FAIL_EVERY == 0 ? (int)(nextRandom() % STAGE_COUNT) : -1;
+    if (failing >= 0) {
+      probes[failing].fails = true;
+      failedBoots++;
+    }
+    if (nextRandom() % TEST_REFUSE_EVERY == 0) {
+      simTaskCreateRefusals = BOOT_WORKERS;
+      refusedBoots++;
+    }
+
+    // helpers may outlive run(), so the sequencer stays until they are gone
+    BootSequencer* sequencer = new BootSequencer();
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      sequencer->add(testStages[i].name, runStage, &probes[i], testStages[i].dependsOn, testStages[i].onCaller);
+    }
+    const bool result = sequencer->run();
+    simTaskCreateRefusals = 0;
+    if (!waitForHelpers()) {
+      printf("  boot %d: %d helper tasks never deleted themselves\n", boot, simTasksAlive.load());
+      return 1;
+    }
+
+    problems += checkBoot(boot, *sequencer, probes, failing, result);
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      skipped += sequencer->stage(i).state == BOOT_STAGE_SKIPPED ? 1 : 0;
+    }
+    mostWorkers = sequencer->workersUsed() > mostWorkers ? sequencer->workersUsed() : mostWorkers;
+
+    if (boot == 0) {
+      printf("%s\n", bootReportHeader());
+      char row[BOOT_ROW_SIZE];
+      for (int i = 0; i < STAGE_COUNT; i++) {
+        formatBootRow(row, sizeof(row), sequencer->stage(i));
+        printf("%s\n", row);
+      }
+      printf("%lld us on %d workers\n\n", (long long)(sequencer->endUs() - sequencer->beginUs()), sequencer->workersUsed());
+    }
+    delete sequencer;
+  }
+
+  printf("%d boots with a failing stage (%d stages skipped), %d without helpers, up to %d stages at once, up to %d workers in one boot\n",
+    failedBoots, skipped, refusedBoots, mostRunning.load(), mostWorkers);
+  if (mostRunning.load() > BOOT_WORKERS) {
+    printf("more than %d stages ran at once\n", BOOT_WORKERS);
+    problems++;
+  }
+  if (mostRunning.load() < 2) {
+    printf("no two stages ever ran at once\n");
+    problems++;
+  }
+
+  if (problems != 0) {
+    printf("%d problems\n", problems);
+  }
+  return problems != 0 ? 1 : 0;
+}
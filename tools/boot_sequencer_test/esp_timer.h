@@ -0,0 +1,20 @@
+/**
+ * @file esp_timer.h
+ * @brief host stand-in for esp_timer_get_time(), boot_sequencer_test only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * microseconds of the steady clock since the first call, safe from every thread. lib/Hal/sim
+ * has the full esp_timer.h on the simulated clock, which only moves when a sim advances it.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+
+inline int64_t esp_timer_get_time()
+{
+  static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
@@ -0,0 +1,35 @@
+/**
+ * @file FreeRTOS.h
+ * @brief host stand-in for the FreeRTOS types and critical sections boot_sequencer.h uses,
+ * boot_sequencer_test only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * tasks are std::threads (see task.h), so a critical section is a std::mutex: it keeps the
+ * other threads out like the portMUX spinlock keeps the other core out.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+#define pdPASS                            1
+#define pdFAIL                            0
+#define portMAX_DELAY                     0xffffffffUL
+#define pdMS_TO_TICKS(ms)                 ((TickType_t)(ms))
+
+struct portMUX_TYPE
+{
+  std::mutex mutex;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED      {}
+#define portENTER_CRITICAL(mux)           (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux)            (mux)->mutex.unlock()
@@ -0,0 +1,51 @@
+/**
+ * @file semphr.h
+ * @brief host stand-in for the FreeRTOS binary semaphore, boot_sequencer_test only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * a flag behind a mutex and a condition variable: give() sets it, take() waits for it and
+ * clears it, gives before a take collapse into one like they do on a binary semaphore.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include "FreeRTOS.h"
+
+struct StaticSemaphore_t
+{
+  std::mutex mutex;
+  std::condition_variable given;
+  bool full = false;
+};
+
+typedef StaticSemaphore_t* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer)
+{
+  return buffer;
+}
+
+/**
+ * @brief portMAX_DELAY is the only timeout boot_sequencer.h uses, so this one waits forever
+ */
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+  (void)ticks;
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  semaphore->given.wait(lock, [semaphore]() { return semaphore->full; });
+  semaphore->full = false;
+  return pdPASS;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    semaphore->full = true;
+  }
+  semaphore->given.notify_one();
+  return pdPASS;
+}
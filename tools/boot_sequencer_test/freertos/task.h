@@ -0,0 +1,59 @@
+/**
+ * @file task.h
+ * @brief host stand-in for FreeRTOS task creation, boot_sequencer_test only
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * xTaskCreate() starts a detached std::thread and vTaskDelete(NULL) marks it gone, the thread
+ * ends when the task function returns right after. simTasksAlive counts the tasks between the
+ * two so a test can wait for every helper to be out, and simTaskCreateRefusals makes that many
+ * next xTaskCreate() calls fail like a heap too small for the stack would.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "FreeRTOS.h"
+
+inline std::atomic<int> simTasksAlive(0);
+inline std::atomic<int> simTaskCreateRefusals(0);
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackSize, void* arg, UBaseType_t priority,
+  TaskHandle_t* handle)
+{
+  (void)name;
+  (void)stackSize;
+  (void)priority;
+  int refusals = simTaskCreateRefusals.load();
+  while (refusals > 0 && !simTaskCreateRefusals.compare_exchange_weak(refusals, refusals - 1)) {
+  }
+  if (refusals > 0) {
+    return pdFAIL;
+  }
+  simTasksAlive++;
+  std::thread thread(function, arg);
+  if (handle != NULL) {
+    *handle = NULL;
+  }
+  thread.detach();
+  return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t task)
+{
+  (void)task;
+  simTasksAlive--;
+}
+
+inline UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+  (void)task;
+  return 1;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
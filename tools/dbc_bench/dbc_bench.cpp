@@ -0,0 +1,230 @@
+/**
+ * @file dbc_bench.cpp
+ * @brief times the generated TEST_STATUS pack / unpack against a generic, table driven bit
+ * extractor
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the generic codec is what a DBC library does at run time: a table of { start, length, byte
+ * order, sign } per signal and a loop that moves one bit at a time, walking the DBC numbering.
+ * the generated code (tools/dbc_codegen) loads the frame as one little and one big endian word
+ * and uses a shift and a mask per signal. both decode and encode the same random frames, the
+ * results are compared first and any difference fails the run, then each is timed over the
+ * whole set until BENCH_MIN_SECONDS have passed and the time per frame is printed.
+ *
+ * build:   g++ -std=c++17 -O2 -I../../CAN-Test/include dbc_bench.cpp -o dbc_bench
+ * usage:   dbc_bench [--frames <count>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "vehicle_dbc.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_MIN_SECONDS                 0.25
+#define BENCH_DEFAULT_FRAMES              4096
+#define BENCH_SIGNALS                     6           // in TEST_STATUS
+
+
+/*
+===============================================================================================
+                                    Generic Codec
+===============================================================================================
+*/
+
+struct GenericSignal
+{
+  uint8_t start;
+  uint8_t length;
+  bool intel;
+  bool isSigned;
+};
+
+// TEST_STATUS as vehicle.dbc lists it
+const GenericSignal testStatusSignals[BENCH_SIGNALS] = {
+  { 0,  8,  true,   false },
+  { 8,  16, true,   false },
+  { 24, 12, true,   true  },
+  { 36, 1,  true,   false },
+  { 47, 16, false,  false },
+  { 63, 8,  false,  true  },
+};
+
+/**
+ * @brief read one signal, most significant bit first
+ */
+int64_t genericRead(const GenericSignal& signal, const uint8_t* data)
+{
+  uint64_t raw = 0;
+  int position = signal.intel ? signal.start + signal.length - 1 : signal.start;
+  for (int i = 0; i < signal.length; i++) {
+    raw = raw << 1 | ((data[position / 8] >> (position % 8)) & 1);
+    if (signal.intel) {
+      position--;
+    }
+    else {
+      position = position % 8 == 0 ? position + 15 : position - 1;
+    }
+  }
+  if (signal.isSigned && (raw >> (signal.length - 1)) & 1) {
+    return (int64_t)raw - ((int64_t)1 << signal.length);
+  }
+  return (int64_t)raw;
+}
+
+void genericWrite(const GenericSignal& signal, int64_t value, uint8_t* data)
+{
+  int position = signal.intel ? signal.start + signal.length - 1 : signal.start;
+  for (int i = 0; i < signal.length; i++) {
+    const uint8_t bit = (uint8_t)(1 << (position % 8));
+    if (((uint64_t)value >> (signal.length - 1 - i)) & 1) {
+      data[position / 8] |= bit;
+    }
+    else {
+      data[position / 8] &= (uint8_t)~bit;
+    }
+    if (signal.intel) {
+      position--;
+    }
+    else {
+      position = position % 8 == 0 ? position + 15 : position - 1;
+    }
+  }
+}
+
+
+/*
+===============================================================================================
+                                    Measurement
+===============================================================================================
+*/
+
+/**
+ * @brief run pass over every frame until BENCH_MIN_SECONDS have passed
+ * @return nanoseconds per frame
+ */
+template <typename Pass>
+double measure(size_t frames, Pass pass)
+{
+  uint64_t done = 0;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+  while (elapsed < BENCH_MIN_SECONDS) {
+    pass();
+    done += frames;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return elapsed * 1e9 / done;
+}
+
+void report(const char* name, double generatedNs, double genericNs)
+{
+  printf("%-8s generated %7.2f ns/frame | generic %7.2f ns/frame | %5.1fx\n", name, generatedNs, genericNs,
+    genericNs / generatedNs);
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  size_t frames = BENCH_DEFAULT_FRAMES;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--frames") == 0 && arg + 1 < argc) {
+      frames = (size_t)strtoul(argv[++arg], NULL, 10);
+    }
+    else {
+      frames = 0;
+      break;
+    }
+  }
+  if (frames == 0) {
+    fprintf(stderr, "usage: %s [--frames <count>]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<uint8_t> data(frames * 8);
+  uint32_t random = 12345;
+  for (size_t i = 0; i < data.size(); i++) {
+    random = random * 1664525u + 1013904223u;
+    data[i] = (uint8_t)(random >> 24);
+  }
+
+  // both codecs agree on every signal of every frame, both ways
+  std::vector<TestStatus> decoded(frames);
+  std::vector<int64_t> values(frames * BENCH_SIGNALS);
+  std::vector<uint8_t> encoded(frames * 8);
+  std::vector<uint8_t> genericEncoded(frames * 8);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < frames; i++) {
+    const TestStatus status = TestStatus::unpack(&data[i * 8]);
+    const int64_t generated[BENCH_SIGNALS] = { status.counter, status.uptime, status.coolantTemp, status.faultActive,
+      status.packVoltage, status.packCurrent };
+    for (int s = 0; s < BENCH_SIGNALS; s++) {
+      mismatches += genericRead(testStatusSignals[s], &data[i * 8]) != generated[s] ? 1 : 0;
+      genericWrite(testStatusSignals[s], generated[s], &genericEncoded[i * 8]);
+    }
+    status.pack(&encoded[i * 8]);
+  }
+  mismatches += memcmp(encoded.data(), genericEncoded.data(), encoded.size()) != 0 ? 1 : 0;
+  if (mismatches != 0) {
+    printf("generated and generic codecs disagree on %zu signals\n", mismatches);
+    return 1;
+  }
+  printf("TEST_STATUS, %d signals (4 Intel, 2 Motorola), %zu random frames, results identical\n", BENCH_SIGNALS, frames);
+
+  const double unpackGenerated = measure(frames, [&]() {
+    for (size_t i = 0; i < frames; i++) {
+      decoded[i] = TestStatus::unpack(&data[i * 8]);
+    }
+  });
+  const double unpackGeneric = measure(frames, [&]() {
+    for (size_t i = 0; i < frames; i++) {
+      for (int s = 0; s < BENCH_SIGNALS; s++) {
+        values[i * BENCH_SIGNALS + s] = genericRead(testStatusSignals[s], &data[i * 8]);
+      }
+    }
+  });
+  const double packGenerated = measure(frames, [&]() {
+    for (size_t i = 0; i < frames; i++) {
+      decoded[i].pack(&encoded[i * 8]);
+    }
+  });
+  const double packGeneric = measure(frames, [&]() {
+    for (size_t i = 0; i < frames; i++) {
+      for (int s = 0; s < BENCH_SIGNALS; s++) {
+        genericWrite(testStatusSignals[s], values[i * BENCH_SIGNALS + s], &genericEncoded[i * 8]);
+      }
+    }
+  });
+
+  // keep the outputs alive so the loops are not optimized away
+  volatile uint8_t sink = (uint8_t)(encoded[frames / 2] ^ genericEncoded[frames / 2] ^ decoded[frames / 2].counter
+    ^ (uint8_t)values[frames / 2]);
+  (void)sink;
+
+  report("unpack", unpackGenerated, unpackGeneric);
+  report("pack", packGenerated, packGeneric);
+  return 0;
+}
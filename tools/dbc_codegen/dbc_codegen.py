@@ -0,0 +1,402 @@
+"""
+@file dbc_codegen.py
+@brief generates constexpr pack / unpack code for every message in a DBC file
+@version 1.0
+@date 2026-10-17
+
+runs as a PlatformIO pre: extra script, reading the project options
+
+    custom_dbc_file     path to the DBC file (relative to the project)
+    custom_dbc_header   path of the generated header (relative to the project)
+
+or by hand:
+
+    python ../tools/dbc_codegen/dbc_codegen.py ../dbc/vehicle.dbc include/vehicle_dbc.h
+
+every message becomes a struct of raw signal values with constexpr pack() and unpack()
+members. the bit positions are baked into shifts and masks, so nothing is parsed at run
+time. floats only appear for signals whose factor or offset is not a whole number.
+"""
+
+import os
+import re
+import sys
+
+
+# --- parsing --- #
+
+MESSAGE_PATTERN = re.compile(r"^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)")
+SIGNAL_PATTERN = re.compile(
+    r"^SG_\s+(\w+)\s*(\w*)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*"
+    r"\(\s*([-+0-9.eE]+)\s*,\s*([-+0-9.eE]+)\s*\)\s*"
+    r"\[\s*([-+0-9.eE]+)\s*\|\s*([-+0-9.eE]+)\s*\]\s*\"([^\"]*)\""
+)
+COMMENT_PATTERN = re.compile(r"^CM_\s+SG_\s+(\d+)\s+(\w+)\s+\"([^\"]*)\"\s*;")
+
+EXTENDED_ID_FLAG = 0x80000000
+
+
+class Signal:
+    def __init__(self, name, start, length, little_endian, signed, factor, offset, minimum, maximum, unit):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.little_endian = little_endian
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.unit = unit
+        self.comment = ""
+
+
+class Message:
+    def __init__(self, frame_id, name, dlc, sender):
+        self.extended = bool(frame_id & EXTENDED_ID_FLAG)
+        self.frame_id = frame_id & ~EXTENDED_ID_FLAG
+        self.name = name
+        self.dlc = dlc
+        self.sender = sender
+        self.signals = []
+
+
+def parse_number(text):
+    value = float(text)
+    return int(value) if value.is_integer() else value
+
+
+def parse_dbc(path):
+    """
+    @brief reads the messages, signals and signal comments out of a DBC file
+    """
+    messages = []
+    by_id = {}
+
+    with open(path, "r", encoding="latin-1") as dbc:
+        for line in dbc:
+            line = line.strip()
+
+            match = MESSAGE_PATTERN.match(line)
+            if match:
+                message = Message(int(match.group(1)), match.group(2), int(match.group(3)), match.group(4))
+                messages.append(message)
+                by_id[message.frame_id] = message
+                continue
+
+            match = SIGNAL_PATTERN.match(line)
+            if match:
+                if not messages:
+                    raise ValueError("%s: signal %s appears before any message" % (path, match.group(1)))
+                if match.group(2):
+                    raise ValueError("%s: multiplexed signal %s is not supported" % (path, match.group(1)))
+
+                messages[-1].signals.append(Signal(
+                    name=match.group(1),
+                    start=int(match.group(3)),
+                    length=int(match.group(4)),
+                    little_endian=match.group(5) == "1",
+                    signed=match.group(6) == "-",
+                    factor=parse_number(match.group(7)),
+                    offset=parse_number(match.group(8)),
+                    minimum=parse_number(match.group(9)),
+                    maximum=parse_number(match.group(10)),
+                    unit=match.group(11),
+                ))
+                continue
+
+            match = COMMENT_PATTERN.match(line)
+            if match:
+                message = by_id.get(int(match.group(1)) & ~EXTENDED_ID_FLAG)
+                for signal in message.signals if message else []:
+                    if signal.name == match.group(2):
+                        signal.comment = match.group(3)
+
+    return messages
+
+
+# --- layout --- #
+
+def signal_shift(signal):
+    """
+    @brief right shift that moves the signal's LSB to bit 0 of the 64 bit frame word
+    intel signals use the little endian word, motorola signals the big endian word
+    """
+    if signal.little_endian:
+        shift = signal.start
+        top = shift + signal.length
+    else:
+        # DBC gives the MSB in sawtooth numbering, convert it to a big endian bit index
+        msb = (signal.start // 8) * 8 + (7 - signal.start % 8)
+        lsb = msb + signal.length - 1
+        shift = 63 - lsb
+        top = lsb + 1
+
+    if signal.length < 1 or signal.length > 64 or shift < 0 or top > 64:
+        raise ValueError("signal %s does not fit in an 8 byte frame" % signal.name)
+    return shift
+
+
+def check_layout(message):
+    """
+    @brief reject signals that overlap each other or run past the message's DLC
+    """
+    used = {}
+    for signal in message.signals:
+        shift = signal_shift(signal)
+        for bit in range(shift, shift + signal.length):
+            # map both byte orders onto the same physical byte/bit numbering
+            physical = bit if signal.little_endian else (7 - bit // 8) * 8 + bit % 8
+            if physical in used:
+                raise ValueError("%s: signals %s and %s overlap" % (message.name, used[physical], signal.name))
+            if physical // 8 >= message.dlc:
+                raise ValueError("%s: signal %s extends past the DLC" % (message.name, signal.name))
+            used[physical] = signal.name
+
+
+def raw_type(signal):
+    for bits in (8, 16, 32, 64):
+        if signal.length <= bits:
+            return ("int%d_t" if signal.signed else "uint%d_t") % bits
+
+
+# --- naming --- #
+
+def words(name):
+    return [word for word in re.split(r"_|(?<=[a-z0-9])(?=[A-Z])", name) if word]
+
+
+def type_name(name):
+    return "".join(word.capitalize() for word in words(name))
+
+
+def member_name(name):
+    parts = words(name)
+    return parts[0].lower() + "".join(word.capitalize() for word in parts[1:])
+
+
+def format_number(value):
+    return repr(value) if isinstance(value, float) else str(value)
+
+
+# --- code generation --- #
+
+HELPERS = """
+/*
+===============================================================================================
+                                    Helpers
+===============================================================================================
+*/
+
+// whole frame as one little endian (intel) word
+constexpr uint64_t dbcLoadLittleEndian(const uint8_t* data)
+{
+  uint64_t word = 0;
+  for (int i = 7; i >= 0; i--) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+// whole frame as one big endian (motorola) word
+constexpr uint64_t dbcLoadBigEndian(const uint8_t* data)
+{
+  uint64_t word = 0;
+  for (int i = 0; i < 8; i++) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+constexpr void dbcStore(uint64_t littleEndian, uint64_t bigEndian, uint8_t* data)
+{
+  for (int i = 0; i < 8; i++) {
+    data[i] = (uint8_t)(littleEndian >> (8 * i)) | (uint8_t)(bigEndian >> (56 - 8 * i));
+  }
+}
+
+constexpr int64_t dbcSignExtend(uint64_t raw, int length)
+{
+  return (int64_t)(raw << (64 - length)) >> (64 - length);
+}
+
+// round half away from zero, only used by scaled signals
+constexpr int64_t dbcRound(float value)
+{
+  return (int64_t)(value >= 0.0f ? value + 0.5f : value - 0.5f);
+}
+"""
+
+
+def generate_signal_members(signal):
+    lines = []
+    description = "%d|%d@%s%s (%s,%s) [%s|%s]" % (
+        signal.start, signal.length, "1" if signal.little_endian else "0", "-" if signal.signed else "+",
+        format_number(signal.factor), format_number(signal.offset),
+        format_number(signal.minimum), format_number(signal.maximum))
+    if signal.unit:
+        description += ' "%s"' % signal.unit
+    if signal.comment:
+        description += " - " + signal.comment
+    lines.append("  %s %s = 0;    // %s" % (raw_type(signal), member_name(signal.name), description))
+    return lines
+
+
+def offset_term(offset, suffix=""):
+    """
+    @brief " + offset" / " - offset", or nothing for a zero offset
+    """
+    if offset == 0:
+        return ""
+    return " %s %s%s" % ("-" if offset < 0 else "+", format_number(abs(offset)), suffix)
+
+
+def generate_physical_accessors(signal):
+    name = member_name(signal.name)
+    accessor = name[0].upper() + name[1:]
+
+    if signal.factor == 1 and signal.offset == 0:
+        return []
+
+    lines = []
+    if isinstance(signal.factor, float) or isinstance(signal.offset, float):
+        factor = format_number(float(signal.factor)) + "f"
+        lines.append("  constexpr float physical%s() const { return %s * %s%s; }" % (
+            accessor, name, factor, offset_term(float(signal.offset), "f")))
+        lines.append("  constexpr void setPhysical%s(float value) { %s = (%s)dbcRound((value%s) / %s); }" % (
+            accessor, name, raw_type(signal), offset_term(-float(signal.offset), "f"), factor))
+    else:
+        lines.append("  constexpr int64_t physical%s() const { return (int64_t)%s * %d%s; }" % (
+            accessor, name, signal.factor, offset_term(signal.offset)))
+        lines.append("  constexpr void setPhysical%s(int64_t value) { %s = (%s)((value%s) / %d); }" % (
+            accessor, name, raw_type(signal), offset_term(-signal.offset), signal.factor))
+    return lines
+
+
+def generate_message(message):
+    check_layout(message)
+
+    name = type_name(message.name)
+    lines = []
+    lines.append("/**")
+    lines.append(" * @brief %s (0x%X), %d bytes, sent by %s" % (message.name, message.frame_id, message.dlc, message.sender))
+    lines.append(" */")
+    lines.append("struct %s" % name)
+    lines.append("{")
+    lines.append("  static constexpr uint32_t ID = 0x%X;" % message.frame_id)
+    lines.append("  static constexpr uint8_t DLC = %d;" % message.dlc)
+    lines.append("  static constexpr bool EXTENDED = %s;" % ("true" if message.extended else "false"))
+    lines.append("")
+
+    # raw signal values
+    for signal in message.signals:
+        lines.extend(generate_signal_members(signal))
+
+    # scaled accessors
+    physical = []
+    for signal in message.signals:
+        physical.extend(generate_physical_accessors(signal))
+    if physical:
+        lines.append("")
+        lines.extend(physical)
+
+    uses_le = any(signal.little_endian for signal in message.signals)
+    uses_be = any(not signal.little_endian for signal in message.signals)
+
+    # pack
+    lines.append("")
+    lines.append("  // write every signal into an 8 byte frame buffer")
+    lines.append("  constexpr void pack(uint8_t* data) const")
+    lines.append("  {")
+    lines.append("    uint64_t littleEndian = 0;")
+    lines.append("    uint64_t bigEndian = 0;")
+    for signal in message.signals:
+        word = "littleEndian" if signal.little_endian else "bigEndian"
+        mask = "0x%XULL" % ((1 << signal.length) - 1)
+        lines.append("    %s |= ((uint64_t)%s & %s) << %d;" % (word, member_name(signal.name), mask, signal_shift(signal)))
+    lines.append("    dbcStore(littleEndian, bigEndian, data);")
+    lines.append("  }")
+
+    # unpack
+    lines.append("")
+    lines.append("  // read every signal out of an 8 byte frame buffer")
+    lines.append("  static constexpr %s unpack(const uint8_t* data)" % name)
+    lines.append("  {")
+    if uses_le:
+        lines.append("    const uint64_t littleEndian = dbcLoadLittleEndian(data);")
+    if uses_be:
+        lines.append("    const uint64_t bigEndian = dbcLoadBigEndian(data);")
+    lines.append("    %s message;" % name)
+    for signal in message.signals:
+        word = "littleEndian" if signal.little_endian else "bigEndian"
+        mask = "0x%XULL" % ((1 << signal.length) - 1)
+        extract = "(%s >> %d) & %s" % (word, signal_shift(signal), mask)
+        if signal.signed:
+            extract = "dbcSignExtend(%s, %d)" % (extract, signal.length)
+        lines.append("    message.%s = (%s)(%s);" % (member_name(signal.name), raw_type(signal), extract))
+    lines.append("    return message;")
+    lines.append("  }")
+
+    lines.append("};")
+    return lines
+
+
+def generate_header(messages, source_name, header_name):
+    lines = []
+    lines.append("/**")
+    lines.append(" * @file %s" % header_name)
+    lines.append(" * @brief generated from %s by tools/dbc_codegen/dbc_codegen.py, do not edit by hand" % source_name)
+    lines.append(" */")
+    lines.append("")
+    lines.append("#pragma once")
+    lines.append("")
+    lines.append("#include <stdint.h>")
+    lines.extend(HELPERS.rstrip("\n").split("\n"))
+    lines.append("")
+    lines.append("")
+    lines.append("/*")
+    lines.append("===============================================================================================")
+    lines.append("                                    Messages")
+    lines.append("===============================================================================================")
+    lines.append("*/")
+    for message in messages:
+        lines.append("")
+        lines.extend(generate_message(message))
+        lines.append("")
+    return "\n".join(lines) + "\n"
+
+
+def generate(dbc_path, header_path):
+    """
+    @brief regenerate the header, only touching it when the output changed so builds stay incremental
+    """
+    messages = parse_dbc(dbc_path)
+    header = generate_header(messages, os.path.basename(dbc_path), os.path.basename(header_path))
+
+    if os.path.exists(header_path):
+        with open(header_path, "r") as existing:
+            if existing.read() == header:
+                return False
+
+    with open(header_path, "w") as output:
+        output.write(header)
+    return True
+
+
+# --- entry points --- #
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    project_dir = env.subst("$PROJECT_DIR")
+    dbc_file = os.path.join(project_dir, env.GetProjectOption("custom_dbc_file"))
+    header_file = os.path.join(project_dir, env.GetProjectOption("custom_dbc_header"))
+    if generate(dbc_file, header_file):
+        print("DBC: generated %s from %s" % (os.path.relpath(header_file, project_dir), os.path.relpath(dbc_file, project_dir)))
+elif __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit("usage: dbc_codegen.py <input.dbc> <output.h>")
+    generate(sys.argv[1], sys.argv[2])
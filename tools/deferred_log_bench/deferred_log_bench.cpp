@@ -0,0 +1,347 @@
+/**
+ * @file deferred_log_bench.cpp
+ * @brief what a log call costs the caller: LOG_PRINTF() into DeferredLog against Serial.printf
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * the call is CAN-Test's TX status line, six integers and about 90 characters, plus Timers'
+ * status line with a string argument. the first table is host CPU time per call: queueing the
+ * record, formatting it the way Serial.printf does, and Serial.printf itself on the simulated
+ * board with the UART not timed, i.e. the formatting plus the copy. none of it blocks.
+ *
+ * the second table is what really hurts on the device: the caller logs once per 1 ms loop pass
+ * for a few seconds of virtual time, into the simulated board's UART (lib/Hal/sim/Arduino.h,
+ * 128 byte TX FIFO drained at baud / 10 bytes per second). Serial.printf blocks the caller
+ * until its line fits into the FIFO, so the loop slows to the UART's pace. LOG_PRINTF() never
+ * waits: the drain task's 10 ms budget of bytes goes out and what the ring cannot hold is
+ * dropped and counted. the table shows the caller's wait per call and, for the logger, how
+ * many records made it out. the logger's wait is the whole call, timed on the host.
+ *
+ * checks: the drained text is byte for byte what Serial.printf prints, the caller never waits
+ * on the logger, every record is either drained or counted as dropped, and the drain never
+ * exceeds its byte budget. the exit code is 1 if any check fails.
+ *
+ * build:   g++ -std=gnu++17 -O2 -I../../lib/DeferredLog/src -I../../lib/Hal/src -I../../lib/Hal/sim deferred_log_bench.cpp -o deferred_log_bench
+ * usage:   deferred_log_bench [--seconds <virtual seconds per UART run>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <Arduino.h>
+#include <deferred_log.h>
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_MIN_SECONDS                 0.25
+#define BENCH_DEFAULT_SECONDS             5.0
+#define BENCH_LOOP_INTERVAL_US            1000        // the caller logs once per loop pass
+#define BENCH_DRAIN_INTERVAL_US           10000       // DeferredLogConfig::drainIntervalMs
+
+static const char* const txFormat = "CAN TX: sent: %u | queue full: %u | deadline misses: %u | bus-off: %u | recovered: %u | tx failed: %u\n";
+static const char* const statusFormat = "TIMER 1 STATUS: %s\n";
+
+/**
+ * @brief arguments for the nth call, so consecutive lines differ
+ */
+struct TxStats
+{
+  uint32_t sent, queueFull, deadlineMisses, busOff, recovered, txFailed;
+};
+
+static TxStats txStatsFor(uint32_t n)
+{
+  TxStats stats = { 100000 + n * 7, n % 13, n % 5, n % 3, n % 3, n % 2 };
+  return stats;
+}
+
+static int failures = 0;
+
+
+/*
+===============================================================================================
+                                    Host CPU per Call
+===============================================================================================
+*/
+
+/**
+ * @brief time calls of one way to log until BENCH_MIN_SECONDS have passed
+ *
+ * @param call logs the nth line
+ * @param between runs untimed after every batch, e.g. to empty the ring
+ * @return ns per call
+ */
+template <typename Call, typename Between>
+double timeCalls(Call call, Between between)
+{
+  double timedNs = 0;
+  uint64_t calls = 0;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < BENCH_MIN_SECONDS) {
+    const std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DEFERRED_LOG_CAPACITY; i++) {
+      call((uint32_t)(calls + i));
+    }
+    timedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - batchStart).count();
+    calls += DEFERRED_LOG_CAPACITY;
+    between();
+  }
+  return timedNs / (double)calls;
+}
+
+static void discard(const uint8_t* data, size_t length, void* context)
+{
+  (void)data;
+  (void)length;
+  (void)context;
+}
+
+static void benchCpu()
+{
+  static DeferredLog log;
+  volatile int sink = 0;
+  char line[DEFERRED_LOG_LINE_SIZE];
+  halSim().log.setEcho(NULL);
+  Serial.begin(0);
+
+  const auto emptyRing = [&]() { log.drain(DEFERRED_LOG_TEXT, (size_t)-1, discard, NULL); };
+  const auto nothing = []() {};
+
+  printf("host CPU per call, ns\n");
+  printf("  %-44s %10s %10s\n", "", "CAN TX line", "status %s");
+
+  const double logTx = timeCalls([&](uint32_t n) {
+    const TxStats s = txStatsFor(n);
+    log.write(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+  }, emptyRing);
+  const double logStatus = timeCalls([&](uint32_t n) { log.write(statusFormat, (n & 1) != 0 ? "RUNNING" : "DISABLED"); }, emptyRing);
+  printf("  %-44s %10.1f %10.1f\n", "LOG_PRINTF(), queue the record", logTx, logStatus);
+
+  const double formatTx = timeCalls([&](uint32_t n) {
+    const TxStats s = txStatsFor(n);
+    sink = sink + snprintf(line, sizeof(line), txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+  }, nothing);
+  const double formatStatus = timeCalls([&](uint32_t n) {
+    sink = sink + snprintf(line, sizeof(line), statusFormat, (n & 1) != 0 ? "RUNNING" : "DISABLED");
+  }, nothing);
+  printf("  %-44s %10.1f %10.1f\n", "snprintf(), the formatting alone", formatTx, formatStatus);
+
+  const double serialTx = timeCalls([&](uint32_t n) {
+    const TxStats s = txStatsFor(n);
+    Serial.printf(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+  }, nothing);
+  const double serialStatus = timeCalls([&](uint32_t n) { Serial.printf(statusFormat, (n & 1) != 0 ? "RUNNING" : "DISABLED"); }, nothing);
+  printf("  %-44s %10.1f %10.1f\n", "Serial.printf(), UART not timed", serialTx, serialStatus);
+  printf("  %-44s %10.1fx %9.1fx\n\n", "Serial.printf() / LOG_PRINTF()", serialTx / logTx, serialStatus / logStatus);
+}
+
+
+/*
+===============================================================================================
+                                    Caller Waiting on the UART
+===============================================================================================
+*/
+
+struct UartRun
+{
+  uint32_t calls = 0;
+  double waitPerCallUs = 0;
+  double worstWaitUs = 0;
+  uint32_t drained = 0;
+  uint32_t dropped = 0;
+  bool withinBudget = true;
+};
+
+/**
+ * @brief the caller's loop with Serial.printf, virtual time
+ */
+static UartRun runSerial(uint32_t baud, double seconds)
+{
+  halSim().log.setEcho(NULL);
+  Serial.begin(baud);
+  UartRun run;
+  const uint64_t blockedBefore = Serial.blockedUs();
+  const int64_t endUs = halSim().clock.nowUs() + (int64_t)(seconds * 1e6);
+  while (halSim().clock.nowUs() < endUs) {
+    const TxStats s = txStatsFor(run.calls);
+    const uint64_t before = Serial.blockedUs();
+    Serial.printf(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+    const double waitUs = (double)(Serial.blockedUs() - before);
+    run.worstWaitUs = waitUs > run.worstWaitUs ? waitUs : run.worstWaitUs;
+    run.calls++;
+    halSim().clock.advance(BENCH_LOOP_INTERVAL_US);
+  }
+  Serial.flush();
+  run.waitPerCallUs = (double)(Serial.blockedUs() - blockedBefore) / run.calls;
+  run.drained = run.calls;
+  Serial.end();
+  return run;
+}
+
+/**
+ * @brief the caller's loop with LOG_PRINTF(), the drain task's budget every 10 ms, virtual time
+ */
+static UartRun runDeferred(uint32_t baud, double seconds)
+{
+  static DeferredLog logs[2];
+  DeferredLog& log = logs[baud > 9600 ? 1 : 0];
+  const size_t budget = (size_t)((uint64_t)baud / 10 * BENCH_DRAIN_INTERVAL_US / 1000000);
+  UartRun run;
+  double waitUs = 0;
+  const int64_t endUs = halSim().clock.nowUs() + (int64_t)(seconds * 1e6);
+  int64_t nextDrainUs = halSim().clock.nowUs() + BENCH_DRAIN_INTERVAL_US;
+  while (halSim().clock.nowUs() < endUs) {
+    const TxStats s = txStatsFor(run.calls);
+    const std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+    log.write(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+    const double callUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+    run.worstWaitUs = callUs > run.worstWaitUs ? callUs : run.worstWaitUs;
+    waitUs += callUs;
+    run.calls++;
+
+    halSim().clock.advance(BENCH_LOOP_INTERVAL_US);
+    if (halSim().clock.nowUs() >= nextDrainUs) {
+      run.withinBudget = log.drain(DEFERRED_LOG_TEXT, budget, discard, NULL) <= budget && run.withinBudget;
+      nextDrainUs += BENCH_DRAIN_INTERVAL_US;
+    }
+  }
+
+  // everything still queued goes out after the loop is done
+  while (log.drain(DEFERRED_LOG_TEXT, budget, discard, NULL) != 0) {
+  }
+  run.waitPerCallUs = waitUs / run.calls;
+  run.drained = log.drained();
+  run.dropped = log.dropped();
+  return run;
+}
+
+static void reportUart(const char* name, uint32_t baud, const UartRun& run, bool deferred)
+{
+  printf("  %-16s %6u %8u %14.1f %13.1f", name, baud, run.calls, run.waitPerCallUs, run.worstWaitUs);
+  if (deferred) {
+    printf(" %9u %9u\n", run.drained, run.dropped);
+  }
+  else {
+    printf(" %9u %9s\n", run.drained, "-");
+  }
+}
+
+static void benchUart(double seconds)
+{
+  printf("caller logging the CAN TX line every %u us for %.0f s of virtual time\n", BENCH_LOOP_INTERVAL_US, seconds);
+  printf("  %-16s %6s %8s %14s %13s %9s %9s\n", "", "baud", "calls", "wait/call us", "worst wait us", "printed", "dropped");
+
+  bool neverWaits = true;
+  bool accounted = true;
+  bool withinBudget = true;
+  bool serialBlocks = true;
+  const uint32_t bauds[] = { 9600, 115200 };
+  for (uint32_t baud : bauds) {
+    const UartRun serial = runSerial(baud, seconds);
+    reportUart("Serial.printf()", baud, serial, false);
+    const UartRun deferred = runDeferred(baud, seconds);
+    reportUart("LOG_PRINTF()", baud, deferred, true);
+
+    // the host clock stands in for the device's, a record is queued in well under a millisecond
+    neverWaits = neverWaits && deferred.worstWaitUs < 1000;
+    accounted = accounted && deferred.drained + deferred.dropped == deferred.calls;
+    withinBudget = withinBudget && deferred.withinBudget;
+    serialBlocks = serialBlocks && serial.waitPerCallUs > 0;
+  }
+  printf("\n");
+
+  printf("--- checks ---\n");
+  printf("%-64s %s\n", "the caller never waited on LOG_PRINTF()", neverWaits ? "ok" : "FAILED");
+  printf("%-64s %s\n", "every record was drained or counted as dropped", accounted ? "ok" : "FAILED");
+  printf("%-64s %s\n", "the drain never went over its byte budget", withinBudget ? "ok" : "FAILED");
+  printf("%-64s %s\n", "Serial.printf() blocked the caller once the FIFO was full", serialBlocks ? "ok" : "FAILED");
+  failures += (neverWaits ? 0 : 1) + (accounted ? 0 : 1) + (withinBudget ? 0 : 1) + (serialBlocks ? 0 : 1);
+}
+
+
+/*
+===============================================================================================
+                                    Same Output
+===============================================================================================
+*/
+
+static void collect(const uint8_t* data, size_t length, void* context)
+{
+  ((std::string*)context)->append((const char*)data, length);
+}
+
+/**
+ * @brief a ring's worth of calls through both, the drained text has to match Serial's
+ */
+static void checkSameText()
+{
+  static DeferredLog log;
+  halSim().log.setEcho(NULL);
+  halSim().log.setCapture(true);
+  halSim().log.clear();
+  Serial.begin(0);
+  for (uint32_t n = 0; n < DEFERRED_LOG_CAPACITY; n++) {
+    const TxStats s = txStatsFor(n);
+    if ((n & 1) != 0) {
+      log.write(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+      Serial.printf(txFormat, s.sent, s.queueFull, s.deadlineMisses, s.busOff, s.recovered, s.txFailed);
+    }
+    else {
+      log.write(statusFormat, (n & 2) != 0 ? "RUNNING" : "DISABLED");
+      Serial.printf(statusFormat, (n & 2) != 0 ? "RUNNING" : "DISABLED");
+    }
+  }
+  std::string drained;
+  log.drain(DEFERRED_LOG_TEXT, (size_t)-1, collect, &drained);
+  halSim().log.setCapture(false);
+
+  const bool same = log.dropped() == 0 && drained == halSim().log.text();
+  printf("%-64s %s\n", "LOG_PRINTF() printed exactly what Serial.printf() did", same ? "ok" : "FAILED");
+  failures += same ? 0 : 1;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  double seconds = BENCH_DEFAULT_SECONDS;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--seconds") == 0 && arg + 1 < argc) {
+      seconds = atof(argv[++arg]);
+    }
+    else {
+      seconds = 0;
+      break;
+    }
+  }
+  if (seconds <= 0) {
+    fprintf(stderr, "usage: %s [--seconds <virtual seconds per UART run>]\n", argv[0]);
+    return 1;
+  }
+
+  printf("ring of %d records, %d byte records\n\n", DEFERRED_LOG_CAPACITY, (int)sizeof(DeferredLogRecord));
+  benchCpu();
+  benchUart(seconds);
+  checkSameText();
+  printf("%d checks failed\n", failures);
+  return failures != 0 ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file event_counters_bench.cpp
+ * @brief events/s through EventCounters from several threads, against counters behind one
+ * shared spinlock and against atomics packed into one cache line
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * every writer thread stands in for one of the Timers example's callbacks and counts its own
+ * source as fast as it can, while a reader thread takes snapshots the whole time like loop()
+ * does. the spinlock counters are what the example did before, one portMUX_TYPE spinlock taken
+ * around every counterN++ and around the read: here an std::atomic_flag taken and released the
+ * same way. the packed atomics are EventCounters without the cache line padding, to show what
+ * the padding buys once writers sit on different cores.
+ *
+ * every run checks that each counter ends at exactly the events its writer counted and that
+ * no snapshot ever goes backwards, the exit code is 1 if any run lost or invented an event.
+ *
+ * build:   g++ -std=c++11 -O2 -pthread -I../../lib/TimerScheduler/src event_counters_bench.cpp -o event_counters_bench
+ * usage:   event_counters_bench [--events <per writer>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "event_counters.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_SOURCES                     4           // the Timers example's four callbacks
+#define BENCH_DEFAULT_EVENTS              5000000
+
+
+/*
+===============================================================================================
+                                    Counters
+===============================================================================================
+*/
+
+/**
+ * @brief the old way, plain counters behind one spinlock shared by every source and the reader
+ */
+class SpinlockCounters
+{
+public:
+  void increment(size_t source)
+  {
+    lock();
+    counts_[source]++;
+    unlock();
+  }
+
+  bool snapshot(EventCounterSnapshot<BENCH_SOURCES>& snapshot)
+  {
+    lock();
+    memcpy(snapshot.counts, counts_, sizeof(counts_));
+    unlock();
+    return true;
+  }
+
+private:
+  void lock()
+  {
+    while (lock_.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+
+  void unlock() { lock_.clear(std::memory_order_release); }
+
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  uint32_t counts_[BENCH_SOURCES] = {};
+};
+
+/**
+ * @brief EventCounters' relaxed adds, with all counters sharing one cache line
+ */
+class PackedCounters
+{
+public:
+  void increment(size_t source) { counts_[source].fetch_add(1, std::memory_order_relaxed); }
+
+  bool snapshot(EventCounterSnapshot<BENCH_SOURCES>& snapshot)
+  {
+    for (size_t i = 0; i < BENCH_SOURCES; i++) {
+      snapshot.counts[i] = counts_[i].load();
+    }
+    return false;
+  }
+
+private:
+  std::atomic<uint32_t> counts_[BENCH_SOURCES] = {};
+};
+
+/**
+ * @brief EventCounters as the example uses it
+ */
+class LockFreeCounters
+{
+public:
+  void increment(size_t source) { counters_.increment(source); }
+  bool snapshot(EventCounterSnapshot<BENCH_SOURCES>& snapshot) { return counters_.snapshot(snapshot); }
+
+private:
+  EventCounters<BENCH_SOURCES> counters_;
+};
+
+
+/*
+===============================================================================================
+                                    Measurement
+===============================================================================================
+*/
+
+struct Run
+{
+  double eventsPerSecond = 0;
+  uint32_t snapshots = 0;
+  uint32_t consistent = 0;            // snapshots the counters reported as one moment
+  uint32_t backwards = 0;             // snapshots with a counter below the one before
+  uint32_t wrongCounts = 0;           // counters that did not end at their writer's events
+};
+
+/**
+ * @brief writers threads count events each on their own source while a reader takes snapshots
+ *
+ * @param counters unused counters, static since EventCounters is cache line aligned
+ */
+template <typename Counters>
+Run measure(Counters& counters, int writers, uint32_t events)
+{
+  std::atomic<bool> go(false);
+  std::atomic<int> running(writers);
+  Run run;
+
+  std::thread reader([&]() {
+    EventCounterSnapshot<BENCH_SOURCES> last;
+    while (!go.load(std::memory_order_acquire)) {
+    }
+    while (running.load(std::memory_order_acquire) != 0) {
+      EventCounterSnapshot<BENCH_SOURCES> snapshot;
+      run.consistent += counters.snapshot(snapshot) ? 1 : 0;
+      for (size_t i = 0; i < BENCH_SOURCES; i++) {
+        run.backwards += snapshot.counts[i] < last.counts[i] ? 1 : 0;
+      }
+      last = snapshot;
+      run.snapshots++;
+    }
+  });
+
+  std::thread threads[BENCH_SOURCES];
+  for (int source = 0; source < writers; source++) {
+    threads[source] = std::thread([&, source]() {
+      while (!go.load(std::memory_order_acquire)) {
+      }
+      for (uint32_t i = 0; i < events; i++) {
+        counters.increment(source);
+      }
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (int source = 0; source < writers; source++) {
+    threads[source].join();
+  }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  reader.join();
+
+  EventCounterSnapshot<BENCH_SOURCES> end;
+  counters.snapshot(end);
+  for (int source = 0; source < BENCH_SOURCES; source++) {
+    run.wrongCounts += end.counts[source] != (source < writers ? events : 0) ? 1 : 0;
+  }
+  run.eventsPerSecond = (double)events * writers / elapsed;
+  return run;
+}
+
+void report(const char* name, const Run& run, int writers, bool consistency)
+{
+  printf("  %-22s %7d %12.1f %14.1f %10u", name, writers, run.eventsPerSecond / 1e6,
+    1e9 * writers / run.eventsPerSecond, run.snapshots);
+  if (consistency) {
+    printf(" %11.1f%%", run.snapshots != 0 ? 100.0 * run.consistent / run.snapshots : 0);
+  }
+  else {
+    printf(" %12s", "-");
+  }
+  printf("  %s\n", run.backwards == 0 && run.wrongCounts == 0 ? "exact" : "LOST EVENTS");
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  uint32_t events = BENCH_DEFAULT_EVENTS;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--events") == 0 && arg + 1 < argc) {
+      events = (uint32_t)strtoul(argv[++arg], NULL, 10);
+    }
+    else {
+      events = 0;
+      break;
+    }
+  }
+  if (events == 0) {
+    fprintf(stderr, "usage: %s [--events <per writer>]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%u events per writer, one source per writer, one reader snapshotting throughout, %u hardware threads\n\n",
+    events, std::thread::hardware_concurrency());
+  if (std::thread::hardware_concurrency() < 2) {
+    printf("one hardware thread: the writers take turns instead of contending, the spinlock only loses to preemption\n\n");
+  }
+  printf("  %-22s %7s %12s %14s %10s %12s\n", "counters", "writers", "Mevents/s", "ns/event/wr", "snapshots", "consistent");
+
+  bool failed = false;
+  for (int writers = 1; writers <= BENCH_SOURCES; writers *= 2) {
+    static LockFreeCounters lockFree[3];
+    static SpinlockCounters spinlock[3];
+    static PackedCounters packed[3];
+    const int index = writers == 1 ? 0 : writers == 2 ? 1 : 2;
+
+    const Run lockFreeRun = measure(lockFree[index], writers, events);
+    report("EventCounters", lockFreeRun, writers, true);
+    const Run spinlockRun = measure(spinlock[index], writers, events);
+    report("one shared spinlock", spinlockRun, writers, true);
+    const Run packedRun = measure(packed[index], writers, events);
+    report("packed atomics", packedRun, writers, false);
+    printf("\n");
+
+    failed = failed || lockFreeRun.backwards != 0 || lockFreeRun.wrongCounts != 0 || spinlockRun.backwards != 0
+      || spinlockRun.wrongCounts != 0 || packedRun.backwards != 0 || packedRun.wrongCounts != 0;
+  }
+
+  if (failed) {
+    printf("events were lost\n");
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file log_decoder.cpp
+ * @brief host side decoder for the deferred logger's binary stream
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * reads the bytes a DEFERRED_LOG_BINARY logger wrote (a capture file or a serial port) and
+ * prints one line per record, prefixed with the device timestamp in seconds. records whose
+ * format was defined before the capture started print as "unknown format" until the logger
+ * resends its format table.
+ *
+ * build:   g++ -std=c++11 -O2 -I../../lib/DeferredLog/src log_decoder.cpp -o log_decoder
+ * usage:   log_decoder [capture file]          (reads stdin without a file)
+ *          stty -F /dev/ttyUSB0 115200 raw && log_decoder /dev/ttyUSB0
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "deferred_log.h"
+
+
+/*
+===============================================================================================
+                                    Stream Reader
+===============================================================================================
+*/
+
+class StreamReader
+{
+public:
+  explicit StreamReader(FILE* input) : input_(input) {}
+
+  bool byte(uint8_t& value)
+  {
+    const int c = fgetc(input_);
+    if (c == EOF) {
+      return false;
+    }
+    value = (uint8_t)c;
+    return true;
+  }
+
+  bool u16(uint16_t& value)
+  {
+    uint8_t low, high;
+    if (!byte(low) || !byte(high)) {
+      return false;
+    }
+    value = (uint16_t)(low | (high << 8));
+    return true;
+  }
+
+  bool u32(uint32_t& value)
+  {
+    uint16_t low, high;
+    if (!u16(low) || !u16(high)) {
+      return false;
+    }
+    value = (uint32_t)low | ((uint32_t)high << 16);
+    return true;
+  }
+
+  bool text(std::string& value, size_t length)
+  {
+    value.resize(length);
+    return length == 0 || fread(&value[0], 1, length, input_) == length;
+  }
+
+private:
+  FILE* input_;
+};
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  FILE* input = stdin;
+  if (argc > 1) {
+    input = fopen(argv[1], "rb");
+    if (input == NULL) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  StreamReader reader(input);
+  std::vector<std::string> formats;
+  uint32_t records = 0;
+  uint32_t skipped = 0;
+
+  uint8_t sync;
+  while (reader.byte(sync)) {
+    // resynchronise on anything that is not a frame, e.g. boot messages before the logger started
+    uint8_t type;
+    if (sync != DEFERRED_LOG_SYNC || !reader.byte(type)) {
+      skipped++;
+      continue;
+    }
+
+    if (type == DEFERRED_LOG_FRAME_FORMAT) {
+      uint16_t id, length;
+      std::string text;
+      if (!reader.u16(id) || !reader.u16(length) || !reader.text(text, length)) {
+        break;
+      }
+      if (id >= formats.size()) {
+        formats.resize(id + 1);
+      }
+      formats[id] = text;
+    }
+    else if (type == DEFERRED_LOG_FRAME_RECORD) {
+      uint16_t id, types;
+      uint32_t timestampUs;
+      uint8_t count;
+      if (!reader.u16(id) || !reader.u32(timestampUs) || !reader.byte(count) || !reader.u16(types) || count > DEFERRED_LOG_MAX_ARGS) {
+        break;
+      }
+
+      uint32_t args[DEFERRED_LOG_MAX_ARGS];
+      DeferredLogArgType argTypes[DEFERRED_LOG_MAX_ARGS];
+      std::string strings[DEFERRED_LOG_MAX_ARGS];
+      const char* stringArgs[DEFERRED_LOG_MAX_ARGS];
+      bool complete = true;
+      for (int i = 0; i < count && complete; i++) {
+        argTypes[i] = (DeferredLogArgType)((types >> (i * 2)) & 0x3);
+        stringArgs[i] = NULL;
+        if (argTypes[i] == DEFERRED_LOG_ARG_STRING) {
+          uint8_t length;
+          complete = reader.byte(length) && reader.text(strings[i], length);
+          stringArgs[i] = strings[i].c_str();
+        }
+        else {
+          complete = reader.u32(args[i]);
+        }
+      }
+      if (!complete) {
+        break;
+      }
+
+      records++;
+      printf("[%6u.%06u] ", timestampUs / 1000000, timestampUs % 1000000);
+      if (id >= formats.size() || formats[id].empty()) {
+        printf("unknown format %u\n", id);
+        continue;
+      }
+
+      char line[DEFERRED_LOG_LINE_SIZE];
+      deferredLogFormat(line, sizeof(line), formats[id].c_str(), args, argTypes, stringArgs, count);
+
+      // one line per record, the device's own line endings are dropped
+      std::string message(line);
+      while (!message.empty() && (message.back() == '\n' || message.back() == '\r')) {
+        message.pop_back();
+      }
+      for (size_t i = 0; i < message.size(); i++) {
+        if (message[i] == '\n' || message[i] == '\r') {
+          message[i] = ' ';
+        }
+      }
+      printf("%s\n", message.c_str());
+    }
+    else if (type == DEFERRED_LOG_FRAME_DROPS) {
+      uint32_t total;
+      if (!reader.u32(total)) {
+        break;
+      }
+      printf("--- device dropped %u records so far\n", total);
+    }
+    else {
+      skipped += 2;
+    }
+    fflush(stdout);
+  }
+
+  fprintf(stderr, "%u records, %u bytes skipped\n", records, skipped);
+  if (input != stdin) {
+    fclose(input);
+  }
+  return 0;
+}
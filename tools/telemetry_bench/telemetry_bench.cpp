@@ -0,0 +1,303 @@
+/**
+ * @file telemetry_bench.cpp
+ * @brief records/s through telemetry.h: encoding samples into frames and decoding them again
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * three channels: GPIO-Test's five GPIO states, Timers' four counts, and eight random values of
+ * every magnitude for the worst case of the varints. each one is encoded the way
+ * TelemetryChannel::write() puts it on the UART (a leading zero, the schema frame every
+ * TELEMETRY_SCHEMA_INTERVAL samples, then the sample frame) into one capture, and the capture
+ * is decoded like tools/telemetry_decoder does: split at the zeros, COBS decode, check the CRC,
+ * read the fields. the table shows records/s both ways, the bytes per record on the wire and
+ * the same record as the printf line it replaced.
+ *
+ * every decoded record is compared with the values that were encoded, and a second capture
+ * with a text log line before every tenth frame (a UART shared with the deferred logger) has
+ * to decode to the same records with exactly one damaged frame per line. the exit code is 1
+ * if anything does not match.
+ *
+ * build:   g++ -std=c++11 -O2 -I../../lib/Telemetry/src telemetry_bench.cpp -o telemetry_bench
+ * usage:   telemetry_bench [--records <per channel>]
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "telemetry.h"
+
+
+/*
+===============================================================================================
+                                    Definitions
+===============================================================================================
+*/
+
+#define BENCH_MIN_SECONDS                 0.25
+#define BENCH_DEFAULT_RECORDS             100000
+#define BENCH_SAMPLE_INTERVAL_US          10000       // GPIO-Test's 10 ms cycle
+#define BENCH_TEXT_EVERY                  10          // frames between text lines in the mixed capture
+
+static const char* const gpioFields[] = { "cycle", "imd", "bms", "fan", "brake" };
+static const char* const timerFields[] = { "timer1", "timer2", "timer3", "timer4" };
+static const char* const wideFields[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+static const char* const textLine = "CAN RX RING: received: 123456 | overflows: 0 | high water mark: 12 / 64\n";
+
+/**
+ * @brief one channel to bench: its fields and the values of its nth record
+ */
+struct BenchChannel
+{
+  const char* name;
+  const char* const* fields;
+  uint8_t fieldCount;
+  void (*values)(uint32_t n, int32_t* values);
+  int (*printed)(char* line, size_t size, const int32_t* values);   // the printf line it replaces
+};
+
+static void gpioValues(uint32_t n, int32_t* values)
+{
+  values[0] = (int32_t)n;
+  for (int i = 1; i < 5; i++) {
+    values[i] = (int32_t)((n >> (i - 1)) & 1);
+  }
+}
+
+static int gpioPrinted(char* line, size_t size, const int32_t* v)
+{
+  return snprintf(line, size, "cycle: %d | imd: %d | bms: %d | fan: %d | brake: %d\r", v[0], v[1], v[2], v[3], v[4]);
+}
+
+static void timerValues(uint32_t n, int32_t* values)
+{
+  values[0] = (int32_t)(n * 2);
+  values[1] = (int32_t)n;
+  values[2] = (int32_t)(n / 2);
+  values[3] = (int32_t)(n / 5);
+}
+
+static int timerPrinted(char* line, size_t size, const int32_t* v)
+{
+  return snprintf(line, size, "timer 1 (0.5 sec): %u | timer 2 (1 sec): %u | timer 3 (2 sec): %u |  timer 4 (5 sec): %u\r",
+    (unsigned)v[0], (unsigned)v[1], (unsigned)v[2], (unsigned)v[3]);
+}
+
+static void wideValues(uint32_t n, int32_t* values)
+{
+  uint32_t random = n * 2654435761u + 1;
+  for (int i = 0; i < 8; i++) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    values[i] = (int32_t)random >> (random & 31);     // every magnitude, both signs
+  }
+}
+
+static int widePrinted(char* line, size_t size, const int32_t* v)
+{
+  return snprintf(line, size, "a: %d | b: %d | c: %d | d: %d | e: %d | f: %d | g: %d | h: %d\r", v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+}
+
+static const BenchChannel benchChannels[] = {
+  { "gpio", gpioFields, 5, gpioValues, gpioPrinted },
+  { "timers", timerFields, 4, timerValues, timerPrinted },
+  { "8 random", wideFields, 8, wideValues, widePrinted },
+};
+
+
+/*
+===============================================================================================
+                                    Encode and Decode
+===============================================================================================
+*/
+
+/**
+ * @brief encode records samples of one channel into capture as write() would send them
+ *
+ * @param textEvery a text line before every textEvery-th frame, 0 for none
+ * @return bytes in the capture
+ */
+static size_t encodeCapture(const BenchChannel& bench, uint32_t records, std::vector<uint8_t>& capture, uint32_t textEvery)
+{
+  const size_t textLength = strlen(textLine);
+  capture.resize((size_t)records * (TELEMETRY_MAX_FRAME * 2 + 1 + textLength));
+  TelemetryChannel channel(1, bench.name, bench.fields, bench.fieldCount);
+  int32_t values[TELEMETRY_MAX_FIELDS];
+  size_t used = 0;
+  for (uint32_t n = 0; n < records; n++) {
+    if (textEvery != 0 && n % textEvery == 0) {
+      memcpy(&capture[used], textLine, textLength);
+      used += textLength;
+    }
+    bench.values(n, values);
+    capture[used++] = 0;
+    used += channel.encode(&capture[used], TELEMETRY_MAX_FRAME * 2, n * BENCH_SAMPLE_INTERVAL_US, values);
+  }
+  return used;
+}
+
+struct DecodeResult
+{
+  uint32_t samples = 0;
+  uint32_t schemas = 0;
+  uint32_t damaged = 0;
+  uint32_t mismatched = 0;        // samples that are not what was encoded
+};
+
+/**
+ * @brief split a capture at the zeros and decode every frame, checking each sample if asked
+ */
+static DecodeResult decodeCapture(const BenchChannel& bench, const uint8_t* capture, size_t length, bool verify)
+{
+  DecodeResult result;
+  uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+  int32_t values[TELEMETRY_MAX_FIELDS];
+  int32_t expected[TELEMETRY_MAX_FIELDS];
+  const uint8_t* position = capture;
+  const uint8_t* const end = capture + length;
+  while (position < end) {
+    const uint8_t* zero = (const uint8_t*)memchr(position, 0, end - position);
+    if (zero == NULL) {
+      break;
+    }
+    const size_t frameLength = zero - position;
+    const uint8_t* frame = position;
+    position = zero + 1;
+    if (frameLength == 0) {
+      continue;
+    }
+
+    const size_t payloadLength = telemetryDecodeFrame(frame, frameLength, payload, sizeof(payload));
+    TelemetryReader reader(payload, payloadLength);
+    uint8_t kind;
+    uint32_t id;
+    if (payloadLength == 0 || !reader.byte(kind) || !reader.varint(id)) {
+      result.damaged++;
+      continue;
+    }
+    if (kind == TELEMETRY_KIND_SCHEMA) {
+      result.schemas++;
+      continue;
+    }
+
+    uint8_t sequence;
+    uint32_t timestamp;
+    bool read = reader.byte(sequence) && reader.varint(timestamp);
+    for (uint8_t i = 0; read && i < bench.fieldCount; i++) {
+      read = reader.signedVarint(values[i]);
+    }
+    if (!read || reader.remaining() != 0) {
+      result.damaged++;
+      continue;
+    }
+
+    if (verify) {
+      const uint32_t n = result.samples;
+      bench.values(n, expected);
+      const bool same = sequence == (uint8_t)n && timestamp == n * BENCH_SAMPLE_INTERVAL_US
+        && memcmp(values, expected, bench.fieldCount * sizeof(int32_t)) == 0;
+      result.mismatched += same ? 0 : 1;
+    }
+    result.samples++;
+  }
+  return result;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  uint32_t records = BENCH_DEFAULT_RECORDS;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--records") == 0 && arg + 1 < argc) {
+      records = (uint32_t)strtoul(argv[++arg], NULL, 10);
+    }
+    else {
+      records = 0;
+      break;
+    }
+  }
+  if (records == 0) {
+    fprintf(stderr, "usage: %s [--records <per channel>]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%u records per channel, schema every %d, as TelemetryChannel::write() sends them\n\n", records, TELEMETRY_SCHEMA_INTERVAL);
+  printf("  %-10s %6s %14s %14s %12s %12s %13s\n", "channel", "fields", "encode rec/s", "decode rec/s", "bytes/rec", "printf line",
+    "decode MB/s");
+
+  bool failed = false;
+  std::vector<uint8_t> capture;
+  for (const BenchChannel& bench : benchChannels) {
+    // encode, the whole capture per pass
+    size_t length = 0;
+    uint64_t encoded = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < BENCH_MIN_SECONDS) {
+      length = encodeCapture(bench, records, capture, 0);
+      encoded += records;
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    const double encodePerSecond = encoded / elapsed;
+
+    // decode the same capture
+    uint64_t decoded = 0;
+    DecodeResult result;
+    start = std::chrono::steady_clock::now();
+    elapsed = 0;
+    while (elapsed < BENCH_MIN_SECONDS) {
+      result = decodeCapture(bench, capture.data(), length, false);
+      decoded += result.samples;
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    const double decodePerSecond = decoded / elapsed;
+    const double bytesPerSecond = decodePerSecond * length / records;
+
+    // the printf line for the same records
+    char line[256];
+    int32_t values[TELEMETRY_MAX_FIELDS];
+    uint64_t printedBytes = 0;
+    for (uint32_t n = 0; n < records; n++) {
+      bench.values(n, values);
+      printedBytes += (uint64_t)bench.printed(line, sizeof(line), values);
+    }
+
+    printf("  %-10s %6u %14.0f %14.0f %12.1f %12.1f %13.1f\n", bench.name, bench.fieldCount, encodePerSecond, decodePerSecond,
+      (double)length / records, (double)printedBytes / records, bytesPerSecond / 1e6);
+
+    // every record comes back as it went in, with or without text on the same UART
+    const DecodeResult clean = decodeCapture(bench, capture.data(), length, true);
+    const size_t mixedLength = encodeCapture(bench, records, capture, BENCH_TEXT_EVERY);
+    const DecodeResult mixed = decodeCapture(bench, capture.data(), mixedLength, true);
+    const uint32_t schemas = (records + TELEMETRY_SCHEMA_INTERVAL - 1) / TELEMETRY_SCHEMA_INTERVAL;
+    const uint32_t textLines = (records + BENCH_TEXT_EVERY - 1) / BENCH_TEXT_EVERY;
+    const bool cleanExact = clean.samples == records && clean.mismatched == 0 && clean.damaged == 0 && clean.schemas == schemas;
+    const bool mixedExact = mixed.samples == records && mixed.mismatched == 0 && mixed.damaged == textLines && mixed.schemas == schemas;
+    if (!cleanExact || !mixedExact) {
+      printf("  %-10s decoded %u / %u records, %u mismatched, %u damaged; with text lines %u / %u records, %u mismatched, %u damaged of %u lines\n",
+        bench.name, clean.samples, records, clean.mismatched, clean.damaged, mixed.samples, records, mixed.mismatched, mixed.damaged, textLines);
+    }
+    failed = failed || !cleanExact || !mixedExact;
+  }
+
+  if (failed) {
+    printf("records were lost or changed\n");
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/**
+ * @file telemetry_decoder.cpp
+ * @brief host side decoder for telemetry.h frames, writes CSV or columnar files per channel
+ * @version 1.0
+ * @date 2026-10-17
+ *
+ * reads a captured serial log (text logs mixed in are skipped), checks every frame's CRC and
+ * writes one file per channel into the output directory, named after the channel:
+ *
+ *   --csv        <channel>.csv, a header row then timestamp_us, sequence and one column per field
+ *   --columnar   <channel>.tcol, column major like a single Parquet row group:
+ *                "TCOL" version:u32 rows:u32 columns:u32, then per column name length:u32 + name,
+ *                then every column as rows little endian int64 values
+ *
+ * timestamps are unwrapped to 64 bits. samples that arrive before their channel's schema are
+ * kept with generated field names. lost frames are counted from sequence gaps.
+ *
+ * build:   g++ -std=c++11 -O2 -I../../lib/Telemetry/src telemetry_decoder.cpp -o telemetry_decoder
+ * usage:   telemetry_decoder [--csv | --columnar] <capture file> <output directory>
+ */
+
+/*
+===============================================================================================
+                                    Includes
+===============================================================================================
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "telemetry.h"
+
+
+/*
+===============================================================================================
+                                    Channel Data
+===============================================================================================
+*/
+
+struct ChannelData
+{
+  std::string name;
+  std::vector<std::string> fields;
+  std::vector<std::vector<int64_t>> columns;      // timestamp, sequence, then fields
+  uint32_t lastTimestamp = 0;
+  int64_t timestampHigh = 0;
+  int lastSequence = -1;
+  uint32_t lost = 0;
+
+  size_t rows() const { return columns.empty() ? 0 : columns[0].size(); }
+
+  std::vector<std::string> columnNames() const
+  {
+    std::vector<std::string> names = { "timestamp_us", "sequence" };
+    for (size_t i = 0; i + 2 < columns.size(); i++) {
+      names.push_back(i < fields.size() ? fields[i] : "field" + std::to_string(i));
+    }
+    return names;
+  }
+};
+
+struct DecoderStats
+{
+  uint32_t frames = 0;
+  uint32_t samples = 0;
+  uint32_t schemas = 0;
+  uint32_t damaged = 0;
+};
+
+
+/*
+===============================================================================================
+                                    Decoding
+===============================================================================================
+*/
+
+static void handlePayload(const uint8_t* payload, size_t length, std::map<uint32_t, ChannelData>& channels, DecoderStats& stats)
+{
+  TelemetryReader reader(payload, length);
+  uint8_t kind;
+  uint32_t id;
+  if (!reader.byte(kind) || !reader.varint(id)) {
+    stats.damaged++;
+    return;
+  }
+  ChannelData& channel = channels[id];
+  if (channel.name.empty()) {
+    channel.name = "channel" + std::to_string(id);
+  }
+
+  if (kind == TELEMETRY_KIND_SCHEMA) {
+    uint8_t count, length;
+    const char* text;
+    if (!reader.byte(count) || !reader.string(text, length)) {
+      stats.damaged++;
+      return;
+    }
+    channel.name.assign(text, length);
+    channel.fields.clear();
+    for (uint8_t i = 0; i < count; i++) {
+      if (!reader.string(text, length)) {
+        stats.damaged++;
+        return;
+      }
+      channel.fields.push_back(std::string(text, length));
+    }
+    stats.schemas++;
+    return;
+  }
+
+  if (kind != TELEMETRY_KIND_SAMPLE) {
+    stats.damaged++;
+    return;
+  }
+
+  uint8_t sequence;
+  uint32_t timestamp;
+  std::vector<int64_t> values;
+  if (!reader.byte(sequence) || !reader.varint(timestamp)) {
+    stats.damaged++;
+    return;
+  }
+  while (reader.remaining() > 0) {
+    int32_t value;
+    if (!reader.signedVarint(value)) {
+      stats.damaged++;
+      return;
+    }
+    values.push_back(value);
+  }
+
+  // the first sample fixes the column count, later ones are padded or cut to match
+  if (channel.columns.empty()) {
+    channel.columns.resize(2 + values.size());
+  }
+  values.resize(channel.columns.size() - 2, 0);
+
+  if (channel.rows() > 0 && timestamp < channel.lastTimestamp) {
+    channel.timestampHigh += (int64_t)1 << 32;
+  }
+  channel.lastTimestamp = timestamp;
+  if (channel.lastSequence >= 0) {
+    channel.lost += (uint8_t)(sequence - channel.lastSequence - 1);
+  }
+  channel.lastSequence = sequence;
+
+  channel.columns[0].push_back(channel.timestampHigh + timestamp);
+  channel.columns[1].push_back(sequence);
+  for (size_t i = 0; i < values.size(); i++) {
+    channel.columns[i + 2].push_back(values[i]);
+  }
+  stats.samples++;
+}
+
+
+/*
+===============================================================================================
+                                    Output
+===============================================================================================
+*/
+
+static bool writeCsv(const std::string& path, const ChannelData& channel)
+{
+  FILE* out = fopen(path.c_str(), "w");
+  if (out == NULL) {
+    perror(path.c_str());
+    return false;
+  }
+  const std::vector<std::string> names = channel.columnNames();
+  for (size_t c = 0; c < names.size(); c++) {
+    fprintf(out, "%s%s", c > 0 ? "," : "", names[c].c_str());
+  }
+  fprintf(out, "\n");
+  for (size_t r = 0; r < channel.rows(); r++) {
+    for (size_t c = 0; c < channel.columns.size(); c++) {
+      fprintf(out, "%s%lld", c > 0 ? "," : "", (long long)channel.columns[c][r]);
+    }
+    fprintf(out, "\n");
+  }
+  fclose(out);
+  return true;
+}
+
+static void putU32(FILE* out, uint32_t value)
+{
+  const uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+  fwrite(bytes, 1, sizeof(bytes), out);
+}
+
+static bool writeColumnar(const std::string& path, const ChannelData& channel)
+{
+  FILE* out = fopen(path.c_str(), "wb");
+  if (out == NULL) {
+    perror(path.c_str());
+    return false;
+  }
+  const std::vector<std::string> names = channel.columnNames();
+  fwrite("TCOL", 1, 4, out);
+  putU32(out, 1);
+  putU32(out, (uint32_t)channel.rows());
+  putU32(out, (uint32_t)names.size());
+  for (const std::string& name : names) {
+    putU32(out, (uint32_t)name.size());
+    fwrite(name.data(), 1, name.size(), out);
+  }
+  for (const std::vector<int64_t>& column : channel.columns) {
+    for (int64_t value : column) {
+      putU32(out, (uint32_t)value);
+      putU32(out, (uint32_t)((uint64_t)value >> 32));
+    }
+  }
+  fclose(out);
+  return true;
+}
+
+
+/*
+===============================================================================================
+                                    Main
+===============================================================================================
+*/
+
+int main(int argc, char** argv)
+{
+  bool columnar = false;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "--csv") == 0) {
+    arg++;
+  }
+  else if (arg < argc && strcmp(argv[arg], "--columnar") == 0) {
+    columnar = true;
+    arg++;
+  }
+  if (argc - arg != 2) {
+    fprintf(stderr, "usage: %s [--csv | --columnar] <capture file> <output directory>\n", argv[0]);
+    return 1;
+  }
+
+  FILE* input = fopen(argv[arg], "rb");
+  if (input == NULL) {
+    perror(argv[arg]);
+    return 1;
+  }
+  const std::string directory = argv[arg + 1];
+
+  // split the stream at every zero, anything too long to be a frame is text and is skipped
+  std::map<uint32_t, ChannelData> channels;
+  DecoderStats stats;
+  std::vector<uint8_t> frame;
+  bool overlong = false;
+  int c;
+  while ((c = fgetc(input)) != EOF) {
+    if (c != 0) {
+      if (frame.size() < TELEMETRY_MAX_FRAME) {
+        frame.push_back((uint8_t)c);
+      }
+      else {
+        overlong = true;
+      }
+      continue;
+    }
+
+    if (!frame.empty()) {
+      stats.frames++;
+      uint8_t payload[TELEMETRY_MAX_PAYLOAD + 2];
+      const size_t length = overlong ? 0 : telemetryDecodeFrame(frame.data(), frame.size(), payload, sizeof(payload));
+      if (length == 0) {
+        stats.damaged++;
+      }
+      else {
+        handlePayload(payload, length, channels, stats);
+      }
+    }
+    frame.clear();
+    overlong = false;
+  }
+  fclose(input);
+
+  for (const auto& entry : channels) {
+    const ChannelData& channel = entry.second;
+    if (channel.rows() == 0) {
+      continue;
+    }
+    const std::string path = directory + "/" + channel.name + (columnar ? ".tcol" : ".csv");
+    if (!(columnar ? writeColumnar(path, channel) : writeCsv(path, channel))) {
+      return 1;
+    }
+    fprintf(stderr, "%-24s %8zu rows %6u lost -> %s\n", channel.name.c_str(), channel.rows(), channel.lost, path.c_str());
+  }
+  fprintf(stderr, "%u frames: %u samples, %u schemas, %u damaged or text\n", stats.frames, stats.samples, stats.schemas, stats.damaged);
+  return 0;
+}